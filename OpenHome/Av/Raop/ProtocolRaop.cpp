@@ -710,7 +710,7 @@ void ProtocolRaop::OutputContainer(const Brx& aFmtp)
     iSupply->OutputData(container);
 }
 
-void ProtocolRaop::OutputAudio(const Brx& aAudio)
+void ProtocolRaop::OutputAudio(const std::vector<IRepairable*>& aAudio)
 {
     /*
      * Outputting delay mid-stream is causing VariableDelay to ramp audio up/down
@@ -746,8 +746,20 @@ void ProtocolRaop::OutputAudio(const Brx& aAudio)
         iSupply->OutputDelay(Delay(latency));
     }
 
-    iAudioDecryptor.Decrypt(aAudio, iAudioDecrypted);
-    iSupply->OutputData(iAudioDecrypted);
+    // Decrypt the whole batch before passing any of it on so the cipher context stays hot
+    for (auto* repairable : aAudio) {
+        iAudioDecryptor.Decrypt(repairable->Data());
+    }
+    for (auto* repairable : aAudio) {
+        // CodecRaop expects each packet's audio to be preceded by its size
+        const Brx& audio = repairable->Data();
+        Bws<sizeof(TUint32)> packetBytes;
+        WriterBuffer writerBuffer(packetBytes);
+        WriterBinary writerBinary(writerBuffer);
+        writerBinary.WriteUint32Be(audio.Bytes());
+        iSupply->OutputData(packetBytes);
+        iSupply->OutputData(audio);
+    }
 }
 
 void ProtocolRaop::OutputDiscontinuity()
@@ -1097,6 +1109,7 @@ void RaopControlServer::Open()
     if (!iOpen) {
         iServer->Open();
         iOpen = true;
+        iStatsLogMsValid = false;
         iSem.Clear();
         iSem.Signal();
     }
@@ -1339,9 +1352,12 @@ TUint ResendRange::End() const
 RaopAudioServer::RaopAudioServer(SocketUdpServer* aServer, IRaopAudioConsumer& aConsumer, TUint aThreadPriority)
     : iServer(aServer)
     , iConsumer(aConsumer)
+    , iMsg(nullptr)
     , iOpen(false)
     , iQuit(false)
     , iAwaitingConsumer(false)
+    , iStatsLogMsValid(false)
+    , iStatsLogMs(0)
     , iSem("RASS", 0)
     , iLock("RASL")
 {
@@ -1356,10 +1372,11 @@ RaopAudioServer::~RaopAudioServer()
         iQuit = true;
     }
     iServer->Interrupt(true);
-    iServer->RemoveRef();
     iSem.Signal();
     iThread->Join();
     delete iThread;
+    ReleaseMsgLocked(); // server thread has exited so no need to lock
+    iServer->RemoveRef();
 }
 
 void RaopAudioServer::Open()
@@ -1379,12 +1396,13 @@ void RaopAudioServer::Close()
     LOG_INFO(kMedia, "RaopAudioServer::Close\n");
     AutoMutex a(iLock);
     if (iOpen) {
+        LogStats("RaopAudioServer::Close");
         iServer->Close();
         iOpen = false;
 
         // Clear any unread packet, which is now invalid.
-        iBuf.SetBytes(0);
         iPacket.Clear();
+        ReleaseMsgLocked();
         iAwaitingConsumer = false;
     }
 }
@@ -1414,11 +1432,29 @@ void RaopAudioServer::PacketConsumed()
 {
     AutoMutex _(iLock);
     if (iAwaitingConsumer) {
+        iPacket.Clear();
+        ReleaseMsgLocked();
         iAwaitingConsumer = false;
         iSem.Signal();
     }
 }
 
+void RaopAudioServer::ReleaseMsgLocked()
+{
+    if (iMsg != nullptr) {
+        iServer->ReleaseMsg(*iMsg);
+        iMsg = nullptr;
+    }
+}
+
+void RaopAudioServer::LogStats(const TChar* aPrefix)
+{
+    const UdpServerStats stats = iServer->TakeStats();
+    const TUint avgLatencyMs = (stats.iDelivered == 0? 0 : (TUint)(stats.iTotalLatencyMs / stats.iDelivered));
+    LOG_INFO(kMedia, "%s received: %u, dropped (no buffer): %u, max queued: %u, latency (ms) avg: %u, max: %u\n",
+             aPrefix, stats.iReceived, stats.iDropped, stats.iMaxQueued, avgLatencyMs, stats.iMaxLatencyMs);
+}
+
 void RaopAudioServer::Run()
 {
     for (;;) {
@@ -1443,17 +1479,29 @@ void RaopAudioServer::Run()
 
         if (canRead) {
             try {
-                iBuf.SetBytes(0);
-                (void)iServer->Receive(iBuf); // Never send any data to audio server, so don't care about Endpoint returned.
+                // Parse the packet in place in the server's buffer, which is held until the consumer is finished with it.
+                // Never send any data to audio server, so don't care about msg's Endpoint.
+                MsgUdp& msg = iServer->ReceiveMsg();
                 try {
-                    iPacket.Set(iBuf);
+                    iPacket.Set(msg.Buffer());
                 }
                 catch (InvalidRaopPacket&) {
+                    iServer->ReleaseMsg(msg);
                     iSem.Signal();
                     continue;
                 }
 
                 AutoMutex _(iLock);
+                if (!iStatsLogMsValid) {
+                    iStatsLogMsValid = true;
+                    iStatsLogMs = msg.ReceivedMs();
+                }
+                else if (msg.ReceivedMs() - iStatsLogMs >= kStatsLogIntervalMs) {
+                    LogStats("RaopAudioServer");
+                    iStatsLogMs = msg.ReceivedMs();
+                }
+                ASSERT(iMsg == nullptr);
+                iMsg = &msg;
                 iAwaitingConsumer = true;
                 iConsumer.AudioPacketReceived();
             }
@@ -1476,35 +1524,38 @@ void RaopAudioServer::Run()
 
 // RaopAudioDecryptor
 
+RaopAudioDecryptor::RaopAudioDecryptor()
+{
+    iCtx = EVP_CIPHER_CTX_new();
+    ASSERT(iCtx != nullptr);
+}
+
+RaopAudioDecryptor::~RaopAudioDecryptor()
+{
+    EVP_CIPHER_CTX_free(iCtx);
+}
+
 void RaopAudioDecryptor::Init(const Brx& aAesKey, const Brx& aAesInitVector)
 {
-    iKey.Replace(aAesKey);
+    ASSERT(aAesKey.Bytes() == kAesKeyBytes);
     iInitVector.Replace(aAesInitVector);
+    const int ret = EVP_DecryptInit_ex(iCtx, EVP_aes_128_cbc(), nullptr, aAesKey.Ptr(), iInitVector.Ptr());
+    ASSERT(ret == 1);
+    (void)EVP_CIPHER_CTX_set_padding(iCtx, 0); // packets are not padded; trailing partial block is plaintext
 }
 
-void RaopAudioDecryptor::Decrypt(const Brx& aEncryptedIn, Bwx& aAudioOut) const
+void RaopAudioDecryptor::Decrypt(Bwx& aAudio)
 {
-    //LOG(kMedia, ">RaopAudioDecryptor::Decrypt aEncryptedIn.Bytes(): %u\n", aEncryptedIn.Bytes());
-    ASSERT(iKey.Bytes() > 0);
     ASSERT(iInitVector.Bytes() > 0);
-    ASSERT(aAudioOut.MaxBytes() >= kPacketSizeBytes+aEncryptedIn.Bytes());
-
-    aAudioOut.SetBytes(0);
-    WriterBuffer writerBuffer(aAudioOut);
-    WriterBinary writerBinary(writerBuffer);
-    writerBinary.WriteUint32Be(aEncryptedIn.Bytes());    // Write out payload size.
-
-    unsigned char* inBuf = const_cast<unsigned char*>(aEncryptedIn.Ptr());
-    unsigned char* outBuf = const_cast<unsigned char*>(aAudioOut.Ptr()+aAudioOut.Bytes());
-    unsigned char initVector[16];
-    memcpy(initVector, iInitVector.Ptr(), sizeof(initVector));  // Use same initVector at start of each decryption block.
-
-    AES_cbc_encrypt(inBuf, outBuf, aEncryptedIn.Bytes(), (AES_KEY*)iKey.Ptr(), initVector, AES_DECRYPT);
-    const TUint audioRemaining = aEncryptedIn.Bytes() % 16;
-    const TUint audioWritten = aEncryptedIn.Bytes()-audioRemaining;
-    if (audioRemaining > 0) {
-        // Copy remaining audio to outBuf if <16 bytes.
-        memcpy(outBuf+audioWritten, inBuf+audioWritten, audioRemaining);
+    const TUint encryptedBytes = aAudio.Bytes() - (aAudio.Bytes() % kAesBlockBytes);
+    if (encryptedBytes == 0) {
+        return;
     }
-    aAudioOut.SetBytes(kPacketSizeBytes+aEncryptedIn.Bytes());
+    TByte* audio = const_cast<TByte*>(aAudio.Ptr());
+    int ret = EVP_DecryptInit_ex(iCtx, nullptr, nullptr, nullptr, iInitVector.Ptr()); // reset IV, keeping key schedule
+    ASSERT(ret == 1);
+    int bytesOut = 0;
+    ret = EVP_DecryptUpdate(iCtx, audio, &bytesOut, audio, (int)encryptedBytes);
+    ASSERT(ret == 1);
+    ASSERT((TUint)bytesOut == encryptedBytes);
 }
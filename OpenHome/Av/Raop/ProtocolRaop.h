@@ -9,7 +9,9 @@
 #include <OpenHome/Media/Debug.h>
 
 #include  <openssl/rsa.h>
-#include  <openssl/aes.h>
+#include  <openssl/evp.h>
+
+#include <vector>
 
 EXCEPTION(InvalidRaopPacket)
 EXCEPTION(RepairerBufferFull)
@@ -21,6 +23,7 @@ namespace OpenHome {
     class Timer;
 namespace Av {
 
+class MsgUdp;
 class SocketUdpServer;
 class UdpServerManager;
 class IRaopDiscovery;
@@ -169,6 +172,7 @@ class RaopAudioServer : private INonCopyable
 {
 private:
     static const TUint kSocketFailureRetryIntervalMs = 50;
+    static const TUint kStatsLogIntervalMs = 60 * 1000;
 public:
     RaopAudioServer(SocketUdpServer* aServer, IRaopAudioConsumer& aConsumer, TUint aThreadPriority);
     ~RaopAudioServer();
@@ -184,34 +188,44 @@ public:
     void PacketConsumed();                  // Signals this to read next packet.
 private:
     void Run();
+    void ReleaseMsgLocked();
+    void LogStats(const TChar* aPrefix);
 private:
     SocketUdpServer* iServer;
     IRaopAudioConsumer& iConsumer;
-    Bws<RtpPacketRaop::kMaxPacketBytes> iBuf;
+    MsgUdp* iMsg; // server buffer iPacket refers to; held until the consumer is finished with it
     RaopPacketAudio iPacket;
     TBool iOpen;
     TBool iQuit;
     TBool iAwaitingConsumer;
+    TBool iStatsLogMsValid;
+    TUint iStatsLogMs; // receive time of the packet that stats were last logged on
     ThreadFunctor* iThread;
     Semaphore iSem;
     mutable Mutex iLock;
 };
 
-// FIXME - this class currently writes out the packet length at the start of decoded audio.
-// That shouldn't be a responsibility of a generic decryptor.
-// Maybe have a chain of elements that write into the same buffer (i.e., one element to write the packet length at the start, then pass onto decryptor to decrypt the audio into the buffer).
-class RaopAudioDecryptor
+/**
+ * Decrypts RAOP audio payloads in place.
+ *
+ * Each packet is AES-128-CBC encrypted independently, starting from the session's IV.
+ * Only whole 16-byte blocks are encrypted; any trailing bytes are sent in the clear.
+ * Uses the EVP interface so that AES-NI/ARMv8 crypto extensions are used where available.
+ * The key schedule is set up once per session in Init(); Decrypt() only resets the IV.
+ */
+class RaopAudioDecryptor : private INonCopyable
 {
 private:
-    static const TUint kAesKeyBytes = sizeof(AES_KEY);
-    static const TUint kAesInitVectorBytes = 16;
-    static const TUint kPacketSizeBytes = sizeof(TUint);
+    static const TUint kAesKeyBytes = 16;
+    static const TUint kAesBlockBytes = 16;
 public:
+    RaopAudioDecryptor();
+    ~RaopAudioDecryptor();
     void Init(const Brx& aAesKey, const Brx& aAesInitVector);
-    void Decrypt(const Brx& aEncryptedIn, Bwx& aAudioOut) const;
+    void Decrypt(Bwx& aAudio);
 private:
-    Bws<kAesKeyBytes> iKey;
-    Bws<kAesInitVectorBytes> iInitVector;
+    EVP_CIPHER_CTX* iCtx;
+    Bws<kAesBlockBytes> iInitVector;
 };
 
 class IRaopResendRequester
@@ -284,29 +298,35 @@ private:
     Semaphore iSem;
 };
 
-class IAudioSupply
-{
-public:
-    virtual void OutputAudio(const Brx& aAudio) = 0;
-    virtual ~IAudioSupply() {}
-};
-
 class IRepairable
 {
 public:
     virtual TUint Frame() const = 0;
     virtual TBool Resend() const = 0;
     virtual const Brx& Data() const = 0;
+    virtual Bwx& Data() = 0;
     virtual void Destroy() = 0;
     virtual ~IRepairable() {}
 };
 
+class IAudioSupply
+{
+public:
+    /*
+     * aAudio are consecutive frames, released together by Repairer.
+     * May modify their Data() (e.g. to decrypt in place).  Repairer destroys them after this returns.
+     */
+    virtual void OutputAudio(const std::vector<IRepairable*>& aAudio) = 0;
+    virtual ~IAudioSupply() {}
+};
+
 class IRepairableAllocatable : public IRepairable
 {
 public: // from IRepairable
     virtual TUint Frame() const = 0;
     virtual TBool Resend() const = 0;
     virtual const Brx& Data() const = 0;
+    virtual Bwx& Data() = 0;
     virtual void Destroy() = 0;
 public:
     virtual void Set(TUint aFrame, TBool aResend, const Brx& aData) = 0;
@@ -331,6 +351,7 @@ public: // from IRepairableAllocatable
     TUint Frame() const override { return iFrame; }
     TBool Resend() const override { return iResend; }
     const Brx& Data() const override { return iData; }
+    Bwx& Data() override { return iData; }
     void Destroy() override { iDeallocator.Deallocate(this); }
     void Set(TUint aFrame, TBool aResend, const Brx& aData) override
     {
@@ -573,9 +594,8 @@ template <TUint MaxFrames> void Repairer<MaxFrames>::OutputAudio(IRepairable& aR
     // Must NOT hold iMutexTransport while calling iAudioSupply.OutputAudio()
     // in case this class receives an interrupt of some form (such as DropAudio()).
     if (iOutput.size() > 0) {
+        iAudioSupply.OutputAudio(iOutput);
         for (auto* repairable : iOutput) {
-            //LOG(kMedia, "Repairer<MaxFrames>::OutputAudio %u\n", repairable->Frame());
-            iAudioSupply.OutputAudio(repairable->Data());
             repairable->Destroy();
         }
         iOutput.clear();
@@ -820,7 +840,7 @@ private: // from IRaopAudioConsumer
 private: // from IRaopResendConsumer
     void ResendPacketReceived() override;
 private: // from IAudioSupply
-    void OutputAudio(const Brx& aAudio) override;
+    void OutputAudio(const std::vector<IRepairable*>& aAudio) override;
 private:
     void DoInterrupt(TBool aInterrupt);
     void Reset();
@@ -848,7 +868,6 @@ private:
     // for servicing control channel, as that is currently handled on its on
     // thread.
     UdpServerManager& iServerManager;
-    Bws<RtpPacketRaop::kMaxPacketBytes> iAudioDecrypted;
     RaopAudioDecryptor iAudioDecryptor;
     RaopAudioServer iAudioServer;
     RaopControlServer iControlServer;
@@ -702,9 +702,7 @@ void RaopDiscoverySession::DecryptAeskey()
     unsigned char aeskey[128];
     TInt res = RSA_private_decrypt(rsaaeskey.Bytes(), rsaaeskey.Ptr(), aeskey, iRsa, RSA_PKCS1_OAEP_PADDING);
     if(res > 0) {
-        AES_KEY key;
-        AES_set_decrypt_key(aeskey, 128, &key);
-        iAeskey.Replace((const TByte* )&key, sizeof(AES_KEY));
+        iAeskey.Replace(aeskey, kAesKeyBytes); // raw AES-128 key; RaopAudioDecryptor sets up its own key schedule
         iAeskeyPresent = true;
         iAesSid++;
     }
@@ -10,7 +10,6 @@
 #include <OpenHome/Media/Pipeline/Attenuator.h>
 
 #include  <openssl/rsa.h>
-#include  <openssl/aes.h>
 
 EXCEPTION(RaopError);
 EXCEPTION(RaopVolumeInvalid);
@@ -162,6 +161,7 @@ class RaopDiscoverySession : public SocketTcpSession, public IRaopDiscovery
 private:
     static const TUint kMaxReadBufferBytes = 12000;
     static const TUint kMaxWriteBufferBytes = 4000;
+    static const TUint kAesKeyBytes = 16;
     static const unsigned char kRsaKeyPrivate[];
 public:
     RaopDiscoverySession(Environment& aEnv, RaopDiscoveryServer& aDiscovery, RaopDevice& aRaopDevice, TUint aInstance, Media::IAttenuator& aAttenuator);
@@ -202,7 +202,7 @@ private:
     HeaderCSeq iHeaderCSeq;
     HeaderRtpInfo iHeaderRtpInfo;
     Media::SdpInfo iSdpInfo;
-    Bws<sizeof(AES_KEY)> iAeskey;
+    Bws<kAesKeyBytes> iAeskey;
     TBool iAeskeyPresent;
     TUint iAesSid;
     RSA *iRsa;
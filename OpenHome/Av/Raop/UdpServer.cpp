@@ -1,6 +1,7 @@
 #include <OpenHome/Av/Raop/UdpServer.h>
 #include <OpenHome/Private/Env.h>
 #include <OpenHome/Private/NetworkAdapterList.h>
+#include <OpenHome/Private/Timer.h>
 #include <OpenHome/Media/Debug.h>
 
 using namespace OpenHome;
@@ -11,6 +12,7 @@ using namespace Av;
 
 MsgUdp::MsgUdp(TUint aMaxSize)
     : iBuf(aMaxSize)
+    , iReceivedMs(0)
 {
 }
 
@@ -33,6 +35,34 @@ Endpoint& MsgUdp::Endpoint()
     return iEndpoint;
 }
 
+void MsgUdp::SetReceivedMs(TUint aMs)
+{
+    iReceivedMs = aMs;
+}
+
+TUint MsgUdp::ReceivedMs() const
+{
+    return iReceivedMs;
+}
+
+
+// UdpServerStats
+
+UdpServerStats::UdpServerStats()
+{
+    Clear();
+}
+
+void UdpServerStats::Clear()
+{
+    iReceived = 0;
+    iDropped = 0;
+    iMaxQueued = 0;
+    iDelivered = 0;
+    iMaxLatencyMs = 0;
+    iTotalLatencyMs = 0;
+}
+
 
 // SocketUdpServer
 
@@ -194,6 +224,17 @@ void SocketUdpServer::SetTtl(TUint aTtl)
 }
 
 Endpoint SocketUdpServer::Receive(Bwx& aBuf)
+{
+    MsgUdp& msg = ReceiveMsg();
+    const Brx& buf = msg.Buffer();
+    ASSERT(aBuf.MaxBytes() >= buf.Bytes());
+    aBuf.Replace(buf);
+    Endpoint ep(msg.Endpoint());
+    ReleaseMsg(msg);
+    return ep;
+}
+
+MsgUdp& SocketUdpServer::ReceiveMsg()
 {
     {
         AutoMutex _(iLock);
@@ -222,26 +263,31 @@ Endpoint SocketUdpServer::Receive(Bwx& aBuf)
 
         AutoMutex _(iLockFifo);
         if (iFifoReady.SlotsUsed() > 0) {
-            // Get data from msg.
             MsgUdp* msg = iFifoReady.Read();
-            Endpoint ep;
-            CopyMsgToBuf(*msg, aBuf, ep);
-            ASSERT(iFifoWaiting.SlotsUsed() < iFifoWaiting.Slots());
-            iFifoWaiting.Write(msg);
-            return ep;
-        }
-        else {
-            continue;
+            const TUint latencyMs = Time::Now(iEnv) - msg->ReceivedMs();
+            iStats.iDelivered++;
+            iStats.iTotalLatencyMs += latencyMs;
+            if (latencyMs > iStats.iMaxLatencyMs) {
+                iStats.iMaxLatencyMs = latencyMs;
+            }
+            return *msg;
         }
     }
 }
 
-void SocketUdpServer::CopyMsgToBuf(MsgUdp& aMsg, Bwx& aBuf, Endpoint& aEndpoint)
+void SocketUdpServer::ReleaseMsg(MsgUdp& aMsg)
 {
-    const Brx& buf = aMsg.Buffer();
-    ASSERT(aBuf.MaxBytes() >= buf.Bytes());
-    aBuf.Replace(buf);
-    aEndpoint.Replace(aMsg.Endpoint());
+    AutoMutex _(iLockFifo);
+    ASSERT(iFifoWaiting.SlotsUsed() < iFifoWaiting.Slots());
+    iFifoWaiting.Write(&aMsg);
+}
+
+UdpServerStats SocketUdpServer::TakeStats()
+{
+    AutoMutex _(iLockFifo);
+    const UdpServerStats stats = iStats;
+    iStats.Clear();
+    return stats;
 }
 
 void SocketUdpServer::ServerThread()
@@ -272,12 +318,18 @@ void SocketUdpServer::ServerThread()
             if (iFifoWaiting.SlotsUsed() == 0) {
                 // No more packets to read into.
                 // Drop this packet and reuse iDiscard to read next packet.
+                iStats.iDropped++;
                 continue;
             }
 
             ASSERT(iFifoReady.SlotsUsed() < iFifoReady.Slots());
+            iDiscard->SetReceivedMs(Time::Now(iEnv));
             iFifoReady.Write(iDiscard);
             iDiscard = iFifoWaiting.Read();
+            iStats.iReceived++;
+            if (iFifoReady.SlotsUsed() > iStats.iMaxQueued) {
+                iStats.iMaxQueued = iFifoReady.SlotsUsed();
+            }
             iSemRead.Signal();
         }
     }
@@ -21,9 +21,33 @@ public:
     void Read(SocketUdp& aSocket);
     const Brx& Buffer();
     OpenHome::Endpoint& Endpoint();
+    void SetReceivedMs(TUint aMs);
+    TUint ReceivedMs() const;
 private:
     Bwh iBuf;
     OpenHome::Endpoint iEndpoint;
+    TUint iReceivedMs;
+};
+
+/**
+ * Receive statistics for a SocketUdpServer, accumulated since they were last taken.
+ *
+ * Packets dropped here were received while every buffer was waiting for the consumer,
+ * so indicate the consumer isn't keeping up.  Packets lost on the network aren't counted
+ * here; they show up as gaps in the consumer's sequence numbers instead.
+ */
+class UdpServerStats
+{
+public:
+    UdpServerStats();
+    void Clear();
+public:
+    TUint iReceived;        // packets queued for the consumer
+    TUint iDropped;         // packets discarded because no buffer was free
+    TUint iMaxQueued;       // most packets waiting for the consumer at once
+    TUint iDelivered;       // packets passed to the consumer
+    TUint iMaxLatencyMs;    // longest any delivered packet waited for the consumer
+    TUint64 iTotalLatencyMs;
 };
 
 /**
@@ -52,9 +76,19 @@ public:
     void SetTtl(TUint aTtl);
     
     Endpoint Receive(Bwx& aBuf);
+    /*
+     * As Receive() but passes the server's own buffer to the caller rather than copying
+     * from it.  The msg must be passed to ReleaseMsg() once the caller is finished with it
+     * and before the caller removes its reference to this server.
+     */
+    MsgUdp& ReceiveMsg();
+    void ReleaseMsg(MsgUdp& aMsg);
+    /*
+     * Returns statistics accumulated since the last call, then clears them.
+     */
+    UdpServerStats TakeStats();
 private:
     ~SocketUdpServer();
-    static void CopyMsgToBuf(MsgUdp& aMsg, Bwx& aBuf, Endpoint& aEndpoint);
     void ServerThread();
     void CurrentAdapterChanged();
     struct RebindJob {
@@ -82,6 +116,7 @@ private:
     TUint iAdapterListenerId;
     TBool iRebindPosted;
     RebindJob iRebindJob;
+    UdpServerStats iStats; // protected by iLockFifo
 };
 
 /**
@@ -326,6 +326,36 @@ void OhmHeaderResend::Externalise(IWriter& aWriter) const
 
     writer.WriteUint32Be(iFramesCount);
 }
+
+// OhmHeaderJoin
+
+OhmHeaderJoin::OhmHeaderJoin()
+    : iCapabilities(0)
+{
+}
+
+OhmHeaderJoin::OhmHeaderJoin(TUint aCapabilities)
+    : iCapabilities(aCapabilities)
+{
+}
+
+void OhmHeaderJoin::Internalise(IReader& aReader, const OhmHeader& aHeader)
+{
+    ASSERT (aHeader.MsgType() == OhmHeader::kMsgTypeJoin || aHeader.MsgType() == OhmHeader::kMsgTypeListen);
+
+    iCapabilities = 0;
+    if (aHeader.MsgBytes() >= kHeaderBytes) {
+        ReaderBinary readerBinary(aReader);
+        iCapabilities = readerBinary.ReadUintBe(4);
+    }
+}
+
+void OhmHeaderJoin::Externalise(IWriter& aWriter) const
+{
+    WriterBinary writer(aWriter);
+
+    writer.WriteUint32Be(iCapabilities);
+}
     
     
 
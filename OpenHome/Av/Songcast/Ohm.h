@@ -260,6 +260,29 @@ private:
     TUint iFramesCount;
 };
 
+class OhmHeaderJoin // optional body of a Join or Listen msg
+{
+public:
+    static const TUint kHeaderBytes = 4;
+    static const TUint kCapabilityLossless = 1 << 0; // can play audio compressed by OhmLossless
+
+public:
+    OhmHeaderJoin();
+    OhmHeaderJoin(TUint aCapabilities);
+
+    void Internalise(IReader& aReader, const OhmHeader& aHeader);
+    void Externalise(IWriter& aWriter) const;
+
+    TUint Capabilities() const {return iCapabilities;}
+    TUint MsgBytes() const {return kHeaderBytes;}
+
+private:
+    //Offset    Bytes                   Desc
+    //0         4                       Capabilities (receivers that predate this send no body, so have none)
+
+    TUint iCapabilities;
+};
+
 class OhzHeader
 {
 public:
@@ -0,0 +1,499 @@
+#include <OpenHome/Av/Songcast/OhmLossless.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Standard.h>
+#include <OpenHome/Av/Songcast/OhmMsg.h>
+
+#include <algorithm>
+
+using namespace OpenHome;
+using namespace OpenHome::Av;
+
+/* Compressed frame layout (bit packed, msb first):
+       4 bits   version
+       4 bits   stereo mode (EStereo)
+   then a subframe per channel:
+       3 bits   predictor order
+       5 bits   rice parameter, or kRiceVerbatim
+       if verbatim:
+           sample-bits signed value per sample
+       else:
+           sample-bits signed value per warm-up sample (predictor order of these)
+           rice coded residual per remaining sample
+   Sample-bits is the stream's bit depth, plus one for side channels. */
+
+// OhmLossless
+
+const Brn OhmLossless::kCodecNamePrefix("OHLC/");
+
+TBool OhmLossless::IsCompressed(const Brx& aCodecName)
+{ // static
+    return aCodecName.BeginsWith(kCodecNamePrefix);
+}
+
+Brn OhmLossless::SourceCodecName(const Brx& aCodecName)
+{ // static
+    if (IsCompressed(aCodecName)) {
+        return aCodecName.Split(kCodecNamePrefix.Bytes());
+    }
+    return Brn(aCodecName);
+}
+
+void OhmLossless::SetCodecName(Bwx& aCodecName, const Brx& aSourceCodecName)
+{ // static
+    aCodecName.Replace(kCodecNamePrefix);
+    const TUint bytes = std::min(aSourceCodecName.Bytes(), aCodecName.MaxBytes() - aCodecName.Bytes());
+    aCodecName.Append(aSourceCodecName.Split(0, bytes));
+}
+
+TBool OhmLossless::IsSupported(TUint aBitDepth, TUint aChannels)
+{ // static
+    if (aChannels == 0 || aChannels > kMaxChannels) {
+        return false;
+    }
+    return (aBitDepth == 8 || aBitDepth == 16 || aBitDepth == 24);
+}
+
+TBool OhmLossless::IsSide(EStereo aMode, TUint aChannel)
+{ // static
+    switch (aMode)
+    {
+    case eLeftSide:
+    case eMidSide:
+        return aChannel == 1;
+    case eSideRight:
+        return aChannel == 0;
+    default:
+        return false;
+    }
+}
+
+TInt OhmLossless::Predict(const TInt* aSamples, TUint aIndex, TUint aOrder)
+{ // static
+    const TInt* s = aSamples + aIndex;
+    switch (aOrder)
+    {
+    case 0:
+        return 0;
+    case 1:
+        return s[-1];
+    case 2:
+        return 2*s[-1] - s[-2];
+    case 3:
+        return 3*s[-1] - 3*s[-2] + s[-3];
+    case 4:
+        return 4*s[-1] - 6*s[-2] + 4*s[-3] - s[-4];
+    default:
+        ASSERTS();
+        return 0;
+    }
+}
+
+TInt OhmLossless::SignExtend(TUint aValue, TUint aBits)
+{ // static
+    const TUint shift = 32 - aBits;
+    return static_cast<TInt>(aValue << shift) >> shift;
+}
+
+TUint OhmLossless::Mask(TUint aBits)
+{ // static
+    return (aBits >= 32? 0xffffffff : (1u << aBits) - 1);
+}
+
+
+// OhmLosslessEncoder
+
+OhmLosslessEncoder::OhmLosslessEncoder()
+    : iPtr(nullptr)
+    , iBitPos(0)
+{
+}
+
+TBool OhmLosslessEncoder::TryEncode(const Brx& aPcm, TUint aBitDepth, TUint aChannels, Bwx& aEncoded)
+{
+    if (!IsSupported(aBitDepth, aChannels)) {
+        return false;
+    }
+    const TUint bytesPerSubsample = aBitDepth / 8;
+    const TUint bytesPerSample = bytesPerSubsample * aChannels;
+    if (aPcm.Bytes() == 0 || aPcm.Bytes() % bytesPerSample != 0 || aPcm.Bytes() / bytesPerSubsample > kMaxSubsamples) {
+        return false;
+    }
+    const TUint samples = aPcm.Bytes() / bytesPerSample;
+
+    const TByte* src = aPcm.Ptr();
+    for (TUint i=0; i<samples; i++) {
+        for (TUint ch=0; ch<aChannels; ch++) {
+            TUint val = 0;
+            for (TUint j=0; j<bytesPerSubsample; j++) {
+                val = (val << 8) | *src++;
+            }
+            iSamples[ch*samples + i] = SignExtend(val, aBitDepth);
+        }
+    }
+
+    Subframe subframes[kMaxChannels];
+    for (TUint ch=0; ch<aChannels; ch++) {
+        subframes[ch].iSamples = iSamples + ch*samples;
+        subframes[ch].iSampleBits = aBitDepth;
+    }
+    EStereo mode = eIndependent;
+    if (aChannels == 2) {
+        const TInt* left = subframes[0].iSamples;
+        const TInt* right = subframes[1].iSamples;
+        for (TUint i=0; i<samples; i++) {
+            iSide[i] = left[i] - right[i];
+            iMid[i] = (left[i] + right[i]) >> 1;
+        }
+        TUint64 costLeft, costRight, costSide, costMid;
+        const TUint orderLeft = BestOrder(left, samples, costLeft);
+        const TUint orderRight = BestOrder(right, samples, costRight);
+        const TUint orderSide = BestOrder(iSide, samples, costSide);
+        const TUint orderMid = BestOrder(iMid, samples, costMid);
+        subframes[0].iOrder = orderLeft;
+        subframes[1].iOrder = orderRight;
+        TUint64 cost = costLeft + costRight;
+        if (costLeft + costSide < cost) {
+            mode = eLeftSide;
+            cost = costLeft + costSide;
+        }
+        if (costSide + costRight < cost) {
+            mode = eSideRight;
+            cost = costSide + costRight;
+        }
+        if (costMid + costSide < cost) {
+            mode = eMidSide;
+        }
+        switch (mode)
+        {
+        case eLeftSide:
+            subframes[1].iSamples = iSide;
+            subframes[1].iOrder = orderSide;
+            break;
+        case eSideRight:
+            subframes[0].iSamples = iSide;
+            subframes[0].iOrder = orderSide;
+            break;
+        case eMidSide:
+            subframes[0].iSamples = iMid;
+            subframes[0].iOrder = orderMid;
+            subframes[1].iSamples = iSide;
+            subframes[1].iOrder = orderSide;
+            break;
+        default:
+            break;
+        }
+    }
+    else {
+        TUint64 ignore;
+        for (TUint ch=0; ch<aChannels; ch++) {
+            subframes[ch].iOrder = BestOrder(subframes[ch].iSamples, samples, ignore);
+        }
+    }
+
+    TUint64 bits = kVersionBits + kStereoBits;
+    for (TUint ch=0; ch<aChannels; ch++) {
+        if (IsSide(mode, ch)) {
+            subframes[ch].iSampleBits++;
+        }
+        Plan(subframes[ch], samples);
+        bits += subframes[ch].iBits;
+    }
+    const TUint64 bytes = (bits + 7) / 8;
+    if (bytes >= aPcm.Bytes() || bytes > aEncoded.MaxBytes()) {
+        return false;
+    }
+
+    iPtr = const_cast<TByte*>(aEncoded.Ptr());
+    iBitPos = 0;
+    WriteBits(kVersion, kVersionBits);
+    WriteBits(mode, kStereoBits);
+    for (TUint ch=0; ch<aChannels; ch++) {
+        WriteSubframe(subframes[ch], samples);
+    }
+    ASSERT(iBitPos == bits);
+    aEncoded.SetBytes(static_cast<TUint>(bytes));
+    iPtr = nullptr;
+    return true;
+}
+
+TUint OhmLosslessEncoder::BestOrder(const TInt* aSamples, TUint aCount, TUint64& aAbsResidualTotal)
+{ // static
+    // compare orders over the samples all of them can predict; warm-up samples cost the same for each
+    TUint64 totals[kMaxOrder + 1] = { 0 };
+    const TUint maxOrder = (aCount > kMaxOrder? kMaxOrder : 0);
+    const TUint start = maxOrder;
+    for (TUint i=start; i<aCount; i++) {
+        for (TUint order=0; order<=maxOrder; order++) {
+            const TInt residual = aSamples[i] - Predict(aSamples, i, order);
+            totals[order] += (residual < 0? -static_cast<TInt64>(residual) : residual);
+        }
+    }
+    TUint best = 0;
+    for (TUint order=1; order<=maxOrder; order++) {
+        if (totals[order] < totals[best]) {
+            best = order;
+        }
+    }
+    aAbsResidualTotal = totals[best];
+    return best;
+}
+
+void OhmLosslessEncoder::Plan(Subframe& aSubframe, TUint aCount)
+{ // static
+    const TUint64 verbatimBits = kOrderBits + kRiceBits + static_cast<TUint64>(aCount) * aSubframe.iSampleBits;
+    aSubframe.iRice = kRiceVerbatim;
+    aSubframe.iBits = verbatimBits;
+
+    const TUint order = aSubframe.iOrder;
+    if (order >= aCount) {
+        return;
+    }
+    // estimate rice parameter from the mean residual then refine by trying its neighbours
+    TUint64 total = 0;
+    for (TUint i=order; i<aCount; i++) {
+        const TInt residual = aSubframe.iSamples[i] - Predict(aSubframe.iSamples, i, order);
+        total += (static_cast<TUint>(residual) << 1) ^ static_cast<TUint>(residual >> 31);
+    }
+    const TUint64 mean = total / (aCount - order);
+    TUint estimate = 0;
+    while (estimate < kMaxRice && (mean >> estimate) > 1) {
+        estimate++;
+    }
+    const TUint first = (estimate == 0? 0 : estimate - 1);
+    const TUint last = (estimate < kMaxRice? estimate + 1 : kMaxRice);
+    const TUint64 fixedBits = kOrderBits + kRiceBits + static_cast<TUint64>(order) * aSubframe.iSampleBits;
+    for (TUint rice=first; rice<=last; rice++) {
+        const TUint64 bits = fixedBits + RiceBits(aSubframe.iSamples, aCount, order, rice);
+        if (bits < aSubframe.iBits) {
+            aSubframe.iRice = rice;
+            aSubframe.iBits = bits;
+        }
+    }
+}
+
+TUint64 OhmLosslessEncoder::RiceBits(const TInt* aSamples, TUint aCount, TUint aOrder, TUint aRice)
+{ // static
+    TUint64 bits = static_cast<TUint64>(aCount - aOrder) * (aRice + 1);
+    for (TUint i=aOrder; i<aCount; i++) {
+        const TInt residual = aSamples[i] - Predict(aSamples, i, aOrder);
+        const TUint folded = (static_cast<TUint>(residual) << 1) ^ static_cast<TUint>(residual >> 31);
+        bits += folded >> aRice;
+    }
+    return bits;
+}
+
+void OhmLosslessEncoder::WriteSubframe(const Subframe& aSubframe, TUint aCount)
+{
+    const TInt* samples = aSubframe.iSamples;
+    const TUint sampleMask = Mask(aSubframe.iSampleBits);
+    if (aSubframe.iRice == kRiceVerbatim) {
+        WriteBits(0, kOrderBits);
+        WriteBits(kRiceVerbatim, kRiceBits);
+        for (TUint i=0; i<aCount; i++) {
+            WriteBits(static_cast<TUint>(samples[i]) & sampleMask, aSubframe.iSampleBits);
+        }
+        return;
+    }
+    const TUint order = aSubframe.iOrder;
+    const TUint rice = aSubframe.iRice;
+    WriteBits(order, kOrderBits);
+    WriteBits(rice, kRiceBits);
+    for (TUint i=0; i<order; i++) {
+        WriteBits(static_cast<TUint>(samples[i]) & sampleMask, aSubframe.iSampleBits);
+    }
+    for (TUint i=order; i<aCount; i++) {
+        const TInt residual = samples[i] - Predict(samples, i, order);
+        const TUint folded = (static_cast<TUint>(residual) << 1) ^ static_cast<TUint>(residual >> 31);
+        TUint quotient = folded >> rice;
+        while (quotient >= 32) {
+            WriteBits(0, 32);
+            quotient -= 32;
+        }
+        WriteBits(1, quotient + 1);
+        if (rice > 0) {
+            WriteBits(folded & Mask(rice), rice);
+        }
+    }
+}
+
+void OhmLosslessEncoder::WriteBits(TUint aValue, TUint aBits)
+{
+    while (aBits > 0) {
+        const TUint bitInByte = iBitPos & 7;
+        const TUint space = 8 - bitInByte;
+        const TUint count = std::min(space, aBits);
+        const TUint bits = (aValue >> (aBits - count)) & Mask(count);
+        TByte& byte = iPtr[iBitPos >> 3];
+        if (bitInByte == 0) {
+            byte = 0;
+        }
+        byte |= static_cast<TByte>(bits << (space - count));
+        iBitPos += count;
+        aBits -= count;
+    }
+}
+
+
+// OhmLosslessDecoder
+
+OhmLosslessDecoder::OhmLosslessDecoder()
+    : iPtr(nullptr)
+    , iBitPos(0)
+    , iBitEnd(0)
+{
+}
+
+void OhmLosslessDecoder::Decode(const Brx& aEncoded, TUint aBitDepth, TUint aChannels, TUint aSamples, Bwx& aPcm)
+{
+    if (!IsSupported(aBitDepth, aChannels) || aSamples == 0 || aSamples * aChannels > kMaxSubsamples) {
+        THROW(OhmLosslessCorrupt);
+    }
+    const TUint bytesPerSubsample = aBitDepth / 8;
+    const TUint pcmBytes = aSamples * aChannels * bytesPerSubsample;
+    if (pcmBytes > aPcm.MaxBytes()) {
+        THROW(OhmLosslessCorrupt);
+    }
+
+    iPtr = aEncoded.Ptr();
+    iBitPos = 0;
+    iBitEnd = aEncoded.Bytes() * 8;
+    const TUint version = ReadBits(kVersionBits);
+    const TUint mode = ReadBits(kStereoBits);
+    if (version != kVersion || mode >= eStereoModeCount || (mode != eIndependent && aChannels != 2)) {
+        THROW(OhmLosslessCorrupt);
+    }
+    for (TUint ch=0; ch<aChannels; ch++) {
+        const TUint sampleBits = aBitDepth + (IsSide(static_cast<EStereo>(mode), ch)? 1 : 0);
+        ReadSubframe(iSamples + ch*aSamples, aSamples, sampleBits);
+    }
+    iPtr = nullptr;
+
+    // sample-bits values are small enough that none of the sums below can overflow
+    TInt* left = iSamples;
+    TInt* right = iSamples + aSamples;
+    switch (mode)
+    {
+    case eLeftSide:
+        for (TUint i=0; i<aSamples; i++) {
+            right[i] = left[i] - right[i];
+        }
+        break;
+    case eSideRight:
+        for (TUint i=0; i<aSamples; i++) {
+            left[i] += right[i];
+        }
+        break;
+    case eMidSide:
+        for (TUint i=0; i<aSamples; i++) {
+            const TInt side = right[i];
+            const TInt sum = left[i]*2 + (side & 1);
+            left[i] = (sum + side) >> 1;
+            right[i] = (sum - side) >> 1;
+        }
+        break;
+    default:
+        break;
+    }
+
+    aPcm.SetBytes(pcmBytes);
+    TByte* dest = const_cast<TByte*>(aPcm.Ptr());
+    for (TUint i=0; i<aSamples; i++) {
+        for (TUint ch=0; ch<aChannels; ch++) {
+            const TUint val = static_cast<TUint>(iSamples[ch*aSamples + i]);
+            for (TUint j=bytesPerSubsample; j>0; j--) {
+                *dest++ = static_cast<TByte>(val >> (8 * (j-1)));
+            }
+        }
+    }
+}
+
+TBool OhmLosslessDecoder::DecodeOrSilence(const Brx& aEncoded, TUint aBitDepth, TUint aChannels, TUint aSamples, Bwx& aPcm)
+{
+    try {
+        Decode(aEncoded, aBitDepth, aChannels, aSamples, aPcm);
+        return true;
+    }
+    catch (OhmLosslessCorrupt&) {
+        const TUint bytesPerSample = aChannels * (aBitDepth / 8);
+        TUint samples = 0;
+        if (bytesPerSample > 0) {
+            samples = std::min(aSamples, aPcm.MaxBytes() / bytesPerSample);
+        }
+        aPcm.SetBytes(samples * bytesPerSample);
+        aPcm.Fill(0);
+        return false;
+    }
+}
+
+void OhmLosslessDecoder::ReadSubframe(TInt* aSamples, TUint aCount, TUint aSampleBits)
+{
+    const TUint order = ReadBits(kOrderBits);
+    const TUint rice = ReadBits(kRiceBits);
+    if (rice == kRiceVerbatim) {
+        for (TUint i=0; i<aCount; i++) {
+            aSamples[i] = SignExtend(ReadBits(aSampleBits), aSampleBits);
+        }
+        return;
+    }
+    if (order > kMaxOrder || order >= aCount || rice > kMaxRice) {
+        THROW(OhmLosslessCorrupt);
+    }
+    for (TUint i=0; i<order; i++) {
+        aSamples[i] = SignExtend(ReadBits(aSampleBits), aSampleBits);
+    }
+    for (TUint i=order; i<aCount; i++) {
+        const TUint quotient = ReadUnary();
+        if (quotient > (0xffffffff >> rice)) {
+            THROW(OhmLosslessCorrupt);
+        }
+        const TUint folded = (quotient << rice) | ReadBits(rice);
+        const TInt residual = static_cast<TInt>(folded >> 1) ^ -static_cast<TInt>(folded & 1);
+        // limit to sample-bits so corrupt data can't overflow later predictions
+        const TInt64 sample = static_cast<TInt64>(residual) + Predict(aSamples, i, order);
+        aSamples[i] = SignExtend(static_cast<TUint>(sample), aSampleBits);
+    }
+}
+
+TUint OhmLosslessDecoder::ReadBits(TUint aBits)
+{
+    if (aBits > iBitEnd - iBitPos) {
+        THROW(OhmLosslessCorrupt);
+    }
+    TUint value = 0;
+    while (aBits > 0) {
+        const TUint bitInByte = iBitPos & 7;
+        const TUint available = 8 - bitInByte;
+        const TUint count = std::min(available, aBits);
+        const TUint bits = (iPtr[iBitPos >> 3] >> (available - count)) & Mask(count);
+        value = (value << count) | bits;
+        iBitPos += count;
+        aBits -= count;
+    }
+    return value;
+}
+
+TUint OhmLosslessDecoder::ReadUnary()
+{
+    TUint zeros = 0;
+    for (;;) {
+        if (iBitPos == iBitEnd) {
+            THROW(OhmLosslessCorrupt);
+        }
+        const TUint bitInByte = iBitPos & 7;
+        const TUint bits = iPtr[iBitPos >> 3] & (0xff >> bitInByte);
+        if (bits == 0) {
+            // rest of this byte is zeros
+            zeros += 8 - bitInByte;
+            iBitPos += 8 - bitInByte;
+            continue;
+        }
+        TUint bit = 7 - bitInByte;
+        while ((bits & (1u << bit)) == 0) {
+            bit--;
+            zeros++;
+        }
+        iBitPos += (7 - bitInByte) - bit + 1;
+        return zeros;
+    }
+}
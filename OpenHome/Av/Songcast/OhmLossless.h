@@ -0,0 +1,122 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Standard.h>
+#include <OpenHome/Av/Songcast/OhmMsg.h>
+
+EXCEPTION(OhmLosslessCorrupt);
+
+namespace OpenHome {
+namespace Av {
+
+/**
+ * Lossless compression of the audio in Songcast frames.
+ *
+ * Each frame is coded independently as frames may be lost, resent or repaired out of order.
+ * Each channel is predicted using one of FLAC's fixed polynomial predictors, with the residuals
+ * Rice coded.  Stereo frames may instead code left/side, side/right or mid/side.
+ *
+ * Compressed frames are identified by a codec name starting with kCodecNamePrefix.  The rest
+ * of the name is the codec of the sender's source, which receivers report as before.
+ */
+class OhmLossless
+{
+public:
+    static const Brn kCodecNamePrefix;
+    static const TUint kMaxChannels = 8;
+public:
+    static TBool IsCompressed(const Brx& aCodecName);
+    static Brn SourceCodecName(const Brx& aCodecName); // aCodecName with any kCodecNamePrefix removed
+    static void SetCodecName(Bwx& aCodecName, const Brx& aSourceCodecName); // truncates aSourceCodecName to fit aCodecName
+protected:
+    enum EStereo
+    {
+        eIndependent
+       ,eLeftSide
+       ,eSideRight
+       ,eMidSide
+       ,eStereoModeCount
+    };
+    static const TUint kVersion = 1;
+    static const TUint kVersionBits = 4;
+    static const TUint kStereoBits = 4;
+    static const TUint kOrderBits = 3;
+    static const TUint kMaxOrder = 4;
+    static const TUint kRiceBits = 5;
+    static const TUint kMaxRice = 30;
+    static const TUint kRiceVerbatim = (1 << kRiceBits) - 1; // subframe holds samples rather than residuals
+    static const TUint kMaxSubsamples = OhmMsgAudio::kMaxSampleBytes; // at least one byte per subsample
+protected:
+    static TBool IsSupported(TUint aBitDepth, TUint aChannels);
+    static TBool IsSide(EStereo aMode, TUint aChannel);
+    static TInt Predict(const TInt* aSamples, TUint aIndex, TUint aOrder);
+    static TInt SignExtend(TUint aValue, TUint aBits);
+    static TUint Mask(TUint aBits);
+};
+
+class OhmLosslessEncoder : private OhmLossless, private INonCopyable
+{
+public:
+    OhmLosslessEncoder();
+    /**
+     * Compress big endian, interleaved pcm.
+     *
+     * @return     false if aPcm can't be compressed to fewer bytes (or its format isn't supported).
+     *             aEncoded is then undefined and aPcm should be sent instead.
+     */
+    TBool TryEncode(const Brx& aPcm, TUint aBitDepth, TUint aChannels, Bwx& aEncoded);
+private:
+    class Subframe
+    {
+    public:
+        const TInt* iSamples;
+        TUint iSampleBits;
+        TUint iOrder;
+        TUint iRice;
+        TUint64 iBits;
+    };
+private:
+    static TUint BestOrder(const TInt* aSamples, TUint aCount, TUint64& aAbsResidualTotal);
+    static void Plan(Subframe& aSubframe, TUint aCount);
+    static TUint64 RiceBits(const TInt* aSamples, TUint aCount, TUint aOrder, TUint aRice);
+    void WriteSubframe(const Subframe& aSubframe, TUint aCount);
+    void WriteBits(TUint aValue, TUint aBits);
+private:
+    TInt iSamples[kMaxSubsamples]; // deinterleaved; channel n starts at n * samples per channel
+    TInt iMid[kMaxSubsamples / 2];
+    TInt iSide[kMaxSubsamples / 2];
+    TByte* iPtr;
+    TUint iBitPos;
+};
+
+class OhmLosslessDecoder : private OhmLossless, private INonCopyable
+{
+public:
+    OhmLosslessDecoder();
+    /**
+     * Decompress audio produced by OhmLosslessEncoder into big endian, interleaved pcm.
+     *
+     * @exception  OhmLosslessCorrupt if aEncoded is not valid for the given format.
+     */
+    void Decode(const Brx& aEncoded, TUint aBitDepth, TUint aChannels, TUint aSamples, Bwx& aPcm);
+    /**
+     * As Decode() but replaces a corrupt frame with aSamples of silence (as many as fit in aPcm)
+     * so that later audio isn't played early.
+     *
+     * @return     false if aEncoded was corrupt.
+     */
+    TBool DecodeOrSilence(const Brx& aEncoded, TUint aBitDepth, TUint aChannels, TUint aSamples, Bwx& aPcm);
+private:
+    void ReadSubframe(TInt* aSamples, TUint aCount, TUint aSampleBits);
+    TUint ReadBits(TUint aBits);
+    TUint ReadUnary();
+private:
+    TInt iSamples[kMaxSubsamples];
+    const TByte* iPtr;
+    TUint iBitPos;
+    TUint iBitEnd;
+};
+
+} // namespace Av
+} // namespace OpenHome
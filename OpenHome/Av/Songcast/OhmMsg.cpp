@@ -96,6 +96,7 @@ OhmMsgAudio::OhmMsgAudio(OhmMsgFactory& aFactory)
 void OhmMsgAudio::Create()
 {
     OhmMsgTimestamped::Create();
+    ResetAudio();
 }
 
 void OhmMsgAudio::Create(IReader& aReader, const OhmHeader& aHeader)
@@ -196,10 +197,22 @@ void OhmMsgAudio::Create(TBool aHalt, TBool aLossless, TBool aTimestamped, TBool
     iUnifiedBuffer.SetBytes(iStreamHeaderOffset);
     iUnifiedBuffer.Append(aStreamHeader);
     iUnifiedBuffer.Append(aAudio);
+    ResetAudio();
     iAudio.SetBytes(aAudio.Bytes());
     iHeaderSerialised = false;
 }
 
+void OhmMsgAudio::ResetAudio()
+{
+    // a msg used for receiving may have left iAudio anywhere in iUnifiedBuffer
+    iAudio.Set(iUnifiedBuffer.Ptr() + kStreamHeaderBytes, 0, kMaxSampleBytes);
+}
+
+TUint OhmMsgAudio::AudioEnd() const
+{
+    return static_cast<TUint>(iAudio.Ptr() - iUnifiedBuffer.Ptr()) + iAudio.Bytes();
+}
+
 void OhmMsgAudio::ReinitialiseFields(TBool aHalt, TBool aLossless, TBool aTimestamped, TBool aResent,
                                      TUint aSamples, TUint aFrame, TUint aNetworkTimestamp, TUint aMediaLatency,
                                      TUint64 aSampleStart, const Brx& aStreamHeader)
@@ -356,7 +369,7 @@ void OhmMsgAudio::Process(IOhmMsgProcessor& aProcessor)
 void OhmMsgAudio::Externalise(IWriter& aWriter)
 {
     Serialise(); // prepends the ohm header, now ready to send!
-    iUnifiedBuffer.SetBytes(kStreamHeaderBytes+iAudio.Bytes());
+    iUnifiedBuffer.SetBytes(AudioEnd());
     aWriter.Write(iUnifiedBuffer.Split(iStreamHeaderOffset));
 }
 
@@ -419,10 +432,70 @@ void OhmMsgAudio::Serialise()
 
 Brn OhmMsgAudio::SendableBuffer()
 {
-    iUnifiedBuffer.SetBytes(kStreamHeaderBytes + iAudio.Bytes());
+    iUnifiedBuffer.SetBytes(AudioEnd());
     return iUnifiedBuffer.Split(iStreamHeaderOffset);
 }
 
+Bwx& OhmMsgAudio::ReceiveBuffer()
+{
+    iUnifiedBuffer.SetBytes(0);
+    return iUnifiedBuffer;
+}
+
+void OhmMsgAudio::Internalise(const OhmHeader& aHeader)
+{
+    ASSERT(aHeader.MsgType() == OhmHeader::kMsgTypeAudio ||
+           aHeader.MsgType() == OhmHeader::kMsgTypeAudioBlob);
+    // The datagram, starting with its Ohm header, is already in iUnifiedBuffer.  Leave it where it
+    // is; the header fields are read from it and Audio() refers to the samples that follow them.
+    static const TUint kAudioHeaderOffset = OhmHeader::kHeaderBytes;
+    if (aHeader.MsgBytes() < kHeaderBytes || kAudioHeaderOffset + aHeader.MsgBytes() > iUnifiedBuffer.Bytes()) {
+        THROW(OhmError);
+    }
+
+    ReaderBuffer rb(iUnifiedBuffer.Split(kAudioHeaderOffset, kHeaderBytes));
+    ReaderBinary reader(rb);
+    const TUint headerBytes = reader.ReadUintBe(1);
+    if (headerBytes != kHeaderBytes) {
+        THROW(OhmError);
+    }
+    const TUint flags = reader.ReadUintBe(1);
+    iHalt = ((flags & kFlagHalt) != 0);
+    iLossless = ((flags & kFlagLossless) != 0);
+    iTimestamped = ((flags & kFlagTimestamped) != 0);
+    iTimestamped2 = ((flags & kFlagTimestamped2) != 0);
+    iResent = ((flags & kFlagResent) != 0);
+    iSamples = reader.ReadUintBe(2);
+    iFrame = reader.ReadUintBe(4);
+    iNetworkTimestamp = reader.ReadUintBe(4);
+    iMediaLatency = reader.ReadUintBe(4);
+    iMediaTimestamp = reader.ReadUintBe(4);
+    iSampleStart = reader.ReadUint64Be(8);
+    iSamplesTotal = reader.ReadUint64Be(8);
+    iSampleRate = reader.ReadUintBe(4);
+    iBitRate = reader.ReadUintBe(4);
+    iVolumeOffset = reader.ReadIntBe(2);
+    iBitDepth = reader.ReadUintBe(1);
+    iChannels = reader.ReadUintBe(1);
+    (void)reader.ReadUintBe(1); // reserved
+    const TUint codecBytes = reader.ReadUintBe(1);
+    if (codecBytes > kMaxCodecBytes || kHeaderBytes + codecBytes > aHeader.MsgBytes()) {
+        THROW(OhmError);
+    }
+    const TUint codecOffset = kAudioHeaderOffset + kHeaderBytes;
+    iCodec.Replace(iUnifiedBuffer.Split(codecOffset, codecBytes));
+
+    const TUint audioOffset = codecOffset + codecBytes;
+    const TUint audioBytes = aHeader.MsgBytes() - kHeaderBytes - codecBytes;
+    if (audioBytes > kMaxSampleBytes) {
+        THROW(OhmError);
+    }
+    iAudio.Set(iUnifiedBuffer.Ptr() + audioOffset, audioBytes, audioBytes);
+    iUnifiedBuffer.SetBytes(audioOffset + audioBytes);
+    iStreamHeaderOffset = 0;
+    iHeaderSerialised = true;
+}
+
 
 // OhmMsgTrack
 
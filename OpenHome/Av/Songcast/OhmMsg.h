@@ -71,6 +71,7 @@ public:
     static const TUint kFlagResent        = 1 << 3;
     static const TUint kFlagTimestamped2  = 1 << 4;
     static const TUint kStreamHeaderBytes = 88; // 8 bytes Ohm header, 50 bytes audio header, 30 bytes codec name
+    static const TUint kMaxDatagramBytes  = 6 * 1024; // largest datagram ReceiveBuffer() accepts
 private:
     static const TUint kHeaderBytes = 50; // not including codec name
     static const TUint kReserved    = 0;
@@ -102,6 +103,12 @@ public:
     void SetResent(TBool aValue);
     void Serialise();
     Brn SendableBuffer();
+    /*
+     * Receiving without copying: read a datagram into ReceiveBuffer() then, if its header shows
+     * it is audio, Internalise() parses it in place.  Audio() then refers to the received bytes.
+     */
+    Bwx& ReceiveBuffer();
+    void Internalise(const OhmHeader& aHeader); // throws OhmError
 public: // from OhmMsg
     void Process(IOhmMsgProcessor& aProcessor) override;
     void Externalise(IWriter& aWriter) override;
@@ -115,6 +122,8 @@ private:
     void Create(TBool aHalt, TBool aLossless, TBool aTimestamped, TBool aResent, TUint aSamples, TUint aFrame,
                 TUint aNetworkTimestamp, TUint aMediaLatency, TUint64 aSampleStart, const Brx& aStreamHeader,
                 const Brx& aAudio);
+    void ResetAudio();
+    TUint AudioEnd() const;
 private:
     TBool iHalt;
     TBool iLossless;
@@ -134,7 +143,7 @@ private:
     TUint iBitDepth;
     TUint iChannels;
     Bws<kMaxCodecBytes> iCodec;
-    Bws<kStreamHeaderBytes+kMaxSampleBytes> iUnifiedBuffer;
+    Bws<kMaxDatagramBytes> iUnifiedBuffer; // also large enough for any datagram a receiver reads into it
     Bwn iAudio;
     TUint iStreamHeaderOffset;
     TBool iHeaderSerialised;
@@ -0,0 +1,51 @@
+#include <OpenHome/Av/Songcast/OhmReceiverCapabilities.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Private/Standard.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Av/Songcast/Ohm.h>
+#include <OpenHome/Av/Debug.h>
+
+using namespace OpenHome;
+using namespace OpenHome::Av;
+
+// OhmReceiverCapabilities
+
+OhmReceiverCapabilities::OhmReceiverCapabilities(TUint aTimeoutMs)
+    : iTimeoutMs(aTimeoutMs)
+{
+    Reset();
+}
+
+void OhmReceiverCapabilities::Reset()
+{
+    iJoined = false;
+    iLosslessUnsupported = false;
+    iLosslessUnsupportedMs = 0;
+}
+
+void OhmReceiverCapabilities::Joined(IReader& aReader, const OhmHeader& aHeader, TUint aNowMs)
+{
+    OhmHeaderJoin headerJoin;
+    headerJoin.Internalise(aReader, aHeader);
+    Joined(headerJoin.Capabilities(), aNowMs);
+}
+
+void OhmReceiverCapabilities::Joined(TUint aCapabilities, TUint aNowMs)
+{
+    iJoined = true;
+    if ((aCapabilities & OhmHeaderJoin::kCapabilityLossless) == 0) {
+        if (!iLosslessUnsupported) {
+            LOG(kSongcast, "OhmReceiverCapabilities: receiver can't play compressed audio\n");
+        }
+        iLosslessUnsupported = true;
+        iLosslessUnsupportedMs = aNowMs;
+    }
+    else if (iLosslessUnsupported && aNowMs - iLosslessUnsupportedMs >= iTimeoutMs) {
+        iLosslessUnsupported = false;
+    }
+}
+
+TBool OhmReceiverCapabilities::LosslessSupported() const
+{
+    return iJoined && !iLosslessUnsupported;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Private/Standard.h>
+
+namespace OpenHome {
+    class IReader;
+namespace Av {
+
+class OhmHeader;
+
+/**
+ * Whether every receiver of a sender can play audio compressed by OhmLossless.
+ *
+ * Receivers report their capabilities in the optional body of each Join and Listen msg.
+ * Those that predate OhmLossless send no body so have none.  Compression is only allowed once
+ * a receiver has joined and no receiver without OhmHeaderJoin::kCapabilityLossless has joined
+ * or listened for aTimeoutMs.  Receivers listen well within this time, so one that can't play
+ * compressed audio keeps compression off for as long as it is listening.
+ * Not thread-safe.
+ */
+class OhmReceiverCapabilities : private INonCopyable
+{
+public:
+    OhmReceiverCapabilities(TUint aTimeoutMs);
+    /**
+     * Forget all receivers.  Call when the sender stops sending.
+     */
+    void Reset();
+    /**
+     * Record a Join or Listen msg.  aReader is positioned after aHeader.
+     */
+    void Joined(IReader& aReader, const OhmHeader& aHeader, TUint aNowMs);
+    void Joined(TUint aCapabilities, TUint aNowMs);
+    TBool LosslessSupported() const;
+private:
+    const TUint iTimeoutMs;
+    TBool iJoined;
+    TBool iLosslessUnsupported;   // a receiver that can't play compressed audio joined or listened...
+    TUint iLosslessUnsupportedMs; // ...at this time
+};
+
+} // namespace Av
+} // namespace OpenHome
@@ -0,0 +1,130 @@
+#include <OpenHome/Av/Songcast/OhmRepairWindow.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Private/Standard.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Av/Songcast/OhmMsg.h>
+
+#include <string.h>
+
+using namespace OpenHome;
+using namespace OpenHome::Av;
+
+// OhmRepairWindow
+
+OhmRepairWindow::OhmRepairWindow(TUint aMaxFrames)
+    : iMaxFrames(aMaxFrames)
+    , iCapacity(RoundUpCapacity(aMaxFrames))
+    , iCount(0)
+    , iNextFrame(0)
+    , iEndFrame(0)
+{
+    iFrames = new OhmMsgAudio*[iCapacity];
+    (void)memset(iFrames, 0, iCapacity * sizeof(iFrames[0]));
+    const TUint words = iCapacity / kFramesPerWord;
+    iHeld = new TUint32[words];
+    (void)memset(iHeld, 0, words * sizeof(iHeld[0]));
+}
+
+OhmRepairWindow::~OhmRepairWindow()
+{
+    Reset(0);
+    delete[] iHeld;
+    delete[] iFrames;
+}
+
+TUint OhmRepairWindow::RoundUpCapacity(TUint aMaxFrames)
+{ // static
+    // never less than a whole word of iHeld
+    ASSERT(aMaxFrames > 0 && aMaxFrames <= (1u << 31));
+    TUint capacity = kFramesPerWord;
+    while (capacity < aMaxFrames) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+TUint OhmRepairWindow::MaxFrames() const
+{
+    return iMaxFrames;
+}
+
+TUint OhmRepairWindow::Count() const
+{
+    return iCount;
+}
+
+void OhmRepairWindow::Reset(TUint aNextFrame)
+{
+    for (TUint frame = iNextFrame; iCount > 0; frame++) {
+        const TUint index = frame & (iCapacity - 1);
+        if (IsHeld(index)) {
+            iFrames[index]->RemoveRef();
+            iFrames[index] = nullptr;
+            iCount--;
+        }
+    }
+    (void)memset(iHeld, 0, (iCapacity / kFramesPerWord) * sizeof(iHeld[0]));
+    iNextFrame = iEndFrame = aNextFrame;
+}
+
+TBool OhmRepairWindow::TryAdd(OhmMsgAudio& aMsg)
+{
+    const TUint frame = aMsg.Frame();
+    const TUint offset = frame - iNextFrame; // frames before iNextFrame wrap to large offsets
+    if (offset >= iMaxFrames) {
+        return false;
+    }
+    const TUint index = frame & (iCapacity - 1);
+    if (IsHeld(index)) {
+        aMsg.RemoveRef();
+        return true;
+    }
+    iFrames[index] = &aMsg;
+    iHeld[index / kFramesPerWord] |= 1u << (index % kFramesPerWord);
+    iCount++;
+    if (offset >= iEndFrame - iNextFrame) {
+        iEndFrame = frame + 1;
+    }
+    return true;
+}
+
+OhmMsgAudio* OhmRepairWindow::TryRemoveNext()
+{
+    const TUint index = iNextFrame & (iCapacity - 1);
+    if (!IsHeld(index)) {
+        return nullptr;
+    }
+    OhmMsgAudio* msg = iFrames[index];
+    iFrames[index] = nullptr;
+    iHeld[index / kFramesPerWord] &= ~(1u << (index % kFramesPerWord));
+    iCount--;
+    iNextFrame++;
+    return msg;
+}
+
+TUint OhmRepairWindow::WriteMissing(IWriter& aWriter, TUint aMaxFrames) const
+{
+    WriterBinary writer(aWriter);
+    TUint count = 0;
+    TUint frame = iNextFrame;
+    while (frame != iEndFrame && count < aMaxFrames) {
+        const TUint index = frame & (iCapacity - 1);
+        const TUint remaining = iEndFrame - frame;
+        if (index % kFramesPerWord == 0 && remaining >= kFramesPerWord && iHeld[index / kFramesPerWord] == 0xffffffff) {
+            // skip whole words of received frames
+            frame += kFramesPerWord;
+            continue;
+        }
+        if (!IsHeld(index)) {
+            writer.WriteUint32Be(frame);
+            count++;
+        }
+        frame++;
+    }
+    return count;
+}
+
+TBool OhmRepairWindow::IsHeld(TUint aIndex) const
+{
+    return (iHeld[aIndex / kFramesPerWord] & (1u << (aIndex % kFramesPerWord))) != 0;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Private/Standard.h>
+
+namespace OpenHome {
+    class IWriter;
+namespace Av {
+
+class OhmMsgAudio;
+
+/**
+ * Audio frames received out of order, held until the frames preceding them arrive.
+ *
+ * Frames are stored in a ring indexed by frame number modulo capacity, alongside a bitmap
+ * of which slots are occupied.  Adding, removing and duplicate detection are all constant
+ * time regardless of how many frames are held.
+ * Not thread-safe.
+ */
+class OhmRepairWindow : private INonCopyable
+{
+    static const TUint kFramesPerWord = 32;
+public:
+    OhmRepairWindow(TUint aMaxFrames);
+    ~OhmRepairWindow();
+    TUint MaxFrames() const;
+    TUint Count() const;
+    /**
+     * Release all held frames and expect aFrame to be the next frame removed.
+     */
+    void Reset(TUint aNextFrame);
+    /**
+     * Hold aMsg until all earlier frames have been removed.
+     * Takes ownership of aMsg if it is held.  Duplicates of held frames are released.
+     *
+     * @return     false if aMsg is outside the window (aMaxFrames or more ahead of the next
+     *             frame, or before it).  The caller retains ownership of aMsg.
+     */
+    TBool TryAdd(OhmMsgAudio& aMsg);
+    /**
+     * @return     The next frame, transferring ownership to the caller, or nullptr if it hasn't arrived yet.
+     */
+    OhmMsgAudio* TryRemoveNext();
+    /**
+     * Write (as big endian 32-bit ints) the numbers of frames missing between the next frame
+     * and the latest frame held.
+     *
+     * @return     Number of frames written; never more than aMaxFrames.
+     */
+    TUint WriteMissing(IWriter& aWriter, TUint aMaxFrames) const;
+private:
+    static TUint RoundUpCapacity(TUint aMaxFrames);
+    TBool IsHeld(TUint aIndex) const;
+private:
+    const TUint iMaxFrames;
+    const TUint iCapacity; // slots in iFrames; power of two so frame % capacity is consistent when frame numbers wrap
+    OhmMsgAudio** iFrames;
+    TUint32* iHeld; // bit per slot in iFrames
+    TUint iCount;
+    TUint iNextFrame;
+    TUint iEndFrame; // one past the latest frame held
+};
+
+} // namespace Av
+} // namespace OpenHome
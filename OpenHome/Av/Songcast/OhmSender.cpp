@@ -294,9 +294,93 @@ void ProviderSender::TimerAudioExpired()
 }
 
 
+// OhmSenderHistory
+
+OhmSenderHistory::Entry::Entry()
+    : iMsg(nullptr)
+    , iResentMs(0)
+    , iResent(false)
+{
+}
+
+OhmSenderHistory::OhmSenderHistory(Environment& aEnv, TUint aMaxFrames)
+    : iEnv(aEnv)
+    , iLock("OHMH")
+    , iMaxFrames(aMaxFrames)
+    , iNewest(0)
+    , iNextFrame(0)
+{
+    ASSERT(iMaxFrames > 0);
+    iEntries = new Entry[iMaxFrames];
+}
+
+OhmSenderHistory::~OhmSenderHistory()
+{
+    Clear();
+    delete[] iEntries;
+}
+
+TUint OhmSenderHistory::MaxFrames() const
+{
+    return iMaxFrames;
+}
+
+void OhmSenderHistory::Add(OhmMsgAudio& aMsg)
+{
+    AutoMutex _(iLock);
+    iNewest = (iNewest + 1) % iMaxFrames;
+    Entry& entry = iEntries[iNewest];
+    if (entry.iMsg != nullptr) {
+        entry.iMsg->RemoveRef();
+    }
+    entry.iMsg = &aMsg;
+    entry.iResent = false;
+    iNextFrame = aMsg.Frame() + 1;
+}
+
+void OhmSenderHistory::Clear()
+{
+    AutoMutex _(iLock);
+    for (TUint i=0; i<iMaxFrames; i++) {
+        if (iEntries[i].iMsg != nullptr) {
+            iEntries[i].iMsg->RemoveRef();
+            iEntries[i].iMsg = nullptr;
+        }
+    }
+    iNextFrame = 0;
+}
+
+OhmMsgAudio* OhmSenderHistory::TryGetForResend(TUint aFrame)
+{
+    AutoMutex _(iLock);
+    const TUint age = iNextFrame - 1 - aFrame; // frames we haven't sent yet wrap to large ages
+    if (age >= iMaxFrames) {
+        return nullptr;
+    }
+    // Index by age rather than frame number so that the ring stays contiguous when frame numbers wrap
+    Entry& entry = iEntries[(iNewest + iMaxFrames - age) % iMaxFrames];
+    if (entry.iMsg == nullptr || entry.iMsg->Frame() != aFrame) {
+        return nullptr;
+    }
+    const TUint nowMs = Time::Now(iEnv);
+    if (entry.iResent && nowMs - entry.iResentMs < kResendCoalesceMs) {
+        return nullptr;
+    }
+    entry.iResent = true;
+    entry.iResentMs = nowMs;
+    entry.iMsg->AddRef();
+    return entry.iMsg;
+}
+
+
 // OhmSenderDriver
 
 OhmSenderDriver::OhmSenderDriver(Environment& aEnv, Optional<IOhmTimestamper> aTimestamper)
+    : OhmSenderDriver(aEnv, aTimestamper, kDefaultHistoryFrames)
+{
+}
+
+OhmSenderDriver::OhmSenderDriver(Environment& aEnv, Optional<IOhmTimestamper> aTimestamper, TUint aHistoryFrames)
     : iMutex("OHMD")
     , iEnabled(false)
     , iActive(false)
@@ -305,13 +389,18 @@ OhmSenderDriver::OhmSenderDriver(Environment& aEnv, Optional<IOhmTimestamper> aT
     , iSampleRate(0)
     , iTimestampMultiplier(0)
     , iBytesPerSample(0)
+    , iBitDepth(0)
+    , iChannels(0)
     , iLossless(false)
+    , iCompress(false)
+    , iReceiversSupportCompression(false)
     , iSamplesTotal(0)
     , iSampleStart(0)
     , iLatencyMs(0)
     , iLatencyOhm(0)
     , iSocket(aEnv)
-    , iFactory(110, 10, 10) // FIXME - rationale for msg counts??
+    , iFactory(aHistoryFrames + 10, 10, 10) // history plus a few being prepared or resent
+    , iHistory(aEnv, aHistoryFrames)
     , iTimestamper(aTimestamper.Ptr())
     , iFirstFrame(true)
 {
@@ -330,11 +419,17 @@ void OhmSenderDriver::SetAudioFormat(TUint aSampleRate, TUint aBitRate, TUint aC
     iTimestampMultiplier = Media::Jiffies::SongcastTicksPerSecond(aSampleRate);
     UpdateLatencyOhm();
     iBytesPerSample = aChannels * aBitDepth / 8;
+    iBitDepth = aBitDepth;
+    iChannels = aChannels;
     iLossless = aLossless;
     iSampleStart = aSampleStart;
 
     iStreamHeader.Replace(Brx::Empty());
     OhmMsgAudio::GetStreamHeader(iStreamHeader, iSamplesTotal, aSampleRate, aBitRate, 0/*VolumeOffset*/, aBitDepth, aChannels, aCodecName);
+    Bws<OhmMsgAudio::kMaxCodecBytes> codecCompressed;
+    OhmLossless::SetCodecName(codecCompressed, aCodecName);
+    iStreamHeaderCompressed.Replace(Brx::Empty());
+    OhmMsgAudio::GetStreamHeader(iStreamHeaderCompressed, iSamplesTotal, aSampleRate, aBitRate, 0/*VolumeOffset*/, aBitDepth, aChannels, codecCompressed);
 
     if (iTimestamper != nullptr) {
         // ignore return value below - false just implies iTimestamper->Timestamp will throw
@@ -344,12 +439,28 @@ void OhmSenderDriver::SetAudioFormat(TUint aSampleRate, TUint aBitRate, TUint aC
 }
 
 OhmMsgAudio* OhmSenderDriver::CreateAudio()
+{
+    return iFactory.CreateAudio();
+}
+
+void OhmSenderDriver::SetCompression(TBool aEnabled)
 {
     AutoMutex mutex(iMutex);
-    if (iFifoHistory.SlotsUsed() == kMaxHistoryFrames) {
-        iFifoHistory.Read()->RemoveRef();
+    iCompress = aEnabled;
+}
+
+void OhmSenderDriver::SetReceiversSupportCompression(TBool aValue)
+{
+    AutoMutex mutex(iMutex);
+    iReceiversSupportCompression = aValue;
+}
+
+TBool OhmSenderDriver::TryCompressLocked(const Brx& aAudio)
+{
+    if (!iCompress || !iReceiversSupportCompression) {
+        return false;
     }
-    return iFactory.CreateAudio();
+    return iEncoder.TryEncode(aAudio, iBitDepth, iChannels, iCompressedAudio);
 }
 
 void OhmSenderDriver::SendAudio(const TByte* aData, TUint aBytes, TBool aHalt)
@@ -371,10 +482,6 @@ void OhmSenderDriver::SendAudio(const TByte* aData, TUint aBytes, TBool aHalt)
         // nothing to usefully communicate to receivers
         return;
     }
-    if (iFifoHistory.SlotsUsed() == kMaxHistoryFrames) {
-        iFifoHistory.Read()->RemoveRef();
-    }
-
     TBool isTimeStamped = false;
     TUint timeStamp = 0;
     if (iFirstFrame) {
@@ -388,6 +495,11 @@ void OhmSenderDriver::SendAudio(const TByte* aData, TUint aBytes, TBool aHalt)
         catch (OhmTimestampNotFound&) {}
     }
 
+    Brn audio(aData, aBytes);
+    const TBool compressed = TryCompressLocked(audio);
+    if (compressed) {
+        audio.Set(iCompressedAudio);
+    }
     OhmMsgAudio* msg = iFactory.CreateAudio(
         aHalt,
         iLossless,
@@ -398,12 +510,11 @@ void OhmSenderDriver::SendAudio(const TByte* aData, TUint aBytes, TBool aHalt)
         timeStamp, // network timestamp
         iLatencyOhm,
         iSampleStart,
-        iStreamHeader,
-        Brn(aData, aBytes)
+        compressed? iStreamHeaderCompressed : iStreamHeader,
+        audio
     );
 
     msg->Serialise();
-    iFifoHistory.Write(msg);
     try {
         iSocket.Send(msg->SendableBuffer(), iEndpoint);
     }
@@ -411,6 +522,7 @@ void OhmSenderDriver::SendAudio(const TByte* aData, TUint aBytes, TBool aHalt)
     }
 
     msg->SetResent(true);
+    iHistory.Add(*msg);
     iSampleStart += samples;
     iFrame++;
 }
@@ -436,10 +548,6 @@ void OhmSenderDriver::SendAudio(OhmMsgAudio* aMsg, TBool aHalt)
         aMsg->RemoveRef();
         return;
     }
-    if (iFifoHistory.SlotsUsed() == kMaxHistoryFrames) {
-        iFifoHistory.Read()->RemoveRef();
-    }
-
     TBool isTimeStamped = false;
     TUint timeStamp = 0;
     if (iFirstFrame) {
@@ -453,6 +561,10 @@ void OhmSenderDriver::SendAudio(OhmMsgAudio* aMsg, TBool aHalt)
         catch (OhmTimestampNotFound&) {}
     }
 
+    const TBool compressed = TryCompressLocked(aMsg->Audio());
+    if (compressed) {
+        aMsg->Audio().Replace(iCompressedAudio);
+    }
     aMsg->ReinitialiseFields(
         aHalt,
         iLossless,
@@ -463,11 +575,10 @@ void OhmSenderDriver::SendAudio(OhmMsgAudio* aMsg, TBool aHalt)
         timeStamp, // network timestamp
         iLatencyOhm,
         iSampleStart,
-        iStreamHeader
+        compressed? iStreamHeaderCompressed : iStreamHeader
     );
 
     aMsg->Serialise();
-    iFifoHistory.Write(aMsg);
     try {
         iSocket.Send(aMsg->SendableBuffer(), iEndpoint);
     }
@@ -475,6 +586,7 @@ void OhmSenderDriver::SendAudio(OhmMsgAudio* aMsg, TBool aHalt)
     }
 
     aMsg->SetResent(true);
+    iHistory.Add(*aMsg);
     iSampleStart += samples;
     iFrame++;
 }
@@ -555,11 +667,11 @@ void OhmSenderDriver::SetTrackPosition(TUint64 aSamplesTotal, TUint64 aSampleSta
     iSampleStart = aSampleStart;
 }
 
-void OhmSenderDriver::Resend(OhmMsgAudio& aMsg)
+void OhmSenderDriver::Resend(OhmMsgAudio& aMsg, const Endpoint& aEndpoint)
 {
     try {
         aMsg.Serialise();
-        iSocket.Send(aMsg.SendableBuffer(), iEndpoint);
+        iSocket.Send(aMsg.SendableBuffer(), aEndpoint);
     }
     catch (NetworkError&) {
     }
@@ -567,55 +679,27 @@ void OhmSenderDriver::Resend(OhmMsgAudio& aMsg)
 
 void OhmSenderDriver::Resend(const Brx& aFrames)
 {
-    AutoMutex mutex(iMutex);
+    /* Only claim iMutex long enough to copy the endpoint.
+       Frames are looked up in iHistory (which has its own lock) so SendAudio isn't blocked
+       while we service requests for many frames. */
+    Endpoint endpoint;
+    {
+        AutoMutex mutex(iMutex);
+        endpoint.Replace(iEndpoint);
+    }
     LOG(kSongcast, "RESEND");
 
     ReaderBuffer buffer(aFrames);
     ReaderBinary reader(buffer);
-    TUint frames = aFrames.Bytes() / 4;
-    TUint frame = reader.ReadUintBe(4);
-    frames--;
-    LOG(kSongcast, " %lu", (unsigned long)frame);
-    TBool found = false;
-    TUint count = iFifoHistory.SlotsUsed();
-    for (TUint i = 0; i < count; i++) {
-        OhmMsgAudio* msg = iFifoHistory.Read();
-        if (!found) {
-            TInt diff = frame - msg->Frame();
-            if (diff == 0) {
-                Resend(*msg);
-                if (frames-- > 0) {
-                    frame = reader.ReadUintBe(4);
-                }
-                else {
-                    found = true;
-                }
-            }
-            else {
-                while (diff < 0) {
-                    if (frames-- > 0) {
-                        frame = reader.ReadUintBe(4);
-                    }
-                    else {
-                        found = true;
-                        break;
-                    }
-                    diff = frame - msg->Frame();
-                    if (diff == 0) {
-                        Resend(*msg);
-                        if (frames-- > 0) {
-                            frame = reader.ReadUintBe(4);
-                        }
-                        else {
-                            found = true;
-                        }
-                        break;
-                    }
-                }
-            }
+    const TUint frames = aFrames.Bytes() / 4;
+    for (TUint i = 0; i < frames; i++) {
+        const TUint frame = reader.ReadUintBe(4);
+        OhmMsgAudio* msg = iHistory.TryGetForResend(frame);
+        if (msg != nullptr) {
+            LOG(kSongcast, " %u", frame);
+            Resend(*msg, endpoint);
+            msg->RemoveRef();
         }
-
-        iFifoHistory.Write(msg);
     }
     LOG(kSongcast, "\n");
 }
@@ -628,10 +712,7 @@ void OhmSenderDriver::ResetLocked()
     if (iTimestamper != nullptr) {
         iTimestamper->Stop();
     }
-    const TUint count = iFifoHistory.SlotsUsed();
-    for (TUint i = 0; i < count; i++) {
-        iFifoHistory.Read()->RemoveRef();
-    }
+    iHistory.Clear();
 }
 
 
@@ -664,6 +745,7 @@ OhmSender::OhmSender(Environment& aEnv, Net::DvDeviceStandard& aDevice, IOhmSend
     , iSequenceTrack(0)
     , iSequenceMetatext(0)
     , iClientControllingTrackMetadata(false)
+    , iReceiverCapabilities(kTimerAliveJoinTimeoutMs)
 {
     iProvider = new ProviderSender(aEnv, iDevice);
     CurrentSubnetChanged(); // roundabout way of initialising iInterface
@@ -980,6 +1062,7 @@ void OhmSender::RunMulticast()
                         LOG(kSongcast, "OhmSender::RunMulticast join/listen received\n");
                         
                         AutoMutex mutex(iMutexActive);
+                        ReceiverJoined(header);
                         
                         if (header.MsgType() == OhmHeader::kMsgTypeJoin) {
                             SendTrack();
@@ -1056,6 +1139,7 @@ void OhmSender::RunMulticast()
             iAliveBlocked = false;
             iProvider->NotifyListeners(false);
             iProvider->SetStatusBlocked(iAliveBlocked);
+            ResetReceiverCapabilities();
         }
         
         iNetworkDeactivated.Signal();
@@ -1081,6 +1165,10 @@ void OhmSender::RunUnicast()
                         
                         if (header.MsgType() <= OhmHeader::kMsgTypeListen) {
                             LOG(kSongcast, "OhmSender::RunUnicast ready/join or listen (%u)\n", header.MsgType());
+                            { // scope for AutoMutex
+                                AutoMutex mutex(iMutexActive);
+                                ReceiverJoined(header);
+                            }
                             break;                        
                         }
                     }
@@ -1113,6 +1201,10 @@ void OhmSender::RunUnicast()
                         header.Internalise(iRxBuffer);
                         
                         if (header.MsgType() == OhmHeader::kMsgTypeJoin) {
+                            { // scope for AutoMutex
+                                AutoMutex mutex(iMutexActive);
+                                ReceiverJoined(header);
+                            }
                             Endpoint sender(iSocketOhm.Sender());
                             if (Debug::TestLevel(Debug::kSongcast)) {
                                 Endpoint::EndpointBuf endptBuf;
@@ -1152,6 +1244,10 @@ void OhmSender::RunUnicast()
                             SendMetatext();
                         }
                         else if (header.MsgType() == OhmHeader::kMsgTypeListen) {
+                            { // scope for AutoMutex
+                                AutoMutex mutex(iMutexActive);
+                                ReceiverJoined(header);
+                            }
                             Endpoint sender(iSocketOhm.Sender());
                             if (sender.Equals(iTargetEndpoint)) {
                                 iTimerExpiry->FireIn(kTimerExpiryTimeoutMs);
@@ -1241,6 +1337,7 @@ void OhmSender::RunUnicast()
                 iAliveJoined = false;               
                 iDriver.SetActive(false);
                 iProvider->NotifyListeners(false);
+                ResetReceiverCapabilities();
                 LOG(kSongcast, "OHM SENDER DRIVER ACTIVE %d\n", iActive);
             }
         }
@@ -1262,6 +1359,7 @@ void OhmSender::RunUnicast()
             iAliveBlocked = false;
             iProvider->NotifyListeners(false);
             iProvider->SetStatusBlocked(iAliveBlocked);
+            ResetReceiverCapabilities();
         }
 
         iNetworkDeactivated.Signal();
@@ -1504,3 +1602,15 @@ TUint OhmSender::FindSlave(const Endpoint& aEndpoint)
     }
     return iSlaveCount;
 }
+
+void OhmSender::ReceiverJoined(const OhmHeader& aHeader)
+{
+    iReceiverCapabilities.Joined(iRxBuffer, aHeader, Time::Now(iEnv));
+    iDriver.SetReceiversSupportCompression(iReceiverCapabilities.LosslessSupported());
+}
+
+void OhmSender::ResetReceiverCapabilities()
+{
+    iReceiverCapabilities.Reset();
+    iDriver.SetReceiversSupportCompression(false);
+}
@@ -15,6 +15,8 @@
 #include "OhmMsg.h"
 #include "OhmSocket.h"
 #include "OhmSenderDriver.h"
+#include "OhmLossless.h"
+#include "OhmReceiverCapabilities.h"
 
 namespace OpenHome {
 class Environment;
@@ -23,16 +25,67 @@ namespace Av {
 class ProviderSender;
 class IOhmTimestamper;
 
+/**
+ * Recently sent audio frames, available for resending to receivers that missed them.
+ *
+ * Frames are held in a ring, in the order they were sent, so each lookup is constant time.
+ * Uses its own lock so resends don't block the audio send path.
+ */
+class OhmSenderHistory : private INonCopyable
+{
+    friend class SuiteOhmSenderHistory;
+    static const TUint kResendCoalesceMs = 20; // less than a receiver's retry interval so lost resends are still retried
+public:
+    OhmSenderHistory(Environment& aEnv, TUint aMaxFrames);
+    ~OhmSenderHistory();
+    TUint MaxFrames() const;
+    /**
+     * Add aMsg, replacing any frame that is now too old to be held.  Takes ownership of aMsg.
+     */
+    void Add(OhmMsgAudio& aMsg);
+    void Clear();
+    /**
+     * @return     aFrame with an extra reference claimed, or nullptr if it is no longer held
+     *             or was resent very recently (one resend serves all receivers that missed it).
+     */
+    OhmMsgAudio* TryGetForResend(TUint aFrame);
+private:
+    class Entry
+    {
+    public:
+        Entry();
+    public:
+        OhmMsgAudio* iMsg;
+        TUint iResentMs;
+        TBool iResent;
+    };
+private:
+    Environment& iEnv;
+    Mutex iLock;
+    const TUint iMaxFrames;
+    Entry* iEntries;
+    TUint iNewest;    // index of the latest frame added
+    TUint iNextFrame; // one past the latest frame added
+};
+
 class OhmSenderDriver : public IOhmSenderDriver
 {
     static const TUint kMaxAudioFrameBytes = 6 * 1024;
-    static const TUint kMaxHistoryFrames = 100;
+public:
+    static const TUint kDefaultHistoryFrames = 100;
 public:
     OhmSenderDriver(Environment& aEnv, Optional<IOhmTimestamper> aTimestamper);
+    OhmSenderDriver(Environment& aEnv, Optional<IOhmTimestamper> aTimestamper, TUint aHistoryFrames);
     void SetAudioFormat(TUint aSampleRate, TUint aBitRate, TUint aChannels, TUint aBitDepth, TBool aLossless, const Brx& aCodecName, TUint64 aSampleStart);
     void SendAudio(const TByte* aData, TUint aBytes, TBool aHalt = false);
     OhmMsgAudio* CreateAudio();
     void SendAudio(OhmMsgAudio* aMsg, TBool aHalt = false);
+    /*
+     * Losslessly compress audio where this reduces its size.  Off by default.  Even when
+     * enabled, audio is only compressed while OhmSender reports that every receiver listening
+     * can play it; receivers that predate OhmLossless can't.
+     */
+    void SetCompression(TBool aEnabled);
 private: // from IOhmSenderDriver
     void SetEnabled(TBool aValue) override;
     void SetActive(TBool aValue) override;
@@ -42,10 +95,12 @@ private: // from IOhmSenderDriver
     void SetTrackPosition(TUint64 aSampleStart, TUint64 aSamplesTotal) override;
     void Resend(const Brx& aFrames) override;
     void StreamInterrupted() override;
+    void SetReceiversSupportCompression(TBool aValue) override;
 private:
     inline void UpdateLatencyOhm();
     void ResetLocked();
-    void Resend(OhmMsgAudio& aMsg);
+    void Resend(OhmMsgAudio& aMsg, const Endpoint& aEndpoint);
+    TBool TryCompressLocked(const Brx& aAudio);
 private:
     Mutex iMutex;
     TBool iEnabled;
@@ -54,18 +109,25 @@ private:
     Endpoint iEndpoint;
     TIpAddress iAdapter;
     Bws<OhmMsgAudio::kStreamHeaderBytes> iStreamHeader;
+    Bws<OhmMsgAudio::kStreamHeaderBytes> iStreamHeaderCompressed;
     TUint iFrame;
     TUint iSampleRate;
     TUint iTimestampMultiplier;
     TUint iBytesPerSample;
+    TUint iBitDepth;
+    TUint iChannels;
     TBool iLossless;
+    TBool iCompress;
+    TBool iReceiversSupportCompression;
+    OhmLosslessEncoder iEncoder;
+    Bws<OhmMsgAudio::kMaxSampleBytes> iCompressedAudio;
     TUint64 iSamplesTotal;
     TUint64 iSampleStart;
     TUint iLatencyMs;
     TUint iLatencyOhm;
     SocketUdp iSocket;
     OhmMsgFactory iFactory;
-    FifoLite<OhmMsgAudio*, kMaxHistoryFrames> iFifoHistory;
+    OhmSenderHistory iHistory;
     IOhmTimestamper* iTimestamper;
     TBool iFirstFrame;
 };
@@ -129,6 +191,8 @@ private:
     TUint FindSlave(const Endpoint& aEndpoint);
     void RemoveSlave(TUint aIndex);
     TBool CheckSlaveExpiry();
+    void ReceiverJoined(const OhmHeader& aHeader); // called with iMutexActive held
+    void ResetReceiverCapabilities();               // called with iMutexActive held
 private:
     Environment& iEnv;
     Net::DvDeviceStandard& iDevice;
@@ -175,6 +239,7 @@ private:
     TUint iSequenceTrack;
     TUint iSequenceMetatext;
     TBool iClientControllingTrackMetadata;
+    OhmReceiverCapabilities iReceiverCapabilities;
 };
 
 } // namespace Av
@@ -18,6 +18,7 @@ public:
     virtual void SetTrackPosition(TUint64 aSampleStart, TUint64 aSamplesTotal) = 0;
     virtual void Resend(const Brx& aFrames) = 0;
     virtual void StreamInterrupted() = 0;
+    virtual void SetReceiversSupportCompression(TBool aValue) = 0; // every receiver listening can play OhmLossless audio
     virtual ~IOhmSenderDriver() {}
 };
 
@@ -1,10 +1,26 @@
 #include "OhmSocket.h"
 #include <OpenHome/Private/Debug.h>
 #include <OpenHome/Av/Debug.h>
+#include <OpenHome/Private/Timer.h>
 
 using namespace OpenHome;
 using namespace OpenHome::Av;
 
+// OhmSocketStats
+
+OhmSocketStats::OhmSocketStats()
+{
+    Clear();
+}
+
+void OhmSocketStats::Clear()
+{
+    iReceived = 0;
+    iMaxLatencyMs = 0;
+    iTotalLatencyMs = 0;
+}
+
+
 // OhmSocket
 
 // Sends on same socket in Unicast mode, but different socket in Multicast mode
@@ -16,6 +32,8 @@ OhmSocket::OhmSocket(Environment& aEnv)
     , iReader(0)
     , iLock("OHMS")
     , iInterrupt(false)
+    , iDatagramRead(false)
+    , iDatagramReadMs(0)
 {
 }
 
@@ -93,6 +111,7 @@ void OhmSocket::Close()
     iRxSocket = nullptr;
     delete iTxSocket;
     iTxSocket = nullptr;
+    iDatagramRead = false;
 }
 
 void OhmSocket::Interrupt(TBool aInterrupt)
@@ -107,10 +126,33 @@ void OhmSocket::Interrupt(TBool aInterrupt)
     }
 }
 
+OhmSocketStats OhmSocket::TakeStats()
+{
+    AutoMutex _(iLock);
+    const OhmSocketStats stats = iStats;
+    iStats.Clear();
+    return stats;
+}
+
 void OhmSocket::Read(Bwx& aBuffer)
 {
     ASSERT(iReader);
+    {
+        AutoMutex _(iLock);
+        if (iDatagramRead) {
+            const TUint latencyMs = Time::Now(iEnv) - iDatagramReadMs;
+            iStats.iTotalLatencyMs += latencyMs;
+            if (latencyMs > iStats.iMaxLatencyMs) {
+                iStats.iMaxLatencyMs = latencyMs;
+            }
+            iDatagramRead = false;
+        }
+    }
     iReader->Read(aBuffer);
+    AutoMutex _(iLock);
+    iStats.iReceived++;
+    iDatagramRead = true;
+    iDatagramReadMs = Time::Now(iEnv);
 }
 
 void OhmSocket::ReadFlush()
@@ -11,6 +11,25 @@ namespace OpenHome {
 class Environment;
 namespace Av {
 
+/**
+ * Receive statistics for an OhmSocket, read and cleared by OhmSocket::TakeStats().
+ *
+ * OhmSocket has no receive queue of its own; the kernel drops datagrams if the reading thread
+ * stays away from the socket for longer than its receive buffer can cover.  The latency here is
+ * how long that was after each datagram.  Datagrams that were dropped (here or on the network)
+ * show up as gaps in audio frame numbers, counted by ProtocolOhBase.
+ */
+class OhmSocketStats
+{
+public:
+    OhmSocketStats();
+    void Clear();
+public:
+    TUint iReceived;        // datagrams read
+    TUint iMaxLatencyMs;    // longest between a datagram being read and the next Read()
+    TUint64 iTotalLatencyMs;
+};
+
 class OhmSocket : public IReaderSource, public INonCopyable
 {
     static const TUint kSendBufBytes = 16 * 1024;
@@ -25,8 +44,9 @@ public:
     void Send(const Brx& aBuffer, const Endpoint& aEndpoint);
     void Close();
     void Interrupt(TBool aInterrupt);
+    OhmSocketStats TakeStats();
 public: // from IReaderSource
-    void Read(Bwx& aBuffer) override;
+    void Read(Bwx& aBuffer) override; // reads a single datagram
     void ReadFlush() override;
     void ReadInterrupt() override;
 private:
@@ -37,6 +57,9 @@ private:
     Endpoint iThis;
     Mutex iLock;
     TBool iInterrupt;
+    OhmSocketStats iStats; // protected by iLock
+    TBool iDatagramRead;   // a datagram has been read since the last Read() call
+    TUint iDatagramReadMs;
 };
 
 class OhzSocket : public IReaderSource, public INonCopyable
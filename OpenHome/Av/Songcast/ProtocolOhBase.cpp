@@ -23,13 +23,12 @@ using namespace OpenHome::Media;
 
 ProtocolOhBase::ProtocolOhBase(Environment& aEnv, IOhmMsgFactory& aFactory, Media::TrackFactory& aTrackFactory,
                                Optional<IOhmTimestamper> aTimestamper, const TChar* aSupportedScheme, const Brx& aMode,
-                               Optional<Av::IOhmMsgProcessor> aOhmMsgProcessor)
+                               Optional<Av::IOhmMsgProcessor> aOhmMsgProcessor, TUint aRepairFrames)
     : Protocol(aEnv)
     , iEnv(aEnv)
     , iMsgFactory(aFactory)
     , iSupply(nullptr)
     , iSocket(aEnv)
-    , iReadBuffer(iSocket)
     , iMode(aMode)
     , iStreamId(IPipelineIdProvider::kStreamIdInvalid)
     , iMutexTransport("POHB")
@@ -49,13 +48,16 @@ ProtocolOhBase::ProtocolOhBase(Environment& aEnv, IOhmMsgFactory& aFactory, Medi
     , iSampleRate(0)
     , iNumChannels(0)
     , iLatency(0)
-    , iRepairFirst(nullptr)
+    , iRepairFrames(aRepairFrames)
     , iPipelineEmpty("OHBS", 0)
     , iOhmMsgProcessor(aOhmMsgProcessor)
+    , iDatagramMsg(nullptr)
+    , iStatsLogMs(0)
+    , iStatsFramesMissed(0)
+    , iStatsRepairsAbandoned(0)
 {
     iNacnId = iEnv.NetworkAdapterList().AddCurrentChangeListener(MakeFunctor(*this, &ProtocolOhBase::CurrentSubnetChanged), "ProtocolOhBase", false);
     iTimerRepair = new Timer(aEnv, MakeFunctor(*this, &ProtocolOhBase::TimerRepairExpired), "ProtocolOhBaseRepair");
-    iRepairFrames.reserve(kMaxRepairBacklogFrames);
     iTimerJoin = new Timer(aEnv, MakeFunctor(*this, &ProtocolOhBase::SendJoin), "ProtocolOhBaseJoin");
     iTimerListen = new Timer(aEnv, MakeFunctor(*this, &ProtocolOhBase::SendListen), "ProtocolOhBaseListen");
 
@@ -66,6 +68,7 @@ ProtocolOhBase::ProtocolOhBase(Environment& aEnv, IOhmMsgFactory& aFactory, Medi
 
 ProtocolOhBase::~ProtocolOhBase()
 {
+    ReleaseDatagram();
     iEnv.NetworkAdapterList().RemoveCurrentChangeListener(iNacnId);
     delete iTimerRepair;
     delete iTimerJoin;
@@ -125,10 +128,19 @@ void ProtocolOhBase::SendListen()
 
 void ProtocolOhBase::Send(TUint aType)
 {
-    Bws<OhmHeader::kHeaderBytes> buffer;
+    Bws<OhmHeader::kHeaderBytes + OhmHeaderJoin::kHeaderBytes> buffer;
     WriterBuffer writer(buffer);
-    OhmHeader msg(aType, 0);
-    msg.Externalise(writer);
+    if (aType == OhmHeader::kMsgTypeJoin || aType == OhmHeader::kMsgTypeListen) {
+        // tell the sender we can decode compressed audio (see OutputAudio())
+        OhmHeaderJoin headerJoin(OhmHeaderJoin::kCapabilityLossless);
+        OhmHeader msg(aType, headerJoin.MsgBytes());
+        msg.Externalise(writer);
+        headerJoin.Externalise(writer);
+    }
+    else {
+        OhmHeader msg(aType, 0);
+        msg.Externalise(writer);
+    }
     try {
         iSocket.Send(buffer, iEndpoint);
     }
@@ -161,6 +173,58 @@ void ProtocolOhBase::WaitForPipelineToEmpty()
     LOG(kSongcast, "< ProtocolOhBase::WaitForPipelineToEmpty()\n");
 }
 
+void ProtocolOhBase::ReadDatagram(OhmHeader& aHeader)
+{
+    ReleaseDatagram();
+    iDatagramMsg = iMsgFactory.CreateAudio();
+    Bwx& buf = iDatagramMsg->ReceiveBuffer();
+    iSocket.Read(buf);
+    if (Time::Now(iEnv) - iStatsLogMs >= kStatsLogIntervalMs) {
+        LogStats();
+    }
+    iDatagram.Set(buf);
+    aHeader.Internalise(iDatagram);
+}
+
+OhmMsgAudio* ProtocolOhBase::TakeAudio(const OhmHeader& aHeader)
+{
+    ASSERT(iDatagramMsg != nullptr);
+    OhmMsgAudio* msg = iDatagramMsg;
+    iDatagramMsg = nullptr;
+    iDatagram.Set(Brx::Empty());
+    try {
+        msg->Internalise(aHeader);
+    }
+    catch (OhmError&) {
+        msg->RemoveRef();
+        throw;
+    }
+    return msg;
+}
+
+void ProtocolOhBase::ReleaseDatagram()
+{
+    iDatagram.Set(Brx::Empty());
+    if (iDatagramMsg != nullptr) {
+        iDatagramMsg->RemoveRef();
+        iDatagramMsg = nullptr;
+    }
+}
+
+void ProtocolOhBase::LogStats()
+{
+    const OhmSocketStats stats = iSocket.TakeStats();
+    const TUint avgLatencyMs = (stats.iReceived == 0? 0 : (TUint)(stats.iTotalLatencyMs / stats.iReceived));
+    iMutexTransport.Wait();
+    const TUint framesMissed = iStatsFramesMissed;
+    const TUint repairsAbandoned = iStatsRepairsAbandoned;
+    iStatsFramesMissed = iStatsRepairsAbandoned = 0;
+    iMutexTransport.Signal();
+    LOG_INFO(kSongcast, "ProtocolOhBase received: %u, frames missed: %u, repairs abandoned: %u, latency (ms) avg: %u, max: %u\n",
+             stats.iReceived, framesMissed, repairsAbandoned, avgLatencyMs, stats.iMaxLatencyMs);
+    iStatsLogMs = Time::Now(iEnv);
+}
+
 void ProtocolOhBase::Interrupt(TBool aInterrupt)
 {
     iSocket.Interrupt(aInterrupt);
@@ -188,6 +252,7 @@ ProtocolStreamResult ProtocolOhBase::Stream(const Brx& aUri)
         return EProtocolStreamErrorUnrecoverable;
     }
     ProtocolStreamResult res;
+    iStatsLogMs = Time::Now(iEnv);
     do {
         iMutexTransport.Wait();
         TIpAddress addr = iAddr;
@@ -198,6 +263,8 @@ ProtocolStreamResult ProtocolOhBase::Stream(const Brx& aUri)
         }
         res = Play(addr, kTtl, ep);
     } while (res != EProtocolStreamStopped);
+    ReleaseDatagram();
+    LogStats();
 
     iMutexTransport.Wait();
     RepairReset();
@@ -254,7 +321,14 @@ void ProtocolOhBase::CurrentSubnetChanged()
 TBool ProtocolOhBase::RepairBegin(OhmMsgAudio& aMsg)
 {
     LOG(kSongcast, "BEGIN ON %d\n", aMsg.Frame());
-    iRepairFirst = &aMsg;
+    iRepairFrames.Reset(iFrame + 1);
+    if (!iRepairFrames.TryAdd(aMsg)) {
+        // too many frames missing to repair
+        iStatsRepairsAbandoned++;
+        RepairReset();
+        aMsg.RemoveRef();
+        return false;
+    }
     iTimerRepair->FireIn(iEnv.Random(kInitialRepairTimeoutMs));
     return true;
 }
@@ -267,14 +341,7 @@ void ProtocolOhBase::RepairReset()
     iMutexTransport.Signal();
     iTimerRepair->Cancel();
     iMutexTransport.Wait();
-    if (iRepairFirst != nullptr) {
-        iRepairFirst->RemoveRef();
-        iRepairFirst = nullptr;
-    }
-    for (TUint i=0; i<iRepairFrames.size(); i++) {
-        iRepairFrames[i]->RemoveRef();
-    }
-    iRepairFrames.clear();
+    iRepairFrames.Reset(0);
     iRunning = false;
     iRepairing = false; // FIXME - not absolutely required as test for iRunning takes precedence in Process(OhmMsgAudio&
     iStreamMsgDue = true; // a failed repair implies a discontinuity in audio.  This should be noted as a new stream.
@@ -287,7 +354,7 @@ TBool ProtocolOhBase::Repair(OhmMsgAudio& aMsg)
     LOG(kSongcast, "GOT %d\n", frame);
 
     // get difference between this and the last frame sent down the pipeline
-    TInt diff = frame - iFrame;
+    const TInt diff = frame - iFrame;
     if (diff < 1) {
         TBool repairing = true;
         if (!aMsg.Resent()) {
@@ -300,107 +367,27 @@ TBool ProtocolOhBase::Repair(OhmMsgAudio& aMsg)
         aMsg.RemoveRef();
         return repairing;
     }
-    if (diff > (TInt)kMaxRepairBacklogFrames) {
+    if (!iRepairFrames.TryAdd(aMsg)) {
         // we're so far behind that we can't fit all the missing frames into iRepairFrames
+        iStatsRepairsAbandoned++;
         RepairReset();
         aMsg.RemoveRef();
         return false;
     }
-    if (diff == 1) {
-        // incoming frame is one greater than the last frame sent down the pipeline, so send this ...
-        iFrame++;
-        OutputAudio(aMsg);
-        // ... and see if the current first waiting frame is now also ready to be sent
-        while (iRepairFirst->Frame() == iFrame + 1) {
-            // ... yes, it is, so send it
-            iFrame++;
-            OutputAudio(*iRepairFirst);
-            // ... and see if there are further messages waiting
-            if (iRepairFrames.size() == 0) {
-                // ... no, so we have completed the repair
-                iRepairFirst = nullptr;
-                LOG(kSongcast, "END\n");
-                return false;
-            }
-            // ... yes, so update the current first waiting frame and continue testing to see if this can also be sent
-            iRepairFirst = iRepairFrames[0];
-            iRepairFrames.erase(iRepairFrames.begin());
-        }
-        // ... we're done
-        return true;
-    }
-
-    // Ok, its a frame that needs to be put into the backlog, but where?
-    // compare it to the current first waiting frame
-    diff = frame - iRepairFirst->Frame();
-    if (diff == 0) {
-        // it's equal to the currently first waiting frame, so discard it - it's a duplicate
-        aMsg.RemoveRef();
-        return true;
-    }
-    if (diff < 0) {
-        // it's earlier than the current first waiting message, so it should become the new current first waiting frame
-        // and the old first waiting frame needs to be injected into the start of the backlog, so inject it into the end
-        // and rotate the others (if there is space to add another frame)
-        if (iRepairFrames.size() == kMaxRepairBacklogFrames) {
-            // can't fit another frame into the backlog
-            RepairReset();
-            aMsg.RemoveRef();
-            return false;
+    // send any frames that now follow on from the last frame sent down the pipeline
+    for (;;) {
+        OhmMsgAudio* msg = iRepairFrames.TryRemoveNext();
+        if (msg == nullptr) {
+            break;
         }
-        iRepairFrames.insert(iRepairFrames.begin(), iRepairFirst);
-        iRepairFirst = &aMsg;
-        return true;
-    }
-    // ok, it's after the currently first waiting frame, so it needs to go into the backlog
-    // first check if the backlog is empty
-    if (iRepairFrames.size() == 0) {
-        // ... yes, so just inject it
-        iRepairFrames.insert(iRepairFrames.begin(), &aMsg);
-        return true;
-    }
-    // ok, so the backlog is not empty
-    // is it a duplicate of the last frame in the backlog?
-    diff = frame - iRepairFrames[iRepairFrames.size()-1]->Frame();
-    if (diff == 0) {
-        // ... yes, so discard
-        aMsg.RemoveRef();
-        return true;
+        iFrame++;
+        OutputAudio(*msg);
     }
-    // is the incoming frame later than the last one currently in the backlog?
-    if (diff > 0) {
-        // ... yes, so, again, just inject it (if there is space)
-        if (iRepairFrames.size() == kMaxRepairBacklogFrames) {
-            // can't fit another frame into the backlog
-            RepairReset();
-            aMsg.RemoveRef();
-            return false;
-        }
-        iRepairFrames.push_back(&aMsg);
-        return true;
-    }
-    // ... no, so it has to go somewhere in the middle of the backlog, so iterate through and inject it at the right place (if there is space)
-    TUint count = iRepairFrames.size();
-    for (auto it = iRepairFrames.begin(); it != iRepairFrames.end(); ++it) {
-        diff = frame - (*it)->Frame();
-        if (diff > 0) {
-            continue;
-        }
-        if (diff == 0) {
-            aMsg.RemoveRef();
-        }
-        else {
-            if (count == kMaxRepairBacklogFrames) {
-                // can't fit another frame into the backlog
-                aMsg.RemoveRef();
-                RepairReset();
-                return false;
-            }
-            iRepairFrames.insert(it, &aMsg);
-        }
-        break;
+    if (iRepairFrames.Count() == 0) {
+        // ... nothing left waiting, so we have completed the repair
+        LOG(kSongcast, "END\n");
+        return false;
     }
-
     return true;
 }
 
@@ -408,38 +395,10 @@ void ProtocolOhBase::TimerRepairExpired()
 {
     AutoMutex a(iMutexTransport);
     if (iRepairing) {
-        LOG(kSongcast, "REQUEST RESEND");
         Bws<kMaxRepairMissedFrames * 4> missed;
         WriterBuffer buffer(missed);
-        WriterBinary writer(buffer);
-
-        TUint count = 0;
-        TUint start = iFrame + 1;
-        TUint end = iRepairFirst->Frame();
-
-        // phase 1 - request the frames between the last sent down the pipeline and the first waiting frame
-        for (TUint i = start; i < end; i++) {
-            writer.WriteUint32Be(i);
-            LOG(kSongcast, " %d", i);
-            if (++count == kMaxRepairMissedFrames) {
-                break;
-            }
-        }
-
-        // phase 2 - if there is room add the missing frames in the backlog
-        for (TUint j = 0; count < kMaxRepairMissedFrames && j < iRepairFrames.size(); j++) {
-            OhmMsgAudio* msg = iRepairFrames[j];
-            start = end + 1;
-            end = msg->Frame();
-            for (TUint i = start; i < end; i++) {
-                writer.WriteUint32Be(i);
-                LOG(kSongcast, " %d", i);
-                if (++count == kMaxRepairMissedFrames) {
-                    break;
-                }
-            }
-        }
-        LOG(kSongcast, "\n");
+        const TUint count = iRepairFrames.WriteMissing(buffer, kMaxRepairMissedFrames);
+        LOG(kSongcast, "REQUEST RESEND %u frames from %u\n", count, iFrame + 1);
 
         RequestResend(missed);
         iTimerRepair->FireIn(kSubsequentRepairTimeoutMs);
@@ -479,7 +438,7 @@ void ProtocolOhBase::OutputAudio(OhmMsgAudio& aMsg)
         iStreamId = iIdProvider->NextStreamId();
         PcmStreamInfo pcmStream;
         pcmStream.Set(aMsg.BitDepth(), aMsg.SampleRate(), aMsg.Channels(), AudioDataEndian::Big, SpeakerProfile((aMsg.Channels() == 1) ? 1 : 2), aMsg.SampleStart());
-        pcmStream.SetCodec(aMsg.Codec(), true);
+        pcmStream.SetCodec(OhmLossless::SourceCodecName(aMsg.Codec()), true);
         iSupply->OutputPcmStream(iTrackUri, totalBytes, false/*seekable*/, false/*live*/, Multiroom::Forbidden, *this, iStreamId, pcmStream);
         iStreamMsgDue = false;
         iBitDepth = aMsg.BitDepth();
@@ -500,7 +459,19 @@ void ProtocolOhBase::OutputAudio(OhmMsgAudio& aMsg)
         iPendingMetatext.Replace(Brx::Empty());
         iMetatextMsgDue = false;
     }
-    iSupply->OutputData(aMsg.Audio());
+    if (!OhmLossless::IsCompressed(aMsg.Codec())) {
+        iSupply->OutputData(aMsg.Audio());
+    }
+    else {
+        /* A corrupt frame is replaced with silence of the same duration.  Dropping it would
+           shift all later audio earlier, losing sync with other receivers. */
+        if (!iDecoder.DecodeOrSilence(aMsg.Audio(), aMsg.BitDepth(), aMsg.Channels(), aMsg.Samples(), iDecodedAudio)) {
+            LOG_ERROR(kSongcast, "ProtocolOhBase::OutputAudio replacing corrupt compressed frame %u with silence\n", aMsg.Frame());
+        }
+        if (iDecodedAudio.Bytes() > 0) {
+            iSupply->OutputData(iDecodedAudio);
+        }
+    }
     const TBool halt = aMsg.Halt();
     if (halt) {
         iSupply->OutputWait();
@@ -543,6 +514,7 @@ void ProtocolOhBase::Process(OhmMsgAudio& aMsg)
                 }
             }
             else {
+                iStatsFramesMissed += diff - 1;
                 iRepairing = RepairBegin(aMsg);
             }
         }
@@ -10,11 +10,11 @@
 #include <OpenHome/Av/Songcast/OhmMsg.h>
 #include <OpenHome/Av/Songcast/OhmSocket.h>
 #include <OpenHome/Av/Songcast/OhmTimestamp.h>
+#include <OpenHome/Av/Songcast/OhmRepairWindow.h>
+#include <OpenHome/Av/Songcast/OhmLossless.h>
 #include <OpenHome/Private/Stream.h>
 #include <OpenHome/Media/Supply.h>
 
-#include <vector>
-
 EXCEPTION(OhmDiscontinuity);
 
 namespace OpenHome {
@@ -24,16 +24,18 @@ namespace Av {
 
 class ProtocolOhBase : public Media::Protocol, private IOhmMsgProcessor
 {
-    static const TUint kMaxRepairBacklogFrames = 200;
     static const TUint kMaxRepairMissedFrames = 20;
     static const TUint kInitialRepairTimeoutMs = 10;
     static const TUint kSubsequentRepairTimeoutMs = 30;
     static const TUint kTimerJoinTimeoutMs = 300;
+    static const TUint kStatsLogIntervalMs = 60 * 1000;
     static const TUint kTtl = 2;
+public:
+    static const TUint kDefaultRepairFrames = 200;
 protected:
     ProtocolOhBase(Environment& aEnv, IOhmMsgFactory& aFactory, Media::TrackFactory& aTrackFactory,
                    Optional<IOhmTimestamper> aTimestamper, const TChar* aSupportedScheme, const Brx& aMode,
-                   Optional<Av::IOhmMsgProcessor> aOhmMsgProcessor);
+                   Optional<Av::IOhmMsgProcessor> aOhmMsgProcessor, TUint aRepairFrames);
     ~ProtocolOhBase();
     void Add(OhmMsg* aMsg);
     void ResendSeen();
@@ -44,6 +46,15 @@ protected:
     TBool IsCurrentStream(TUint aStreamId) const;
     void WaitForPipelineToEmpty();
     void AddRxTimestamp(OhmMsgAudio& aMsg);
+    /*
+     * Datagrams are read straight into an audio msg from iMsgFactory, avoiding a copy for audio.
+     * ReadDatagram() returns the header; the rest of the datagram is then available from iDatagram.
+     * TakeAudio() passes ownership of the msg, parsed in place, to the caller.  The msg for any
+     * other type of datagram is returned to the factory by ReleaseDatagram() or the next ReadDatagram().
+     */
+    void ReadDatagram(OhmHeader& aHeader);
+    OhmMsgAudio* TakeAudio(const OhmHeader& aHeader);
+    void ReleaseDatagram();
 private:
     virtual Media::ProtocolStreamResult Play(TIpAddress aInterface, TUint aTtl, const Endpoint& aEndpoint) = 0;
 protected: // from Media::Protocol
@@ -62,12 +73,13 @@ private:
     TBool RepairBegin(OhmMsgAudio& aMsg);
     TBool Repair(OhmMsgAudio& aMsg);
     void OutputAudio(OhmMsgAudio& aMsg);
+    void LogStats();
 private: // from IOhmMsgProcessor
     void Process(OhmMsgAudio& aMsg) override;
     void Process(OhmMsgTrack& aMsg) override;
     void Process(OhmMsgMetatext& aMsg) override;
 protected:
-    static const TUint kMaxFrameBytes = 6*1024;
+    static const TUint kMaxFrameBytes = OhmMsgAudio::kMaxDatagramBytes;
     static const TUint kTimerListenTimeoutMs = 10000;
 protected:
     Environment& iEnv;
@@ -75,7 +87,7 @@ protected:
     Media::Supply* iSupply;
     OhmSocket iSocket;
     TIpAddress iAddr;
-    Srs<kMaxFrameBytes> iReadBuffer;
+    ReaderBuffer iDatagram;
     Endpoint iEndpoint;
     Timer* iTimerJoin;
     Timer* iTimerListen;
@@ -104,13 +116,18 @@ private:
     TUint iSampleRate;
     TUint iNumChannels;
     TUint64 iLatency;
-    OhmMsgAudio* iRepairFirst;
-    std::vector<OhmMsgAudio*> iRepairFrames;
+    OhmRepairWindow iRepairFrames;
+    OhmLosslessDecoder iDecoder;
+    Bws<OhmMsgAudio::kMaxSampleBytes> iDecodedAudio;
     Timer* iTimerRepair;
     Media::BwsTrackUri iTrackUri;
     Media::BwsTrackMetaData iTrackMetadata;
     Semaphore iPipelineEmpty;
     Optional<Av::IOhmMsgProcessor> iOhmMsgProcessor;
+    OhmMsgAudio* iDatagramMsg; // holds the datagram iDatagram reads from
+    TUint iStatsLogMs;
+    TUint iStatsFramesMissed;    // frames missing when a repair began
+    TUint iStatsRepairsAbandoned;
 };
 
 } // namespace Av
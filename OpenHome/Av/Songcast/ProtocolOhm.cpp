@@ -51,8 +51,8 @@ using namespace OpenHome::Media;
 
 ProtocolOhm::ProtocolOhm(Environment& aEnv, IOhmMsgFactory& aMsgFactory, TrackFactory& aTrackFactory,
                          Optional<IOhmTimestamper> aTimestamper, const Brx& aMode,
-                         Optional<Av::IOhmMsgProcessor> aOhmMsgProcessor)
-    : ProtocolOhBase(aEnv, aMsgFactory, aTrackFactory, aTimestamper, "ohm", aMode, aOhmMsgProcessor)
+                         Optional<Av::IOhmMsgProcessor> aOhmMsgProcessor, TUint aRepairFrames)
+    : ProtocolOhBase(aEnv, aMsgFactory, aTrackFactory, aTimestamper, "ohm", aMode, aOhmMsgProcessor, aRepairFrames)
     , iStoppedLock("POHM")
     , iSemSenderUnicastOverride("POM2", 0)
     , iSenderUnicastOverrideEnabled(false)
@@ -125,7 +125,7 @@ ProtocolStreamResult ProtocolOhm::Play(TIpAddress aInterface, TUint aTtl, const
 
             while (!joinComplete) {
                 try {
-                    header.Internalise(iReadBuffer);
+                    ReadDatagram(header);
 
                     switch (header.MsgType())
                     {
@@ -140,18 +140,18 @@ ProtocolStreamResult ProtocolOhm::Play(TIpAddress aInterface, TUint aTtl, const
                            for the pipeline to empty if we're re-starting a stream following a drop-out
                            We do however need to check for timestamps, to avoid the timestamper
                            filling up with out of date values */
-                        auto msg = iMsgFactory.CreateAudio(iReadBuffer, header);
+                        auto msg = TakeAudio(header);
                         AddRxTimestamp(*msg);
                         msg->RemoveRef();
                     }
                         break;
                     case OhmHeader::kMsgTypeTrack:
-                        Add(iMsgFactory.CreateTrack(iReadBuffer, header));
+                        Add(iMsgFactory.CreateTrack(iDatagram, header));
                         receivedTrack = true;
                         joinComplete = receivedMetatext;
                         break;
                     case OhmHeader::kMsgTypeMetatext:
-                        Add(iMsgFactory.CreateMetatext(iReadBuffer, header));
+                        Add(iMsgFactory.CreateMetatext(iDatagram, header));
                         receivedMetatext = true;
                         joinComplete = receivedTrack;
                         break;
@@ -160,7 +160,7 @@ ProtocolStreamResult ProtocolOhm::Play(TIpAddress aInterface, TUint aTtl, const
                         break;
                     }
 
-                    iReadBuffer.ReadFlush();
+                    ReleaseDatagram();
                 }
                 catch (OhmError&) {
                 }
@@ -179,7 +179,7 @@ ProtocolStreamResult ProtocolOhm::Play(TIpAddress aInterface, TUint aTtl, const
             iTimerListen->FireIn((kTimerListenTimeoutMs >> 2) - iEnv.Random(kTimerListenTimeoutMs >> 3)); // listen primary timeout
             for (;;) {
                 try {
-                    header.Internalise(iReadBuffer);
+                    ReadDatagram(header);
 
                     switch (header.MsgType())
                     {
@@ -191,20 +191,20 @@ ProtocolStreamResult ProtocolOhm::Play(TIpAddress aInterface, TUint aTtl, const
                         iTimerListen->FireIn((kTimerListenTimeoutMs >> 1) - iEnv.Random(kTimerListenTimeoutMs >> 3)); // listen secondary timeout
                         break;
                     case OhmHeader::kMsgTypeAudio:
-                        Add(iMsgFactory.CreateAudio(iReadBuffer, header));
+                        Add(TakeAudio(header));
                         break;
                     case OhmHeader::kMsgTypeTrack:
-                        Add(iMsgFactory.CreateTrack(iReadBuffer, header));
+                        Add(iMsgFactory.CreateTrack(iDatagram, header));
                         break;
                     case OhmHeader::kMsgTypeMetatext:
-                        Add(iMsgFactory.CreateMetatext(iReadBuffer, header));
+                        Add(iMsgFactory.CreateMetatext(iDatagram, header));
                         break;
                     case OhmHeader::kMsgTypeResend:
                         ResendSeen();
                         break;
                     }
 
-                    iReadBuffer.ReadFlush();
+                    ReleaseDatagram();
                 }
                 catch (OhmError&) {
                 }
@@ -222,7 +222,7 @@ ProtocolStreamResult ProtocolOhm::Play(TIpAddress aInterface, TUint aTtl, const
         iTimestamper->Stop();
     }
 
-    iReadBuffer.ReadFlush();
+    ReleaseDatagram();
     iTimerJoin->Cancel();
     iTimerListen->Cancel();
     iSocket.Close();
@@ -22,8 +22,8 @@ using namespace OpenHome::Media;
 
 // ProtocolOhu
 
-ProtocolOhu::ProtocolOhu(Environment& aEnv, IOhmMsgFactory& aMsgFactory, Media::TrackFactory& aTrackFactory, Optional<IOhmTimestamper> aTimestamper, const Brx& aMode, Optional<Av::IOhmMsgProcessor> aOhmMsgProcessor)
-    : ProtocolOhBase(aEnv, aMsgFactory, aTrackFactory, aTimestamper, "ohu", aMode, aOhmMsgProcessor)
+ProtocolOhu::ProtocolOhu(Environment& aEnv, IOhmMsgFactory& aMsgFactory, Media::TrackFactory& aTrackFactory, Optional<IOhmTimestamper> aTimestamper, const Brx& aMode, Optional<Av::IOhmMsgProcessor> aOhmMsgProcessor, TUint aRepairFrames)
+    : ProtocolOhBase(aEnv, aMsgFactory, aTrackFactory, aTimestamper, "ohu", aMode, aOhmMsgProcessor, aRepairFrames)
     , iLeaveLock("POHU")
 {
     iTimerLeave = new Timer(aEnv, MakeFunctor(*this, &ProtocolOhu::TimerLeaveExpired), "ProtocolOhuLeave");
@@ -36,7 +36,7 @@ ProtocolOhu::~ProtocolOhu()
 
 void ProtocolOhu::HandleAudio(const OhmHeader& aHeader)
 {
-    Broadcast(iMsgFactory.CreateAudio(iReadBuffer, aHeader));
+    Broadcast(TakeAudio(aHeader));
 
     AutoMutex a(iLeaveLock);
     if (iLeaving) {
@@ -45,28 +45,28 @@ void ProtocolOhu::HandleAudio(const OhmHeader& aHeader)
         iTimerJoin->Cancel();
         iTimerListen->Cancel();
         SendLeave();
-        iReadBuffer.ReadInterrupt();
+        iSocket.ReadInterrupt();
     }
 }
 
 void ProtocolOhu::HandleTrack(const OhmHeader& aHeader)
 {
-    Broadcast(iMsgFactory.CreateTrack(iReadBuffer, aHeader));
+    Broadcast(iMsgFactory.CreateTrack(iDatagram, aHeader));
 }
 
 void ProtocolOhu::HandleMetatext(const OhmHeader& aHeader)
 {
-    Broadcast(iMsgFactory.CreateMetatext(iReadBuffer, aHeader));
+    Broadcast(iMsgFactory.CreateMetatext(iDatagram, aHeader));
 }
 
 void ProtocolOhu::HandleSlave(const OhmHeader& aHeader)
 {
     OhmHeaderSlave headerSlave;
-    headerSlave.Internalise(iReadBuffer, aHeader);
+    headerSlave.Internalise(iDatagram, aHeader);
     iSlaveCount = headerSlave.SlaveCount();
 
     for (TUint i = 0; i < iSlaveCount; i++) {
-        iSlaveList[i].Internalise(iReadBuffer);
+        iSlaveList[i].Internalise(iDatagram);
         if (Debug::TestLevel(Debug::kSongcast)) {
             Endpoint::EndpointBuf endptBuf;
             iSlaveList[i].AppendEndpoint(endptBuf);
@@ -153,7 +153,7 @@ ProtocolStreamResult ProtocolOhu::Play(TIpAddress /*aInterface*/, TUint aTtl, co
 
             while (!joinComplete) {
                 try {
-                    header.Internalise(iReadBuffer);
+                    ReadDatagram(header);
 
                     switch (header.MsgType())
                     {
@@ -167,7 +167,7 @@ ProtocolStreamResult ProtocolOhu::Play(TIpAddress /*aInterface*/, TUint aTtl, co
                            for the pipeline to empty if we're re-starting a stream following a drop-out
                            We do however need to check for timestamps, to avoid the timestamper
                            filling up with out of date values */
-                        auto lmsg = iMsgFactory.CreateAudio(iReadBuffer, header);
+                        auto lmsg = TakeAudio(header);
                         AddRxTimestamp(*lmsg);
                         lmsg->RemoveRef();
                     }
@@ -194,7 +194,7 @@ ProtocolStreamResult ProtocolOhu::Play(TIpAddress /*aInterface*/, TUint aTtl, co
                         ASSERTS();
                     }
 
-                    iReadBuffer.ReadFlush();
+                    ReleaseDatagram();
                 }
                 catch (OhmError&) {
                     LOG_ERROR(kSongcast, "OHU: OhmError while joining\n");
@@ -215,7 +215,7 @@ ProtocolStreamResult ProtocolOhu::Play(TIpAddress /*aInterface*/, TUint aTtl, co
             iTimerListen->FireIn((kTimerListenTimeoutMs >> 2) - iEnv.Random(kTimerListenTimeoutMs >> 3)); // listen primary timeout
             for (;;) {
                 try {
-                    header.Internalise(iReadBuffer);
+                    ReadDatagram(header);
 
                     switch (header.MsgType())
                     {
@@ -244,7 +244,7 @@ ProtocolStreamResult ProtocolOhu::Play(TIpAddress /*aInterface*/, TUint aTtl, co
                         ASSERTS();
                     }
 
-                    iReadBuffer.ReadFlush();
+                    ReleaseDatagram();
                 }
                 catch (OhmError&) {
                     LOG_ERROR(kSongcast, "OHU: OhmError while playing\n");
@@ -267,7 +267,7 @@ ProtocolStreamResult ProtocolOhu::Play(TIpAddress /*aInterface*/, TUint aTtl, co
     }
 
     Interrupt(false); // cancel any interrupt to allow SendLeave to succeed
-    iReadBuffer.ReadFlush();
+    ReleaseDatagram();
     // Ensure a JOIN/LISTEN doesn't go out after SendLeave() is called, which may confuse a sender and think this receiver has immediately re-joined.
     iTimerJoin->Cancel();
     iTimerListen->Cancel();
@@ -315,7 +315,7 @@ TUint ProtocolOhu::TryStop(TUint aStreamId)
         iStopped = true;
         iLeaving = true;
         iTimerLeave->FireIn(kTimerLeaveTimeoutMs);
-        iReadBuffer.ReadInterrupt();
+        iSocket.ReadInterrupt();
     }
     return iNextFlushId;
 }
@@ -336,5 +336,5 @@ void ProtocolOhu::TimerLeaveExpired()
     }
     iLeaving = false;
     SendLeave();
-    iReadBuffer.ReadInterrupt();
+    iSocket.ReadInterrupt();
 }
@@ -22,7 +22,7 @@ class ProtocolOhu : public ProtocolOhBase
 public:
     ProtocolOhu(Environment& aEnv, IOhmMsgFactory& aFactory, Media::TrackFactory& aTrackFactory,
                 Optional<IOhmTimestamper> aTimestamper, const Brx& aMode,
-                Optional<Av::IOhmMsgProcessor> aOhmMsgProcessor);
+                Optional<Av::IOhmMsgProcessor> aOhmMsgProcessor, TUint aRepairFrames);
     ~ProtocolOhu();
 private: // from ProtocolOhBase
     Media::ProtocolStreamResult Play(TIpAddress aInterface, TUint aTtl, const Endpoint& aEndpoint) override;
@@ -32,6 +32,7 @@ const Brn Sender::kConfigIdEnabled("Sender.Enabled");
 const Brn Sender::kConfigIdChannel("Sender.Channel");
 const Brn Sender::kConfigIdMode("Sender.Mode");
 const Brn Sender::kConfigIdPreset("Sender.Preset");
+const Brn Sender::kConfigIdCompression("Sender.Compression");
 
 Sender::Sender(Environment& aEnv,
                Net::DvDeviceStandard& aDevice,
@@ -77,6 +78,10 @@ Sender::Sender(Environment& aEnv,
     iConfigEnabled = new ConfigChoice(aConfigInit, kConfigIdEnabled, choices, eStringIdYes);
     iListenerIdConfigEnabled = iConfigEnabled->Subscribe(MakeFunctorConfigChoice(*this, &Sender::ConfigEnabledChanged));
 
+    // off by default; when on, audio is still only compressed while all receivers listening can play it
+    iConfigCompression = new ConfigChoice(aConfigInit, kConfigIdCompression, choices, eStringIdNo);
+    iListenerIdConfigCompression = iConfigCompression->Subscribe(MakeFunctorConfigChoice(*this, &Sender::ConfigCompressionChanged));
+
     iPendingAudio.reserve(100); // arbitrarily chosen value.  Doesn't need to prevent any reallocation, just avoid regular churn early on
 }
 
@@ -92,6 +97,8 @@ Sender::~Sender()
     delete iConfigMode;
     iConfigPreset->Unsubscribe(iListenerIdConfigPreset);
     delete iConfigPreset;
+    iConfigCompression->Unsubscribe(iListenerIdConfigCompression);
+    delete iConfigCompression;
 }
 
 void Sender::SetName(const Brx& aName)
@@ -347,6 +354,11 @@ void Sender::ConfigPresetChanged(KeyValuePair<TInt>& aKvp)
     iOhmSender->SetPreset(aKvp.Value());
 }
 
+void Sender::ConfigCompressionChanged(KeyValuePair<TUint>& aStringId)
+{
+    iOhmSenderDriver->SetCompression(aStringId.Value() == eStringIdYes);
+}
+
 // FIXME: review how this mapping is generated
 TUint Sender::FirstChannelToSend(TUint aNumChannels)
 {
@@ -399,6 +411,11 @@ void Sender::Flush()
 {
 }
 
+AudioDataEndian Sender::Endian() const
+{
+    return AudioDataEndian::Big; // Songcast audio is always big endian
+}
+
 
 // Sender::PlayableCreator
 
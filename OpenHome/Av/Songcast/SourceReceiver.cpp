@@ -56,7 +56,8 @@ public:
                    Optional<Media::IClockPuller> aClockPuller,
                    Optional<IOhmTimestamper> aTxTimestamper,
                    Optional<IOhmTimestamper> aRxTimestamper,
-                   Optional<IOhmMsgProcessor> aOhmMsgObserver);
+                   Optional<IOhmMsgProcessor> aOhmMsgObserver,
+                   TUint aRepairFrames);
     ~SourceReceiver();
 private: // from ISource
     void Activate(TBool aAutoPlay, TBool aPrefetchAllowed) override;
@@ -162,7 +163,17 @@ ISource* SourceFactory::NewReceiver(IMediaPlayer& aMediaPlayer,
                                     Optional<IOhmTimestamper> aRxTimestamper,
                                     Optional<IOhmMsgProcessor> aOhmMsgObserver)
 { // static
-    return new SourceReceiver(aMediaPlayer, aClockPuller, aTxTimestamper, aRxTimestamper, aOhmMsgObserver);
+    return new SourceReceiver(aMediaPlayer, aClockPuller, aTxTimestamper, aRxTimestamper, aOhmMsgObserver, ProtocolOhBase::kDefaultRepairFrames);
+}
+
+ISource* SourceFactory::NewReceiver(IMediaPlayer& aMediaPlayer,
+                                    Optional<IClockPuller> aClockPuller,
+                                    Optional<IOhmTimestamper> aTxTimestamper,
+                                    Optional<IOhmTimestamper> aRxTimestamper,
+                                    Optional<IOhmMsgProcessor> aOhmMsgObserver,
+                                    TUint aRepairFrames)
+{ // static
+    return new SourceReceiver(aMediaPlayer, aClockPuller, aTxTimestamper, aRxTimestamper, aOhmMsgObserver, aRepairFrames);
 }
 
 const TChar* SourceFactory::kSourceTypeReceiver = "Receiver";
@@ -194,7 +205,8 @@ SourceReceiver::SourceReceiver(IMediaPlayer& aMediaPlayer,
                                Optional<Media::IClockPuller> aClockPuller,
                                Optional<IOhmTimestamper> aTxTimestamper,
                                Optional<IOhmTimestamper> aRxTimestamper,
-                               Optional<IOhmMsgProcessor> aOhmMsgObserver)
+                               Optional<IOhmMsgProcessor> aOhmMsgObserver,
+                               TUint aRepairFrames)
     : Source(SourceFactory::kSourceNameReceiver, SourceFactory::kSourceTypeReceiver, aMediaPlayer.Pipeline())
     , iLock("SRX1")
     , iActivationLock("SRX2")
@@ -220,11 +232,11 @@ SourceReceiver::SourceReceiver(IMediaPlayer& aMediaPlayer,
     iUriProvider->SetTransportPlay(MakeFunctor(*this, &SourceReceiver::Play));
     iUriProvider->SetTransportStop(MakeFunctor(*this, &SourceReceiver::Stop));
     iPipeline.Add(iUriProvider);
-    iOhmMsgFactory = new OhmMsgFactory(210, 10, 10);
+    iOhmMsgFactory = new OhmMsgFactory(aRepairFrames + 10, 10, 10); // enough audio msgs for a full repair window plus those in flight
     TrackFactory& trackFactory = aMediaPlayer.TrackFactory();
-    auto protocolOhm = new ProtocolOhm(env, *iOhmMsgFactory, trackFactory, aRxTimestamper, iUriProvider->Mode(), aOhmMsgObserver);
+    auto protocolOhm = new ProtocolOhm(env, *iOhmMsgFactory, trackFactory, aRxTimestamper, iUriProvider->Mode(), aOhmMsgObserver, aRepairFrames);
     iPipeline.Add(protocolOhm);
-    iPipeline.Add(new ProtocolOhu(env, *iOhmMsgFactory, trackFactory, aRxTimestamper, iUriProvider->Mode(), aOhmMsgObserver));
+    iPipeline.Add(new ProtocolOhu(env, *iOhmMsgFactory, trackFactory, aRxTimestamper, iUriProvider->Mode(), aOhmMsgObserver, aRepairFrames));
     iStoreZone = new StoreText(aMediaPlayer.ReadWriteStore(), aMediaPlayer.PowerManager(), kPowerPriorityNormal,
                                Brn("Receiver.Zone"), Brx::Empty(), iZone.MaxBytes());
     iStoreZone->Get(iZone);
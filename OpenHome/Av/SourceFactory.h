@@ -37,6 +37,12 @@ public:
                                 Optional<IOhmTimestamper> aTxTimestamper,
                                 Optional<IOhmTimestamper> aRxTimestamper,
                                 Optional<IOhmMsgProcessor> aOhmMsgObserver);
+    static ISource* NewReceiver(IMediaPlayer& aMediaPlayer,
+                                Optional<Media::IClockPuller> aClockPuller,
+                                Optional<IOhmTimestamper> aTxTimestamper,
+                                Optional<IOhmTimestamper> aRxTimestamper,
+                                Optional<IOhmMsgProcessor> aOhmMsgObserver,
+                                TUint aRepairFrames); // max frames held while waiting for resends; larger values tolerate lossier networks
     static ISource* NewScd(
         IMediaPlayer& aMediaPlayer,
         Optional<Configuration::ConfigChoice> aProtocolSelector);
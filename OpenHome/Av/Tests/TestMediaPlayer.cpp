@@ -24,6 +24,7 @@
 #include <OpenHome/Av/Debug.h>
 #include <OpenHome/Av/Credentials.h>
 #include <OpenHome/Media/Pipeline/Pipeline.h>
+#include <OpenHome/Media/Utils/ShellCommandProfile.h>
 #include <OpenHome/Web/WebAppFramework.h>
 #include <OpenHome/Web/ConfigUi/ConfigUiMediaPlayer.h>
 #include <OpenHome/Web/ConfigUi/FileResourceHandler.h>
@@ -265,6 +266,7 @@ TestMediaPlayer::TestMediaPlayer(Net::DvStack& aDvStack, Net::CpStack& aCpStack,
     delete mpInit;
     iPipelineObserver = new LoggingPipelineObserver();
     iMediaPlayer->Pipeline().AddObserver(*iPipelineObserver);
+    iShellCommandProfile = new ShellCommandProfile(iMediaPlayer->Pipeline().Profile(), *(aDvStack.Env().Shell()));
 
     iFnUpdaterStandard = new FriendlyNameAttributeUpdater(iMediaPlayer->FriendlyNameObservable(), iMediaPlayer->ThreadPool(), *iDevice);
     iFnManagerUpnpAv = new FriendlyNameManagerUpnpAv(kFriendlyNamePrefix, iMediaPlayer->Product());
@@ -295,6 +297,7 @@ TestMediaPlayer::~TestMediaPlayer()
     delete iFnUpdaterUpnpAv;
     delete iFnManagerUpnpAv;
     delete iFsFlushPeriodic;
+    delete iShellCommandProfile;
     delete iMediaPlayer;
     delete iPipelineObserver;
     delete iInfoLogger;
@@ -46,6 +46,7 @@ namespace Media {
     class IPullableClock;
     class AllocatorInfoLogger;
     class AudioTimeCpu;
+    class ShellCommandProfile;
 }
 namespace Configuration {
     class ConfigRamStore;
@@ -201,6 +202,7 @@ private:
     Media::AudioTimeCpu* iAudioTime;
     Bws<Uri::kMaxUriBytes+1> iPresentationUrl;
     Media::LoggingPipelineObserver* iPipelineObserver;
+    Media::ShellCommandProfile* iShellCommandProfile;
     Av::FriendlyNameAttributeUpdater* iFnUpdaterStandard;
     FriendlyNameManagerUpnpAv* iFnManagerUpnpAv;
     Av::FriendlyNameAttributeUpdater* iFnUpdaterUpnpAv;
@@ -0,0 +1,331 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Av/Songcast/OhmLossless.h>
+#include <OpenHome/Av/Songcast/OhmMsg.h>
+
+#include <math.h>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Av;
+
+namespace OpenHome {
+namespace Av {
+
+class SuiteOhmLossless : public SuiteUnitTest, private INonCopyable
+{
+public:
+    SuiteOhmLossless();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    TUint Random();
+    void AddSample(TInt aValue, TUint aBitDepth);
+    void AddSine(TUint aSamples, TUint aBitDepth, TUint aChannels, TUint aNoiseBits);
+    TBool RoundTrip(TUint aBitDepth, TUint aChannels);
+    void TestCodecName();
+    void TestUnsupported();
+    void TestStereo16();
+    void TestStereo24();
+    void TestMono();
+    void Test8Bit();
+    void TestMultichannel();
+    void TestCorrelatedStereo();
+    void TestSilence();
+    void TestShortFrame();
+    void TestExtremes();
+    void TestNoise();
+    void TestCorrupt();
+    void TestCorruptIsSilence();
+private:
+    OhmLosslessEncoder* iEncoder;
+    OhmLosslessDecoder* iDecoder;
+    Bws<OhmMsgAudio::kMaxSampleBytes> iPcm;
+    Bws<OhmMsgAudio::kMaxSampleBytes> iEncoded;
+    Bws<OhmMsgAudio::kMaxSampleBytes> iDecoded;
+    TUint iRandom;
+};
+
+} // namespace Av
+} // namespace OpenHome
+
+
+// SuiteOhmLossless
+
+SuiteOhmLossless::SuiteOhmLossless()
+    : SuiteUnitTest("OhmLossless")
+{
+    AddTest(MakeFunctor(*this, &SuiteOhmLossless::TestCodecName), "TestCodecName");
+    AddTest(MakeFunctor(*this, &SuiteOhmLossless::TestUnsupported), "TestUnsupported");
+    AddTest(MakeFunctor(*this, &SuiteOhmLossless::TestStereo16), "TestStereo16");
+    AddTest(MakeFunctor(*this, &SuiteOhmLossless::TestStereo24), "TestStereo24");
+    AddTest(MakeFunctor(*this, &SuiteOhmLossless::TestMono), "TestMono");
+    AddTest(MakeFunctor(*this, &SuiteOhmLossless::Test8Bit), "Test8Bit");
+    AddTest(MakeFunctor(*this, &SuiteOhmLossless::TestMultichannel), "TestMultichannel");
+    AddTest(MakeFunctor(*this, &SuiteOhmLossless::TestCorrelatedStereo), "TestCorrelatedStereo");
+    AddTest(MakeFunctor(*this, &SuiteOhmLossless::TestSilence), "TestSilence");
+    AddTest(MakeFunctor(*this, &SuiteOhmLossless::TestShortFrame), "TestShortFrame");
+    AddTest(MakeFunctor(*this, &SuiteOhmLossless::TestExtremes), "TestExtremes");
+    AddTest(MakeFunctor(*this, &SuiteOhmLossless::TestNoise), "TestNoise");
+    AddTest(MakeFunctor(*this, &SuiteOhmLossless::TestCorrupt), "TestCorrupt");
+    AddTest(MakeFunctor(*this, &SuiteOhmLossless::TestCorruptIsSilence), "TestCorruptIsSilence");
+}
+
+void SuiteOhmLossless::Setup()
+{
+    iEncoder = new OhmLosslessEncoder();
+    iDecoder = new OhmLosslessDecoder();
+    iPcm.SetBytes(0);
+    iEncoded.SetBytes(0);
+    iDecoded.SetBytes(0);
+    iRandom = 1;
+}
+
+void SuiteOhmLossless::TearDown()
+{
+    delete iDecoder;
+    delete iEncoder;
+}
+
+TUint SuiteOhmLossless::Random()
+{
+    iRandom = iRandom * 1103515245 + 12345;
+    return iRandom >> 8;
+}
+
+void SuiteOhmLossless::AddSample(TInt aValue, TUint aBitDepth)
+{
+    for (TUint shift=aBitDepth; shift>0; shift-=8) {
+        iPcm.Append(static_cast<TByte>(static_cast<TUint>(aValue) >> (shift - 8)));
+    }
+}
+
+void SuiteOhmLossless::AddSine(TUint aSamples, TUint aBitDepth, TUint aChannels, TUint aNoiseBits)
+{
+    const TInt max = (1 << (aBitDepth - 1)) - 1;
+    const TInt amplitude = max / 2;
+    for (TUint i=0; i<aSamples; i++) {
+        for (TUint ch=0; ch<aChannels; ch++) {
+            const double phase = (2 * 3.14159265 * 441 * i / 44100) + ch;
+            TInt value = static_cast<TInt>(amplitude * sin(phase));
+            if (aNoiseBits > 0) {
+                value += static_cast<TInt>(Random() & ((1 << aNoiseBits) - 1)) - (1 << (aNoiseBits - 1));
+            }
+            AddSample(value, aBitDepth);
+        }
+    }
+}
+
+TBool SuiteOhmLossless::RoundTrip(TUint aBitDepth, TUint aChannels)
+{
+    iEncoded.SetBytes(0);
+    if (!iEncoder->TryEncode(iPcm, aBitDepth, aChannels, iEncoded)) {
+        return false;
+    }
+    TEST(iEncoded.Bytes() < iPcm.Bytes());
+    const TUint samples = iPcm.Bytes() / (aChannels * aBitDepth / 8);
+    iDecoded.SetBytes(0);
+    iDecoder->Decode(iEncoded, aBitDepth, aChannels, samples, iDecoded);
+    TEST(iDecoded == iPcm);
+    return true;
+}
+
+void SuiteOhmLossless::TestCodecName()
+{
+    Bws<OhmMsgAudio::kMaxCodecBytes> name;
+    OhmLossless::SetCodecName(name, Brn("FLAC"));
+    TEST(name == Brn("OHLC/FLAC"));
+    TEST(OhmLossless::IsCompressed(name));
+    TEST(OhmLossless::SourceCodecName(name) == Brn("FLAC"));
+    TEST(!OhmLossless::IsCompressed(Brn("FLAC")));
+    TEST(OhmLossless::SourceCodecName(Brn("FLAC")) == Brn("FLAC"));
+
+    OhmLossless::SetCodecName(name, Brn("ThisCodecNameIsLongerThanTheSpaceAvailable"));
+    TEST(name.Bytes() == name.MaxBytes());
+    TEST(OhmLossless::IsCompressed(name));
+}
+
+void SuiteOhmLossless::TestUnsupported()
+{
+    AddSine(100, 16, 2, 0);
+    TEST(!iEncoder->TryEncode(iPcm, 32, 1, iEncoded));
+    TEST(!iEncoder->TryEncode(iPcm, 16, 0, iEncoded));
+    TEST(!iEncoder->TryEncode(iPcm, 16, OhmLossless::kMaxChannels + 1, iEncoded));
+    TEST(!iEncoder->TryEncode(iPcm, 24, 1, iEncoded)); // not a whole number of samples
+    TEST(!iEncoder->TryEncode(Brx::Empty(), 16, 2, iEncoded));
+}
+
+void SuiteOhmLossless::TestStereo16()
+{
+    AddSine(220, 16, 2, 4);
+    TEST(RoundTrip(16, 2));
+    // aim is to at least halve bandwidth for typical music
+    TEST(iEncoded.Bytes() < iPcm.Bytes() / 2);
+}
+
+void SuiteOhmLossless::TestStereo24()
+{
+    AddSine(960, 24, 2, 8);
+    TEST(RoundTrip(24, 2));
+    TEST(iEncoded.Bytes() < iPcm.Bytes() / 2);
+}
+
+void SuiteOhmLossless::TestMono()
+{
+    AddSine(441, 16, 1, 2);
+    TEST(RoundTrip(16, 1));
+}
+
+void SuiteOhmLossless::Test8Bit()
+{
+    AddSine(441, 8, 2, 0);
+    TEST(RoundTrip(8, 2));
+}
+
+void SuiteOhmLossless::TestMultichannel()
+{
+    AddSine(240, 24, 6, 6);
+    TEST(RoundTrip(24, 6));
+}
+
+void SuiteOhmLossless::TestCorrelatedStereo()
+{
+    // identical channels should code one of them as a side channel of zeros
+    for (TUint i=0; i<220; i++) {
+        const TInt value = static_cast<TInt>(Random() & 0xffff) - 0x8000;
+        AddSample(value, 16);
+        AddSample(value, 16);
+    }
+    TEST(RoundTrip(16, 2));
+    TEST(iEncoded.Bytes() < (iPcm.Bytes() * 6) / 10);
+}
+
+void SuiteOhmLossless::TestSilence()
+{
+    for (TUint i=0; i<1920; i++) {
+        iPcm.Append(static_cast<TByte>(0));
+    }
+    TEST(RoundTrip(24, 2));
+    TEST(iEncoded.Bytes() < 100);
+}
+
+void SuiteOhmLossless::TestShortFrame()
+{
+    // fewer samples than the highest predictor order
+    for (TUint samples=1; samples<=5; samples++) {
+        iPcm.SetBytes(0);
+        for (TUint i=0; i<samples; i++) {
+            AddSample(-1, 24);
+            AddSample(1, 24);
+        }
+        TEST(RoundTrip(24, 2));
+    }
+}
+
+void SuiteOhmLossless::TestExtremes()
+{
+    // largest possible side channel values and prediction residuals
+    static const TInt kMax = (1 << 23) - 1;
+    static const TInt kMin = -(1 << 23);
+    for (TUint i=0; i<480; i++) {
+        const TBool odd = ((i & 1) != 0);
+        AddSample(odd? kMax : kMin, 24);
+        AddSample(odd? kMin : kMax, 24);
+    }
+    (void)RoundTrip(24, 2);
+    // mostly constant with occasional full scale spikes
+    iPcm.SetBytes(0);
+    for (TUint i=0; i<480; i++) {
+        const TInt value = ((i % 97) == 0? kMin : 0);
+        AddSample(value, 24);
+        AddSample(-value - 1, 24);
+    }
+    TEST(RoundTrip(24, 2));
+}
+
+void SuiteOhmLossless::TestNoise()
+{
+    // full scale white noise can't be compressed
+    for (TUint i=0; i<480; i++) {
+        AddSample(static_cast<TInt>(Random()), 24);
+        AddSample(static_cast<TInt>(Random()), 24);
+    }
+    TEST(!RoundTrip(24, 2));
+}
+
+void SuiteOhmLossless::TestCorrupt()
+{
+    AddSine(220, 16, 2, 4);
+    TEST(RoundTrip(16, 2));
+    const TUint samples = 220;
+
+    Bws<OhmMsgAudio::kMaxSampleBytes> encoded(iEncoded);
+    encoded.SetBytes(encoded.Bytes() / 2);
+    TEST_THROWS(iDecoder->Decode(encoded, 16, 2, samples, iDecoded), OhmLosslessCorrupt);
+    TEST_THROWS(iDecoder->Decode(iEncoded, 16, 2, 0, iDecoded), OhmLosslessCorrupt);
+    TEST_THROWS(iDecoder->Decode(iEncoded, 32, 2, samples, iDecoded), OhmLosslessCorrupt);
+    Bws<16> small;
+    TEST_THROWS(iDecoder->Decode(iEncoded, 16, 2, samples, small), OhmLosslessCorrupt);
+
+    encoded.Replace(iEncoded);
+    encoded[0] = 0xff; // unknown version
+    TEST_THROWS(iDecoder->Decode(encoded, 16, 2, samples, iDecoded), OhmLosslessCorrupt);
+
+    // random data must either be rejected or decode to something of the expected size
+    for (TUint i=0; i<100; i++) {
+        encoded.SetBytes(0);
+        encoded.Append(static_cast<TByte>(0x10 | (i % 4)));
+        const TUint bytes = 1 + Random() % 400;
+        for (TUint j=0; j<bytes; j++) {
+            encoded.Append(static_cast<TByte>(Random()));
+        }
+        try {
+            iDecoder->Decode(encoded, 16, 2, samples, iDecoded);
+            TEST(iDecoded.Bytes() == samples * 4);
+        }
+        catch (OhmLosslessCorrupt&) {
+        }
+    }
+}
+
+void SuiteOhmLossless::TestCorruptIsSilence()
+{
+    AddSine(220, 24, 2, 4);
+    TEST(RoundTrip(24, 2));
+    const TUint samples = 220;
+    TEST(iDecoder->DecodeOrSilence(iEncoded, 24, 2, samples, iDecoded));
+    TEST(iDecoded == iPcm);
+
+    // a corrupt frame is replaced by the same number of samples of silence, not dropped
+    Bws<OhmMsgAudio::kMaxSampleBytes> encoded(iEncoded);
+    encoded.SetBytes(encoded.Bytes() / 2);
+    TEST(!iDecoder->DecodeOrSilence(encoded, 24, 2, samples, iDecoded));
+    TEST(iDecoded.Bytes() == samples * 2 * 3);
+    TUint nonZero = 0;
+    for (TUint i=0; i<iDecoded.Bytes(); i++) {
+        if (iDecoded[i] != 0) {
+            nonZero++;
+        }
+    }
+    TEST(nonZero == 0);
+
+    // ...truncated to whole samples if the frame claims more than fit
+    Bws<16> small;
+    TEST(!iDecoder->DecodeOrSilence(iEncoded, 24, 2, samples, small));
+    TEST(small.Bytes() == 12);
+
+    // ...and empty for a format with no whole bytes per sample
+    TEST(!iDecoder->DecodeOrSilence(iEncoded, 4, 2, samples, iDecoded));
+    TEST(iDecoded.Bytes() == 0);
+}
+
+
+
+void TestOhmLossless()
+{
+    Runner runner("OhmLossless tests\n");
+    runner.Add(new SuiteOhmLossless());
+    runner.Run();
+}
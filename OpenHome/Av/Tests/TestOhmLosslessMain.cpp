@@ -0,0 +1,11 @@
+#include <OpenHome/Private/TestFramework.h>
+
+extern void TestOhmLossless();
+
+void OpenHome::TestFramework::Runner::Main(TInt /*aArgc*/, TChar* /*aArgv*/[], Net::InitialisationParams* aInitParams)
+{
+    Net::UpnpLibrary::InitialiseMinimal(aInitParams);
+    TestOhmLossless();
+    delete aInitParams;
+    Net::UpnpLibrary::Close();
+}
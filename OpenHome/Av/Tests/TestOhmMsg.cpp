@@ -0,0 +1,359 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Av/Songcast/Ohm.h>
+#include <OpenHome/Av/Songcast/OhmMsg.h>
+#include <OpenHome/Av/Songcast/OhmReceiverCapabilities.h>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Av;
+
+namespace OpenHome {
+namespace Av {
+
+class SuiteOhmMsgAudioReceive : public SuiteUnitTest, private INonCopyable
+{
+    static const TUint kSamples = 240;
+    static const TUint kFrame = 0x12345678;
+    static const TUint kNetworkTimestamp = 1000;
+    static const TUint kMediaLatency = 2000;
+    static const TUint64 kSampleStart = 0x100000000LL;
+    static const TUint64 kSamplesTotal = 0x200000000LL;
+    static const TUint kSampleRate = 48000;
+    static const TUint kBitRate = 48000 * 24 * 2;
+    static const TUint kBitDepth = 24;
+    static const TUint kChannels = 2;
+public:
+    SuiteOhmMsgAudioReceive();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    OhmMsgAudio* CreateSendMsg();
+    OhmMsgAudio* Receive(const Brx& aDatagram);
+    void TestFieldsParsed();
+    void TestAudioNotCopied();
+    void TestExternaliseRoundTrip();
+    void TestTruncatedRejected();
+    void TestReusedForSend();
+private:
+    OhmMsgFactory* iMsgFactory;
+    Bws<OhmMsgAudio::kMaxSampleBytes> iAudio;
+    Bws<OhmMsgAudio::kMaxDatagramBytes> iSent;
+};
+
+class SuiteOhmHeaderJoin : public Suite
+{
+public:
+    SuiteOhmHeaderJoin();
+    void Test() override;
+private:
+    TUint Internalise(const Brx& aMsg);
+};
+
+class SuiteOhmReceiverCapabilities : public SuiteUnitTest, private INonCopyable
+{
+    static const TUint kTimeoutMs = 10000;
+public:
+    SuiteOhmReceiverCapabilities();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    void JoinOld(TUint aNowMs);
+    void JoinNew(TUint aNowMs);
+    void Join(const Brx& aMsg, TUint aNowMs);
+    void TestInitiallyUnsupported();
+    void TestOldReceiverUnsupported();
+    void TestNewReceiverSupported();
+    void TestMixedUntilTimeout();
+    void TestReset();
+private:
+    OhmReceiverCapabilities* iCapabilities;
+};
+
+} // namespace Av
+} // namespace OpenHome
+
+
+// SuiteOhmMsgAudioReceive
+
+SuiteOhmMsgAudioReceive::SuiteOhmMsgAudioReceive()
+    : SuiteUnitTest("OhmMsgAudio receive")
+{
+    AddTest(MakeFunctor(*this, &SuiteOhmMsgAudioReceive::TestFieldsParsed), "TestFieldsParsed");
+    AddTest(MakeFunctor(*this, &SuiteOhmMsgAudioReceive::TestAudioNotCopied), "TestAudioNotCopied");
+    AddTest(MakeFunctor(*this, &SuiteOhmMsgAudioReceive::TestExternaliseRoundTrip), "TestExternaliseRoundTrip");
+    AddTest(MakeFunctor(*this, &SuiteOhmMsgAudioReceive::TestTruncatedRejected), "TestTruncatedRejected");
+    AddTest(MakeFunctor(*this, &SuiteOhmMsgAudioReceive::TestReusedForSend), "TestReusedForSend");
+}
+
+void SuiteOhmMsgAudioReceive::Setup()
+{
+    // a single audio msg so that each test reuses the one a previous Create() wrote to
+    iMsgFactory = new OhmMsgFactory(1, 1, 1);
+    iAudio.SetBytes(0);
+    for (TUint i=0; i<kSamples * kChannels * kBitDepth/8; i++) {
+        iAudio.Append(static_cast<TByte>(i));
+    }
+    OhmMsgAudio* msg = CreateSendMsg();
+    iSent.Replace(msg->SendableBuffer());
+    msg->RemoveRef();
+}
+
+void SuiteOhmMsgAudioReceive::TearDown()
+{
+    delete iMsgFactory;
+}
+
+OhmMsgAudio* SuiteOhmMsgAudioReceive::CreateSendMsg()
+{
+    Bws<OhmMsgAudio::kStreamHeaderBytes> streamHeader;
+    OhmMsgAudio::GetStreamHeader(streamHeader, kSamplesTotal, kSampleRate, kBitRate, 0, kBitDepth, kChannels, Brn("PCM"));
+    OhmMsgAudio* msg = iMsgFactory->CreateAudio(false, true, true, false, kSamples, kFrame, kNetworkTimestamp,
+                                                kMediaLatency, kSampleStart, streamHeader, iAudio);
+    msg->Serialise();
+    return msg;
+}
+
+OhmMsgAudio* SuiteOhmMsgAudioReceive::Receive(const Brx& aDatagram)
+{
+    OhmMsgAudio* msg = iMsgFactory->CreateAudio();
+    Bwx& buf = msg->ReceiveBuffer();
+    buf.Replace(aDatagram);
+    ReaderBuffer reader(buf);
+    OhmHeader header;
+    header.Internalise(reader);
+    try {
+        msg->Internalise(header);
+    }
+    catch (OhmError&) {
+        msg->RemoveRef();
+        throw;
+    }
+    return msg;
+}
+
+void SuiteOhmMsgAudioReceive::TestFieldsParsed()
+{
+    OhmMsgAudio* msg = Receive(iSent);
+    TEST(!msg->Halt());
+    TEST(msg->Lossless());
+    TEST(msg->Timestamped());
+    TEST(!msg->Resent());
+    TEST(msg->Samples() == kSamples);
+    TEST(msg->Frame() == kFrame);
+    TEST(msg->NetworkTimestamp() == kNetworkTimestamp);
+    TEST(msg->MediaLatency() == kMediaLatency);
+    TEST(msg->SampleStart() == kSampleStart);
+    TEST(msg->SamplesTotal() == kSamplesTotal);
+    TEST(msg->SampleRate() == kSampleRate);
+    TEST(msg->BitRate() == kBitRate);
+    TEST(msg->VolumeOffset() == 0);
+    TEST(msg->BitDepth() == kBitDepth);
+    TEST(msg->Channels() == kChannels);
+    TEST(msg->Codec() == Brn("PCM"));
+    TEST(msg->Audio() == iAudio);
+    msg->RemoveRef();
+}
+
+void SuiteOhmMsgAudioReceive::TestAudioNotCopied()
+{
+    OhmMsgAudio* msg = iMsgFactory->CreateAudio();
+    Bwx& buf = msg->ReceiveBuffer();
+    buf.Replace(iSent);
+    ReaderBuffer reader(buf);
+    OhmHeader header;
+    header.Internalise(reader);
+    msg->Internalise(header);
+    const TByte* audio = msg->Audio().Ptr();
+    TEST(audio >= buf.Ptr());
+    TEST(audio + msg->Audio().Bytes() == buf.Ptr() + iSent.Bytes());
+    msg->RemoveRef();
+}
+
+void SuiteOhmMsgAudioReceive::TestExternaliseRoundTrip()
+{
+    // ProtocolOhu forwards received msgs to its slaves unchanged
+    OhmMsgAudio* msg = Receive(iSent);
+    Bws<OhmMsgAudio::kMaxDatagramBytes> buf;
+    WriterBuffer writer(buf);
+    msg->Externalise(writer);
+    TEST(buf == iSent);
+    TEST(msg->SendableBuffer() == iSent);
+    msg->RemoveRef();
+}
+
+void SuiteOhmMsgAudioReceive::TestTruncatedRejected()
+{
+    Bws<OhmMsgAudio::kMaxDatagramBytes> truncated(iSent.Split(0, iSent.Bytes() - 1));
+    TEST_THROWS(Receive(truncated), OhmError);
+    truncated.Replace(iSent.Split(0, OhmHeader::kHeaderBytes + 10));
+    TEST_THROWS(Receive(truncated), OhmError);
+}
+
+void SuiteOhmMsgAudioReceive::TestReusedForSend()
+{
+    // a msg that was last used for receiving is laid out for sending again when next created
+    OhmMsgAudio* msg = Receive(iSent);
+    msg->RemoveRef();
+    msg = CreateSendMsg();
+    TEST(msg->SendableBuffer() == iSent);
+    msg->RemoveRef();
+
+    msg = Receive(iSent);
+    msg->RemoveRef();
+    msg = iMsgFactory->CreateAudio();
+    TEST(msg->Audio().Bytes() == 0);
+    TEST(msg->Audio().MaxBytes() == OhmMsgAudio::kMaxSampleBytes);
+    msg->RemoveRef();
+}
+
+
+
+// SuiteOhmHeaderJoin
+
+SuiteOhmHeaderJoin::SuiteOhmHeaderJoin()
+    : Suite("OhmHeaderJoin")
+{
+}
+
+void SuiteOhmHeaderJoin::Test()
+{
+    // join and listen msgs from current receivers advertise their capabilities
+    Bws<OhmHeader::kHeaderBytes + OhmHeaderJoin::kHeaderBytes> msg;
+    WriterBuffer writer(msg);
+    OhmHeaderJoin headerJoin(OhmHeaderJoin::kCapabilityLossless);
+    OhmHeader(OhmHeader::kMsgTypeJoin, headerJoin.MsgBytes()).Externalise(writer);
+    headerJoin.Externalise(writer);
+    TEST(msg.Bytes() == OhmHeader::kHeaderBytes + OhmHeaderJoin::kHeaderBytes);
+    TEST(Internalise(msg) == OhmHeaderJoin::kCapabilityLossless);
+
+    // ...older receivers send no body so have no capabilities
+    msg.SetBytes(0);
+    OhmHeader(OhmHeader::kMsgTypeListen, 0).Externalise(writer);
+    TEST(Internalise(msg) == 0);
+}
+
+TUint SuiteOhmHeaderJoin::Internalise(const Brx& aMsg)
+{
+    ReaderBuffer reader(aMsg);
+    OhmHeader header;
+    header.Internalise(reader);
+    OhmHeaderJoin headerJoin(~0u);
+    headerJoin.Internalise(reader, header);
+    return headerJoin.Capabilities();
+}
+
+
+// SuiteOhmReceiverCapabilities
+
+SuiteOhmReceiverCapabilities::SuiteOhmReceiverCapabilities()
+    : SuiteUnitTest("OhmReceiverCapabilities")
+{
+    AddTest(MakeFunctor(*this, &SuiteOhmReceiverCapabilities::TestInitiallyUnsupported), "TestInitiallyUnsupported");
+    AddTest(MakeFunctor(*this, &SuiteOhmReceiverCapabilities::TestOldReceiverUnsupported), "TestOldReceiverUnsupported");
+    AddTest(MakeFunctor(*this, &SuiteOhmReceiverCapabilities::TestNewReceiverSupported), "TestNewReceiverSupported");
+    AddTest(MakeFunctor(*this, &SuiteOhmReceiverCapabilities::TestMixedUntilTimeout), "TestMixedUntilTimeout");
+    AddTest(MakeFunctor(*this, &SuiteOhmReceiverCapabilities::TestReset), "TestReset");
+}
+
+void SuiteOhmReceiverCapabilities::Setup()
+{
+    iCapabilities = new OhmReceiverCapabilities(kTimeoutMs);
+}
+
+void SuiteOhmReceiverCapabilities::TearDown()
+{
+    delete iCapabilities;
+}
+
+void SuiteOhmReceiverCapabilities::JoinOld(TUint aNowMs)
+{
+    // receivers that predate OhmHeaderJoin send a header with no body
+    Bws<OhmHeader::kHeaderBytes> msg;
+    WriterBuffer writer(msg);
+    OhmHeader(OhmHeader::kMsgTypeJoin, 0).Externalise(writer);
+    Join(msg, aNowMs);
+}
+
+void SuiteOhmReceiverCapabilities::JoinNew(TUint aNowMs)
+{
+    Bws<OhmHeader::kHeaderBytes + OhmHeaderJoin::kHeaderBytes> msg;
+    WriterBuffer writer(msg);
+    OhmHeaderJoin headerJoin(OhmHeaderJoin::kCapabilityLossless);
+    OhmHeader(OhmHeader::kMsgTypeJoin, headerJoin.MsgBytes()).Externalise(writer);
+    headerJoin.Externalise(writer);
+    Join(msg, aNowMs);
+}
+
+void SuiteOhmReceiverCapabilities::Join(const Brx& aMsg, TUint aNowMs)
+{
+    ReaderBuffer reader(aMsg);
+    OhmHeader header;
+    header.Internalise(reader);
+    iCapabilities->Joined(reader, header, aNowMs);
+}
+
+void SuiteOhmReceiverCapabilities::TestInitiallyUnsupported()
+{
+    TEST(!iCapabilities->LosslessSupported());
+}
+
+void SuiteOhmReceiverCapabilities::TestOldReceiverUnsupported()
+{
+    JoinOld(0);
+    TEST(!iCapabilities->LosslessSupported());
+    // an old receiver that keeps listening keeps compression off indefinitely
+    for (TUint ms = 1000; ms <= 5 * kTimeoutMs; ms += 1000) {
+        JoinOld(ms);
+        TEST(!iCapabilities->LosslessSupported());
+    }
+}
+
+void SuiteOhmReceiverCapabilities::TestNewReceiverSupported()
+{
+    JoinNew(0);
+    TEST(iCapabilities->LosslessSupported());
+    JoinNew(1000);
+    TEST(iCapabilities->LosslessSupported());
+}
+
+void SuiteOhmReceiverCapabilities::TestMixedUntilTimeout()
+{
+    JoinNew(0);
+    JoinOld(1000);
+    TEST(!iCapabilities->LosslessSupported());
+    JoinNew(2000);
+    TEST(!iCapabilities->LosslessSupported());
+    JoinNew(1000 + kTimeoutMs - 1);
+    TEST(!iCapabilities->LosslessSupported());
+    // old receiver has stopped listening
+    JoinNew(1000 + kTimeoutMs);
+    TEST(iCapabilities->LosslessSupported());
+}
+
+void SuiteOhmReceiverCapabilities::TestReset()
+{
+    JoinNew(0);
+    TEST(iCapabilities->LosslessSupported());
+    iCapabilities->Reset();
+    TEST(!iCapabilities->LosslessSupported());
+    JoinOld(1000);
+    iCapabilities->Reset();
+    JoinNew(2000);
+    TEST(iCapabilities->LosslessSupported());
+}
+
+
+
+void TestOhmMsg()
+{
+    Runner runner("OhmMsg tests\n");
+    runner.Add(new SuiteOhmMsgAudioReceive());
+    runner.Add(new SuiteOhmHeaderJoin());
+    runner.Add(new SuiteOhmReceiverCapabilities());
+    runner.Run();
+}
@@ -0,0 +1,254 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Private/Converter.h>
+#include <OpenHome/Av/Songcast/OhmRepairWindow.h>
+#include <OpenHome/Av/Songcast/OhmMsg.h>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Av;
+
+namespace OpenHome {
+namespace Av {
+
+class SuiteOhmRepairWindow : public SuiteUnitTest, private INonCopyable
+{
+    static const TUint kCapacity = 64;
+    static const TUint kMaxMissed = 20;
+public:
+    SuiteOhmRepairWindow();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    OhmMsgAudio* CreateAudio(TUint aFrame);
+    void Add(TUint aFrame);
+    TUint WriteMissing(TUint aMaxFrames);
+    TUint Missing(TUint aIndex) const;
+    void TestMaxFramesNotPowerOfTwo();
+    void TestInOrder();
+    void TestOutOfOrder();
+    void TestDuplicate();
+    void TestOutsideWindow();
+    void TestMissing();
+    void TestMissingLimit();
+    void TestMissingSkipsWords();
+    void TestFrameWrap();
+    void TestResetReleasesFrames();
+private:
+    OhmMsgFactory* iMsgFactory;
+    OhmRepairWindow* iWindow;
+    Bws<kCapacity * 4> iMissed;
+};
+
+} // namespace Av
+} // namespace OpenHome
+
+
+// SuiteOhmRepairWindow
+
+SuiteOhmRepairWindow::SuiteOhmRepairWindow()
+    : SuiteUnitTest("OhmRepairWindow")
+{
+    AddTest(MakeFunctor(*this, &SuiteOhmRepairWindow::TestMaxFramesNotPowerOfTwo), "TestMaxFramesNotPowerOfTwo");
+    AddTest(MakeFunctor(*this, &SuiteOhmRepairWindow::TestInOrder), "TestInOrder");
+    AddTest(MakeFunctor(*this, &SuiteOhmRepairWindow::TestOutOfOrder), "TestOutOfOrder");
+    AddTest(MakeFunctor(*this, &SuiteOhmRepairWindow::TestDuplicate), "TestDuplicate");
+    AddTest(MakeFunctor(*this, &SuiteOhmRepairWindow::TestOutsideWindow), "TestOutsideWindow");
+    AddTest(MakeFunctor(*this, &SuiteOhmRepairWindow::TestMissing), "TestMissing");
+    AddTest(MakeFunctor(*this, &SuiteOhmRepairWindow::TestMissingLimit), "TestMissingLimit");
+    AddTest(MakeFunctor(*this, &SuiteOhmRepairWindow::TestMissingSkipsWords), "TestMissingSkipsWords");
+    AddTest(MakeFunctor(*this, &SuiteOhmRepairWindow::TestFrameWrap), "TestFrameWrap");
+    AddTest(MakeFunctor(*this, &SuiteOhmRepairWindow::TestResetReleasesFrames), "TestResetReleasesFrames");
+}
+
+void SuiteOhmRepairWindow::Setup()
+{
+    iMsgFactory = new OhmMsgFactory(kCapacity, 1, 1);
+    iWindow = new OhmRepairWindow(kCapacity);
+    iWindow->Reset(1);
+}
+
+void SuiteOhmRepairWindow::TearDown()
+{
+    delete iWindow;
+    delete iMsgFactory;
+}
+
+OhmMsgAudio* SuiteOhmRepairWindow::CreateAudio(TUint aFrame)
+{
+    return iMsgFactory->CreateAudio(false, true, false, false, 0, aFrame, 0, 0, 0, Brx::Empty(), Brx::Empty());
+}
+
+void SuiteOhmRepairWindow::Add(TUint aFrame)
+{
+    TEST(iWindow->TryAdd(*CreateAudio(aFrame)));
+}
+
+TUint SuiteOhmRepairWindow::WriteMissing(TUint aMaxFrames)
+{
+    iMissed.SetBytes(0);
+    WriterBuffer writer(iMissed);
+    const TUint count = iWindow->WriteMissing(writer, aMaxFrames);
+    TEST(iMissed.Bytes() == count * 4);
+    return count;
+}
+
+TUint SuiteOhmRepairWindow::Missing(TUint aIndex) const
+{
+    return Converter::BeUint32At(iMissed, aIndex * 4);
+}
+
+void SuiteOhmRepairWindow::TestMaxFramesNotPowerOfTwo()
+{
+    static const TUint kMaxFrames = 40;
+    OhmRepairWindow window(kMaxFrames);
+    TEST(window.MaxFrames() == kMaxFrames);
+    window.Reset(1);
+    OhmMsgAudio* msg = CreateAudio(1 + kMaxFrames);
+    TEST(!window.TryAdd(*msg));
+    msg->RemoveRef();
+    msg = CreateAudio(kMaxFrames);
+    TEST(window.TryAdd(*msg));
+    TEST(window.Count() == 1);
+}
+
+void SuiteOhmRepairWindow::TestInOrder()
+{
+    Add(1);
+    Add(2);
+    TEST(iWindow->Count() == 2);
+    OhmMsgAudio* msg = iWindow->TryRemoveNext();
+    TEST(msg != nullptr);
+    TEST(msg->Frame() == 1);
+    msg->RemoveRef();
+    msg = iWindow->TryRemoveNext();
+    TEST(msg != nullptr);
+    TEST(msg->Frame() == 2);
+    msg->RemoveRef();
+    TEST(iWindow->TryRemoveNext() == nullptr);
+    TEST(iWindow->Count() == 0);
+}
+
+void SuiteOhmRepairWindow::TestOutOfOrder()
+{
+    Add(4);
+    Add(3);
+    TEST(iWindow->TryRemoveNext() == nullptr);
+    Add(1);
+    OhmMsgAudio* msg = iWindow->TryRemoveNext();
+    TEST(msg->Frame() == 1);
+    msg->RemoveRef();
+    TEST(iWindow->TryRemoveNext() == nullptr);
+    Add(2);
+    for (TUint frame=2; frame<=4; frame++) {
+        msg = iWindow->TryRemoveNext();
+        TEST(msg != nullptr);
+        TEST(msg->Frame() == frame);
+        msg->RemoveRef();
+    }
+    TEST(iWindow->Count() == 0);
+}
+
+void SuiteOhmRepairWindow::TestDuplicate()
+{
+    Add(3);
+    Add(3);
+    TEST(iWindow->Count() == 1);
+}
+
+void SuiteOhmRepairWindow::TestOutsideWindow()
+{
+    OhmMsgAudio* msg = CreateAudio(1 + kCapacity);
+    TEST(!iWindow->TryAdd(*msg));
+    msg->RemoveRef();
+    Add(kCapacity); // last frame that fits
+    msg = CreateAudio(0); // before the window
+    TEST(!iWindow->TryAdd(*msg));
+    msg->RemoveRef();
+    TEST(iWindow->Count() == 1);
+}
+
+void SuiteOhmRepairWindow::TestMissing()
+{
+    TEST(WriteMissing(kMaxMissed) == 0);
+    Add(3);
+    Add(5);
+    Add(6);
+    Add(9);
+    TEST(WriteMissing(kMaxMissed) == 5);
+    TEST(Missing(0) == 1);
+    TEST(Missing(1) == 2);
+    TEST(Missing(2) == 4);
+    TEST(Missing(3) == 7);
+    TEST(Missing(4) == 8);
+}
+
+void SuiteOhmRepairWindow::TestMissingLimit()
+{
+    Add(kCapacity);
+    TEST(WriteMissing(kMaxMissed) == kMaxMissed);
+    TEST(Missing(0) == 1);
+    TEST(Missing(kMaxMissed - 1) == kMaxMissed);
+}
+
+void SuiteOhmRepairWindow::TestMissingSkipsWords()
+{
+    // frames 32..63 fill a whole word of the bitmap
+    delete iWindow;
+    iWindow = new OhmRepairWindow(2 * kCapacity);
+    iWindow->Reset(1);
+    for (TUint frame=32; frame<64; frame++) {
+        Add(frame);
+    }
+    Add(65);
+    TEST(WriteMissing(kCapacity) == 32);
+    TEST(Missing(0) == 1);
+    TEST(Missing(30) == 31);
+    TEST(Missing(31) == 64);
+}
+
+void SuiteOhmRepairWindow::TestFrameWrap()
+{
+    const TUint first = 0xffffffff - 1;
+    iWindow->Reset(first);
+    Add(1);
+    Add(first + 1);
+    TEST(WriteMissing(kMaxMissed) == 2);
+    TEST(Missing(0) == first);
+    TEST(Missing(1) == 0);
+    Add(first);
+    Add(0);
+    for (TUint i=0; i<4; i++) {
+        OhmMsgAudio* msg = iWindow->TryRemoveNext();
+        TEST(msg != nullptr);
+        TEST(msg->Frame() == first + i);
+        msg->RemoveRef();
+    }
+    TEST(iWindow->Count() == 0);
+}
+
+void SuiteOhmRepairWindow::TestResetReleasesFrames()
+{
+    for (TUint frame=1; frame<=kCapacity; frame++) {
+        Add(frame);
+    }
+    iWindow->Reset(1);
+    TEST(iWindow->Count() == 0);
+    // all msgs returned to the factory so we can allocate them again
+    for (TUint frame=1; frame<=kCapacity; frame++) {
+        Add(frame);
+    }
+    TEST(iWindow->Count() == kCapacity);
+}
+
+
+
+void TestOhmRepairWindow()
+{
+    Runner runner("OhmRepairWindow tests\n");
+    runner.Add(new SuiteOhmRepairWindow());
+    runner.Run();
+}
@@ -0,0 +1,11 @@
+#include <OpenHome/Private/TestFramework.h>
+
+extern void TestOhmRepairWindow();
+
+void OpenHome::TestFramework::Runner::Main(TInt /*aArgc*/, TChar* /*aArgv*/[], Net::InitialisationParams* aInitParams)
+{
+    Net::UpnpLibrary::InitialiseMinimal(aInitParams);
+    TestOhmRepairWindow();
+    delete aInitParams;
+    Net::UpnpLibrary::Close();
+}
@@ -0,0 +1,212 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Av/Songcast/OhmSender.h>
+#include <OpenHome/Av/Songcast/OhmMsg.h>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Av;
+
+namespace OpenHome {
+namespace Av {
+
+class SuiteOhmSenderHistory : public SuiteUnitTest, private INonCopyable
+{
+    static const TUint kMaxFrames = 40; // not a power of two, as with the default history size
+public:
+    SuiteOhmSenderHistory(Environment& aEnv);
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    void Add(TUint aFrame);
+    TBool TryResend(TUint aFrame);
+    void TestLookup();
+    void TestLookupLargeHistory();
+    void TestAgeRejected();
+    void TestUnsentRejected();
+    void TestFrameWrap();
+    void TestResendCoalesced();
+    void TestClear();
+private:
+    Environment& iEnv;
+    OhmMsgFactory* iMsgFactory;
+    OhmSenderHistory* iHistory;
+};
+
+} // namespace Av
+} // namespace OpenHome
+
+
+// SuiteOhmSenderHistory
+
+SuiteOhmSenderHistory::SuiteOhmSenderHistory(Environment& aEnv)
+    : SuiteUnitTest("OhmSenderHistory")
+    , iEnv(aEnv)
+{
+    AddTest(MakeFunctor(*this, &SuiteOhmSenderHistory::TestLookup), "TestLookup");
+    AddTest(MakeFunctor(*this, &SuiteOhmSenderHistory::TestLookupLargeHistory), "TestLookupLargeHistory");
+    AddTest(MakeFunctor(*this, &SuiteOhmSenderHistory::TestAgeRejected), "TestAgeRejected");
+    AddTest(MakeFunctor(*this, &SuiteOhmSenderHistory::TestUnsentRejected), "TestUnsentRejected");
+    AddTest(MakeFunctor(*this, &SuiteOhmSenderHistory::TestFrameWrap), "TestFrameWrap");
+    AddTest(MakeFunctor(*this, &SuiteOhmSenderHistory::TestResendCoalesced), "TestResendCoalesced");
+    AddTest(MakeFunctor(*this, &SuiteOhmSenderHistory::TestClear), "TestClear");
+}
+
+void SuiteOhmSenderHistory::Setup()
+{
+    // one msg more than the history holds so that Add() never blocks waiting for a msg
+    iMsgFactory = new OhmMsgFactory(kMaxFrames + 1, 1, 1);
+    iHistory = new OhmSenderHistory(iEnv, kMaxFrames);
+}
+
+void SuiteOhmSenderHistory::TearDown()
+{
+    delete iHistory;
+    delete iMsgFactory;
+}
+
+void SuiteOhmSenderHistory::Add(TUint aFrame)
+{
+    iHistory->Add(*iMsgFactory->CreateAudio(false, true, false, false, 0, aFrame, 0, 0, 0, Brx::Empty(), Brx::Empty()));
+}
+
+TBool SuiteOhmSenderHistory::TryResend(TUint aFrame)
+{
+    OhmMsgAudio* msg = iHistory->TryGetForResend(aFrame);
+    if (msg == nullptr) {
+        return false;
+    }
+    TEST(msg->Frame() == aFrame);
+    msg->RemoveRef();
+    return true;
+}
+
+void SuiteOhmSenderHistory::TestLookup()
+{
+    TEST(iHistory->MaxFrames() == kMaxFrames);
+    TEST(!TryResend(0));
+    for (TUint frame=0; frame<kMaxFrames; frame++) {
+        Add(frame);
+    }
+    for (TUint frame=0; frame<kMaxFrames; frame++) {
+        TEST(TryResend(frame));
+    }
+}
+
+void SuiteOhmSenderHistory::TestLookupLargeHistory()
+{
+    // Each lookup goes straight to its slot so requests for many frames from a large history
+    // cost no more per frame than from a small one.
+    static const TUint kLargeFrames = 2000;
+    OhmMsgFactory factory(kLargeFrames + 1, 1, 1);
+    OhmSenderHistory history(iEnv, kLargeFrames);
+    for (TUint frame=0; frame<3*kLargeFrames; frame++) {
+        history.Add(*factory.CreateAudio(false, true, false, false, 0, frame, 0, 0, 0, Brx::Empty(), Brx::Empty()));
+    }
+    for (TUint frame=2*kLargeFrames; frame<3*kLargeFrames; frame++) {
+        OhmMsgAudio* msg = history.TryGetForResend(frame);
+        TEST(msg != nullptr);
+        if (msg != nullptr) {
+            TEST(msg->Frame() == frame);
+            msg->RemoveRef();
+        }
+    }
+    TEST(history.TryGetForResend(2*kLargeFrames - 1) == nullptr);
+}
+
+void SuiteOhmSenderHistory::TestAgeRejected()
+{
+    for (TUint frame=0; frame<3*kMaxFrames; frame++) {
+        Add(frame);
+    }
+    TEST(!TryResend(0));
+    TEST(!TryResend(2*kMaxFrames - 1));
+    TEST(TryResend(2*kMaxFrames));
+    TEST(TryResend(3*kMaxFrames - 1));
+}
+
+void SuiteOhmSenderHistory::TestUnsentRejected()
+{
+    for (TUint frame=0; frame<10; frame++) {
+        Add(frame);
+    }
+    TEST(TryResend(9));
+    TEST(!TryResend(10));
+    TEST(!TryResend(kMaxFrames));
+    TEST(!TryResend(0xffffffff));
+}
+
+void SuiteOhmSenderHistory::TestFrameWrap()
+{
+    // frame numbers wrap from 0xffffffff to 0; every frame still held is available
+    const TUint first = 0xffffffff - (kMaxFrames / 2) + 1;
+    TUint frame = first;
+    for (TUint i=0; i<kMaxFrames; i++) {
+        Add(frame++);
+    }
+    TEST(frame == kMaxFrames / 2);
+    frame = first;
+    for (TUint i=0; i<kMaxFrames; i++) {
+        TEST(TryResend(frame++));
+    }
+    TEST(!TryResend(first - 1));
+    TEST(!TryResend(kMaxFrames / 2));
+
+    // ...and age is still measured correctly once older frames are replaced
+    // (wait until the resends above no longer suppress repeat requests)
+    Thread::Sleep(OhmSenderHistory::kResendCoalesceMs + 10);
+    Add(kMaxFrames / 2);
+    TEST(!TryResend(first));
+    TEST(TryResend(first + 1));
+    TEST(TryResend(kMaxFrames / 2));
+}
+
+void SuiteOhmSenderHistory::TestResendCoalesced()
+{
+    Add(0);
+    Add(1);
+    TEST(TryResend(0));
+    // a request from another receiver for the same frame is served by the resend already sent...
+    TEST(!TryResend(0));
+    // ...but doesn't affect other frames
+    TEST(TryResend(1));
+    // a later request means the resend was lost so is honoured
+    Thread::Sleep(OhmSenderHistory::kResendCoalesceMs + 10);
+    TEST(TryResend(0));
+    TEST(!TryResend(0));
+
+    // a frame that replaces a resent one can be resent immediately
+    for (TUint frame=2; frame<kMaxFrames+1; frame++) {
+        Add(frame);
+    }
+    TEST(!TryResend(0));
+    TEST(TryResend(kMaxFrames));
+}
+
+void SuiteOhmSenderHistory::TestClear()
+{
+    for (TUint frame=0; frame<kMaxFrames; frame++) {
+        Add(frame);
+    }
+    iHistory->Clear();
+    for (TUint frame=0; frame<kMaxFrames; frame++) {
+        TEST(!TryResend(frame));
+    }
+    // all msgs returned to the factory so we can allocate them again
+    for (TUint frame=0; frame<kMaxFrames; frame++) {
+        Add(frame);
+    }
+    TEST(TryResend(0));
+    TEST(TryResend(kMaxFrames - 1));
+}
+
+
+
+void TestOhmSenderHistory(Environment& aEnv)
+{
+    Runner runner("OhmSenderHistory tests\n");
+    runner.Add(new SuiteOhmSenderHistory(aEnv));
+    runner.Run();
+}
@@ -25,7 +25,7 @@ class MockAudioSupply : public IAudioSupply, private INonCopyable
 public:
     MockAudioSupply(OpenHome::Test::ITestPipeWritable& aTestPipe);
 private: // from IAudioSupply
-    void OutputAudio(const Brx& aAudio) override;
+    void OutputAudio(const std::vector<IRepairable*>& aAudio) override;
 private:
     OpenHome::Test::ITestPipeWritable& iTestPipe;
 };
@@ -41,6 +41,7 @@ public: // from IRepairable
     TUint Frame() const override;
     TBool Resend() const override;
     const Brx& Data() const override;
+    Bwx& Data() override;
     void Destroy() override;
 private:
     OpenHome::Test::ITestPipeWritable& iTestPipe;
@@ -136,6 +137,22 @@ private:
     Repairer<kMaxFrames>* iRepairer;
 };
 
+class SuiteRaopAudioDecryptor : public TestFramework::SuiteUnitTest, private INonCopyable
+{
+public:
+    SuiteRaopAudioDecryptor();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    void TestKnownAnswer();
+    void TestTrailingPartialBlock();
+    void TestShortPacket();
+    void TestInitVectorResetPerPacket();
+private:
+    RaopAudioDecryptor* iDecryptor;
+};
+
 } // namespace Test
 } // namespace Av
 } // namespace OpenHome
@@ -175,14 +192,18 @@ MockAudioSupply::MockAudioSupply(ITestPipeWritable& aTestPipe)
 {
 }
 
-void MockAudioSupply::OutputAudio(const Brx& aAudio)
+void MockAudioSupply::OutputAudio(const std::vector<IRepairable*>& aAudio)
 {
-    ASSERT(aAudio.Bytes() > 0);
-    Bws<50> buf("MAS::OutputAudio ");
-    Ascii::AppendDec(buf, aAudio.Bytes());
-    buf.Append(" ");
-    buf.Append(aAudio);
-    iTestPipe.Write(buf);
+    ASSERT(aAudio.size() > 0);
+    for (auto* repairable : aAudio) {
+        const Brx& audio = repairable->Data();
+        ASSERT(audio.Bytes() > 0);
+        Bws<50> buf("MAS::OutputAudio ");
+        Ascii::AppendDec(buf, audio.Bytes());
+        buf.Append(" ");
+        buf.Append(audio);
+        iTestPipe.Write(buf);
+    }
 }
 
 
@@ -217,6 +238,11 @@ const Brx& MockRepairable::Data() const
     return iData;
 }
 
+Bwx& MockRepairable::Data()
+{
+    return iData;
+}
+
 void MockRepairable::Destroy()
 {
     Bws<50> buf("MR::Destroy ");
@@ -403,14 +429,14 @@ void SuiteRaopResend::TestResendOnePacket()
     // Now, deliver expected packet...
     iRepairer->OutputAudio(*iAllocator->Allocate(1, true, Brn("1")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 1")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 1")));
 
     // FIXME
     // Don't expect timer to be cancelled, as could still be requesting other missing ranges...
     // ...but, would we expect it to be cancelled if the repair buffer was emptied (i.e., after the next packet was output, which is the only packet queued)?
-    // ... followed by next that was buffered
+    // ... followed by next that was buffered, in the same batch
 
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 2")));
+    TEST(iTestPipe->Expect(Brn("MR::Destroy 1")));
     TEST(iTestPipe->Expect(Brn("MR::Destroy 2")));
 
     // Now, resume normal sequence.
@@ -444,9 +470,8 @@ void SuiteRaopResend::TestResendMultiplePackets()
     TEST(iTestPipe->Expect(Brn("MR::Destroy 1")));
     iRepairer->OutputAudio(*iAllocator->Allocate(2, true, Brn("2")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 2")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 2")));
-
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 3")));
+    TEST(iTestPipe->Expect(Brn("MR::Destroy 2")));
     TEST(iTestPipe->Expect(Brn("MR::Destroy 3")));
 
     // Now, resume normal sequence.
@@ -481,16 +506,16 @@ void SuiteRaopResend::TestResendMulitpleRanges()
     TEST(iTestPipe->Expect(Brn("MR::Destroy 1")));
     iRepairer->OutputAudio(*iAllocator->Allocate(2, true, Brn("2")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 2")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 2")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 3")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 3")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 4")));
+    TEST(iTestPipe->Expect(Brn("MR::Destroy 2")));
+    TEST(iTestPipe->Expect(Brn("MR::Destroy 3")));
     TEST(iTestPipe->Expect(Brn("MR::Destroy 4")));
 
     iRepairer->OutputAudio(*iAllocator->Allocate(5, false, Brn("5")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 5")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 5")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 6")));
+    TEST(iTestPipe->Expect(Brn("MR::Destroy 5")));
     TEST(iTestPipe->Expect(Brn("MR::Destroy 6")));
 
     TEST(iTestPipe->ExpectEmpty());
@@ -520,13 +545,13 @@ void SuiteRaopResend::TestResendBeyondMultipleRangeLimit()
     // Send in the missing packets, which should flush out the buffered packets.
     iRepairer->OutputAudio(*iAllocator->Allocate(1, true, Brn("1")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 1")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 1")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 2")));
+    TEST(iTestPipe->Expect(Brn("MR::Destroy 1")));
     TEST(iTestPipe->Expect(Brn("MR::Destroy 2")));
     iRepairer->OutputAudio(*iAllocator->Allocate(3, true, Brn("3")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 3")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 3")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 4")));
+    TEST(iTestPipe->Expect(Brn("MR::Destroy 3")));
     TEST(iTestPipe->Expect(Brn("MR::Destroy 4")));
 
     // Now fire timer to allow request for final missing packet.
@@ -536,8 +561,8 @@ void SuiteRaopResend::TestResendBeyondMultipleRangeLimit()
 
     iRepairer->OutputAudio(*iAllocator->Allocate(5, true, Brn("5")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 5")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 5")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 6")));
+    TEST(iTestPipe->Expect(Brn("MR::Destroy 5")));
     TEST(iTestPipe->Expect(Brn("MR::Destroy 6")));
 
     TEST(iTestPipe->ExpectEmpty());
@@ -577,8 +602,8 @@ void SuiteRaopResend::TestMultipleResendRecover()
     // Send in first missing packet.
     iRepairer->OutputAudio(*iAllocator->Allocate(2, true, Brn("2")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 2")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 2")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 3")));
+    TEST(iTestPipe->Expect(Brn("MR::Destroy 2")));
     TEST(iTestPipe->Expect(Brn("MR::Destroy 3")));
 
     // Pass in another packet.
@@ -587,12 +612,12 @@ void SuiteRaopResend::TestMultipleResendRecover()
     // Send in last missing packet.
     iRepairer->OutputAudio(*iAllocator->Allocate(4, true, Brn("4")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 4")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 4")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 5")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 5")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 6")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 6")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 7")));
+    TEST(iTestPipe->Expect(Brn("MR::Destroy 4")));
+    TEST(iTestPipe->Expect(Brn("MR::Destroy 5")));
+    TEST(iTestPipe->Expect(Brn("MR::Destroy 6")));
     TEST(iTestPipe->Expect(Brn("MR::Destroy 7")));
 
     // Allow timer to fire again. Nothing should happen as no more missing packets.
@@ -622,14 +647,14 @@ void SuiteRaopResend::TestMultipleResendRecover()
     // Resent packet arrives.
     iRepairer->OutputAudio(*iAllocator->Allocate(10, true, Brn("10")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 2 10")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 10")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 2 11")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 11")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 2 12")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 12")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 2 13")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 13")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 2 14")));
+    TEST(iTestPipe->Expect(Brn("MR::Destroy 10")));
+    TEST(iTestPipe->Expect(Brn("MR::Destroy 11")));
+    TEST(iTestPipe->Expect(Brn("MR::Destroy 12")));
+    TEST(iTestPipe->Expect(Brn("MR::Destroy 13")));
     TEST(iTestPipe->Expect(Brn("MR::Destroy 14")));
 
     TEST(iTestPipe->ExpectEmpty());
@@ -662,10 +687,10 @@ void SuiteRaopResend::TestResendRequest()
     // Send in missed packet.
     iRepairer->OutputAudio(*iAllocator->Allocate(1, true, Brn("1")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 1")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 1")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 2")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 2")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 3")));
+    TEST(iTestPipe->Expect(Brn("MR::Destroy 1")));
+    TEST(iTestPipe->Expect(Brn("MR::Destroy 2")));
     TEST(iTestPipe->Expect(Brn("MR::Destroy 3")));
 
     TEST(iTestPipe->ExpectEmpty());
@@ -864,12 +889,12 @@ void SuiteRaopResend::TestResendPacketsOutOfOrder()
     TEST(iTestPipe->ExpectEmpty());
     iRepairer->OutputAudio(*iAllocator->Allocate(1, true, Brn("1")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 1")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 1")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 2")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 2")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 3")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 3")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 4")));
+    TEST(iTestPipe->Expect(Brn("MR::Destroy 1")));
+    TEST(iTestPipe->Expect(Brn("MR::Destroy 2")));
+    TEST(iTestPipe->Expect(Brn("MR::Destroy 3")));
     TEST(iTestPipe->Expect(Brn("MR::Destroy 4")));
 
     TEST(iTestPipe->ExpectEmpty());
@@ -903,12 +928,12 @@ void SuiteRaopResend::TestDropPacketWhileAwaitingResend()
     // Now, receive resent packet.
     iRepairer->OutputAudio(*iAllocator->Allocate(1, true, Brn("1")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 1")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 1")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 2")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 2")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 3")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 3")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 4")));
+    TEST(iTestPipe->Expect(Brn("MR::Destroy 1")));
+    TEST(iTestPipe->Expect(Brn("MR::Destroy 2")));
+    TEST(iTestPipe->Expect(Brn("MR::Destroy 3")));
     TEST(iTestPipe->Expect(Brn("MR::Destroy 4")));
 
     // Send in another packet.
@@ -922,10 +947,10 @@ void SuiteRaopResend::TestDropPacketWhileAwaitingResend()
     // Now, send in requested packet.
     iRepairer->OutputAudio(*iAllocator->Allocate(5, true, Brn("5")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 5")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 5")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 6")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 6")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 7")));
+    TEST(iTestPipe->Expect(Brn("MR::Destroy 5")));
+    TEST(iTestPipe->Expect(Brn("MR::Destroy 6")));
     TEST(iTestPipe->Expect(Brn("MR::Destroy 7")));
 
     TEST(iTestPipe->ExpectEmpty());
@@ -968,12 +993,12 @@ void SuiteRaopResend::TestResendPacketsAlreadySeen()
     // Then, both packets were sent successfully after second request. Duplicate packet 3 should have no effect.
     iRepairer->OutputAudio(*iAllocator->Allocate(1, true, Brn("1")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 1")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 1")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 2")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 2")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 3")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 3")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 4")));
+    TEST(iTestPipe->Expect(Brn("MR::Destroy 1")));
+    TEST(iTestPipe->Expect(Brn("MR::Destroy 2")));
+    TEST(iTestPipe->Expect(Brn("MR::Destroy 3")));
     TEST(iTestPipe->Expect(Brn("MR::Destroy 4")));
     iRepairer->OutputAudio(*iAllocator->Allocate(3, true, Brn("3")));
     TEST(iTestPipe->Expect(Brn("MR::Destroy 3")));  // Discard resend.
@@ -1100,18 +1125,100 @@ void SuiteRaopResend::TestSequenceNumberWrappingDuringRepair()
     iRepairer->OutputAudio(*iAllocator->Allocate(65534, false, Brn("65534")));
     // Missing packet should be output, allong with all others.
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 5 65534")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 65534")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 5 65535")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 65535")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 0")));
+    TEST(iTestPipe->Expect(Brn("MR::Destroy 65534")));
+    TEST(iTestPipe->Expect(Brn("MR::Destroy 65535")));
     TEST(iTestPipe->Expect(Brn("MR::Destroy 0")));
 }
 
 
 
+// SuiteRaopAudioDecryptor
+
+// AES-128 CBC test vectors from NIST SP 800-38A, F.2.2
+static const TByte kAesKey[] = {
+    0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c };
+static const TByte kAesInitVector[] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+static const TByte kAesCipherText[] = {
+    0x76, 0x49, 0xab, 0xac, 0x81, 0x19, 0xb2, 0x46, 0xce, 0xe9, 0x8e, 0x9b, 0x12, 0xe9, 0x19, 0x7d,
+    0x50, 0x86, 0xcb, 0x9b, 0x50, 0x72, 0x19, 0xee, 0x95, 0xdb, 0x11, 0x3a, 0x91, 0x76, 0x78, 0xb2 };
+static const TByte kAesPlainText[] = {
+    0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+    0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51 };
+static const TByte kUnencryptedTail[] = { 0xa1, 0xa2, 0xa3, 0xa4, 0xa5 };
+
+SuiteRaopAudioDecryptor::SuiteRaopAudioDecryptor()
+    : SuiteUnitTest("SuiteRaopAudioDecryptor")
+{
+    AddTest(MakeFunctor(*this, &SuiteRaopAudioDecryptor::TestKnownAnswer), "TestKnownAnswer");
+    AddTest(MakeFunctor(*this, &SuiteRaopAudioDecryptor::TestTrailingPartialBlock), "TestTrailingPartialBlock");
+    AddTest(MakeFunctor(*this, &SuiteRaopAudioDecryptor::TestShortPacket), "TestShortPacket");
+    AddTest(MakeFunctor(*this, &SuiteRaopAudioDecryptor::TestInitVectorResetPerPacket), "TestInitVectorResetPerPacket");
+}
+
+void SuiteRaopAudioDecryptor::Setup()
+{
+    iDecryptor = new RaopAudioDecryptor();
+    iDecryptor->Init(Brn(kAesKey, sizeof(kAesKey)), Brn(kAesInitVector, sizeof(kAesInitVector)));
+}
+
+void SuiteRaopAudioDecryptor::TearDown()
+{
+    delete iDecryptor;
+}
+
+void SuiteRaopAudioDecryptor::TestKnownAnswer()
+{
+    Bws<sizeof(kAesCipherText)> audio(Brn(kAesCipherText, sizeof(kAesCipherText)));
+    iDecryptor->Decrypt(audio);
+    TEST(audio == Brn(kAesPlainText, sizeof(kAesPlainText)));
+}
+
+void SuiteRaopAudioDecryptor::TestTrailingPartialBlock()
+{
+    // Bytes after the last whole block are sent unencrypted.
+    Bws<sizeof(kAesCipherText) + sizeof(kUnencryptedTail)> audio(Brn(kAesCipherText, sizeof(kAesCipherText)));
+    audio.Append(Brn(kUnencryptedTail, sizeof(kUnencryptedTail)));
+    iDecryptor->Decrypt(audio);
+    TEST(audio.Bytes() == sizeof(kAesPlainText) + sizeof(kUnencryptedTail));
+    TEST(Brn(audio.Ptr(), sizeof(kAesPlainText)) == Brn(kAesPlainText, sizeof(kAesPlainText)));
+    TEST(Brn(audio.Ptr() + sizeof(kAesPlainText), sizeof(kUnencryptedTail)) == Brn(kUnencryptedTail, sizeof(kUnencryptedTail)));
+}
+
+void SuiteRaopAudioDecryptor::TestShortPacket()
+{
+    Bws<sizeof(kUnencryptedTail)> audio(Brn(kUnencryptedTail, sizeof(kUnencryptedTail)));
+    iDecryptor->Decrypt(audio);
+    TEST(audio == Brn(kUnencryptedTail, sizeof(kUnencryptedTail)));
+}
+
+void SuiteRaopAudioDecryptor::TestInitVectorResetPerPacket()
+{
+    // Each packet is encrypted starting from the session IV, so CBC state must not chain between packets.
+    for (TUint i=0; i<3; i++) {
+        Bws<sizeof(kAesCipherText)> audio(Brn(kAesCipherText, sizeof(kAesCipherText)));
+        iDecryptor->Decrypt(audio);
+        TEST(audio == Brn(kAesPlainText, sizeof(kAesPlainText)));
+    }
+
+    // Second block alone as a packet decrypts against the session IV rather than the first block.
+    const TUint kBlockBytes = sizeof(kAesCipherText) / 2;
+    Bws<kBlockBytes> block(Brn(kAesCipherText + kBlockBytes, kBlockBytes));
+    iDecryptor->Decrypt(block);
+    for (TUint i=0; i<kBlockBytes; i++) {
+        const TByte expected = kAesPlainText[kBlockBytes + i] ^ kAesCipherText[i] ^ kAesInitVector[i];
+        TEST(block[i] == expected);
+    }
+}
+
+
+
 void TestRaop(Environment& aEnv)
 {
     Runner runner("RAOP tests\n");
     runner.Add(new SuiteRaopResend(aEnv));
+    runner.Add(new SuiteRaopAudioDecryptor());
     runner.Run();
 }
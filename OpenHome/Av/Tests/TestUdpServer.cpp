@@ -98,6 +98,8 @@ private:
     void TestMsgsDisposedStart();
     void TestMsgsDisposed();
     void TestMsgsDisposedCapacityExceeded();
+    void TestReceiveMsg();
+    void TestStats();
 
     void TestSend();
     void TestPort();
@@ -135,6 +137,8 @@ SuiteSocketUdpServer::SuiteSocketUdpServer(Environment& aEnv, TIpAddress aInterf
     AddTest(MakeFunctor(*this, &SuiteSocketUdpServer::TestMsgsDisposedStart), "TestMsgsDisposedStart");
     AddTest(MakeFunctor(*this, &SuiteSocketUdpServer::TestMsgsDisposed), "TestMsgsDisposed");
     AddTest(MakeFunctor(*this, &SuiteSocketUdpServer::TestMsgsDisposedCapacityExceeded), "TestMsgsDisposedCapacityExceeded");
+    AddTest(MakeFunctor(*this, &SuiteSocketUdpServer::TestReceiveMsg), "TestReceiveMsg");
+    AddTest(MakeFunctor(*this, &SuiteSocketUdpServer::TestStats), "TestStats");
     AddTest(MakeFunctor(*this, &SuiteSocketUdpServer::TestSend), "TestSend");
     AddTest(MakeFunctor(*this, &SuiteSocketUdpServer::TestPort), "TestPort");
 }
@@ -380,6 +384,63 @@ void SuiteSocketUdpServer::TestMsgsDisposedCapacityExceeded()
     }
 }
 
+void SuiteSocketUdpServer::TestReceiveMsg()
+{
+    // test msgs can be read in place, and that server only fills buffers that have been released
+    iServer->Open();
+    SendNextMsg(iOutBuf);
+    MsgUdp& msg = iServer->ReceiveMsg();
+    Brn buf(msg.Buffer());
+    CheckMsgValue(buf, iMsgCount++);
+    TEST(msg.Endpoint().Port() == iSender->Port());
+
+    // holding msg leaves capacity for one fewer msg
+    for (TUint i=0; i<kMaxMsgCount+kDisposedCount; i++) {
+        SendNextMsg(iOutBuf);
+    }
+    CheckMsgValue(buf, 0);
+    iServer->ReleaseMsg(msg);
+    for (TUint i=0; i<kMaxMsgCount-1; i++) {
+        iServer->Receive(iInBuf);
+        CheckMsgValue(iInBuf, iMsgCount++);
+    }
+    iMsgCount += kDisposedCount + 1;
+
+    SendNextMsg(iOutBuf);
+    iServer->Receive(iInBuf);
+    CheckMsgValue(iInBuf, iMsgCount++);
+}
+
+void SuiteSocketUdpServer::TestStats()
+{
+    iServer->Open();
+    UdpServerStats stats = iServer->TakeStats();
+    TEST(stats.iReceived == 0);
+    TEST(stats.iDropped == 0);
+    TEST(stats.iDelivered == 0);
+
+    for (TUint i=0; i<kMaxMsgCount+kDisposedCount; i++) {
+        SendNextMsg(iOutBuf);
+    }
+    for (TUint i=0; i<kMaxMsgCount; i++) {
+        iServer->Receive(iInBuf);
+    }
+    stats = iServer->TakeStats();
+    TEST(stats.iReceived == kMaxMsgCount);
+    TEST(stats.iDropped == kDisposedCount);
+    TEST(stats.iMaxQueued == kMaxMsgCount);
+    TEST(stats.iDelivered == kMaxMsgCount);
+    TEST(stats.iMaxLatencyMs >= (kDisposedCount * kSendWaitMs));
+    TEST(stats.iTotalLatencyMs >= stats.iMaxLatencyMs);
+
+    // stats are cleared when taken
+    stats = iServer->TakeStats();
+    TEST(stats.iReceived == 0);
+    TEST(stats.iDropped == 0);
+    TEST(stats.iMaxQueued == 0);
+    TEST(stats.iMaxLatencyMs == 0);
+}
+
 void SuiteSocketUdpServer::TestSend()
 {
     // Switch roles of iSender and iServer only for this test.
@@ -190,6 +190,7 @@ CodecAacFdkAdts::CodecAacFdkAdts(IMimeTypeList& aMimeTypeList)
     : CodecAacFdkBase("ADTS", aMimeTypeList)
 {
     LOG(kCodec, "CodecAacFdkAdts::CodecAacFdkAdts\n");
+    iSignature.AddExtension("aac");
 }
 
 CodecAacFdkAdts::~CodecAacFdkAdts()
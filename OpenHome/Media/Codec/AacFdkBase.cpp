@@ -23,11 +23,6 @@ const Brn CodecAacFdkBase::kCodecAac("AAC");
 CodecAacFdkBase::CodecAacFdkBase(const TChar* aId, IMimeTypeList& aMimeTypeList)
     : CodecBase(aId)
     , iDecoderHandle(nullptr)
-#ifdef FDK_LITTLE_ENDIAN
-    , iEndianness(AudioDataEndian::Little)
-#else
-    , iEndianness(AudioDataEndian::Big)
-#endif
 {
     aMimeTypeList.Add("audio/aac");
     aMimeTypeList.Add("audio/aacp");
@@ -94,9 +89,8 @@ void CodecAacFdkBase::Process()
 // flush any remaining samples from the decoded buffer
 void CodecAacFdkBase::FlushOutput()
 {
-    if ((iStreamEnded || iNewStreamStarted) && iOutBuf.Bytes() > 0) {
-        iTrackOffset += iController->OutputAudioPcm(iOutBuf, iChannels, iOutputSampleRate, iBitDepth, iEndianness, iTrackOffset);
-        iOutBuf.SetBytes(0);
+    if (iStreamEnded || iNewStreamStarted) {
+        iController->FlushAudioBuf();
     }
     //LOG(kCodec, "CodecAac::Process complete - total samples = %lld\n", iTotalSamplesOutput);
 }
@@ -149,21 +143,22 @@ void CodecAacFdkBase::DecodeFrame()
             iController->OutputDecodedStream(iBitrateAverage, iBitDepth, iOutputSampleRate, iChannels, kCodecAac, iTrackLengthJiffies, 0, false, DeriveProfile(iChannels));
         }
 
-        const TUint frameSize = info->frameSize * info->numChannels;    // Total number of samples to output across all channels.
-        const TUint bytesOut = frameSize * (iBitDepth / 8);             // Each sample is (iBitDepth / 8) bytes.
-        iOutBuf.SetBytes(bytesOut);
-
         // Output samples
-        const TUint samplesToWrite = iOutBuf.Bytes() / (iChannels * (iBitDepth / 8));   // Only output full samples, and ensure each set of samples includes all channels.
-        const TUint bytes = samplesToWrite * (iBitDepth / 8) * iChannels;
-
-        Brn outBuf(iOutBuf.Ptr(), bytes);
-        if (outBuf.Bytes() > 0) {
-            iTrackOffset += iController->OutputAudioPcm(outBuf, iChannels, iOutputSampleRate, iBitDepth, iEndianness, iTrackOffset);
+        // Decoder writes each channel as a contiguous block of info->frameSize samples.
+        // Interleave these straight into pipeline audio buffers.
+        if (iChannels > kMaxChannels) {
+            THROW(CodecStreamFeatureUnsupported);
+        }
+        const TUint samplesToWrite = info->frameSize;
+        if (samplesToWrite > 0) {
+            const INT_PCM* channels[kMaxChannels];
+            const INT_PCM* pcm = reinterpret_cast<const INT_PCM*>(iOutBuf.Ptr());
+            for (TUint i=0; i<iChannels; i++) {
+                channels[i] = pcm + (i * samplesToWrite);
+            }
+            AudioBufWriter::WritePlanar(*iController, channels, iChannels, iBitDepth, samplesToWrite, iTrackOffset,
+                                        [](INT_PCM aSubsample) { return aSubsample; });
             iTotalSamplesOutput += samplesToWrite;
-
-            Brn remaining(iOutBuf.Ptr() + outBuf.Bytes(), iOutBuf.Bytes() - outBuf.Bytes());
-            iOutBuf.Replace(remaining);
         }
 
         //LOG(kCodec, "CodecAac::iSamplesWrittenTotal: %llu\n", iTotalSamplesOutput);
@@ -174,6 +169,7 @@ void CodecAacFdkBase::InitialiseDecoderMp4(const Brx& aAudioSpecificConfig)
 {
     ASSERT(iDecoderHandle == nullptr);
     iDecoderHandle = aacDecoder_Open(TT_MP4_RAW, 1);
+    (void)aacDecoder_SetParam(iDecoderHandle, AAC_PCM_OUTPUT_INTERLEAVED, 0); // DecodeFrame interleaves
 
     // Set up decoder with "audio specific config".
     const TByte* ascPtr = aAudioSpecificConfig.Ptr();
@@ -188,4 +184,5 @@ void CodecAacFdkBase::InitialiseDecoderAdts()
 {
     ASSERT(iDecoderHandle == nullptr);
     iDecoderHandle = aacDecoder_Open(TT_MP4_ADTS, 1);
+    (void)aacDecoder_SetParam(iDecoderHandle, AAC_PCM_OUTPUT_INTERLEAVED, 0); // DecodeFrame interleaves
 }
@@ -18,6 +18,7 @@ class CodecAacFdkBase : public CodecBase
 private:
     static const TUint kInputBufBytes = 4096;   // Input buf size used by third-party decoder examples.
     static const TUint kOutputBufBytes = 8192;  // See #5602 before changing. Was previously set to 7680 for #5602 but needed to be upped to #8192 for certain tracks (see #6137).
+    static const TUint kMaxChannels = 8;
 public:
     static const Brn kCodecAac;
 protected:
@@ -54,7 +55,6 @@ protected:
     TBool iStreamEnded;
 private:
     HANDLE_AACDECODER iDecoderHandle;
-    AudioDataEndian iEndianness;
 };
 
 } //namespace Codec
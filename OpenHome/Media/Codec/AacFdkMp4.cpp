@@ -57,6 +57,7 @@ CodecAacFdkMp4::CodecAacFdkMp4(IMimeTypeList& aMimeTypeList)
     : CodecAacFdkBase("AAC", aMimeTypeList)
     , iAudioSpecificConfig(kDefaultAscBytes)
 {
+    iSignature.AddMagic(0, Brn("mp4a")); // codec id written by Mpeg4Container
 }
 
 CodecAacFdkMp4::~CodecAacFdkMp4()
@@ -249,14 +250,9 @@ void CodecAacFdkMp4::StreamInitialise()
         InitialiseDecoderMp4(iAudioSpecificConfig);
 
         // Read sample size table.
-        ReaderBinary readerBin(codecBufReader);
         iSampleSizeTable.Clear();
-        const TUint sampleCount = readerBin.ReadUintBe(4);
-        iSampleSizeTable.Init(sampleCount);
-        for (TUint i=0; i<sampleCount; i++) {
-            const TUint sampleSize = readerBin.ReadUintBe(4);
-            iSampleSizeTable.AddSampleSize(sampleSize);
-        }
+        SampleSizeTableInitialiser sampleSizeTableInitialiser(iSampleSizeTable, codecBufReader);
+        sampleSizeTableInitialiser.Init();
 
         // Read seek table.
         iSeekTable.Deinitialise();
@@ -42,6 +42,7 @@ CodecAifc::CodecAifc(IMimeTypeList& aMimeTypeList)
 {
     aMimeTypeList.Add("audio/aifc");
     aMimeTypeList.Add("audio/x-aifc");
+    iSignature.AddExtension("aifc");
 }
 
 CodecAifc::~CodecAifc()
@@ -41,6 +41,8 @@ CodecAiff::CodecAiff(IMimeTypeList& aMimeTypeList)
 {
     aMimeTypeList.Add("audio/aiff");
     aMimeTypeList.Add("audio/x-aiff");
+    iSignature.AddExtension("aif");
+    iSignature.AddExtension("aiff");
 }
 
 CodecAiff::~CodecAiff()
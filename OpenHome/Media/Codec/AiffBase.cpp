@@ -13,6 +13,9 @@ CodecAiffBase::CodecAiffBase(const TChar* aName)
     : CodecBase(aName, kCostLow)
     , iName(aName)
 {
+    Bws<12> form("FORM????");
+    form.Append(iName);
+    iSignature.AddMagic(0, form);
 }
 
 CodecAiffBase::~CodecAiffBase()
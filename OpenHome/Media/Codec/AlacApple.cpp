@@ -60,6 +60,7 @@ CodecAlacApple::CodecAlacApple(IMimeTypeList& aMimeTypeList)
 {
     LOG(kCodec, "CodecAlac::CodecAlac\n");
     aMimeTypeList.Add("audio/x-m4a");
+    iSignature.AddMagic(0, Brn("alac")); // codec id written by Mpeg4Container
 }
 
 CodecAlacApple::~CodecAlacApple()
@@ -119,14 +120,9 @@ void CodecAlacApple::StreamInitialise()
         }
 
         // Read sample size table.
-        ReaderBinary readerBin(codecBufReader);
         iSampleSizeTable.Clear();
-        const TUint sampleCount = readerBin.ReadUintBe(4);
-        iSampleSizeTable.Init(sampleCount);
-        for (TUint i=0; i<sampleCount; i++) {
-            const TUint sampleSize = readerBin.ReadUintBe(4);
-            iSampleSizeTable.AddSampleSize(sampleSize);
-        }
+        SampleSizeTableInitialiser sampleSizeTableInitialiser(iSampleSizeTable, codecBufReader);
+        sampleSizeTableInitialiser.Init();
 
         // Read seek table.
         iSeekTable.Deinitialise();
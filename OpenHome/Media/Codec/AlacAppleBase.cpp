@@ -91,24 +91,9 @@ void CodecAlacAppleBase::Decode()
     //LOG(kCodec, "CodecAlacAppleBase::Process  iDecodedBuf.Bytes(): %u\n", iDecodedBuf.Bytes());
 
     // Output all samples, as will probably fill full iDecodedBuf on next decode.
-    TUint idx = 0;
-    TUint samplesToWrite = iDecodedBuf.Bytes()/iBytesPerSample;
-    while (samplesToWrite > 0) {
-        TUint bytesToOutput = DecodedAudio::kMaxBytes;
-        Brn out;
-        if (iDecodedBuf.Bytes()-idx < bytesToOutput) {
-            bytesToOutput = iDecodedBuf.Bytes()-idx;
-        }
-        out.Set(iDecodedBuf.Ptr()+idx, bytesToOutput);
-        TUint samplesOut = bytesToOutput/iBytesPerSample;
-
-        iTrackOffset += iController->OutputAudioPcm(out, iChannels, iSampleRate, iBitDepth, Endianness(), iTrackOffset);
-
-        idx += out.Bytes();
-        out.Set(Brx::Empty());
-        samplesToWrite -= samplesOut;
-        iSamplesWrittenTotal += samplesOut;
-    }
+    // Decoder owns its interleaving so copy (converting endianness if required) straight into pipeline audio buffers.
+    AudioBufWriter::WriteInterleaved(*iController, iDecodedBuf, iBitDepth, iChannels, Endianness(), iTrackOffset);
+    iSamplesWrittenTotal += outSamples;
     iDecodedBuf.SetBytes(0);
 }
 
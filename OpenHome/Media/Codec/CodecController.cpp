@@ -9,8 +9,10 @@
 #include <OpenHome/Media/Pipeline/Rewinder.h>
 #include <OpenHome/Media/Pipeline/Logger.h>
 #include <OpenHome/Media/Debug.h>
+#include <OpenHome/Media/Utils/PcmKernels.h>
 
 #include <algorithm>
+#include <string.h>
 
 using namespace OpenHome;
 using namespace OpenHome::Media;
@@ -122,6 +124,58 @@ void EncodedStreamInfo::SetDsd(TUint aSampleRate, TUint aNumChannels, TUint aSam
 }
 
 
+// AudioBufWriter
+
+void AudioBufWriter::WritePlanarInt32(ICodecController& aController, const TInt32* const* aChannels, TUint aNumChannels, TUint aBitDepth,
+                                      TUint aNumSamples, TUint64& aTrackOffset, TUint aShift)
+{ // static
+    ASSERT(aBitDepth % 8 == 0);
+    const TBool bigEndian = (aController.AudioBufEndian() == AudioDataEndian::Big);
+    TUint index = 0;
+    while (index < aNumSamples) {
+        TByte* dest;
+        TUint samples;
+        aController.GetAudioBuf(dest, samples);
+        samples = std::min(samples, aNumSamples - index);
+        if (bigEndian) {
+            PcmKernels::PackPlanarBigEndian(aChannels, aNumChannels, index, samples, aShift, aBitDepth / 8, dest);
+        }
+        else {
+            PcmKernels::PackPlanarLittleEndian(aChannels, aNumChannels, index, samples, aShift, aBitDepth / 8, dest);
+        }
+        aController.AppendAudioBuf(samples, aTrackOffset);
+        index += samples;
+    }
+}
+
+void AudioBufWriter::WriteInterleaved(ICodecController& aController, const Brx& aData, TUint aBitDepth, TUint aNumChannels,
+                                      AudioDataEndian aEndian, TUint64& aTrackOffset)
+{ // static
+    const TUint subsampleBytes = aBitDepth / 8;
+    const TUint bytesPerSample = subsampleBytes * aNumChannels;
+    ASSERT(aData.Bytes() % bytesPerSample == 0);
+    const TBool swap = (subsampleBytes > 1 && aEndian != aController.AudioBufEndian());
+    const TByte* src = aData.Ptr();
+    TUint remaining = aData.Bytes() / bytesPerSample;
+    while (remaining > 0) {
+        TByte* dest;
+        TUint samples;
+        aController.GetAudioBuf(dest, samples);
+        samples = std::min(samples, remaining);
+        const TUint bytes = samples * bytesPerSample;
+        if (swap) {
+            PcmKernels::CopySwapped(src, dest, bytes, subsampleBytes);
+        }
+        else {
+            (void)memcpy(dest, src, bytes);
+        }
+        aController.AppendAudioBuf(samples, aTrackOffset);
+        src += bytes;
+        remaining -= samples;
+    }
+}
+
+
 // CodecBase
 
 CodecBase::~CodecBase()
@@ -153,6 +207,11 @@ void CodecBase::Construct(ICodecController& aController)
     iController = &aController;
 }
 
+const FormatSignature& CodecBase::Signature() const
+{
+    return iSignature;
+}
+
 SpeakerProfile CodecBase::DeriveProfile(TUint aChannels)
 {
     return (aChannels == 1) ? SpeakerProfile(1) : SpeakerProfile(2);
@@ -179,6 +238,10 @@ CodecController::CodecController(MsgFactory& aMsgFactory, IPipelineElementUpstre
     , iUrlBlockWriter(aUrlBlockWriter)
     , iLock("CDCC")
     , iShutdownSem("CDC2", 0)
+    , iProbeBytes(0)
+    , iSeekPoints(kSeekPointCacheTracks, kSeekPointCachePointsPerTrack)
+    , iDecodedAudioCache(nullptr)
+    , iFlushIdProvider(nullptr)
     , iAnimator(nullptr)
     , iActiveCodec(nullptr)
     , iPendingMsg(nullptr)
@@ -189,6 +252,7 @@ CodecController::CodecController(MsgFactory& aMsgFactory, IPipelineElementUpstre
     , iPostSeekStreamInfo(nullptr)
     , iAudioEncoded(nullptr)
     , iSeekable(false)
+    , iPlayingCached(false)
     , iLive(false)
     , iStreamFormat(MsgEncodedStream::Format::Encoded)
     , iStreamHandler(nullptr)
@@ -204,6 +268,7 @@ CodecController::CodecController(MsgFactory& aMsgFactory, IPipelineElementUpstre
     , iMaxOutputJiffies(aMaxOutputJiffies)
     , iAudioDecoded(nullptr)
     , iAudioDecodedBytes(0)
+    , iAudioDecodedTrackOffset(0)
     , iRamp(RampType::Sample)
     , iInitialSeekPos(0)
 {
@@ -232,6 +297,7 @@ CodecController::~CodecController()
     if (iPostSeekStreamInfo != nullptr) {
         iPostSeekStreamInfo->RemoveRef();
     }
+    delete iDecodedAudioCache;
     delete iLoggerRewinder;
 }
 
@@ -246,6 +312,8 @@ void CodecController::AddCodec(CodecBase* aCodec)
         }
     }
     iCodecs.insert(it, aCodec);
+    iRecognitionOrder.reserve(iCodecs.size());
+    iProbeBytes = std::max(iProbeBytes, aCodec->iSignature.ProbeBytes());
 #if 0
     Log::Print("Sorted codecs are: ");
     it = iCodecs.begin();
@@ -266,6 +334,13 @@ void CodecController::SetAnimator(IPipelineAnimator& aAnimator)
     iAnimator = &aAnimator;
 }
 
+void CodecController::EnableDecodedAudioCache(TUint aMaxBytes, IFlushIdProvider& aFlushIdProvider)
+{
+    ASSERT(iDecodedAudioCache == nullptr);
+    iDecodedAudioCache = new DecodedAudioCache(aMaxBytes);
+    iFlushIdProvider = &aFlushIdProvider;
+}
+
 void CodecController::Flush(TUint aFlushId)
 {
     AutoMutex amx(iLock);
@@ -282,7 +357,7 @@ void CodecController::StartSeek(TUint aStreamId, TUint aSecondsAbsolute, ISeekOb
         aHandle = ISeeker::kHandleError;
         return;
     }
-    if (iActiveCodec == nullptr) {
+    if (iActiveCodec == nullptr && !iPlayingCached) {
         LOG_ERROR(kMedia, "CodecController::StartSeek(%u, %u) fail - no active codec\n", aStreamId, aSecondsAbsolute);
         aHandle = ISeeker::kHandleError;
         return;
@@ -340,6 +415,10 @@ void CodecController::CodecThread()
             }
             iQueueTrackData = true;
             iStreamStarted = iStreamEnded = false;
+            if (iDecodedAudioCache != nullptr && iInitialSeekPos == 0 && iDecodedAudioCache->IsComplete()) {
+                OutputCachedStream();
+                continue;
+            }
             iRecognising = true;
             EncodedStreamInfo streamInfo;
             if (iStreamFormat == MsgEncodedStream::Format::Pcm) {
@@ -356,8 +435,18 @@ void CodecController::CodecThread()
             LOG(kMedia, "CodecThread: start recognition.  iTrackId=%u, iStreamId=%u\n", iTrackId, iStreamId);
             TBool streamEnded = false;
 
-            for (size_t i=0; i<iCodecs.size() && !iQuit && !iStreamStopped; i++) {
-                CodecBase* codec = iCodecs[i];
+            // Try codecs whose signature matches the stream first, saving a rewind and re-read per codec ahead of them
+            iRecognitionOrder.clear();
+            if (iStreamFormat != MsgEncodedStream::Format::Encoded) {
+                iRecognitionOrder.insert(iRecognitionOrder.end(), iCodecs.begin(), iCodecs.end());
+            }
+            else if (ProbeStream(streamEnded)) {
+                FormatSignature::Order(iCodecs, iProbe, iTrackUri, iRecognitionOrder);
+                LOG(kMedia, "CodecThread: trying %s first\n", iRecognitionOrder.size() > 0? iRecognitionOrder[0]->Id() : "none");
+            }
+
+            for (size_t i=0; i<iRecognitionOrder.size() && !iQuit && !iStreamStopped; i++) {
+                CodecBase* codec = iRecognitionOrder[i];
                 TBool recognised = false;
                 try {
                     recognised = codec->Recognise(streamInfo);
@@ -434,7 +523,7 @@ void CodecController::CodecThread()
                     if (!seek) {
                         iActiveCodec->Process();
                     }
-                    else {
+                    else if (!TrySeekCached(seekHandle)) {
                         iExpectedSeekFlushId = MsgFlush::kIdInvalid;
                         TUint64 sampleNum = iSeekSeconds * static_cast<TUint64>(iSampleRate);
                         iSeekInProgress = true;
@@ -467,6 +556,10 @@ void CodecController::CodecThread()
             catch (CodecStreamStart&) {}
             catch (CodecStreamEnded&) {
                 iStreamEnded = true;
+                if (iDecodedAudioCache != nullptr && !iStreamStopped && iStreamPos >= iStreamLength) {
+                    // codec has read (and so output audio for) the whole stream
+                    iDecodedAudioCache->SetComplete();
+                }
             }
             catch (CodecStreamCorrupt&) {
                 if (!iStreamStopped) {
@@ -485,6 +578,7 @@ void CodecController::CodecThread()
         catch (Exception& ex) {
             LOG_ERROR(kPipeline, "WARNING: codec threw %s\n", ex.Message());
         }
+        FlushAudioBuf();
         if (iActiveCodec != nullptr) {
             iActiveCodec->StreamCompleted();
         }
@@ -517,6 +611,32 @@ void CodecController::Rewind()
     iStreamPos = 0;
 }
 
+TBool CodecController::ProbeStream(TBool& aStreamEnded)
+{ // Reads the start of a stream into iProbe.  Returns false if recognition should be abandoned.
+    iProbe.SetBytes(0);
+    if (iProbeBytes == 0) {
+        return true;
+    }
+    try {
+        Read(iProbe, iProbeBytes);
+    }
+    catch (CodecStreamStart&) {}
+    catch (CodecStreamEnded&) {}
+    catch (CodecStreamStopped&) {}
+    catch (CodecStreamFlush&) {
+        return false;
+    }
+    catch (CodecRecognitionOutOfData&) {}
+    iLock.Wait();
+    if (iStreamStarted || iStreamEnded) {
+        aStreamEnded = true;
+    }
+    iStreamStarted = iStreamEnded = false; // as for codec recognition, Rewind() will replay any Track or EncodedStream msgs
+    Rewind();
+    iLock.Signal();
+    return true;
+}
+
 Msg* CodecController::PullMsg()
 {
     {
@@ -567,6 +687,7 @@ void CodecController::ReleaseAudioDecoded()
         iAudioDecoded->RemoveRef();
         iAudioDecoded = nullptr;
     }
+    iAudioDecodedBytes = 0;
 }
 
 void CodecController::Read(Bwx& aBuf, TUint aBytes)
@@ -708,6 +829,9 @@ TBool CodecController::TrySeekTo(TUint aStreamId, TUint64 aBytePos)
     if (flushId != MsgFlush::kIdInvalid) {
         ReleaseAudioEncoded();
         ReleaseAudioDecoded();
+        if (iDecodedAudioCache != nullptr) {
+            iDecodedAudioCache->MarkDiscontinuity();
+        }
         iExpectedFlushId = flushId;
         iConsumeExpectedFlush = false;
         iExpectedSeekFlushId = flushId;
@@ -727,6 +851,16 @@ TUint64 CodecController::StreamPos() const
     return iStreamPos;
 }
 
+void CodecController::AddSeekPoint(TUint64 aSample, TUint64 aBytePos)
+{
+    iSeekPoints.Add(aSample, aBytePos);
+}
+
+TBool CodecController::TryGetSeekPoint(TUint64 aSample, TUint64& aSamplePoint, TUint64& aBytePos)
+{
+    return iSeekPoints.TryFind(aSample, aSamplePoint, aBytePos);
+}
+
 void CodecController::OutputDecodedStream(TUint aBitRate, TUint aBitDepth, TUint aSampleRate,
                                           TUint aNumChannels, const Brx& aCodecName,
                                           TUint64 aTrackLength, TUint64 aSampleStart,
@@ -743,6 +877,19 @@ void CodecController::OutputDecodedStream(TUint aBitRate, TUint aBitDepth, TUint
     if (aSampleRate > 192000) {
         multiroom = Multiroom::Forbidden;
     }
+    if (iDecodedAudioCache != nullptr) {
+        DecodedAudioCache::Format format;
+        format.iBitRate = aBitRate;
+        format.iBitDepth = aBitDepth;
+        format.iSampleRate = aSampleRate;
+        format.iNumChannels = aNumChannels;
+        format.iCodecName.Replace(aCodecName);
+        format.iTrackLength = aTrackLength;
+        format.iLossless = aLossless;
+        format.iProfile = aProfile;
+        format.iAnalogBypass = aAnalogBypass;
+        iDecodedAudioCache->SetFormat(format);
+    }
     MsgDecodedStream* msg =
         iMsgFactory.CreateMsgDecodedStream(iStreamId, aBitRate, aBitDepth, aSampleRate, aNumChannels,
                                            aCodecName, aTrackLength, aSampleStart,
@@ -760,6 +907,9 @@ void CodecController::OutputDecodedStreamDsd(TUint aSampleRate, TUint aNumChanne
         Log::Print("ERROR: DSD stream with %u channels cannot be played\n", aNumChannels);
         THROW(CodecStreamFeatureUnsupported);
     }
+    if (iDecodedAudioCache != nullptr) {
+        iDecodedAudioCache->Discard(); // only pcm is cached
+    }
     static const TUint kBitDepth = 1;
     const TUint bitRate = aSampleRate * aNumChannels;
     auto msg =
@@ -773,6 +923,7 @@ void CodecController::OutputDecodedStreamDsd(TUint aSampleRate, TUint aNumChanne
 
 void CodecController::DoOutputDecodedStream(MsgDecodedStream* aMsg)
 {
+    FlushAudioBuf(); // held audio is in the format of the previous stream
     TBool queue = true;
     auto& stream = aMsg->StreamInfo();
     {
@@ -826,6 +977,7 @@ TUint64 CodecController::OutputAudioPcm(const Brx& aData, TUint aChannels, TUint
     do {
         const TUint bytes = std::min(iMaxOutputBytes, data.Bytes());
         Brn buf(p, bytes);
+        CacheAudio(buf, aEndian, aTrackOffset);
         MsgAudioPcm* audio = iMsgFactory.CreateMsgAudioPcm(buf, aChannels, aSampleRate, aBitDepth, aEndian, aTrackOffset);
         const TUint64 jiffies = DoOutputAudio(audio);
         aTrackOffset += jiffies;
@@ -842,6 +994,9 @@ TUint64 CodecController::OutputAudioPcm(MsgAudioEncoded* aMsg, TUint aChannels,
     ASSERT(aChannels == iChannels);
     ASSERT(aSampleRate == iSampleRate);
     ASSERT(aBitDepth == iBitDepth);
+    if (iDecodedAudioCache != nullptr && iExpectedFlushId == MsgFlush::kIdInvalid) {
+        iDecodedAudioCache->Add(*aMsg, aTrackOffset / Jiffies::PerSample(iSampleRate));
+    }
     MsgAudioPcm* audio = iMsgFactory.CreateMsgAudioPcm(aMsg, aChannels, aSampleRate, aBitDepth, aTrackOffset);
     aMsg->RemoveRef();
     return DoOutputAudio(audio);
@@ -849,6 +1004,7 @@ TUint64 CodecController::OutputAudioPcm(MsgAudioEncoded* aMsg, TUint aChannels,
 
 TUint64 CodecController::DoOutputAudio(MsgAudio* aAudioMsg)
 {
+    FlushAudioBuf();
     if (iExpectedFlushId != MsgFlush::kIdInvalid) {
         // Codec outputting audio while flush is pending
         // This audio may be cached by third party code so it's easier to ignore it here rather than tracking down all causes of it
@@ -872,6 +1028,121 @@ TUint64 CodecController::DoOutputAudio(MsgAudio* aAudioMsg)
     return jiffies;
 }
 
+void CodecController::CacheAudio(const Brx& aData, AudioDataEndian aEndian, TUint64 aTrackOffset)
+{
+    // skip audio that DoOutputAudio() will discard
+    if (iDecodedAudioCache != nullptr && iExpectedFlushId == MsgFlush::kIdInvalid) {
+        iDecodedAudioCache->Add(aData, aEndian, aTrackOffset / Jiffies::PerSample(iSampleRate));
+    }
+}
+
+TBool CodecController::TrySeekCached(TUint aSeekHandle)
+{
+    if (iDecodedAudioCache == nullptr || iExpectedFlushId != MsgFlush::kIdInvalid) {
+        return false;
+    }
+    FlushAudioBuf(); // cached audio must run right up to the point the codec will continue decoding from
+    const TUint64 sample = iSeekSeconds * static_cast<TUint64>(iSampleRate);
+    Brn audio;
+    const TBool cached = (iPlayingCached? iDecodedAudioCache->TryRead(sample, audio)   // whole track is held
+                                        : iDecodedAudioCache->Contains(sample));
+    if (!cached) {
+        return false;
+    }
+    LOG(kMedia, "CodecController: seek to %us in stream %u served from decoded audio cache\n", iSeekSeconds, iStreamId);
+
+    // There's no upstream flush to wait for.  Generate our own so that Seeker discards
+    // audio output since the seek point and then play the cached audio from there.
+    const TUint flushId = iFlushIdProvider->NextFlushId();
+    iLock.Wait();
+    const TBool notify = (iSeek && iSeekHandle == aSeekHandle);
+    if (notify) {
+        iSeek = false;
+    }
+    ISeekObserver* seekObserver = iSeekObserver;
+    iLock.Signal();
+    if (notify) {
+        seekObserver->NotifySeekComplete(aSeekHandle, flushId);
+        Queue(iMsgFactory.CreateMsgFlush(flushId));
+        const auto& format = iDecodedAudioCache->CurrentFormat();
+        OutputDecodedStream(format.iBitRate, format.iBitDepth, format.iSampleRate, format.iNumChannels,
+                            format.iCodecName, format.iTrackLength, sample, format.iLossless,
+                            format.iProfile, format.iAnalogBypass);
+        OutputCachedAudio(sample);
+    }
+    return true;
+}
+
+void CodecController::OutputCachedStream()
+{
+    LOG(kMedia, "CodecThread: playing track %u from decoded audio cache.  iStreamId=%u\n", iTrackId, iStreamId);
+    iRewinder.Stop(); // we won't be recognising (or rewinding) this stream
+    iLock.Wait();
+    iPlayingCached = true;
+    iLock.Signal();
+    const auto& format = iDecodedAudioCache->CurrentFormat();
+    OutputDecodedStream(format.iBitRate, format.iBitDepth, format.iSampleRate, format.iNumChannels,
+                        format.iCodecName, format.iTrackLength, 0, format.iLossless,
+                        format.iProfile, format.iAnalogBypass);
+    OutputCachedAudio(0);
+
+    // There's no codec to seek so serve all seeks from the cache.  Seeks beyond the end of the
+    // track fail, leaving Seeker to discard or restream as it would for any other stream.
+    for (;;) {
+        iLock.Wait();
+        const TBool seek = iSeek;
+        const TUint seekHandle = iSeekHandle;
+        iLock.Signal();
+        if (!seek) {
+            break;
+        }
+        if (TrySeekCached(seekHandle)) {
+            continue;
+        }
+        iLock.Wait();
+        const TBool notify = (iSeek && iSeekHandle == seekHandle);
+        if (notify) {
+            iSeek = false;
+        }
+        ISeekObserver* seekObserver = iSeekObserver;
+        iLock.Signal();
+        if (notify) {
+            seekObserver->NotifySeekComplete(seekHandle, MsgFlush::kIdInvalid);
+        }
+        break;
+    }
+
+    // the remainder of the encoded stream isn't needed
+    iLock.Wait();
+    iPlayingCached = false;
+    if (iExpectedFlushId == MsgFlush::kIdInvalid) {
+        auto streamHandler = iStreamHandler.load();
+        iExpectedFlushId = streamHandler->TryStop(iStreamId);
+        if (iExpectedFlushId != MsgFlush::kIdInvalid) {
+            iConsumeExpectedFlush = true;
+        }
+    }
+    iLock.Signal();
+}
+
+void CodecController::OutputCachedAudio(TUint64 aSample)
+{
+    const TUint64 jiffiesPerSample = Jiffies::PerSample(iSampleRate);
+    Brn audio;
+    while (iDecodedAudioCache->TryRead(aSample, audio)) {
+        {
+            AutoMutex _(iLock);
+            if (iSeek || iStreamStopped || iExpectedFlushId != MsgFlush::kIdInvalid) {
+                break;
+            }
+        }
+        auto msg = iMsgFactory.CreateMsgAudioPcm(audio, iChannels, iSampleRate, iBitDepth,
+                                                 AudioDataEndian::Big, aSample * jiffiesPerSample);
+        (void)DoOutputAudio(msg);
+        aSample += audio.Bytes() / iBytesPerSample;
+    }
+}
+
 TUint64 CodecController::OutputAudioDsd(const Brx& aData, TUint aChannels, TUint aSampleRate,
                                         TUint aSampleBlockWords, TUint64 aTrackOffset, TUint aPadBytesPerChunk)
 {
@@ -917,12 +1188,14 @@ TUint64 CodecController::OutputAudioDsd(MsgAudioEncoded* aMsg, TUint aChannels,
 
 void CodecController::OutputMetaText(const Brx& aMetaText)
 {
+    FlushAudioBuf();
     MsgMetaText* text = iMsgFactory.CreateMsgMetaText(aMetaText);
     Queue(text);
 }
 
 void CodecController::OutputStreamInterrupted()
 {
+    FlushAudioBuf();
     MsgStreamInterrupted* interrupted = iMsgFactory.CreateMsgStreamInterrupted();
     Queue(interrupted);
 }
@@ -934,19 +1207,51 @@ void CodecController::GetAudioBuf(TByte*& aDest, TUint& aSamples)
         iAudioDecodedBytes = 0;
     }
     aDest = iAudioDecoded->PtrW() + iAudioDecodedBytes;
+    const auto samplesHeld = iAudioDecodedBytes / iBytesPerSample;
     const auto samplesMsg = (AudioData::kMaxBytes - iAudioDecodedBytes) / iBytesPerSample;
-    aSamples = std::min(iMaxOutputSamples, samplesMsg);
+    aSamples = std::min(iMaxOutputSamples - samplesHeld, samplesMsg);
+}
+
+AudioDataEndian CodecController::AudioBufEndian() const
+{
+    return iMsgFactory.DecodedAudioEndian();
 }
 
 void CodecController::OutputAudioBuf(TUint aSamples, TUint64& aTrackOffset)
 {
+    AppendAudioBuf(aSamples, aTrackOffset);
+    FlushAudioBuf();
+}
+
+void CodecController::AppendAudioBuf(TUint aSamples, TUint64& aTrackOffset)
+{
+    ASSERT(iAudioDecoded != nullptr);
+    if (aSamples == 0) {
+        return;
+    }
+    if (iAudioDecodedBytes == 0) {
+        iAudioDecodedTrackOffset = aTrackOffset;
+    }
     iAudioDecodedBytes += (aSamples * iBytesPerSample);
+    ASSERT(iAudioDecodedBytes <= AudioData::kMaxBytes);
+    aTrackOffset += static_cast<TUint64>(aSamples) * Jiffies::PerSample(iSampleRate);
+    if (iAudioDecodedBytes / iBytesPerSample >= iMaxOutputSamples ||
+        AudioData::kMaxBytes - iAudioDecodedBytes < iBytesPerSample) {
+        FlushAudioBuf();
+    }
+}
+
+void CodecController::FlushAudioBuf()
+{
+    if (iAudioDecodedBytes == 0) {
+        return;
+    }
     iAudioDecoded->SetBytes(iAudioDecodedBytes);
-    auto audioPcm = iMsgFactory.CreateMsgAudioPcm(iAudioDecoded, iChannels, iSampleRate, iBitDepth, aTrackOffset);
+    CacheAudio(Brn(iAudioDecoded->Ptr(0), iAudioDecodedBytes), iAudioDecoded->Endian(), iAudioDecodedTrackOffset);
+    auto audioPcm = iMsgFactory.CreateMsgAudioPcm(iAudioDecoded, iChannels, iSampleRate, iBitDepth, iAudioDecodedTrackOffset);
     iAudioDecoded = nullptr; // ownership of reference passed to audioPcm
     iAudioDecodedBytes = 0;
-    const TUint64 jiffies = DoOutputAudio(audioPcm);
-    aTrackOffset += jiffies;
+    (void)DoOutputAudio(audioPcm);
 }
 
 TUint CodecController::MaxBitDepth() const
@@ -1026,7 +1331,11 @@ Msg* CodecController::ProcessMsg(MsgEncodedStream* aMsg)
     iStreamStopped = false; // likewise, if iStreamStopped was set, this was for the previous stream
     iStreamLength = aMsg->TotalBytes();
     iSeekable = aMsg->Seekable();
+    iSeekPoints.SetStream(iTrackUri, (iSeekable? iStreamLength : 0));
     iLive = aMsg->Live();
+    if (iDecodedAudioCache != nullptr) {
+        iDecodedAudioCache->SetStream(iTrackId, iTrackUri, (iLive? 0 : iStreamLength));
+    }
     iStreamHandler.store(aMsg->StreamHandler());
     auto msg = iMsgFactory.CreateMsgEncodedStream(aMsg, this);
     iStreamFormat = aMsg->StreamFormat();
@@ -1078,6 +1387,9 @@ Msg* CodecController::ProcessMsg(MsgMetaText* aMsg)
 Msg* CodecController::ProcessMsg(MsgStreamInterrupted* aMsg)
 {
     iStreamEnded = true;
+    if (iDecodedAudioCache != nullptr) {
+        iDecodedAudioCache->Discard(); // don't treat what we have as the whole track
+    }
     Queue(aMsg);
     return nullptr;
 }
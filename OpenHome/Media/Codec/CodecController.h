@@ -6,7 +6,11 @@
 #include <OpenHome/Private/Standard.h>
 #include <OpenHome/Media/Pipeline/Msg.h>
 #include <OpenHome/Media/Pipeline/Rewinder.h>
+#include <OpenHome/Media/Codec/FormatSignature.h>
+#include <OpenHome/Media/Codec/SeekPointCache.h>
+#include <OpenHome/Media/Codec/DecodedAudioCache.h>
 
+#include <algorithm>
 #include <atomic>
 #include <vector>
 
@@ -102,6 +106,27 @@ public:
      * @return     Number of bytes the codec has consumed from the stream.
      */
     virtual TUint64 StreamPos() const = 0;
+    /**
+     * Record the byte offset of a sample in the current stream.
+     *
+     * Points are remembered across plays of the same track so that later seeks can use
+     * TryGetSeekPoint() rather than estimating or searching for an offset.  Only record
+     * exact positions, from which decoding can restart.  Ignored for streams of unknown length.
+     *
+     * @param[in] aSample        Sample number.
+     * @param[in] aBytePos       Byte offset (as used by StreamPos() and TrySeekTo()) that decoding of aSample starts from.
+     */
+    virtual void AddSeekPoint(TUint64 aSample, TUint64 aBytePos) = 0;
+    /**
+     * Find the last point recorded by AddSeekPoint() at or before a sample.
+     *
+     * @param[in]  aSample       Sample number being seeked to.
+     * @param[out] aSamplePoint  Sample number of the point found.  Decoding from here reaches aSample.
+     * @param[out] aBytePos      Byte offset of aSamplePoint.
+     *
+     * @return     true if a point was found; false otherwise.
+     */
+    virtual TBool TryGetSeekPoint(TUint64 aSample, TUint64& aSamplePoint, TUint64& aBytePos) = 0;
     /**
      * Notify the pipeline of a new stream or a discontinuity in the current stream.
      *
@@ -217,11 +242,116 @@ public:
      * This allows the pipeline to ramp audio down/up to avoid glitches caused by a stream discontinuity. A MsgDecodedStream must follow this.
      */
     virtual void OutputStreamInterrupted() = 0;
+    /**
+     * Retrieve space to write decoded audio to directly, avoiding the copy made by OutputAudioPcm().
+     *
+     * Audio must be written as packed, interleaved pcm, in the byte order returned by AudioBufEndian(),
+     * in the format given by the most recent call to OutputDecodedStream().  Any other Output function
+     * may invalidate aDest.
+     * See AudioBufWriter for helpers that convert common decoder output formats.
+     *
+     * @param[out] aDest         Location to write audio to.
+     * @param[out] aSamples      Maximum number of samples (each covering all channels) that can be written to aDest.
+     */
     virtual void GetAudioBuf(TByte*& aDest, TUint& aSamples) = 0;
+    /**
+     * Byte order that audio written to the location returned by GetAudioBuf() must use.
+     *
+     * Matches the pipeline's storage order so that no conversion is required downstream.
+     */
+    virtual AudioDataEndian AudioBufEndian() const = 0;
+    /**
+     * Add audio written to the location returned by GetAudioBuf() to the pipeline.
+     *
+     * Outputs immediately, along with any audio previously passed to AppendAudioBuf().
+     *
+     * @param[in]     aSamples      Number of samples written.  Must not exceed the value returned by GetAudioBuf().
+     * @param[in,out] aTrackOffset  Offset (in jiffies) into the stream of the first sample written.
+     *                              Advanced by the duration of aSamples.
+     */
     virtual void OutputAudioBuf(TUint aSamples, TUint64& aTrackOffset) = 0;
+    /**
+     * Add audio written to the location returned by GetAudioBuf() to the pipeline.
+     *
+     * Audio is held until its buffer is full, allowing codecs which decode small blocks to
+     * fill pipeline msgs without a private staging buffer.  Partially filled buffers are output
+     * by FlushAudioBuf(), before the output of any other Output function and when the codec
+     * exits Process() via an exception.
+     *
+     * @param[in]     aSamples      Number of samples written.  Must not exceed the value returned by GetAudioBuf().
+     * @param[in,out] aTrackOffset  Offset (in jiffies) into the stream of the first sample written.
+     *                              Advanced by the duration of aSamples.
+     */
+    virtual void AppendAudioBuf(TUint aSamples, TUint64& aTrackOffset) = 0;
+    /**
+     * Output any audio passed to AppendAudioBuf() that is still held.
+     */
+    virtual void FlushAudioBuf() = 0;
     virtual TUint MaxBitDepth() const = 0;
 };
 
+/**
+ * Helpers for codecs which write decoded audio directly into pipeline buffers.
+ *
+ * Audio is passed to the pipeline via ICodecController::AppendAudioBuf(), spread
+ * across as many buffers as are required.
+ */
+class AudioBufWriter
+{
+public:
+    /**
+     * Interleave audio from a decoder which outputs a separate array of samples per channel.
+     *
+     * @param[in]     aController   Codec controller.
+     * @param[in]     aChannels     aNumChannels arrays, each holding (at least) aNumSamples samples.
+     * @param[in]     aNumChannels  Number of channels.  Must match the current decoded stream.
+     * @param[in]     aBitDepth     Output bit depth.  Must match the current decoded stream.
+     * @param[in]     aNumSamples   Number of samples to write from each channel.
+     * @param[in,out] aTrackOffset  Offset (in jiffies) into the stream of the first sample.
+     *                              Advanced by the duration of aNumSamples.
+     * @param[in]     aConvert      Functor returning a subsample from an element of aChannels,
+     *                              right aligned to aBitDepth.
+     */
+    template <class T, class Convert>
+    static void WritePlanar(ICodecController& aController, const T* const* aChannels, TUint aNumChannels, TUint aBitDepth,
+                            TUint aNumSamples, TUint64& aTrackOffset, Convert aConvert);
+    /**
+     * Interleave 32-bit audio from a decoder which outputs a separate array of samples per channel.
+     *
+     * Uses vectorised packing so should be preferred over WritePlanar() for any decoder whose output
+     * is held in signed 32-bit integers.
+     *
+     * @param[in]     aController   Codec controller.
+     * @param[in]     aChannels     aNumChannels arrays, each holding (at least) aNumSamples samples.
+     * @param[in]     aNumChannels  Number of channels.  Must match the current decoded stream.
+     * @param[in]     aBitDepth     Output bit depth.  Must match the current decoded stream.
+     * @param[in]     aNumSamples   Number of samples to write from each channel.
+     * @param[in,out] aTrackOffset  Offset (in jiffies) into the stream of the first sample.
+     *                              Advanced by the duration of aNumSamples.
+     * @param[in]     aShift        Number of bits each value is (arithmetic) shifted right by before
+     *                              being clipped to aBitDepth.
+     */
+    static void WritePlanarInt32(ICodecController& aController, const TInt32* const* aChannels, TUint aNumChannels, TUint aBitDepth,
+                                 TUint aNumSamples, TUint64& aTrackOffset, TUint aShift = 0);
+    /**
+     * Copy packed, interleaved audio, converting to ICodecController::AudioBufEndian() if necessary.
+     *
+     * @param[in]     aController   Codec controller.
+     * @param[in]     aData         Audio.  Must contain a whole number of samples.
+     * @param[in]     aBitDepth     Bit depth.  Must match the current decoded stream.
+     * @param[in]     aNumChannels  Number of channels.  Must match the current decoded stream.
+     * @param[in]     aEndian       Endianness of aData.
+     * @param[in,out] aTrackOffset  Offset (in jiffies) into the stream of the start of aData.
+     *                              Advanced by the duration of aData.
+     */
+    static void WriteInterleaved(ICodecController& aController, const Brx& aData, TUint aBitDepth, TUint aNumChannels,
+                                 AudioDataEndian aEndian, TUint64& aTrackOffset);
+private:
+    template <TUint kBytes, TBool kBigEndian, class T, class Convert>
+    static TByte* Interleave(TByte* aDest, const T* const* aChannels, TUint aNumChannels,
+                             TUint aStart, TUint aEnd, Convert& aConvert);
+};
+
 class EncodedStreamInfo
 {
     friend class CodecController;
@@ -338,6 +468,13 @@ public:
      * @return     Codec identifier
      */
     const TChar* Id() const;
+    /**
+     * Cheap tests for the formats this codec handles.
+     *
+     * Codecs whose signature matches a stream are offered it before other codecs.
+     * Codecs should populate iSignature in their constructor.
+     */
+    const FormatSignature& Signature() const;
 protected:
     CodecBase(const TChar* aId, RecognitionComplexity aRecognitionCost=kCostMedium);
     static SpeakerProfile DeriveProfile(TUint aChannels);
@@ -345,6 +482,7 @@ private:
     void Construct(ICodecController& aController);
 protected:
     ICodecController* iController;
+    FormatSignature iSignature;
 private:
     const TChar* iId;
     RecognitionComplexity iRecognitionCost;
@@ -352,6 +490,8 @@ private:
 
 class CodecController : public ISeeker, private ICodecController, private IMsgProcessor, private IStreamHandler, private INonCopyable
 {
+    static const TUint kSeekPointCacheTracks = 16;
+    static const TUint kSeekPointCachePointsPerTrack = 512;
 private:
     class InitialSeekObserver : public ISeekObserver
     {
@@ -365,10 +505,19 @@ public:
     void AddCodec(CodecBase* aCodec);
     void Start();
     void SetAnimator(IPipelineAnimator& aAnimator);
+    /**
+     * Hold up to aMaxBytes of recently decoded pcm, allowing short seeks backwards and
+     * repeats of tracks held in full to be played without re-fetching or re-decoding.
+     * Seeks within a repeat played from the cache are also served from the cache.
+     * All aMaxBytes are allocated here, rather than as audio is decoded.
+     * Must be called before Start().
+     */
+    void EnableDecodedAudioCache(TUint aMaxBytes, IFlushIdProvider& aFlushIdProvider);
     void Flush(TUint aFlushId);
 private:
     void CodecThread();
     void Rewind();
+    TBool ProbeStream(TBool& aStreamEnded);
     Msg* PullMsg();
     void Queue(Msg* aMsg);
     TBool QueueTrackData() const;
@@ -377,6 +526,10 @@ private:
     TBool DoRead(Bwx& aBuf, TUint aBytes);
     void DoOutputDecodedStream(MsgDecodedStream* aMsg);
     TUint64 DoOutputAudio(MsgAudio* aAudioMsg);
+    void CacheAudio(const Brx& aData, AudioDataEndian aEndian, TUint64 aTrackOffset);
+    TBool TrySeekCached(TUint aSeekHandle);
+    void OutputCachedStream();
+    void OutputCachedAudio(TUint64 aSample);
 private: // ISeeker
     void StartSeek(TUint aStreamId, TUint aSecondsAbsolute, ISeekObserver& aObserver, TUint& aHandle) override;
 private: // ICodecController
@@ -387,6 +540,8 @@ private: // ICodecController
     TBool TrySeekTo(TUint aStreamId, TUint64 aBytePos) override;
     TUint64 StreamLength() const override;
     TUint64 StreamPos() const override;
+    void AddSeekPoint(TUint64 aSample, TUint64 aBytePos) override;
+    TBool TryGetSeekPoint(TUint64 aSample, TUint64& aSamplePoint, TUint64& aBytePos) override;
     void OutputDecodedStream(TUint aBitRate, TUint aBitDepth, TUint aSampleRate, TUint aNumChannels, const Brx& aCodecName, TUint64 aTrackLength, TUint64 aSampleStart, TBool aLossless, SpeakerProfile aProfile, TBool aAnalogBypass) override;
     void OutputDecodedStreamDsd(TUint aSampleRate, TUint aNumChannels, const Brx& aCodecName, TUint64 aLength, TUint64 aSampleStart, SpeakerProfile aProfile) override;
     TUint64 OutputAudioPcm(const Brx& aData, TUint aChannels, TUint aSampleRate, TUint aBitDepth, AudioDataEndian aEndian, TUint64 aTrackOffset) override;
@@ -396,7 +551,10 @@ private: // ICodecController
     void OutputMetaText(const Brx& aMetaText) override;
     void OutputStreamInterrupted() override;
     void GetAudioBuf(TByte*& aDest, TUint& aSamples) override;
+    AudioDataEndian AudioBufEndian() const override;
     void OutputAudioBuf(TUint aSamples, TUint64& aTrackOffset) override;
+    void AppendAudioBuf(TUint aSamples, TUint64& aTrackOffset) override;
+    void FlushAudioBuf() override;
     TUint MaxBitDepth() const override;
 private: // IMsgProcessor
     Msg* ProcessMsg(MsgMode* aMsg) override;
@@ -433,6 +591,12 @@ private:
     Mutex iLock;
     Semaphore iShutdownSem;
     std::vector<CodecBase*> iCodecs;
+    std::vector<CodecBase*> iRecognitionOrder;
+    Bws<FormatSignature::kMaxProbeBytes> iProbe;
+    TUint iProbeBytes;
+    SeekPointCache iSeekPoints;
+    DecodedAudioCache* iDecodedAudioCache;
+    IFlushIdProvider* iFlushIdProvider;
     ThreadFunctor* iDecoderThread;
     IPipelineAnimator* iAnimator;
     CodecBase* iActiveCodec;
@@ -457,6 +621,7 @@ private:
     MsgAudioEncoded* iAudioEncoded;
 
     TBool iSeekable;
+    TBool iPlayingCached;
     TBool iLive;
     MsgEncodedStream::Format iStreamFormat;
     Media::Multiroom iMultiroom;
@@ -477,6 +642,7 @@ private:
     const TUint iMaxOutputJiffies;
     DecodedAudio* iAudioDecoded;
     TUint iAudioDecodedBytes;
+    TUint64 iAudioDecodedTrackOffset;
     RampType iRamp;
     TUint iInitialSeekPos;
     InitialSeekObserver iInitialSeekObserver;
@@ -503,6 +669,67 @@ private:
     EState iState;
 };
 
+// AudioBufWriter
+
+template <class T, class Convert>
+void AudioBufWriter::WritePlanar(ICodecController& aController, const T* const* aChannels, TUint aNumChannels, TUint aBitDepth,
+                                 TUint aNumSamples, TUint64& aTrackOffset, Convert aConvert)
+{ // static
+    const TBool bigEndian = (aController.AudioBufEndian() == AudioDataEndian::Big);
+    TUint index = 0;
+    while (index < aNumSamples) {
+        TByte* dest;
+        TUint samples;
+        aController.GetAudioBuf(dest, samples);
+        samples = std::min(samples, aNumSamples - index);
+        const TUint end = index + samples;
+        switch (aBitDepth)
+        {
+        case 8:
+            (void)Interleave<1, true>(dest, aChannels, aNumChannels, index, end, aConvert);
+            break;
+        case 16:
+            (void)(bigEndian? Interleave<2, true>(dest, aChannels, aNumChannels, index, end, aConvert)
+                            : Interleave<2, false>(dest, aChannels, aNumChannels, index, end, aConvert));
+            break;
+        case 24:
+            (void)(bigEndian? Interleave<3, true>(dest, aChannels, aNumChannels, index, end, aConvert)
+                            : Interleave<3, false>(dest, aChannels, aNumChannels, index, end, aConvert));
+            break;
+        case 32:
+            (void)(bigEndian? Interleave<4, true>(dest, aChannels, aNumChannels, index, end, aConvert)
+                            : Interleave<4, false>(dest, aChannels, aNumChannels, index, end, aConvert));
+            break;
+        default:
+            ASSERTS();
+        }
+        aController.AppendAudioBuf(samples, aTrackOffset);
+        index = end;
+    }
+}
+
+template <TUint kBytes, TBool kBigEndian, class T, class Convert>
+inline TByte* AudioBufWriter::Interleave(TByte* aDest, const T* const* aChannels, TUint aNumChannels,
+                                         TUint aStart, TUint aEnd, Convert& aConvert)
+{ // static
+    for (TUint i=aStart; i<aEnd; i++) {
+        for (TUint j=0; j<aNumChannels; j++) {
+            const TUint32 subsample = static_cast<TUint32>(aConvert(aChannels[j][i]));
+            if (kBigEndian) {
+                for (TUint k=kBytes; k>0; k--) {
+                    *aDest++ = static_cast<TByte>(subsample >> (8 * (k-1)));
+                }
+            }
+            else {
+                for (TUint k=0; k<kBytes; k++) {
+                    *aDest++ = static_cast<TByte>(subsample >> (8 * k));
+                }
+            }
+        }
+    }
+    return aDest;
+}
+
 } // namespace Codec
 } // namespace Media
 } // namespace OpenHome
@@ -6,6 +6,8 @@
 #include <OpenHome/Media/Pipeline/Msg.h>
 #include <OpenHome/Media/Debug.h>
 
+#include <algorithm>
+
 using namespace OpenHome;
 using namespace OpenHome::Media;
 using namespace OpenHome::Media::Codec;
@@ -28,6 +30,11 @@ const Brx& ContainerBase::Id() const
     return iId;
 }
 
+const FormatSignature& ContainerBase::Signature() const
+{
+    return iSignature;
+}
+
 void ContainerBase::Construct(IMsgAudioEncodedCache& aCache, MsgFactory& aMsgFactory, IContainerSeekHandler& aSeekHandler, IContainerUrlBlockWriter& aUrlBlockWriter, IContainerStopper& aContainerStopper)
 {
     iCache = &aCache;
@@ -440,6 +447,7 @@ ContainerController::ContainerController(MsgFactory& aMsgFactory, IPipelineEleme
     , iUrlBlockWriter(aUrlBlockWriter)
     , iRewinder(iMsgFactory, aUpstreamElement)
     , iLoggerRewinder(nullptr)
+    , iProbeBytes(0)
     , iActiveContainer(nullptr)
     , iContainerNull(nullptr)
     , iContainerDiscard(nullptr)
@@ -483,6 +491,8 @@ void ContainerController::AddContainer(ContainerBase* aContainer)
      iContainers.pop_back();
      iContainers.push_back(aContainer);
      iContainers.push_back(containerNull);
+     iRecognitionOrder.reserve(iContainers.size());
+     iProbeBytes = std::max(iProbeBytes, aContainer->Signature().ProbeBytes());
 }
 
 ContainerController::~ContainerController()
@@ -511,11 +521,42 @@ Msg* ContainerController::RecogniseContainer()
         while (iState != eRecognitionComplete) {
             if (iState == eRecognitionStart) {
                 iRecogIdx = 0;
+                iProbe.SetBytes(0);
+                if (iProbeBytes > 0) {
+                    iStreamEnded = false;
+                    iRewinder.Rewind();
+                    iCache->Reset();
+                    iCache->Inspect(iProbe, iProbeBytes);
+                    iState = eRecognitionProbe;
+                }
+                else {
+                    FormatSignature::Order(iContainers, iProbe, iUrl, iRecognitionOrder);
+                    iState = eRecognitionSelectContainer;
+                }
+            }
+            else if (iState == eRecognitionProbe) {
+                // Read the start of the stream once so that containers whose signature matches are tried first.
+                // Short or unreadable streams are left to each container to reject in turn.
+                if (!iStreamEnded) {
+                    try {
+                        Msg* msg = iCache->Pull();
+                        if (msg != nullptr) {
+                            return msg;
+                        }
+                    }
+                    catch (CodecPulledNullMsg&) {
+                        iProbe.SetBytes(0);
+                    }
+                    catch (AudioCacheException&) {
+                        iProbe.SetBytes(0);
+                    }
+                }
+                FormatSignature::Order(iContainers, iProbe, iUrl, iRecognitionOrder);
                 iState = eRecognitionSelectContainer;
             }
             else if (iState == eRecognitionSelectContainer) {
-                ASSERT(iRecogIdx < iContainers.size()); // ContainerNull should always recognise.
-                auto& container = iContainers[iRecogIdx];
+                ASSERT(iRecogIdx < iRecognitionOrder.size()); // ContainerNull should always recognise.
+                auto& container = iRecognitionOrder[iRecogIdx];
                 iStreamEnded = false;
                 iRewinder.Rewind();
                 iCache->Reset();
@@ -524,7 +565,7 @@ Msg* ContainerController::RecogniseContainer()
             }
             else if (iState == eRecognitionContainer) {
                 if (!iStreamEnded) {
-                    auto& container = iContainers[iRecogIdx];
+                    auto& container = iRecognitionOrder[iRecogIdx];
                     try {
                         Msg* msg = container->Recognise();
                         if (msg != nullptr) {
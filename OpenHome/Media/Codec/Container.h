@@ -7,6 +7,7 @@
 #include <OpenHome/Media/Pipeline/Msg.h>
 #include <OpenHome/Media/Pipeline/Rewinder.h>
 #include <OpenHome/Media/Pipeline/Logger.h>
+#include <OpenHome/Media/Codec/FormatSignature.h>
 
 #include <atomic>
 #include <vector>
@@ -84,6 +85,7 @@ public:
     virtual void Init(TUint64 aStreamBytes) = 0;
     virtual TBool TrySeek(TUint aStreamId, TUint64 aOffset) = 0;
     const Brx& Id() const;
+    const FormatSignature& Signature() const; // containers whose signature matches a stream are tried first
 protected:
     virtual void Construct(IMsgAudioEncodedCache& aCache, MsgFactory& aMsgFactory, IContainerSeekHandler& aSeekHandler, IContainerUrlBlockWriter& aUrlBlockWriter, IContainerStopper& aContainerStopper);
 public: // from IPipelineElementUpstream
@@ -94,6 +96,7 @@ protected:
     IContainerSeekHandler* iSeekHandler;
     IContainerUrlBlockWriter* iUrlBlockWriter;
     IContainerStopper* iStopper;
+    FormatSignature iSignature;
 private:
     const Bws<kMaxNameBytes> iId;
 };
@@ -223,6 +226,7 @@ private:
     enum ERecognitionState
     {
         eRecognitionStart,
+        eRecognitionProbe,
         eRecognitionSelectContainer,
         eRecognitionContainer,
         eRecognitionComplete,
@@ -234,6 +238,9 @@ private:
     Logger* iLoggerRewinder;
     MsgAudioEncodedCache* iCache;
     std::vector<ContainerBase*> iContainers;
+    std::vector<ContainerBase*> iRecognitionOrder;
+    Bws<FormatSignature::kMaxProbeBytes> iProbe;
+    TUint iProbeBytes;
     ContainerBase* iActiveContainer;
     ContainerNull* iContainerNull;
     ContainerDiscard* iContainerDiscard;
@@ -0,0 +1,310 @@
+#include <OpenHome/Media/Codec/DecodedAudioCache.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Standard.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Media/Utils/PcmKernels.h>
+
+#include <algorithm>
+#include <deque>
+#include <list>
+#include <string.h>
+
+using namespace OpenHome;
+using namespace OpenHome::Media;
+using namespace OpenHome::Media::Codec;
+
+// DecodedAudioCache::Format
+
+DecodedAudioCache::Format::Format()
+    : iBitRate(0)
+    , iBitDepth(0)
+    , iSampleRate(0)
+    , iNumChannels(0)
+    , iTrackLength(0)
+    , iLossless(false)
+    , iAnalogBypass(false)
+{
+}
+
+const DecodedAudioCache::Format& DecodedAudioCache::Format::operator=(const Format& aOther)
+{
+    iBitRate = aOther.iBitRate;
+    iBitDepth = aOther.iBitDepth;
+    iSampleRate = aOther.iSampleRate;
+    iNumChannels = aOther.iNumChannels;
+    iCodecName.Replace(aOther.iCodecName);
+    iTrackLength = aOther.iTrackLength;
+    iLossless = aOther.iLossless;
+    iProfile = aOther.iProfile;
+    iAnalogBypass = aOther.iAnalogBypass;
+    return *this;
+}
+
+TBool DecodedAudioCache::Format::IsCompatible(const Format& aOther) const
+{
+    return iBitDepth == aOther.iBitDepth
+        && iSampleRate == aOther.iSampleRate
+        && iNumChannels == aOther.iNumChannels;
+}
+
+
+// DecodedAudioCache::Chunk
+
+DecodedAudioCache::Chunk::Chunk()
+    : iSample(0)
+    , iSamples(0)
+{
+}
+
+
+// DecodedAudioCache::Track
+
+DecodedAudioCache::Track::Track(TUint aTrackId, const Brx& aUri, TUint64 aStreamBytes)
+    : iTrackId(aTrackId)
+    , iUri(aUri)
+    , iStreamBytes(aStreamBytes)
+    , iComplete(false)
+{
+}
+
+TBool DecodedAudioCache::Track::Matches(TUint aTrackId, const Brx& aUri, TUint64 aStreamBytes) const
+{
+    return iTrackId == aTrackId && iStreamBytes == aStreamBytes && iUri == aUri;
+}
+
+TUint64 DecodedAudioCache::Track::EndSample() const
+{
+    if (iChunks.size() == 0) {
+        return 0;
+    }
+    const Chunk* last = iChunks.back();
+    return last->iSample + last->iSamples;
+}
+
+
+// DecodedAudioCache
+
+DecodedAudioCache::DecodedAudioCache(TUint aMaxBytes)
+    : iCurrent(nullptr)
+    , iContiguous(false)
+{
+    ASSERT(aMaxBytes > 0);
+    const TUint count = std::max(aMaxBytes / kChunkBytes, 1u);
+    iChunks.reserve(count);
+    iFree.reserve(count);
+    for (TUint i=0; i<count; i++) {
+        auto chunk = new Chunk();
+        iChunks.push_back(chunk);
+        iFree.push_back(chunk);
+    }
+}
+
+DecodedAudioCache::~DecodedAudioCache()
+{
+    for (auto track : iTracks) {
+        delete track;
+    }
+    for (auto chunk : iChunks) {
+        delete chunk;
+    }
+}
+
+void DecodedAudioCache::SetStream(TUint aTrackId, const Brx& aUri, TUint64 aStreamBytes)
+{
+    if (iCurrent != nullptr && iCurrent->iChunks.size() == 0) {
+        // nothing worth remembering for the previous track
+        ASSERT(iTracks.front() == iCurrent);
+        iTracks.pop_front();
+        delete iCurrent;
+    }
+    iCurrent = nullptr;
+    iContiguous = false; // audio held from a previous play doesn't follow on from anything the codec has output yet
+    if (aStreamBytes == 0 || aUri.Bytes() == 0) {
+        return;
+    }
+    for (auto it=iTracks.begin(); it!=iTracks.end(); ++it) {
+        if ((*it)->Matches(aTrackId, aUri, aStreamBytes)) {
+            iCurrent = *it;
+            iTracks.erase(it);
+            iTracks.push_front(iCurrent);
+            return;
+        }
+    }
+    iCurrent = new Track(aTrackId, aUri, aStreamBytes);
+    iTracks.push_front(iCurrent);
+}
+
+void DecodedAudioCache::SetFormat(const Format& aFormat)
+{
+    if (iCurrent == nullptr) {
+        return;
+    }
+    if (!iCurrent->iFormat.IsCompatible(aFormat)) {
+        Clear(*iCurrent);
+    }
+    iCurrent->iFormat = aFormat;
+}
+
+void DecodedAudioCache::Add(const Brx& aData, AudioDataEndian aEndian, TUint64 aSample)
+{
+    TByte* dest = Append(aData.Bytes(), aSample);
+    if (dest == nullptr) {
+        return;
+    }
+    const TUint subsampleBytes = iCurrent->iFormat.iBitDepth / 8;
+    if (aEndian == AudioDataEndian::Little && subsampleBytes > 1) {
+        PcmKernels::CopySwapped(aData.Ptr(), dest, aData.Bytes(), subsampleBytes);
+    }
+    else {
+        (void)memcpy(dest, aData.Ptr(), aData.Bytes());
+    }
+}
+
+void DecodedAudioCache::Add(MsgAudioEncoded& aMsg, TUint64 aSample)
+{
+    TByte* dest = Append(aMsg.Bytes(), aSample);
+    if (dest != nullptr) {
+        aMsg.CopyTo(dest);
+    }
+}
+
+void DecodedAudioCache::SetComplete()
+{
+    if (iCurrent != nullptr && iCurrent->iChunks.size() > 0) {
+        iCurrent->iComplete = true;
+    }
+}
+
+void DecodedAudioCache::MarkDiscontinuity()
+{
+    iContiguous = false;
+}
+
+void DecodedAudioCache::Discard()
+{
+    if (iCurrent != nullptr) {
+        Clear(*iCurrent);
+    }
+}
+
+const DecodedAudioCache::Format& DecodedAudioCache::CurrentFormat() const
+{
+    ASSERT(iCurrent != nullptr);
+    return iCurrent->iFormat;
+}
+
+TBool DecodedAudioCache::Contains(TUint64 aSample) const
+{
+    return iContiguous && Find(aSample) != nullptr;
+}
+
+TBool DecodedAudioCache::IsComplete() const
+{
+    if (iCurrent == nullptr || !iCurrent->iComplete) {
+        return false;
+    }
+    // oldest audio may have been discarded to make room for more recent tracks
+    return iCurrent->iChunks.front()->iSample == 0;
+}
+
+TBool DecodedAudioCache::TryRead(TUint64 aSample, Brn& aData) const
+{
+    const Chunk* chunk = Find(aSample);
+    if (chunk == nullptr) {
+        return false;
+    }
+    const TUint bytesPerSample = chunk->iData.Bytes() / chunk->iSamples;
+    const TUint offset = static_cast<TUint>(aSample - chunk->iSample) * bytesPerSample;
+    aData.Set(chunk->iData.Ptr() + offset, chunk->iData.Bytes() - offset);
+    return true;
+}
+
+TByte* DecodedAudioCache::Append(TUint aBytes, TUint64 aSample)
+{
+    if (iCurrent == nullptr || iCurrent->iFormat.iNumChannels == 0 || aBytes == 0) {
+        return nullptr;
+    }
+    const TUint bytesPerSample = (iCurrent->iFormat.iBitDepth / 8) * iCurrent->iFormat.iNumChannels;
+    ASSERT(aBytes % bytesPerSample == 0);
+    auto& chunks = iCurrent->iChunks;
+    if (chunks.size() > 0 && iCurrent->EndSample() != aSample) {
+        Clear(*iCurrent);
+    }
+    iCurrent->iComplete = false;
+    if (aBytes > kChunkBytes) {
+        Clear(*iCurrent);
+        return nullptr;
+    }
+
+    Chunk* chunk = (chunks.size() > 0? chunks.back() : nullptr);
+    if (chunk == nullptr || chunk->iData.Bytes() + aBytes > chunk->iData.MaxBytes()) {
+        chunk = AllocChunk();
+        chunk->iSample = aSample;
+        chunks.push_back(chunk);
+    }
+    TByte* dest = const_cast<TByte*>(chunk->iData.Ptr()) + chunk->iData.Bytes();
+    chunk->iData.SetBytes(chunk->iData.Bytes() + aBytes);
+    chunk->iSamples += aBytes / bytesPerSample;
+    iContiguous = true;
+    return dest;
+}
+
+void DecodedAudioCache::Clear(Track& aTrack)
+{
+    for (auto chunk : aTrack.iChunks) {
+        FreeChunk(chunk);
+    }
+    aTrack.iChunks.clear();
+    aTrack.iComplete = false;
+}
+
+DecodedAudioCache::Chunk* DecodedAudioCache::AllocChunk()
+{
+    while (iFree.size() == 0) {
+        Track* oldest = iTracks.back();
+        if (oldest != iCurrent) {
+            Clear(*oldest);
+            delete oldest;
+            iTracks.pop_back();
+        }
+        else {
+            // only the current track remains; forget its oldest audio
+            auto& chunks = iCurrent->iChunks;
+            ASSERT(chunks.size() > 0);
+            FreeChunk(chunks.front());
+            chunks.pop_front();
+        }
+    }
+    Chunk* chunk = iFree.back();
+    iFree.pop_back();
+    return chunk;
+}
+
+void DecodedAudioCache::FreeChunk(Chunk* aChunk)
+{
+    aChunk->iSamples = 0;
+    aChunk->iData.SetBytes(0);
+    iFree.push_back(aChunk);
+}
+
+const DecodedAudioCache::Chunk* DecodedAudioCache::Find(TUint64 aSample) const
+{
+    if (iCurrent == nullptr) {
+        return nullptr;
+    }
+    const auto& chunks = iCurrent->iChunks;
+    auto it = std::upper_bound(chunks.begin(), chunks.end(), aSample,
+                               [](TUint64 aSample, const Chunk* aChunk) {
+                                   return aSample < aChunk->iSample;
+                               });
+    if (it == chunks.begin()) {
+        return nullptr;
+    }
+    --it;
+    const Chunk* chunk = *it;
+    if (aSample >= chunk->iSample + chunk->iSamples) {
+        return nullptr;
+    }
+    return chunk;
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Standard.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+
+#include <deque>
+#include <list>
+#include <vector>
+
+namespace OpenHome {
+namespace Media {
+namespace Codec {
+
+/**
+ * Recently decoded pcm, held so that short seeks backwards and repeats of a track can
+ * be played without re-fetching or re-decoding the stream.
+ *
+ * Audio is held per track (identified by track id, uri and length in bytes) as a single
+ * contiguous run of chunks keyed by their starting sample.  Adding a chunk that doesn't
+ * follow on from the end of the run (e.g. because the codec has seeked) starts a new run.
+ * A run that starts at sample 0 and is marked complete holds the whole track.
+ *
+ * All memory is allocated up front as a pool of fixed size chunks.  Successive msgs are packed
+ * into a chunk until the next one doesn't fit.  When the pool is exhausted, audio for the least
+ * recently played tracks is discarded first, then the oldest audio for the current track.
+ * Not thread-safe; owned by CodecController and only used from its thread.
+ */
+class DecodedAudioCache : private INonCopyable
+{
+public:
+    class Format
+    {
+    public:
+        Format();
+        const Format& operator=(const Format& aOther);
+        TBool IsCompatible(const Format& aOther) const; // same layout of audio
+    public:
+        TUint iBitRate;
+        TUint iBitDepth;
+        TUint iSampleRate;
+        TUint iNumChannels;
+        BwsCodecName iCodecName;
+        TUint64 iTrackLength;
+        TBool iLossless;
+        SpeakerProfile iProfile;
+        TBool iAnalogBypass;
+    };
+public:
+    DecodedAudioCache(TUint aMaxBytes); // rounded down to a whole number of chunks (at least one)
+    ~DecodedAudioCache();
+    /**
+     * Select the track subsequent calls apply to.
+     *
+     * aStreamBytes of 0 (unknown length or live stream) disables the cache until the next call.
+     */
+    void SetStream(TUint aTrackId, const Brx& aUri, TUint64 aStreamBytes);
+    /**
+     * Set the format of audio for the current track.  Any audio held in an incompatible format is discarded.
+     */
+    void SetFormat(const Format& aFormat);
+    /**
+     * Add decoded audio starting at aSample.  aData must contain a whole number of samples.
+     */
+    void Add(const Brx& aData, AudioDataEndian aEndian, TUint64 aSample);
+    void Add(MsgAudioEncoded& aMsg, TUint64 aSample); // aMsg must contain big endian pcm
+    /**
+     * Note that the last audio added was the end of the track.
+     */
+    void SetComplete();
+    /**
+     * Note that the next audio added may not follow on from the held run (e.g. the codec
+     * is seeking).  Contains() returns false until more audio is added.
+     */
+    void MarkDiscontinuity();
+    /**
+     * Discard all audio held for the current track.
+     */
+    void Discard();
+    const Format& CurrentFormat() const;
+    /**
+     * @return     true if the current run holds aSample and ends with the last audio added.
+     *             Audio is then available from aSample to the end of the run.
+     */
+    TBool Contains(TUint64 aSample) const;
+    /**
+     * @return     true if the whole of the current track is held.
+     */
+    TBool IsComplete() const;
+    /**
+     * Retrieve big endian audio from aSample to the end of the chunk that holds it.
+     *
+     * @return     false if aSample is not held (e.g. it is the end of the run).
+     */
+    TBool TryRead(TUint64 aSample, Brn& aData) const;
+private:
+    static const TUint kChunkBytes = DecodedAudio::kMaxBytes; // any single msg fits in a chunk
+    class Chunk : private INonCopyable
+    {
+    public:
+        Chunk();
+    public:
+        TUint64 iSample;
+        TUint iSamples;
+        Bws<kChunkBytes> iData;
+    };
+    class Track : private INonCopyable
+    {
+    public:
+        Track(TUint aTrackId, const Brx& aUri, TUint64 aStreamBytes);
+        TBool Matches(TUint aTrackId, const Brx& aUri, TUint64 aStreamBytes) const;
+        TUint64 EndSample() const;
+    public:
+        TUint iTrackId;
+        Brh iUri;
+        TUint64 iStreamBytes;
+        Format iFormat;
+        TBool iComplete;
+        std::deque<Chunk*> iChunks; // contiguous, ordered by sample
+    };
+private:
+    TByte* Append(TUint aBytes, TUint64 aSample);
+    void Clear(Track& aTrack);
+    Chunk* AllocChunk();
+    void FreeChunk(Chunk* aChunk);
+    const Chunk* Find(TUint64 aSample) const;
+private:
+    std::vector<Chunk*> iChunks;    // all chunks, allocated on construction
+    std::vector<Chunk*> iFree;
+    std::list<Track*> iTracks;      // most recently used first
+    Track* iCurrent;
+    TBool iContiguous;              // iCurrent's run ends with the last audio added for this stream
+};
+
+} // namespace Codec
+} // namespace Media
+} // namespace OpenHome
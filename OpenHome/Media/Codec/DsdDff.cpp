@@ -1,6 +1,7 @@
 #include <OpenHome/Media/Codec/CodecController.h>
 #include <OpenHome/Media/Codec/CodecFactory.h>
 #include <OpenHome/Media/Codec/Container.h>
+#include <OpenHome/Media/Codec/DsdPacker.h>
 #include <OpenHome/Types.h>
 #include <OpenHome/Buffer.h>
 #include <OpenHome/Private/Converter.h>
@@ -44,7 +45,6 @@ private:
     TUint64 ReadChunkHeader();
     void ReadId(const Brx& aId);
     void SendMsgDecodedStream(TUint64 aStartSample);
-    inline void WriteBlock(TByte*& aDest, const TByte*& aPtr, TUint numWords);
     void TransferToOutputBuffer();
 
     static TUint64 BeUint64At(Brx& aBuf, TUint aOffset);
@@ -66,6 +66,7 @@ private:
     const TUint iSampleBlockWords;
     const TUint iPadBytesPerChunk;
     const TUint iTotalBytesPerChunk;
+    DsdPacker iPacker;
 };
 
 } // namespace Codec
@@ -88,10 +89,13 @@ CodecDsdDff::CodecDsdDff(IMimeTypeList& aMimeTypeList, TUint aSampleBlockWords,
     , iSampleBlockWords(aSampleBlockWords)
     , iPadBytesPerChunk(aPadBytesPerChunk)
     , iTotalBytesPerChunk(kPlayableBytesPerChunk + aPadBytesPerChunk)
+    , iPacker(aPadBytesPerChunk)
 {
     ASSERT((iSampleBlockWords * 4) % iTotalBytesPerChunk == 0);
     aMimeTypeList.Add("audio/dff");
     aMimeTypeList.Add("audio/x-dff");
+    iSignature.AddMagic(0, Brn("FRM8"));
+    iSignature.AddExtension("dff");
 }
 
 
@@ -302,47 +306,19 @@ void CodecDsdDff::Process()
 
 }
 
-inline void CodecDsdDff::WriteBlock(TByte*& aDest, const TByte*& aPtr, TUint aNumChunks)
-{
-    // padding is MSB and PCM silence in case stream is passed to an Exakt device that tries to play it as PCM
-    
-    for (TUint i = 0; i < aNumChunks; i++)
-    {
-        TUint paddingByte = iPadBytesPerChunk / 2;
-
-        for (TUint j = 0; j < paddingByte; j++) {
-            *aDest++ = 0x00; // padding
-        }
-        *aDest++ = aPtr[0];
-        *aDest++ = aPtr[2];
-
-        for (TUint j = 0; j < paddingByte; j++) {
-            *aDest++ = 0x00; // padding
-        }
-        *aDest++ = aPtr[1];
-        *aDest++ = aPtr[3];
-
-        aPtr +=4;
-    }
-}
-
 void CodecDsdDff::TransferToOutputBuffer()
 {
+    // padding is MSB and PCM silence in case stream is passed to an Exakt device that tries to play it as PCM
     const TByte* inPtr = iInputBuffer.Ptr();
-    TByte* dest = const_cast<TByte*>(iOutputBuffer.Ptr() + iOutputBuffer.Bytes());
-    // numChunks represents how many stereo pairs of samples make up a sampleBlock (how many groups of 16xL, 16xR)
-    const TUint numChunks = iSampleBlockWords - iPadBytesPerChunk;
     TUint inputChunks = iInputBuffer.Bytes() / kPlayableBytesPerChunk;
 
     do {
         TUint outputChunks = iOutputBuffer.BytesRemaining() / iTotalBytesPerChunk;
-        TUint remainingChunks = std::min(inputChunks, outputChunks);
-        TUint numBlocks = remainingChunks / numChunks;
+        const TUint remainingChunks = std::min(inputChunks, outputChunks);
+        TByte* dest = const_cast<TByte*>(iOutputBuffer.Ptr() + iOutputBuffer.Bytes());
 
-        for (TUint i = 0; i < numBlocks; i++)
-        {
-            WriteBlock(dest, inPtr, numChunks);
-        }
+        iPacker.PackInterleavedBytes(inPtr, dest, remainingChunks);
+        inPtr += remainingChunks * kPlayableBytesPerChunk;
         iOutputBuffer.SetBytes(iOutputBuffer.Bytes() + (remainingChunks * iTotalBytesPerChunk));
         outputChunks -= remainingChunks;
         inputChunks -= remainingChunks;
@@ -350,21 +326,16 @@ void CodecDsdDff::TransferToOutputBuffer()
         if (iAudioBytesRemaining == 0 && inputChunks == 0) // All audio has been transferred to output buffer.
         {
             TUint sampleBlockBytes = iSampleBlockWords * 4;
-            TUint outputBufferBytes = iOutputBuffer.Bytes();
             TUint remainingBytes = iOutputBuffer.Bytes() % sampleBlockBytes;
 
             if (remainingBytes != 0)
             {
                 // Pad partial end block with DSD silence to make a full block
-                const TByte kDsdSilence = 0x69;
-                TUint paddingBytes = sampleBlockBytes - remainingBytes;
-                iOutputBuffer.SetBytes(outputBufferBytes + paddingBytes);
-                for (TUint i = 0; i < paddingBytes; i++)
-                {
-                    iOutputBuffer[outputBufferBytes++] = kDsdSilence;
-                }
+                const TUint paddingChunks = (sampleBlockBytes - remainingBytes) / iTotalBytesPerChunk;
+                dest = const_cast<TByte*>(iOutputBuffer.Ptr() + iOutputBuffer.Bytes());
+                iPacker.PackSilence(dest, paddingChunks);
+                iOutputBuffer.SetBytes(iOutputBuffer.Bytes() + (paddingChunks * iTotalBytesPerChunk));
             }
-            iOutputBuffer.SetBytes(outputBufferBytes);
             outputChunks = 0;
         }
 
@@ -372,7 +343,6 @@ void CodecDsdDff::TransferToOutputBuffer()
         {
             iTrackOffsetJiffies += iController->OutputAudioDsd(iOutputBuffer, iChannelCount, iSampleRate, iSampleBlockWords, iTrackOffsetJiffies, iPadBytesPerChunk);
             iOutputBuffer.SetBytes(0);
-            dest = const_cast<TByte*>(iOutputBuffer.Ptr());
         }
 
     } while (inputChunks > 0);
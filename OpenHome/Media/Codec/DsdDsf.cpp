@@ -1,6 +1,7 @@
 #include <OpenHome/Media/Codec/CodecController.h>
 #include <OpenHome/Media/Codec/CodecFactory.h>
 #include <OpenHome/Media/Codec/Container.h>
+#include <OpenHome/Media/Codec/DsdPacker.h>
 #include <OpenHome/Types.h>
 #include <OpenHome/Buffer.h>
 #include <OpenHome/Private/Converter.h>
@@ -49,13 +50,11 @@ private:
     TBool ReadChunkId(const OpenHome::Brx& aBuf);
     void SendMsgDecodedStream(TUint64 aStartSample);
     TBool StreamIsValid() const;
-    inline void WriteBlock(TByte*& aDest, const TByte*& aLeftPtr, const TByte*& aRightPtr, TUint aNumChunks);
     void TransferToOutputBuffer();
     void CheckReinterleave();
     void ShowBufLeader() const;
 
     static TUint64 LeUint64At(Brx& aBuf, TUint aOffset);
-    static TUint8 ReverseBits8(TUint8 aData);
     static void LogBuf(const Brx& aBuf);
 
 
@@ -83,6 +82,7 @@ private:
     const TUint iSampleBlockWords;
     const TUint iPadBytesPerChunk;
     const TUint iTotalBytesPerChunk;
+    DsdPacker iPacker;
 };
 
 } // namespace Codec
@@ -104,10 +104,13 @@ CodecDsdDsf::CodecDsdDsf(IMimeTypeList& aMimeTypeList, TUint aSampleBlockWords,
     , iSampleBlockWords(aSampleBlockWords)
     , iPadBytesPerChunk(aPadBytesPerChunk)
     , iTotalBytesPerChunk(kPlayableBytesPerChunk + aPadBytesPerChunk)
+    , iPacker(aPadBytesPerChunk)
 {
     ASSERT((iSampleBlockWords * 4) % iTotalBytesPerChunk == 0);
     aMimeTypeList.Add("audio/dsf");
     aMimeTypeList.Add("audio/x-dsf");
+    iSignature.AddMagic(0, Brn("DSD "));
+    iSignature.AddExtension("dsf");
 }
 
 
@@ -166,34 +169,11 @@ void CodecDsdDsf::StreamInitialise()
     iInitialAudio = true;
 }
 
-inline void CodecDsdDsf::WriteBlock(TByte*& aDest, const TByte*& aLeftPtr, const TByte*& aRightPtr, TUint aNumChunks)
-{
-    // padding is MSB and PCM silence in case stream is passed to an Exakt device that tries to play it as PCM
-
-    TUint paddingByte = iPadBytesPerChunk / 2;
-    for (TUint i = 0; i < aNumChunks; i++)
-    {
-        for (TUint j = 0; j < paddingByte; j++) {
-            *aDest++ = 0x00; // padding
-        }
-        *aDest++ = ReverseBits8(*aLeftPtr++);
-        *aDest++ = ReverseBits8(*aLeftPtr++);
-
-        for (TUint j = 0; j < paddingByte; j++) {
-            *aDest++ = 0x00; // padding
-        }
-        *aDest++ = ReverseBits8(*aRightPtr++);
-        *aDest++ = ReverseBits8(*aRightPtr++);
-    }
-}
-
 void CodecDsdDsf::TransferToOutputBuffer()
 {
+    // padding is MSB and PCM silence in case stream is passed to an Exakt device that tries to play it as PCM
     const TByte* lPtr = iInputBuffer.Ptr();
     const TByte* rPtr = lPtr + kDataBlockBytes;
-    TByte* dest = const_cast<TByte*>(iOutputBuffer.Ptr() + iOutputBuffer.Bytes());
-    // numChunks represents how many stereo pairs of samples make up a sampleBlock (how many groups of 16xL, 16xR)
-    const TUint numChunks = iSampleBlockWords - iPadBytesPerChunk;
     TUint inputChunks = iInputBuffer.Bytes();
     if (iAudioBytesRemaining == 0) {
         const TUint audioBytesPadding = (TUint)(iAudioBytesTotal - iAudioBytesTotalPlayable);
@@ -204,13 +184,12 @@ void CodecDsdDsf::TransferToOutputBuffer()
 
     do {
         TUint outputChunks = iOutputBuffer.BytesRemaining() / iTotalBytesPerChunk;
-        TUint remainingChunks = std::min(inputChunks, outputChunks);
-        TUint numBlocks = remainingChunks / numChunks;
+        const TUint remainingChunks = std::min(inputChunks, outputChunks);
+        TByte* dest = const_cast<TByte*>(iOutputBuffer.Ptr() + iOutputBuffer.Bytes());
 
-        for (TUint i = 0; i < numBlocks; i++)
-        {
-            WriteBlock(dest, lPtr, rPtr, numChunks);
-        }
+        iPacker.PackPlanarLsbFirst(lPtr, rPtr, dest, remainingChunks);
+        lPtr += remainingChunks * 2;
+        rPtr += remainingChunks * 2;
         iOutputBuffer.SetBytes(iOutputBuffer.Bytes() + (remainingChunks * iTotalBytesPerChunk));
         outputChunks -= remainingChunks;
         inputChunks -= remainingChunks;
@@ -218,21 +197,16 @@ void CodecDsdDsf::TransferToOutputBuffer()
         if (iAudioBytesRemaining == 0 && inputChunks == 0) // All audio has been transferred to output buffer.
         {
             TUint sampleBlockBytes = iSampleBlockWords * 4;
-            TUint outputBufferBytes = iOutputBuffer.Bytes();
-            TUint remainingBytes = outputBufferBytes % sampleBlockBytes;
+            TUint remainingBytes = iOutputBuffer.Bytes() % sampleBlockBytes;
 
             if (remainingBytes != 0)
             {
                 // Pad partial end block with DSD silence to make a full block
-                const TByte kDsdSilence = 0x69;
-                TUint paddingBytes = sampleBlockBytes - remainingBytes;
-                iOutputBuffer.SetBytes(outputBufferBytes + paddingBytes);
-                for (TUint i = 0; i < paddingBytes; i++)
-                {
-                    iOutputBuffer[outputBufferBytes++] = kDsdSilence;
-                }
+                const TUint paddingChunks = (sampleBlockBytes - remainingBytes) / iTotalBytesPerChunk;
+                dest = const_cast<TByte*>(iOutputBuffer.Ptr() + iOutputBuffer.Bytes());
+                iPacker.PackSilence(dest, paddingChunks);
+                iOutputBuffer.SetBytes(iOutputBuffer.Bytes() + (paddingChunks * iTotalBytesPerChunk));
             }
-            iOutputBuffer.SetBytes(outputBufferBytes);
             outputChunks = 0;
         }
 
@@ -240,7 +214,6 @@ void CodecDsdDsf::TransferToOutputBuffer()
         {
             iTrackOffsetJiffies += iController->OutputAudioDsd(iOutputBuffer, iChannelCount, iSampleRate, iSampleBlockWords, iTrackOffsetJiffies, iPadBytesPerChunk);
             iOutputBuffer.SetBytes(0);
-            dest = const_cast<TByte*>(iOutputBuffer.Ptr());
         }
 
     } while (inputChunks > 0);
@@ -457,14 +430,6 @@ TUint64 CodecDsdDsf::LeUint64At(Brx& aBuf, TUint aOffset)
 }
 
 
-TUint8 CodecDsdDsf::ReverseBits8(TUint8 aData)
-{
-    aData = (((aData & 0xaa) >> 1) | ((aData & 0x55) << 1));
-    aData = (((aData & 0xcc) >> 2) | ((aData & 0x33) << 2));
-    return((aData >> 4) | (aData << 4));
-}
-
-
 TBool CodecDsdDsf::ReadChunkId(const Brx& aId)
 {
     iInputBuffer.SetBytes(0);
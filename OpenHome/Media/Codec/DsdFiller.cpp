@@ -70,6 +70,13 @@ void DsdFiller::Reset()
     iPending.SetBytes(0);
 }
 
+void DsdFiller::WriteChunksDsd(const TByte*& aSrc, TByte*& aDest, TUint aChunks)
+{
+    for (TUint i = 0; i < aChunks; i++) {
+        WriteChunkDsd(aSrc, aDest);
+    }
+}
+
 void DsdFiller::WriteBlocks(const Brx& aData)
 {
     ASSERT(aData.Bytes() % iBlockBytesInput == 0); // Expect whole sample blocks at this point
@@ -83,11 +90,7 @@ void DsdFiller::WriteBlocks(const Brx& aData)
         const TUint blocks = std::min(inputBlocks, outputBlocks);
         const TUint bytes = blocks * iBlockBytesOutput;
 
-        for (TUint i = 0; i < blocks; i++) {
-            for (TUint j = 0; j < iChunksPerBlock; j++) {
-                WriteChunkDsd(src, dest);
-            }
-        }
+        WriteChunksDsd(src, dest, blocks * iChunksPerBlock);
         iOutputBuffer.SetBytes(iOutputBuffer.Bytes() + bytes);
         inputBlocks -= blocks;
         outputBlocks -= blocks;
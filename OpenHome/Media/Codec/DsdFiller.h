@@ -23,6 +23,10 @@ namespace Media {
  * Operations on the data are deferred to the implementor via WriteChunkDsd(), where clients
  * can define the specific operation to be done. (See CodecDsdRaw for an example of this - 
  * data is padded and passed without interleaving)
+ *
+ * WriteChunksDsd() is called with every whole chunk that fits in the output buffer.  Its default
+ * implementation calls WriteChunkDsd() once per chunk; override it to convert a run of chunks
+ * in one pass (e.g. using DsdPacker).
  */
 
 class DsdFiller
@@ -40,6 +44,7 @@ protected:
     void Reset();
 protected:
     virtual void WriteChunkDsd(const TByte*& aSrc, TByte*& aDest) = 0;
+    virtual void WriteChunksDsd(const TByte*& aSrc, TByte*& aDest, TUint aChunks);
     virtual void OutputDsd(const Brx& aData) = 0;
 private:
     void WriteBlocks(const Brx& aData);
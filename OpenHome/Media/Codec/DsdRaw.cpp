@@ -2,6 +2,7 @@
 #include <OpenHome/Media/Codec/CodecFactory.h>
 #include <OpenHome/Media/Codec/Container.h>
 #include <OpenHome/Media/Codec/DsdFiller.h>
+#include <OpenHome/Media/Codec/DsdPacker.h>
 #include <OpenHome/Types.h>
 #include <OpenHome/Buffer.h>
 #include <OpenHome/Private/Printer.h>
@@ -27,10 +28,12 @@ private: // from CodecBase
     TBool TrySeek(TUint aStreamId, TUint64 aSample) override;
 private: // from DsdFiller
     void WriteChunkDsd(const TByte*& aSrc, TByte*& aDest) override;
+    void WriteChunksDsd(const TByte*& aSrc, TByte*& aDest, TUint aChunks) override;
     void OutputDsd(const Brx& aData) override;
 private:
     const TUint iSampleBlockWords;
     const TUint iPaddingBytes;
+    DsdPacker iPacker;
 
     Bws<kInputBufferSizeMax> iInputBuffer;
 
@@ -63,6 +66,7 @@ CodecDsdRaw::CodecDsdRaw(TUint aSampleBlockWords, TUint aPaddingBytes)
         (aSampleBlockWords * 4))                        // BlockBytesOutput
     , iSampleBlockWords(aSampleBlockWords)
     , iPaddingBytes(aPaddingBytes)
+    , iPacker(aPaddingBytes)
 {
 }
 
@@ -117,20 +121,16 @@ TBool CodecDsdRaw::TrySeek(TUint /*aStreamId*/, TUint64 /*aSample*/)
 }
 
 void CodecDsdRaw::WriteChunkDsd(const TByte*& aSrc, TByte*& aDest)
+{
+    WriteChunksDsd(aSrc, aDest, 1);
+}
+
+void CodecDsdRaw::WriteChunksDsd(const TByte*& aSrc, TByte*& aDest, TUint aChunks)
 {
     // CodecDsdRaw only pads and passes the data
-    const TUint padding = iPaddingBytes / 2;
-    for (TUint i = 0; i < padding; i++) {
-        *aDest++ = 0x00;
-    }
-    *aDest++ = aSrc[0];
-    *aDest++ = aSrc[1];
-    for (TUint i = 0; i < padding; i++) {
-        *aDest++ = 0x00;
-    }
-    *aDest++ = aSrc[2];
-    *aDest++ = aSrc[3];
-    aSrc += 4;
+    iPacker.PackChunks(aSrc, aDest, aChunks);
+    aSrc += aChunks * DsdPacker::kPlayableBytesPerChunk;
+    aDest += aChunks * iPacker.BytesPerChunk();
 }
 
 void CodecDsdRaw::OutputDsd(const Brx& aData)
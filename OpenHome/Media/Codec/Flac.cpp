@@ -46,7 +46,9 @@ public:
     void CallbackError(const FLAC__StreamDecoder* aDecoder,
                        FLAC__StreamDecoderErrorStatus aStatus);
 private:
-    TByte iBuf[DecodedAudio::kMaxBytes];
+    static const TUint kSeekPointIntervalSecs = 1;
+    static const TUint kSeekPointMaxDecodeSecs = 10; // max audio to decode then discard when seeking via a cached seek point
+private:
     FLAC__StreamDecoder* iDecoder;
     Brn iName;
     TUint64 iSampleStart;
@@ -58,6 +60,8 @@ private:
     TBool iStreamMsgDue;
     TBool iOgg;
     TUint iStreamId;
+    TUint64 iSkipToSample;
+    TUint64 iNextSeekPoint;
 };
 
 } // namespace Codec
@@ -143,6 +147,9 @@ CodecFlac::CodecFlac(IMimeTypeList& aMimeTypeList)
     // By default, only the STREAMINFO metadata block is returned, but let's just explicitly tell the decoder that's all we want.
     ASSERT(FLAC__stream_decoder_set_metadata_respond(iDecoder, FLAC__METADATA_TYPE_STREAMINFO));
     aMimeTypeList.Add("audio/x-flac");
+    iSignature.AddMagic(0, Brn("fLaC"));
+    iSignature.AddMagic(0, Brn("OggS"), 37, Brn("fLaC")); // native FLAC mapping into an Ogg page
+    iSignature.AddExtension("flac");
 }
 
 CodecFlac::~CodecFlac()
@@ -184,6 +191,8 @@ void CodecFlac::StreamInitialise()
     iNumChannels = 0;
     iBitDepth = 0;
     iTrackLengthJiffies = 0;
+    iSkipToSample = 0;
+    iNextSeekPoint = 0;
 
     FLAC__StreamDecoderState state;
     state = FLAC__stream_decoder_get_state(iDecoder);
@@ -275,6 +284,28 @@ TBool CodecFlac::TrySeek(TUint aStreamId, TUint64 aSample)
 {
     iStreamId = aStreamId;
     iSampleStart = aSample;
+    iSkipToSample = 0;
+    iNextSeekPoint = 0;
+
+    /* Without a SEEKTABLE, libFLAC bisects the stream to find aSample, each step costing a
+       seek (typically a new http request).  If we recorded the position of a nearby frame
+       while decoding this track earlier, seek straight there instead and have CallbackWrite
+       discard audio preceding aSample. */
+    TUint64 pointSample = 0;
+    TUint64 pointBytes = 0;
+    if (!iOgg && iSampleRate > 0
+        && iController->TryGetSeekPoint(aSample, pointSample, pointBytes)
+        && aSample - pointSample <= static_cast<TUint64>(kSeekPointMaxDecodeSecs) * iSampleRate) {
+        if (!iController->TrySeekTo(aStreamId, pointBytes)) {
+            return false;
+        }
+        (void)FLAC__stream_decoder_flush(iDecoder);
+        iSkipToSample = aSample;
+        iTrackOffset = iSampleStart * Jiffies::PerSample(iSampleRate);
+        iStreamMsgDue = true;
+        return true;
+    }
+
     FLAC__bool ret = FLAC__stream_decoder_seek_absolute(iDecoder, aSample);
     if (ret == 0) {
         // Seeking failed.
@@ -351,7 +382,7 @@ FLAC__StreamDecoderWriteStatus CodecFlac::CallbackWrite(const FLAC__StreamDecode
                                                         const TInt32* const aBuffer[])
 {
     const TUint channels = aFrame->header.channels;
-    TUint samplesToWrite = aFrame->header.blocksize;
+    const TUint samplesToWrite = aFrame->header.blocksize;
     const TUint bitDepth = aFrame->header.bits_per_sample;
     const TUint sampleRate = aFrame->header.sample_rate;
     if (iSampleRate != sampleRate || iNumChannels != channels || iBitDepth != bitDepth) {
@@ -370,43 +401,40 @@ FLAC__StreamDecoderWriteStatus CodecFlac::CallbackWrite(const FLAC__StreamDecode
         iStreamMsgDue = false;
     }
     
-    const TUint bytesPerSample = (bitDepth/8) * channels;
-    const TUint maxSamples = sizeof(iBuf) / bytesPerSample;
-    TUint startI=0, endI;
-    while (samplesToWrite > 0) {
-        const TUint samples = (samplesToWrite > maxSamples? maxSamples : samplesToWrite);
-        TByte* p = iBuf;
-        endI = startI + samples;
-        for (TUint i=startI; i<endI; i++) {
-            for (TUint j=0; j<channels; j++) {
-                TUint subsample = aBuffer[j][i];
-                // pipeline audio data is big endian so we might as well convert to that here
-                switch (bitDepth)
-                {
-                case 8:
-                    *p++ = (TByte)subsample;
-                    break;
-                case 16:
-                    *p++ = (TByte)(subsample >> 8);
-                    *p++ = (TByte)subsample;
-                    break;
-                case 24:
-                    *p++ = (TByte)(subsample >> 16);
-                    *p++ = (TByte)(subsample >> 8);
-                    *p++ = (TByte)subsample;
-                    break;
-                default:
-                    Log::Print("Unsupported bit depth in CodecFlac::CallbackWrite - %u\n", bitDepth);
-                    THROW(CodecStreamFeatureUnsupported);
-                }
-            }
+    if (bitDepth != 8 && bitDepth != 16 && bitDepth != 24) {
+        Log::Print("Unsupported bit depth in CodecFlac::CallbackWrite - %u\n", bitDepth);
+        THROW(CodecStreamFeatureUnsupported);
+    }
+    TUint skip = 0;
+    if (aFrame->header.number_type == FLAC__FRAME_NUMBER_TYPE_SAMPLE_NUMBER) {
+        const TUint64 frameStart = aFrame->header.number.sample_number;
+        const TUint64 frameEnd = frameStart + samplesToWrite;
+        if (iSkipToSample > frameStart) {
+            skip = static_cast<TUint>(std::min(iSkipToSample, frameEnd) - frameStart);
+        }
+        if (iSkipToSample <= frameEnd) {
+            iSkipToSample = 0;
+        }
+
+        // The stream is now positioned at the start of the next frame.  Remember this for later seeks.
+        TUint64 decodePos = 0;
+        if (!iOgg && frameEnd >= iNextSeekPoint
+            && FLAC__stream_decoder_get_decode_position(iDecoder, &decodePos)) {
+            iController->AddSeekPoint(frameEnd, decodePos);
+            iNextSeekPoint = frameEnd + static_cast<TUint64>(kSeekPointIntervalSecs) * sampleRate;
+        }
+    }
+
+    // interleave straight into pipeline audio buffers
+    if (skip == 0) {
+        AudioBufWriter::WritePlanarInt32(*iController, aBuffer, channels, bitDepth, samplesToWrite, iTrackOffset);
+    }
+    else if (skip < samplesToWrite) {
+        const TInt32* buffer[FLAC__MAX_CHANNELS];
+        for (TUint i=0; i<channels; i++) {
+            buffer[i] = aBuffer[i] + skip;
         }
-        const TUint bytes = samples * bytesPerSample;
-        Brn encodedAudio(iBuf, bytes);
-        iTrackOffset += iController->OutputAudioPcm(encodedAudio, channels, sampleRate,
-                                                    bitDepth, AudioDataEndian::Big, iTrackOffset);
-        samplesToWrite -= samples;
-        startI = endI;
+        AudioBufWriter::WritePlanarInt32(*iController, buffer, channels, bitDepth, samplesToWrite - skip, iTrackOffset);
     }
 
     return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
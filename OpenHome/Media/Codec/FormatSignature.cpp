@@ -0,0 +1,138 @@
+#include <OpenHome/Media/Codec/FormatSignature.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Ascii.h>
+#include <OpenHome/Private/Standard.h>
+
+#include <algorithm>
+#include <vector>
+
+using namespace OpenHome;
+using namespace OpenHome::Media;
+using namespace OpenHome::Media::Codec;
+
+// FormatSignature
+
+FormatSignature::FormatSignature()
+    : iProbeBytes(0)
+{
+}
+
+void FormatSignature::AddMagic(TUint aOffset, const Brx& aPattern)
+{
+    Bws<kMaxProbeBytes> mask;
+    for (TUint i=0; i<aPattern.Bytes() && i<mask.MaxBytes(); i++) {
+        mask.Append((TByte)0xff);
+    }
+    AddMagic(aOffset, aPattern, mask);
+}
+
+void FormatSignature::AddMagic(TUint aOffset, const Brx& aPattern, const Brx& aMask)
+{
+    ASSERT(aPattern.Bytes() > 0);
+    ASSERT(aOffset + aPattern.Bytes() <= kMaxProbeBytes);
+    ASSERT(aMask.Bytes() == aPattern.Bytes());
+    Magic magic;
+    magic.iOffset = aOffset;
+    magic.iPattern.Replace(aPattern);
+    magic.iMask.Replace(aMask);
+    iMagic.push_back(magic);
+    iProbeBytes = std::max(iProbeBytes, aOffset + aPattern.Bytes());
+}
+
+void FormatSignature::AddMagic(TUint aOffset1, const Brx& aPattern1, TUint aOffset2, const Brx& aPattern2)
+{
+    ASSERT(aOffset1 + aPattern1.Bytes() <= aOffset2);
+    ASSERT(aOffset2 + aPattern2.Bytes() <= kMaxProbeBytes);
+    Bws<kMaxProbeBytes> pattern(aPattern1);
+    Bws<kMaxProbeBytes> mask;
+    for (TUint i=0; i<aPattern1.Bytes(); i++) {
+        mask.Append((TByte)0xff);
+    }
+    while (pattern.Bytes() < aOffset2 - aOffset1) {
+        pattern.Append((TByte)0);
+        mask.Append((TByte)0);
+    }
+    pattern.Append(aPattern2);
+    for (TUint i=0; i<aPattern2.Bytes(); i++) {
+        mask.Append((TByte)0xff);
+    }
+    AddMagic(aOffset1, pattern, mask);
+}
+
+void FormatSignature::AddExtension(const TChar* aExtension)
+{
+    iExtensions.push_back(Brn(aExtension));
+}
+
+TBool FormatSignature::MatchesData(const Brx& aProbe) const
+{
+    for (auto& magic : iMagic) {
+        const TUint bytes = magic.iPattern.Bytes();
+        if (magic.iOffset + bytes > aProbe.Bytes()) {
+            continue;
+        }
+        TBool matched = true;
+        for (TUint i=0; i<bytes && matched; i++) {
+            const TByte mask = magic.iMask[i];
+            matched = ((magic.iPattern[i] & mask) == (aProbe[magic.iOffset + i] & mask));
+        }
+        if (matched) {
+            return true;
+        }
+    }
+    return false;
+}
+
+TBool FormatSignature::MatchesUri(const Brx& aUri) const
+{
+    return MatchesExtension(UriExtension(aUri));
+}
+
+TUint FormatSignature::ProbeBytes() const
+{
+    return iProbeBytes;
+}
+
+TUint FormatSignature::Rank(const Brx& aProbe, const Brx& aUriExtension) const
+{
+    if (MatchesData(aProbe)) {
+        return 0;
+    }
+    if (MatchesExtension(aUriExtension)) {
+        return 1;
+    }
+    return 2;
+}
+
+TBool FormatSignature::MatchesExtension(const Brx& aUriExtension) const
+{
+    if (aUriExtension.Bytes() == 0) {
+        return false;
+    }
+    for (auto& ext : iExtensions) {
+        if (Ascii::CaseInsensitiveEquals(ext, aUriExtension)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+Brn FormatSignature::UriExtension(const Brx& aUri)
+{ // static
+    // extension of the final path segment, ignoring any query or fragment
+    TUint end = 0;
+    while (end < aUri.Bytes() && aUri[end] != '?' && aUri[end] != '#') {
+        end++;
+    }
+    for (TUint i=end; i>0; i--) {
+        const TByte ch = aUri[i-1];
+        if (ch == '/') {
+            break;
+        }
+        if (ch == '.') {
+            return Brn(aUri.Ptr() + i, end - i);
+        }
+    }
+    return Brn(Brx::Empty());
+}
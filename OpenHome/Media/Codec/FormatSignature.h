@@ -0,0 +1,101 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+
+#include <vector>
+
+namespace OpenHome {
+namespace Media {
+namespace Codec {
+
+/**
+ * Cheap tests for whether a stream is in a particular format.
+ *
+ * Declared by codecs and containers and used by CodecController and ContainerController
+ * to choose which candidates to try first.  A match is only a hint: Recognise() still makes
+ * the final decision and candidates which don't match are tried after those which do.
+ */
+class FormatSignature
+{
+public:
+    static const TUint kMaxProbeBytes = 192; // room for an MPEG-TS sync byte repeated one packet in
+public:
+    FormatSignature();
+    /**
+     * Add a pattern which streams in this format contain near their start.
+     *
+     * Patterns are alternatives; a stream matches if any one pattern matches.
+     *
+     * @param[in] aOffset    Offset of aPattern from the start of the stream.
+     * @param[in] aPattern   Bytes to match.
+     *                       aOffset + aPattern.Bytes() must not exceed kMaxProbeBytes.
+     */
+    void AddMagic(TUint aOffset, const Brx& aPattern);
+    /**
+     * Add a pattern, only comparing the bits which are set in aMask.
+     *
+     * @param[in] aOffset    Offset of aPattern from the start of the stream.
+     * @param[in] aPattern   Bytes to match.
+     * @param[in] aMask      One byte per byte of aPattern.  0xff compares the whole byte, 0x00 ignores it.
+     */
+    void AddMagic(TUint aOffset, const Brx& aPattern, const Brx& aMask);
+    /**
+     * Add a pair of patterns which must both match.  Bytes between them are ignored.
+     */
+    void AddMagic(TUint aOffset1, const Brx& aPattern1, TUint aOffset2, const Brx& aPattern2);
+    /**
+     * Add a uri extension (without a leading '.') used by streams in this format.
+     * Compared case insensitively.
+     */
+    void AddExtension(const TChar* aExtension);
+    TBool MatchesData(const Brx& aProbe) const;
+    TBool MatchesUri(const Brx& aUri) const;
+    TUint ProbeBytes() const; // bytes from the start of a stream that MatchesData() uses
+    /**
+     * Order aCandidates (codecs or containers) for recognition of a stream.
+     *
+     * Candidates whose magic matches aProbe come first, then those whose extension matches aUri,
+     * then all others.  Relative order within each group is preserved.
+     * T must provide Signature(), returning a FormatSignature.
+     */
+    template <class T>
+    static void Order(const std::vector<T*>& aCandidates, const Brx& aProbe, const Brx& aUri, std::vector<T*>& aOrdered);
+private:
+    TUint Rank(const Brx& aProbe, const Brx& aUriExtension) const;
+    TBool MatchesExtension(const Brx& aUriExtension) const;
+    static Brn UriExtension(const Brx& aUri);
+private:
+    class Magic
+    {
+    public:
+        TUint iOffset;
+        Bws<kMaxProbeBytes> iPattern;
+        Bws<kMaxProbeBytes> iMask;
+    };
+private:
+    std::vector<Magic> iMagic;
+    std::vector<Brn> iExtensions;
+    TUint iProbeBytes;
+};
+
+// FormatSignature
+
+template <class T>
+void FormatSignature::Order(const std::vector<T*>& aCandidates, const Brx& aProbe, const Brx& aUri, std::vector<T*>& aOrdered)
+{ // static
+    static const TUint kRankCount = 3;
+    aOrdered.clear();
+    const Brn ext = UriExtension(aUri);
+    for (TUint rank=0; rank<kRankCount; rank++) {
+        for (auto candidate : aCandidates) {
+            if (candidate->Signature().Rank(aProbe, ext) == rank) {
+                aOrdered.push_back(candidate);
+            }
+        }
+    }
+}
+
+} // namespace Codec
+} // namespace Media
+} // namespace OpenHome
@@ -25,6 +25,7 @@ ContainerBase* ContainerFactory::NewId3v2()
 Id3v2::Id3v2()
     : ContainerBase(Brn("ID3"))
 {
+    iSignature.AddMagic(0, Brn("ID3"));
 }
 
 Msg* Id3v2::Recognise()
@@ -11,6 +11,7 @@
 #include <OpenHome/Media/MimeTypeList.h>
 #include <mad.h>
 
+#include <algorithm>
 #include <stdlib.h>
 #include <string.h>
 
@@ -147,6 +148,8 @@ private: // from CodecBase
 private:
     static const TUint kReadReqBytes = 4096;
     static const TUint kInBufBytes = kReadReqBytes+MAD_BUFFER_GUARD;
+    static const TUint kSeekPointIntervalSecs = 1;
+    static const TUint kSeekPointMaxDecodeSecs = 10; // max audio to decode then discard when seeking via a cached seek point
     mad_stream  iMadStream;
     mad_frame   iMadFrame;
     mad_synth   iMadSynth;
@@ -156,7 +159,9 @@ private:
     Bws<kInBufBytes> iInput;
     TUint64     iTrackLengthJiffies;
     TUint64     iTrackOffset;
-    Bws<DecodedAudio::kMaxBytes> iOutput;
+    TUint64     iSkipSamples;
+    TUint64     iNextSeekPoint;
+    TBool       iSeekPointsValid;   // iSamplesWrittenTotal is exact (rather than estimated after a seek)
     TBool       iStreamEnded;
     Bws<6*1024> iRecogBuf;
 };
@@ -653,25 +658,10 @@ TUint Mp3Header::ValidSync(const Brx& aSync, TUint& layer, TUint& mode)
 // MAD_F_FRACBITS is the number of F's and is architecture dependent (28 on all
 // platforms we currently care about).
 //
-// After checking for clipping (first two if's) we then convert to 24-bit with the bottom 8 bits unused.
-static TUint32 fixedToPcm(mad_fixed_t aFixed)
-{
-    const TUint32 kPlusOne  = 0x7FFFFF00l;
-    const TUint32 kMinusOne = 0x80000000l;
-    if (aFixed >= MAD_F_ONE) {
-        //LOG(kCodec, "fixedToPcm upper CLIPPED: %08x ret: %08x\n", aFixed, kPlusOne);
-        return kPlusOne;
-    }
-    if (aFixed <= -MAD_F_ONE) {
-        //LOG(kCodec, "fixedToPcm lower CLIPPED: %08x ret: %08x\n", aFixed, kMinusOne);
-        return kMinusOne; 
-    }
-    // if no clipping, then the 24 bit number is composed of the lsb W and 23 of
-    // the most significant F's.  Linn stores the 24 bits in the higher order
-    // bits with the bottom eight bits zeroed.
-    TInt32 value = (aFixed << 3) & 0xFFFFFF00l;
-    return (TUint32)value;
-}
+// A 24-bit sample is composed of the lsb W and 23 of the most significant F's.
+// Values outside [-MAD_F_ONE, MAD_F_ONE) are clipped when packed.
+static const TUint kMadShift = MAD_F_FRACBITS + 1 - kBitDepth;
+static_assert(sizeof(mad_fixed_t) == sizeof(TInt32), "mad_fixed_t must be packed as TInt32");
 
 
 // CodecMp3
@@ -686,6 +676,7 @@ CodecMp3::CodecMp3(IMimeTypeList& aMimeTypeList)
     aMimeTypeList.Add("audio/mpeg");
     aMimeTypeList.Add("audio/x-mpeg");
     aMimeTypeList.Add("audio/mp1");
+    iSignature.AddExtension("mp3");
 }
 
 CodecMp3::~CodecMp3()
@@ -718,12 +709,14 @@ void CodecMp3::StreamInitialise()
 
     iSamplesWrittenTotal = 0;
     iTrackOffset = 0;
+    iSkipSamples = 0;
+    iNextSeekPoint = 0;
+    iSeekPointsValid = true;
     iStreamEnded = false;
     mad_stream_init(&iMadStream);
     mad_frame_init(&iMadFrame);
     mad_synth_init(&iMadSynth);
 
-    iOutput.SetBytes(0);
     // Discard bytes preceeding frame start.
     iInput.SetBytes(0);
     if (iHeaderBytes > 0) {
@@ -749,7 +742,6 @@ void CodecMp3::StreamCompleted()
     //LOG(kCodec, "CodecMp3::Deinitialise\n");
     iHeader.Clear();
     iInput.SetBytes(0);
-    iOutput.SetBytes(0);
     iHeaderBytes = 0;
 
     mad_synth_finish(&iMadSynth);
@@ -759,24 +751,44 @@ void CodecMp3::StreamCompleted()
 
 TBool CodecMp3::TrySeek(TUint aStreamId, TUint64 aSample)
 {
+    // Prefer a frame position recorded while decoding this track earlier.  Unlike SampleToByte(),
+    // which is an estimate for VBR streams, this is exact.  Look for a point at least one frame
+    // before aSample as the first frame decoded after a seek may use main data from its predecessor.
+    const TUint samplesPerFrame = iHeader.SamplesPerFrame();
+    const TUint64 lookupSample = (aSample >= samplesPerFrame? aSample - samplesPerFrame : aSample);
+    TUint64 startSample = aSample;
     TUint64 bytes = 0;
-    try {
-        bytes = iHeader.SampleToByte(aSample);
-    }
-    catch (Mp3SampleInvalid&) {
-        return false;
+    TBool cached = iController->TryGetSeekPoint(lookupSample, startSample, bytes);
+    if (cached && aSample - startSample > static_cast<TUint64>(kSeekPointMaxDecodeSecs) * iHeader.SampleRate()) {
+        cached = false;
+        startSample = aSample;
     }
-    //LOG(kCodec, "CodecMp3::Seek(%lld), byte: %lld\n", aSamples, bytes);
-    // FIXME - need to know how much data has been consumed by the container
-    //bytes += iController->ContainerSize();
-    if (bytes >= iController->StreamLength()) {
-        bytes = iController->StreamLength() - 1;    // keep seek within file bounds
+    if (!cached) {
+        try {
+            bytes = iHeader.SampleToByte(aSample);
+        }
+        catch (Mp3SampleInvalid&) {
+            return false;
+        }
+        //LOG(kCodec, "CodecMp3::Seek(%lld), byte: %lld\n", aSamples, bytes);
+        // FIXME - need to know how much data has been consumed by the container
+        //bytes += iController->ContainerSize();
+        if (bytes >= iController->StreamLength()) {
+            bytes = iController->StreamLength() - 1;    // keep seek within file bounds
+        }
     }
     TBool canSeek = iController->TrySeekTo(aStreamId, bytes);
     if (canSeek) {
         iInput.SetBytes(0);
-        iOutput.SetBytes(0);
-        iSamplesWrittenTotal = aSample;
+        // discard any frames buffered from before the seek
+        mad_stream_finish(&iMadStream);
+        mad_stream_init(&iMadStream);
+        mad_frame_mute(&iMadFrame);
+        mad_synth_mute(&iMadSynth);
+        iSamplesWrittenTotal = startSample;
+        iSkipSamples = aSample - startSample;
+        iNextSeekPoint = startSample;
+        iSeekPointsValid = cached;
         iTrackOffset = (aSample * Jiffies::kPerSecond) / iHeader.SampleRate();
         iController->OutputDecodedStream(iHeader.BitRate(), kBitDepth, iHeader.SampleRate(), iHeader.Channels(), iHeader.Name(), iTrackLengthJiffies, aSample, false, DeriveProfile(iHeader.Channels()));
     }
@@ -854,6 +866,16 @@ void CodecMp3::Process()
         // Not start/end of stream; try some error recovery.
         if (MAD_RECOVERABLE(iMadStream.error)) {
             //LOG(kCodec, "CodecMp3::Process recoverable error: %s\n", mad_stream_errorstr(&iMadStream));
+            if (iSkipSamples > 0 && iMadStream.error == MAD_ERROR_BADDATAPTR) {
+                // First frame after a seek referred to main data from before the seek point.
+                // Count it as discarded so that sample numbers remain exact.
+                const TUint frameSamples = 32 * MAD_NSBSAMPLES(&iMadFrame.header);
+                iSkipSamples -= std::min(iSkipSamples, static_cast<TUint64>(frameSamples));
+                iSamplesWrittenTotal += frameSamples;
+            }
+            else {
+                iSeekPointsValid = false;
+            }
             return;
         }
         else {
@@ -882,45 +904,30 @@ void CodecMp3::Process()
         }
     }
 
-    TUint pcmIndex = 0;
-    do {
-        TUint bytes = samplesToWrite * (kBitDepth/8) * channels;
-        TUint samples = samplesToWrite;
-        TUint outputSpace = iOutput.MaxBytes() - iOutput.Bytes();
-        if (bytes > outputSpace) {
-            samples = outputSpace / (channels * (kBitDepth/8));
-            bytes = samples * (kBitDepth/8) * channels;
-        }
-        TByte* dst = const_cast<TByte*>(iOutput.Ptr()) + iOutput.Bytes();
-        for (TUint i=pcmIndex; i<pcmIndex+samples; i++) {
-            for (TUint j=0; j<channels; j++) {
-                TUint subsample = fixedToPcm(iMadSynth.pcm.samples[j][i]);
-                // output is always 24-bit
-                *dst++ = (TByte)(subsample >> 24);
-                *dst++ = (TByte)(subsample >> 16);
-                *dst++ = (TByte)(subsample >> 8);
-            }
-        }
-        pcmIndex += samples;
-        iOutput.SetBytes(iOutput.Bytes() + bytes);
-        // only output audio when we have data for a full-sized msg.
-        // any data not output now will be picked up the next time round
-        if (iOutput.MaxBytes() - iOutput.Bytes() < (kBitDepth/8) * channels) {
-            iTrackOffset += iController->OutputAudioPcm(iOutput, channels, iHeader.SampleRate(),
-                                                        kBitDepth, AudioDataEndian::Big, iTrackOffset);
-            iOutput.SetBytes(0);
-        }
-        iSamplesWrittenTotal += samples;
-        samplesToWrite -= samples;
-    } while (samplesToWrite > 0);
+    if (iSeekPointsValid && !iStreamEnded && !newStreamStarted && iSamplesWrittenTotal >= iNextSeekPoint) {
+        // iInput (from iMadStream.buffer to bufend) holds the bytes most recently read from the stream
+        const TUint64 bufferedBytes = iMadStream.bufend - iMadStream.this_frame;
+        iController->AddSeekPoint(iSamplesWrittenTotal, iController->StreamPos() - bufferedBytes);
+        iNextSeekPoint = iSamplesWrittenTotal + static_cast<TUint64>(kSeekPointIntervalSecs) * iHeader.SampleRate();
+    }
+
+    // drop any samples preceding the target of a seek via a cached seek point
+    TUint skip = 0;
+    if (iSkipSamples > 0) {
+        skip = static_cast<TUint>(std::min(iSkipSamples, static_cast<TUint64>(samplesToWrite)));
+        iSkipSamples -= skip;
+    }
+
+    // interleave straight into pipeline audio buffers.  Output is always 24-bit
+    const TInt32* pcm[] = { reinterpret_cast<const TInt32*>(iMadSynth.pcm.samples[0]) + skip,
+                            reinterpret_cast<const TInt32*>(iMadSynth.pcm.samples[1]) + skip };
+    AudioBufWriter::WritePlanarInt32(*iController, pcm, channels, kBitDepth, samplesToWrite - skip, iTrackOffset, kMadShift);
+    iSamplesWrittenTotal += samplesToWrite;
 
     // now propogate any end of stream exception
     // first check we have processed remaining frames of this stream
     if ((iMadStream.md_len == 0) && (iStreamEnded || newStreamStarted)) {
-        if (iOutput.Bytes() > 0) { // only output if there is audio remaining
-            iController->OutputAudioPcm(iOutput, channels, iHeader.SampleRate(),
-                                        kBitDepth, AudioDataEndian::Big, iTrackOffset);
-        }
+        iController->FlushAudioBuf();
         if (newStreamStarted) {
             THROW(CodecStreamStart);
         }
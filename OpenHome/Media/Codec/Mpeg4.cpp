@@ -10,6 +10,7 @@
 #include <OpenHome/Media/Debug.h>
 #include <OpenHome/Media/MimeTypeList.h>
 
+#include <algorithm>
 #include <limits>
 #include <vector>
 
@@ -1012,20 +1013,15 @@ Msg* Mpeg4BoxStsz::Process()
                     THROW(MediaMpeg4FileInvalid);
                 }
 
-                iSampleSizeTable.Init(entries);
-
                 // If iSampleSize == 0, there follows an array of sample size entries.
                 // If iSampleSize > 0, there are <entries> entries each of size <iSampleSize> (and no array follows).
                 if (iSampleSize > 0) {
-                    // Sample size table currently doesn't support a cheap way of having
-                    // a fixed iSampleSize, so just perform a pseudo-population of it here.
-                    for (TUint i=0; i<entries; i++) {
-                        iSampleSizeTable.AddSampleSize(iSampleSize);
-                    }
+                    iSampleSizeTable.InitFixed(entries, iSampleSize);
                     iState = eComplete;
                 }
                 else {
                     // Array of sample size entries follows; prepare to read it.
+                    iSampleSizeTable.Init(entries);
                     iCache->Inspect(iBuf, iBuf.MaxBytes());
                     iState = eEntry;
                 }
@@ -1969,18 +1965,12 @@ TUint Mpeg4BoxMdat::ChunkBytes() const
     }
     const TUint chunkSamples = iSeekTable.SamplesPerChunk(iChunk);
     const TUint startSample = iSeekTable.StartSample(iChunk); // NOTE: this assumes first sample == 0 (which is valid with how our tables are setup), but in MPEG4 spec, first sample == 1.
-    TUint chunkBytes = 0;
     // Samples start from 1. However, tables here are indexed from 0.
-    for (TUint i = startSample; i < startSample + chunkSamples; i++) {
-        const TUint sampleBytes = iSampleSizeTable.SampleSize(i);
-
-        if ((std::numeric_limits<TUint>::max() - chunkBytes) < sampleBytes) {
-            // Wrapping will occur.
-            THROW(MediaMpeg4FileInvalid);
-        }
-        chunkBytes += sampleBytes;
+    const TUint64 chunkBytes = iSampleSizeTable.Bytes(startSample, chunkSamples);
+    if (chunkBytes > std::numeric_limits<TUint>::max()) {
+        THROW(MediaMpeg4FileInvalid);
     }
-    return chunkBytes;
+    return static_cast<TUint>(chunkBytes);
 }
 
 TUint Mpeg4BoxMdat::BytesToRead() const
@@ -1999,7 +1989,7 @@ TUint Mpeg4BoxMdat::BytesToRead() const
 
 SampleSizeTable::SampleSizeTable()
 {
-    WriteInit();
+    Clear();
 }
 
 SampleSizeTable::~SampleSizeTable()
@@ -2009,71 +1999,192 @@ SampleSizeTable::~SampleSizeTable()
 
 void SampleSizeTable::Init(TUint aMaxEntries)
 {
-    ASSERT(iTable.size() == 0);
-    iTable.reserve(aMaxEntries);
+    ASSERT(iCount == 0);
+    ASSERT(iFixedSize == 0);
+    iMaxEntries = aMaxEntries;
+    iTable16.reserve(aMaxEntries);
+    iSkipList.reserve(aMaxEntries / kSkipInterval + 1);
+}
+
+void SampleSizeTable::InitFixed(TUint aEntries, TUint aSampleSize)
+{
+    ASSERT(iCount == 0);
+    ASSERT(aSampleSize > 0);
+    iMaxEntries = aEntries;
+    iCount = aEntries;
+    iFixedSize = aSampleSize;
+    iTotalBytes = static_cast<TUint64>(aEntries) * aSampleSize;
 }
 
 void SampleSizeTable::Clear()
 {
-    iTable.clear();
+    iTable16.clear();
+    iTable32.clear();
+    iSkipList.clear();
+    iMaxEntries = 0;
+    iCount = 0;
+    iFixedSize = 0;
+    iWide = false;
+    iTotalBytes = 0;
+    WriteInit();
 }
 
 void SampleSizeTable::AddSampleSize(TUint aSize)
 {
-    if (iTable.size() == iTable.capacity()) {
+    ASSERT(iFixedSize == 0);
+    if (iCount == iMaxEntries) {
         // File contains more sample sizes than it reported (and than we reserved capacity for).
         THROW(MediaMpeg4FileInvalid);
     }
-    iTable.push_back(aSize);
+    if (iCount % kSkipInterval == 0) {
+        iSkipList.push_back(iTotalBytes);
+    }
+    if (!iWide && aSize > std::numeric_limits<TUint16>::max()) {
+        Widen();
+    }
+    if (iWide) {
+        iTable32.push_back(aSize);
+    }
+    else {
+        iTable16.push_back(static_cast<TUint16>(aSize));
+    }
+    iCount++;
+    iTotalBytes += aSize;
 }
 
 TUint32 SampleSizeTable::SampleSize(TUint aIndex) const
 {
-    if (aIndex > iTable.size() - 1) {
+    if (aIndex >= iCount) {
         THROW(MediaMpeg4FileInvalid);
     }
-    return iTable[aIndex];
+    if (iFixedSize > 0) {
+        return iFixedSize;
+    }
+    return (iWide? iTable32[aIndex] : iTable16[aIndex]);
 }
 
 TUint32 SampleSizeTable::Count() const
 {
-    return iTable.size();
+    return iCount;
+}
+
+TUint64 SampleSizeTable::Bytes(TUint aFirstIndex, TUint aCount) const
+{
+    if (aFirstIndex > iCount || aCount > iCount - aFirstIndex) {
+        THROW(MediaMpeg4FileInvalid);
+    }
+    return StartOffset(aFirstIndex + aCount) - StartOffset(aFirstIndex);
 }
 
 void SampleSizeTable::WriteInit()
 {
+    iHeaderWritten = false;
     iWriteIndex = 0;
 }
 
 void SampleSizeTable::Write(IWriter& aWriter, TUint aMaxBytes)
 {
+    // Serialised as sample count, fixed sample size and entry width, followed by
+    // [sample count] entries of [entry width] bytes if the sample size isn't fixed.
+    static const TUint kHeaderBytes = 3 * sizeof(TUint32);
     TUint bytesLeftToWrite = aMaxBytes;
     WriterBinary writerBin(aWriter);
+    const TUint entryBytes = (iFixedSize > 0? 0 : (iWide? sizeof(TUint32) : sizeof(TUint16)));
 
-    if (iWriteIndex == 0) {
-        if (bytesLeftToWrite < sizeof(TUint32)) {
-           return;
-       }
-       writerBin.WriteUint32Be(Count());
-       bytesLeftToWrite -= sizeof(TUint32);
+    if (!iHeaderWritten) {
+        if (bytesLeftToWrite < kHeaderBytes) {
+            return;
+        }
+        writerBin.WriteUint32Be(iCount);
+        writerBin.WriteUint32Be(iFixedSize);
+        writerBin.WriteUint32Be(entryBytes);
+        bytesLeftToWrite -= kHeaderBytes;
+        iHeaderWritten = true;
+        if (iFixedSize > 0) {
+            iWriteIndex = iCount;
+        }
     }
 
-    while ((iWriteIndex < Count()) && (bytesLeftToWrite >= sizeof(TUint32))) {
-       writerBin.WriteUint32Be(SampleSize(iWriteIndex));
-       bytesLeftToWrite -= sizeof(TUint32);
-       iWriteIndex++;
+    while ((iWriteIndex < iCount) && (bytesLeftToWrite >= entryBytes)) {
+        if (iWide) {
+            writerBin.WriteUint32Be(iTable32[iWriteIndex]);
+        }
+        else {
+            writerBin.WriteUint16Be(iTable16[iWriteIndex]);
+        }
+        bytesLeftToWrite -= entryBytes;
+        iWriteIndex++;
     }
 }
 
 TBool SampleSizeTable::WriteComplete() const
 {
-    return (iWriteIndex == Count());
+    return (iHeaderWritten && iWriteIndex == iCount);
 }
 
+TUint64 SampleSizeTable::StartOffset(TUint aIndex) const
+{
+    ASSERT(aIndex <= iCount);
+    if (iFixedSize > 0) {
+        return static_cast<TUint64>(aIndex) * iFixedSize;
+    }
+    if (aIndex == iCount) {
+        return iTotalBytes;
+    }
+    const TUint skip = aIndex / kSkipInterval;
+    TUint64 offset = iSkipList[skip];
+    for (TUint i=skip*kSkipInterval; i<aIndex; i++) {
+        offset += (iWide? iTable32[i] : iTable16[i]);
+    }
+    return offset;
+}
+
+void SampleSizeTable::Widen()
+{
+    iTable32.reserve(iMaxEntries);
+    iTable32.assign(iTable16.begin(), iTable16.end());
+    std::vector<TUint16>().swap(iTable16);
+    iWide = true;
+}
+
+
+// SampleSizeTableInitialiser
+
+SampleSizeTableInitialiser::SampleSizeTableInitialiser(SampleSizeTable& aSampleSizeTable, IReader& aReader)
+    : iSampleSizeTable(aSampleSizeTable)
+    , iReader(aReader)
+    , iInitialised(false)
+{
+}
+
+void SampleSizeTableInitialiser::Init()
+{
+    ASSERT(!iInitialised);
+    ReaderBinary readerBin(iReader);
+    const TUint sampleCount = readerBin.ReadUintBe(4);
+    const TUint fixedSize = readerBin.ReadUintBe(4);
+    const TUint entryBytes = readerBin.ReadUintBe(4);
+    if (fixedSize > 0) {
+        iSampleSizeTable.InitFixed(sampleCount, fixedSize);
+    }
+    else {
+        if (entryBytes != sizeof(TUint16) && entryBytes != sizeof(TUint32)) {
+            THROW(MediaMpeg4FileInvalid);
+        }
+        iSampleSizeTable.Init(sampleCount);
+        for (TUint i=0; i<sampleCount; i++) {
+            iSampleSizeTable.AddSampleSize(readerBin.ReadUintBe(entryBytes));
+        }
+    }
+    iInitialised = true;
+}
+
+
 // SeekTable
 // Table of samples->chunk->offset required for seeking
 
 SeekTable::SeekTable()
+    : iWideOffsets(false)
 {
     WriteInit();
 }
@@ -2101,7 +2212,7 @@ void SeekTable::InitialiseOffsets(TUint aEntries)
 TBool SeekTable::Initialised() const
 {
     const TBool initialised = iSamplesPerChunk.size() > 0
-            && iAudioSamplesPerSample.size() > 0 && iOffsets.size() > 0;
+            && iAudioSamplesPerSample.size() > 0 && ChunkCount() > 0;
     return initialised;
 }
 
@@ -2110,31 +2221,60 @@ void SeekTable::Deinitialise()
     iSamplesPerChunk.clear();
     iAudioSamplesPerSample.clear();
     iOffsets.clear();
+    iOffsets64.clear();
+    iWideOffsets = false;
 }
 
 void SeekTable::SetSamplesPerChunk(TUint aFirstChunk, TUint aSamplesPerChunk,
         TUint aSampleDescriptionIndex)
 {
+    TUint64 firstSample = 0;
+    if (iSamplesPerChunk.size() > 0) {
+        const TSamplesPerChunkEntry& prev = iSamplesPerChunk.back();
+        if (aFirstChunk < prev.iFirstChunk) {
+            THROW(MediaMpeg4FileInvalid);
+        }
+        firstSample = prev.iFirstSample + static_cast<TUint64>(aFirstChunk - prev.iFirstChunk) * prev.iSamples;
+    }
     TSamplesPerChunkEntry entry = { aFirstChunk, aSamplesPerChunk,
-            aSampleDescriptionIndex };
+            aSampleDescriptionIndex, firstSample };
     iSamplesPerChunk.push_back(entry);
 }
 
 void SeekTable::SetAudioSamplesPerSample(TUint32 aSampleCount,
         TUint32 aAudioSamples)
 {
-    TAudioSamplesPerSampleEntry entry = { aSampleCount, aAudioSamples };
+    TUint64 firstCodecSample = 0;
+    TUint64 firstAudioSample = 0;
+    if (iAudioSamplesPerSample.size() > 0) {
+        const TAudioSamplesPerSampleEntry& prev = iAudioSamplesPerSample.back();
+        firstCodecSample = prev.iFirstCodecSample + prev.iSampleCount;
+        firstAudioSample = prev.iFirstAudioSample + static_cast<TUint64>(prev.iSampleCount) * prev.iAudioSamples;
+    }
+    TAudioSamplesPerSampleEntry entry = { aSampleCount, aAudioSamples,
+            firstCodecSample, firstAudioSample };
     iAudioSamplesPerSample.push_back(entry);
 }
 
 void SeekTable::SetOffset(TUint64 aOffset)
 {
-    iOffsets.push_back(aOffset);
+    if (!iWideOffsets && aOffset > std::numeric_limits<TUint32>::max()) {
+        iOffsets64.reserve(iOffsets.capacity());
+        iOffsets64.assign(iOffsets.begin(), iOffsets.end());
+        std::vector<TUint32>().swap(iOffsets);
+        iWideOffsets = true;
+    }
+    if (iWideOffsets) {
+        iOffsets64.push_back(aOffset);
+    }
+    else {
+        iOffsets.push_back(static_cast<TUint32>(aOffset));
+    }
 }
 
 TUint SeekTable::ChunkCount() const
 {
-    return iOffsets.size();
+    return (iWideOffsets? iOffsets64.size() : iOffsets.size());
 }
 
 TUint SeekTable::AudioSamplesPerSample() const
@@ -2144,60 +2284,26 @@ TUint SeekTable::AudioSamplesPerSample() const
 
 TUint SeekTable::SamplesPerChunk(TUint aChunkIndex) const
 {
-    //ASSERT(aChunkIndex < iSamplesPerChunk.size());
-    //return iSamplesPerChunk[aChunkIndex];
-
-    // FIXME - don't move through loop backwards.
-    TUint current = iSamplesPerChunk.size() - 1;
-    for (;;) {
-        // Note: aChunkIndex = 0 => iFirstChunk = 1
-        if (iSamplesPerChunk[current].iFirstChunk <= aChunkIndex + 1) {
-            return iSamplesPerChunk[current].iSamples;
-        }
-        ASSERT(current != 0);
-        current--;
-    }
+    // Note: aChunkIndex = 0 => iFirstChunk = 1
+    return iSamplesPerChunk[SamplesPerChunkEntry(aChunkIndex + 1)].iSamples;
 }
 
 TUint SeekTable::StartSample(TUint aChunkIndex) const
 {
     // NOTE: chunk indexes passed in start from 0, but chunks referenced within seek table start from 1.
-    TUint startSample = 0;
     const TUint desiredChunk = aChunkIndex + 1;
-    TUint prevFirstChunk = 1;
-    TUint prevSamples = 0;
-    for (TUint i = 0; i < iSamplesPerChunk.size(); i++) {
-        const TUint nextFirstChunk = iSamplesPerChunk[i].iFirstChunk;
-        const TUint nextSamples = iSamplesPerChunk[i].iSamples;
-
-        // Desired chunk was within last chunk range.
-        if (nextFirstChunk >= desiredChunk) {
-            const TUint chunkDiff = desiredChunk - prevFirstChunk;
-            startSample += chunkDiff * prevSamples;
-            prevFirstChunk = nextFirstChunk;
-            prevSamples = nextSamples;
-            break;
-        }
-
-        const TUint chunkDiff = nextFirstChunk - prevFirstChunk;
-        startSample += chunkDiff * prevSamples;
-        prevFirstChunk = nextFirstChunk;
-        prevSamples = nextSamples;
+    if (iSamplesPerChunk.size() == 0 || desiredChunk < iSamplesPerChunk[0].iFirstChunk) {
+        return 0;
     }
-
-    // See if exhausted samples per chunk table without encountering desired chunk.
-    if (prevFirstChunk < desiredChunk) {
-        const TUint chunkDiff = desiredChunk - prevFirstChunk;
-        startSample += chunkDiff * prevSamples;
-    }
-
-    return startSample;
+    const TSamplesPerChunkEntry& entry = iSamplesPerChunk[SamplesPerChunkEntry(desiredChunk)];
+    const TUint64 startSample = entry.iFirstSample + static_cast<TUint64>(desiredChunk - entry.iFirstChunk) * entry.iSamples;
+    return static_cast<TUint>(startSample);
 }
 
 TUint64 SeekTable::Offset(TUint64& aAudioSample, TUint64& aSample)
 {
     if (iSamplesPerChunk.size() == 0 || iAudioSamplesPerSample.size() == 0
-            || iOffsets.size() == 0) {
+            || ChunkCount() == 0) {
         THROW(CodecStreamCorrupt); // seek table empty - cannot do seek // FIXME - throw a MpegMediaFileInvalid exception, which is actually expected/caught?
     }
 
@@ -2216,20 +2322,23 @@ TUint64 SeekTable::Offset(TUint64& aAudioSample, TUint64& aSample)
     aSample = codecSampleFromChunk;
 
     //stco:
-    if (chunk >= iOffsets.size()+1) { // error - required chunk doesn't exist
+    if (chunk >= ChunkCount()+1) { // error - required chunk doesn't exist
         THROW(MediaMpeg4OutOfRange);
     }
-    return iOffsets[chunk - 1]; // entry found - return offset to required chunk
+    return GetOffset(chunk - 1); // entry found - return offset to required chunk
 }
 
 TUint64 SeekTable::GetOffset(TUint aChunkIndex) const
 {
-    ASSERT(aChunkIndex < iOffsets.size());
-    return iOffsets[aChunkIndex];
+    ASSERT(aChunkIndex < ChunkCount());
+    return (iWideOffsets? iOffsets64[aChunkIndex] : iOffsets[aChunkIndex]);
 }
 
 void SeekTable::WriteInit()
 {
+    iSpcHeaderWritten = false;
+    iAspsHeaderWritten = false;
+    iOffsetsHeaderWritten = false;
     iSpcWriteIndex = 0;
     iAspsWriteIndex = 0;
     iOffsetsWriteIndex = 0;
@@ -2241,12 +2350,13 @@ void SeekTable::Write(IWriter& aWriter, TUint aMaxBytes)
     WriterBinary writerBin(aWriter);
 
     const TUint samplesPerChunkCount = iSamplesPerChunk.size();
-    if (iSpcWriteIndex == 0) {
+    if (!iSpcHeaderWritten) {
         if (bytesLeftToWrite < sizeof(TUint32)) {
             return;
         }
         writerBin.WriteUint32Be(samplesPerChunkCount);
         bytesLeftToWrite -= sizeof(TUint32);
+        iSpcHeaderWritten = true;
     }
 
     while (iSpcWriteIndex < samplesPerChunkCount) {
@@ -2261,12 +2371,13 @@ void SeekTable::Write(IWriter& aWriter, TUint aMaxBytes)
     }
 
     const TUint audioSamplesPerSampleCount = iAudioSamplesPerSample.size();
-    if (iAspsWriteIndex == 0) {
+    if (!iAspsHeaderWritten) {
         if (bytesLeftToWrite < sizeof(TUint32)) {
             return;
         }
         writerBin.WriteUint32Be(audioSamplesPerSampleCount);
         bytesLeftToWrite -= sizeof(TUint32);
+        iAspsHeaderWritten = true;
     }
 
     while (iAspsWriteIndex < audioSamplesPerSampleCount) {
@@ -2279,201 +2390,134 @@ void SeekTable::Write(IWriter& aWriter, TUint aMaxBytes)
         iAspsWriteIndex++;
     }
 
-    const TUint chunkCount = iOffsets.size();
-    if (iOffsetsWriteIndex == 0) {
-        if (bytesLeftToWrite < sizeof(TUint32)) {
+    // Offsets are written as chunk count and entry width, followed by [chunk count] entries of [entry width] bytes.
+    const TUint chunkCount = ChunkCount();
+    const TUint offsetBytes = (iWideOffsets? sizeof(TUint64) : sizeof(TUint32));
+    if (!iOffsetsHeaderWritten) {
+        if (bytesLeftToWrite < 2*sizeof(TUint32)) {
             return;
         }
         writerBin.WriteUint32Be(chunkCount);
-        bytesLeftToWrite -= sizeof(TUint32);
+        writerBin.WriteUint32Be(offsetBytes);
+        bytesLeftToWrite -= 2*sizeof(TUint32);
+        iOffsetsHeaderWritten = true;
     }
 
     while (iOffsetsWriteIndex < chunkCount) {
-        if (bytesLeftToWrite < sizeof(TUint64)) {
+        if (bytesLeftToWrite < offsetBytes) {
             return;
         }
-        writerBin.WriteUint64Be(iOffsets[iOffsetsWriteIndex]);
-        bytesLeftToWrite -= sizeof(TUint64);
+        if (iWideOffsets) {
+            writerBin.WriteUint64Be(iOffsets64[iOffsetsWriteIndex]);
+        }
+        else {
+            writerBin.WriteUint32Be(iOffsets[iOffsetsWriteIndex]);
+        }
+        bytesLeftToWrite -= offsetBytes;
         iOffsetsWriteIndex++;
     }
 }
 
 TBool SeekTable::WriteComplete() const
 {
-    return (iSpcWriteIndex == iSamplesPerChunk.size()) &&
+    return iOffsetsHeaderWritten &&
+           (iSpcWriteIndex == iSamplesPerChunk.size()) &&
            (iAspsWriteIndex == iAudioSamplesPerSample.size()) &&
-           (iOffsetsWriteIndex == iOffsets.size());
+           (iOffsetsWriteIndex == ChunkCount());
 }
 
 TUint64 SeekTable::CodecSample(TUint64 aAudioSample) const
 {
     // Use entries from stts box to find codec sample that contains the desired
     // audio sample.
-    TUint64 totalCodecSamples = 0;
-    TUint64 totalAudioSamples = 0;
-    for (TUint entry = 0; entry < iAudioSamplesPerSample.size(); entry++) {
-        const TUint sampleCount = iAudioSamplesPerSample[entry].iSampleCount;
-        const TUint audioSamples = iAudioSamplesPerSample[entry].iAudioSamples;
-        const TUint audioSamplesInrange = sampleCount * audioSamples;
-        if (aAudioSample <= totalCodecSamples + audioSamplesInrange) {
-            // Audio samples are within this range.
-
-            // Find codec sample in this range that contains given audio sample.
-            ASSERT(aAudioSample >= totalAudioSamples);
-            const TUint64 audioSampleOffset = aAudioSample - totalAudioSamples;
-            const TUint64 codecSampleOffset = audioSampleOffset / audioSamples;
-            ASSERT(codecSampleOffset <= sampleCount);
-
-            totalCodecSamples += codecSampleOffset;
-            return totalCodecSamples;
-        }
-        totalCodecSamples += sampleCount;
-        totalAudioSamples += audioSamplesInrange;
-    }
-
-    if (aAudioSample > totalAudioSamples) {
+    auto it = std::upper_bound(iAudioSamplesPerSample.begin(), iAudioSamplesPerSample.end(), aAudioSample,
+                               [](TUint64 aSample, const TAudioSamplesPerSampleEntry& aEntry) {
+                                   return aSample < aEntry.iFirstAudioSample;
+                               });
+    ASSERT(it != iAudioSamplesPerSample.begin()); // first entry always starts at audio sample 0
+    const TAudioSamplesPerSampleEntry& entry = *(it - 1);
+    const TUint64 audioSamplesInRange = static_cast<TUint64>(entry.iSampleCount) * entry.iAudioSamples;
+    if (aAudioSample > entry.iFirstAudioSample + audioSamplesInRange) {
         THROW(MediaMpeg4OutOfRange);
     }
-
-    // Something went wrong. Could be corrupt table or programmer error!
-    LOG(kCodec, "SeekTable::CodecSample could not find aAudioSample: %u\n", aAudioSample);
-    THROW(MediaMpeg4FileInvalid);
-}
-
-TUint SeekTable::SamplesPerChunkTotal(TUint aIndex) const
-{
-    // Calculates chunks*samples_per_chunk at given index in samples-per-chunk
-    // table.
-    ASSERT(aIndex < iSamplesPerChunk.size());
-    const TUint startChunk = iSamplesPerChunk[aIndex].iFirstChunk;
-    const TUint spc = iSamplesPerChunk[aIndex].iSamples;
-    TUint endChunk = 0;
-
-    // Find last chunk in current run.
-    if (aIndex + 1 < iSamplesPerChunk.size()) {
-        endChunk = iSamplesPerChunk[aIndex + 1].iFirstChunk;
-    }
-    else {
-        // No next entry, so end chunk must be last chunk in file.
-        // Since chunk numbers start at one, must be chunk_count+1.
-        endChunk = iOffsets.size()+1;
+    if (entry.iAudioSamples == 0) {
+        LOG(kCodec, "SeekTable::CodecSample could not find aAudioSample: %llu\n", aAudioSample);
+        THROW(MediaMpeg4FileInvalid);
     }
-
-    const TUint chunkDiff = endChunk - startChunk;
-    const TUint samplesInRange = chunkDiff * spc;
-
-    return samplesInRange;
+    const TUint64 codecSampleOffset = (aAudioSample - entry.iFirstAudioSample) / entry.iAudioSamples;
+    return entry.iFirstCodecSample + codecSampleOffset;
 }
 
-TUint SeekTable::ChunkWithinSamplesPerChunk(TUint aIndex, TUint aSampleOffset) const
+TUint SeekTable::SamplesPerChunkEntry(TUint aChunk) const
 {
-    ASSERT(aIndex < iSamplesPerChunk.size());
-    const TUint chunk = iSamplesPerChunk[aIndex].iFirstChunk;
-    const TUint spc = iSamplesPerChunk[aIndex].iSamples;
-    const TUint chunkOffset = static_cast<TUint>(aSampleOffset / spc);
-    return chunk + chunkOffset;
+    auto it = std::upper_bound(iSamplesPerChunk.begin(), iSamplesPerChunk.end(), aChunk,
+                               [](TUint aChunk, const TSamplesPerChunkEntry& aEntry) {
+                                   return aChunk < aEntry.iFirstChunk;
+                               });
+    ASSERT(it != iSamplesPerChunk.begin());
+    return static_cast<TUint>(it - iSamplesPerChunk.begin()) - 1;
 }
 
 TUint SeekTable::Chunk(TUint64 aCodecSample) const
 {
     // Use data from stsc box to find chunk containing the desired codec sample.
-    TUint64 totalSamples = 0;
-    for (TUint entry = 0; entry < iSamplesPerChunk.size(); entry++) {
-        const TUint samplesInRange = SamplesPerChunkTotal(entry);
-        if (aCodecSample < totalSamples + samplesInRange) {
-            // Desired sample is in this range.
-
-            // Find chunk in this range that contains the desired sample.
-            ASSERT(aCodecSample >= totalSamples);
-            const TUint64 sampleOffset64 = aCodecSample - totalSamples;
-            ASSERT(sampleOffset64 <= std::numeric_limits<TUint>::max());  // Ensure no issues with casting to smaller type.
-            const TUint sampleOffset = static_cast<TUint>(sampleOffset64);
-            const TUint chunk = ChunkWithinSamplesPerChunk(entry, sampleOffset);
-
-            return chunk;
-        }
-
-        totalSamples += samplesInRange;
+    auto it = std::upper_bound(iSamplesPerChunk.begin(), iSamplesPerChunk.end(), aCodecSample,
+                               [](TUint64 aSample, const TSamplesPerChunkEntry& aEntry) {
+                                   return aSample < aEntry.iFirstSample;
+                               });
+    ASSERT(it != iSamplesPerChunk.begin()); // first entry always starts at codec sample 0
+    const TSamplesPerChunkEntry& entry = *(it - 1);
+    TUint64 endSample = entry.iFirstSample;
+    if (it != iSamplesPerChunk.end()) {
+        endSample = it->iFirstSample;
+    }
+    else if (ChunkCount() + 1 > entry.iFirstChunk) {
+        // No next entry, so run ends with the last chunk in the file.
+        // Since chunk numbers start at one, must be chunk_count+1.
+        endSample += static_cast<TUint64>(ChunkCount() + 1 - entry.iFirstChunk) * entry.iSamples;
     }
 
-    if (aCodecSample > totalSamples) {
+    if (aCodecSample < endSample) {
+        const TUint64 sampleOffset64 = aCodecSample - entry.iFirstSample;
+        ASSERT(sampleOffset64 <= std::numeric_limits<TUint>::max());  // Ensure no issues with casting to smaller type.
+        const TUint sampleOffset = static_cast<TUint>(sampleOffset64);
+        return entry.iFirstChunk + sampleOffset / entry.iSamples;
+    }
+    if (aCodecSample > endSample) {
         THROW(MediaMpeg4OutOfRange);
     }
 
-    LOG(kCodec, "SeekTable::Chunk could not find aCodecSample: %u\n", aCodecSample);
+    LOG(kCodec, "SeekTable::Chunk could not find aCodecSample: %llu\n", aCodecSample);
     THROW(MediaMpeg4FileInvalid);
 }
 
 TUint SeekTable::CodecSampleFromChunk(TUint aChunk) const
 {
-    // Use data from stsc box to find chunk containing the desired codec sample.
-    TUint totalSamples = 0;
-    TUint chunk = 1;
-    for (TUint entry = 0; entry < iSamplesPerChunk.size(); entry++) {
-        const TUint startChunk = iSamplesPerChunk[entry].iFirstChunk;
-        const TUint spc = iSamplesPerChunk[entry].iSamples;
-        TUint endChunk = 0;
-
-        // Find last chunk in current run.
-        if (entry + 1 < iSamplesPerChunk.size()) {
-            endChunk = iSamplesPerChunk[entry + 1].iFirstChunk;
-        }
-        else {
-            // No next entry, so end chunk must be last chunk in file.
-            endChunk = iOffsets.size();
-        }
-
-        const TUint chunkDiff = endChunk - startChunk;
-        const TUint samplesInRange = chunkDiff * spc;
-
-        if (aChunk <= endChunk) {
-            // Desired chunk is in this range.
-
-            const TUint chunkOffset = aChunk - startChunk;
-            const TUint sampleOffset = chunkOffset * spc;
-            totalSamples += sampleOffset;
-            return totalSamples;
-        }
-
-        totalSamples += samplesInRange;
-        chunk = startChunk;
-    }
-
-    if (aChunk > chunk) {
+    if (aChunk > ChunkCount()) {
         THROW(MediaMpeg4OutOfRange);
     }
-
-    LOG(kCodec, "SeekTable::CodecSampleFromChunk could not find aCodecSample: %u\n", aChunk);
-    THROW(MediaMpeg4FileInvalid);
+    if (aChunk == 0 || iSamplesPerChunk.size() == 0) {
+        LOG(kCodec, "SeekTable::CodecSampleFromChunk could not find aChunk: %u\n", aChunk);
+        THROW(MediaMpeg4FileInvalid);
+    }
+    return StartSample(aChunk - 1);
 }
 
 TUint SeekTable::AudioSampleFromCodecSample(TUint aCodecSample) const
 {
     // Use entries from stts box to find audio sample that start at given codec sample;
-    TUint totalCodecSamples = 0;
-    for (TUint entry = 0; entry < iAudioSamplesPerSample.size(); entry++) {
-        const TUint sampleCount = iAudioSamplesPerSample[entry].iSampleCount;
-        const TUint audioSamples = iAudioSamplesPerSample[entry].iAudioSamples;
-        if (aCodecSample <= totalCodecSamples + sampleCount) {
-            // Codec sample is within this range.
-
-            // Find the number of audio samples at the start of the given codec sample.
-            ASSERT(totalCodecSamples <= aCodecSample);
-            const TUint codecSampleOffset = aCodecSample - totalCodecSamples;
-            const TUint audioSampleOffset = codecSampleOffset * audioSamples;
-
-            return audioSampleOffset;
-        }
-        totalCodecSamples += sampleCount;
-    }
-
-    if (aCodecSample > totalCodecSamples) {
+    auto it = std::upper_bound(iAudioSamplesPerSample.begin(), iAudioSamplesPerSample.end(), aCodecSample,
+                               [](TUint aSample, const TAudioSamplesPerSampleEntry& aEntry) {
+                                   return aSample < aEntry.iFirstCodecSample;
+                               });
+    ASSERT(it != iAudioSamplesPerSample.begin()); // first entry always starts at codec sample 0
+    const TAudioSamplesPerSampleEntry& entry = *(it - 1);
+    if (aCodecSample > entry.iFirstCodecSample + entry.iSampleCount) {
         THROW(MediaMpeg4OutOfRange);
     }
-
-    // Something went wrong. Could be corrupt table or programmer error!
-    LOG(kCodec, "SeekTable::AudioSampleFromCodecSample could not find aCodecSample: %u\n", aCodecSample);
-    THROW(MediaMpeg4FileInvalid);
+    const TUint64 codecSampleOffset = aCodecSample - entry.iFirstCodecSample;
+    const TUint64 audioSample = entry.iFirstAudioSample + codecSampleOffset * entry.iAudioSamples;
+    return static_cast<TUint>(audioSample);
 }
 
 
@@ -2509,10 +2553,20 @@ void SeekTableInitialiser::Init()
     }
 
     const TUint chunkCount = readerBin.ReadUintBe(4);
+    const TUint offsetBytes = readerBin.ReadUintBe(4);
     iSeekTable.InitialiseOffsets(chunkCount);
-    for (TUint i = 0; i < chunkCount; i++) {
-        const TUint64 offset = readerBin.ReadUint64Be(8);
-        iSeekTable.SetOffset(offset);
+    if (offsetBytes == sizeof(TUint32)) {
+        for (TUint i = 0; i < chunkCount; i++) {
+            iSeekTable.SetOffset(readerBin.ReadUintBe(4));
+        }
+    }
+    else if (offsetBytes == sizeof(TUint64)) {
+        for (TUint i = 0; i < chunkCount; i++) {
+            iSeekTable.SetOffset(readerBin.ReadUint64Be(8));
+        }
+    }
+    else {
+        THROW(MediaMpeg4FileInvalid);
     }
     iInitialised = true;
 }
@@ -2778,6 +2832,9 @@ Mpeg4Container::Mpeg4Container(IMimeTypeList& aMimeTypeList)
     , iLock("MP4L")
 {
     aMimeTypeList.Add("audio/mp4");
+    iSignature.AddMagic(4, Brn("ftyp"));
+    iSignature.AddExtension("m4a");
+    iSignature.AddExtension("mp4");
 }
 
 Mpeg4Container::~Mpeg4Container()
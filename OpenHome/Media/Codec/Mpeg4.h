@@ -752,24 +752,63 @@ private:
     Mutex iLock;
 };
 
+/*
+ * Sizes of each codec sample (stsz).
+ *
+ * Tables with a fixed sample size store only that size.  Otherwise sizes are held in 16 bits
+ * where possible, along with the cumulative size at every kSkipInterval samples so that the
+ * total size of any run of samples can be found without summing from the start.
+ *
+ * Write() serialises the table in-band from Mpeg4Container to the codec, where it is read back
+ * by SampleSizeTableInitialiser.  Only those two ends, built from the same source, ever see the
+ * serialised form and it isn't stored anywhere, so its layout can change freely.  It starts with
+ * a header (sample count, fixed size, entry width) so that fixed size tables are sent without
+ * any entries and variable ones in 16 bits where they fit, rather than as 4 bytes per sample.
+ */
 class SampleSizeTable
 {
+public:
+    static const TUint kSkipInterval = 64;
 public:
     SampleSizeTable();
     ~SampleSizeTable();
     void Init(TUint aMaxEntries);
+    void InitFixed(TUint aEntries, TUint aSampleSize);
     void Clear();
     void AddSampleSize(TUint aSampleSize);
     TUint SampleSize(TUint aIndex) const;
     TUint Count() const;
+    TUint64 Bytes(TUint aFirstIndex, TUint aCount) const; // total size of aCount samples starting at aFirstIndex
     void WriteInit();
     void Write(IWriter& aWriter, TUint aMaxBytes);
     TBool WriteComplete() const;
 private:
-    std::vector<TUint> iTable;
+    TUint64 StartOffset(TUint aIndex) const;
+    void Widen();
+private:
+    std::vector<TUint16> iTable16;
+    std::vector<TUint32> iTable32;
+    std::vector<TUint64> iSkipList;
+    TUint iMaxEntries;
+    TUint iCount;
+    TUint iFixedSize;
+    TBool iWide;
+    TUint64 iTotalBytes;
+    TBool iHeaderWritten;
     TUint iWriteIndex;
 };
 
+class SampleSizeTableInitialiser : public INonCopyable
+{
+public:
+    SampleSizeTableInitialiser(SampleSizeTable& aSampleSizeTable, IReader& aReader);
+    void Init();
+private:
+    SampleSizeTable& iSampleSizeTable;
+    IReader& iReader;
+    TBool iInitialised;
+};
+
 // FIXME - should probably also include stss here.
 // If stss box is present, it means that not all samples are sync samples, and the stss box is consulted to find the first sync sample prior to specified time.
 // If stss not present, all samples are sync samples.
@@ -795,31 +834,43 @@ public:
     // FIXME - See if it's possible to split this class into its 3 separate components, to simplify it.
     TUint64 GetOffset(TUint aChunkIndex) const;
     void WriteInit();
-    void Write(IWriter& aWriter, TUint aMaxBytes);   // Serialise.
+    // Serialise, for SeekTableInitialiser.  Offsets are preceded by their width so that
+    // tables with no co64 offset send 4 rather than 8 bytes per chunk.  See SampleSizeTable.
+    void Write(IWriter& aWriter, TUint aMaxBytes);
     TBool WriteComplete() const;
 private:
     // Find the codec sample that contains the given audio sample.
     TUint64 CodecSample(TUint64 aAudioSample) const;
-    TUint SamplesPerChunkTotal(TUint aIndex) const;
-    TUint ChunkWithinSamplesPerChunk(TUint aIndex, TUint aSampleOffset) const;
+    // Index into iSamplesPerChunk of the run containing the given chunk (numbered from 1).
+    TUint SamplesPerChunkEntry(TUint aChunk) const;
     // Find the chunk that contains the desired codec sample.
     TUint Chunk(TUint64 aCodecSample) const;
     TUint CodecSampleFromChunk(TUint aChunk) const;
     TUint AudioSampleFromCodecSample(TUint aCodecSample) const;
 private:
+    // Each entry records the first codec (and audio) sample of its run so that lookups can
+    // binary search the tables rather than walk them from the start.
     typedef struct {
         TUint   iFirstChunk;
         TUint   iSamples;
         TUint   iSampleDescriptionIndex;
+        TUint64 iFirstSample;
     } TSamplesPerChunkEntry;
     typedef struct {
         TUint   iSampleCount;
         TUint   iAudioSamples;
+        TUint64 iFirstCodecSample;
+        TUint64 iFirstAudioSample;
     } TAudioSamplesPerSampleEntry;
 private:
     std::vector<TSamplesPerChunkEntry> iSamplesPerChunk;
     std::vector<TAudioSamplesPerSampleEntry> iAudioSamplesPerSample;
-    std::vector<TUint64> iOffsets;
+    std::vector<TUint32> iOffsets;   // stco offsets; also co64 offsets until one exceeds 32 bits
+    std::vector<TUint64> iOffsets64; // used in place of iOffsets once any offset exceeds 32 bits
+    TBool iWideOffsets;
+    TBool iSpcHeaderWritten;
+    TBool iAspsHeaderWritten;
+    TBool iOffsetsHeaderWritten;
     TUint iSpcWriteIndex;
     TUint iAspsWriteIndex;
     TUint iOffsetsWriteIndex;
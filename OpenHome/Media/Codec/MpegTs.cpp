@@ -932,6 +932,8 @@ MpegTsContainer::MpegTsContainer(IMimeTypeList& aMimeTypeList)
     , iMpegPes(nullptr)
 {
     aMimeTypeList.Add("application/vnd.apple.mpegurl");
+    iSignature.AddMagic(0, Brn("\x47"), MpegTs::kPacketBytes, Brn("\x47")); // sync bytes of the first two packets
+    iSignature.AddExtension("ts");
 }
 
 MpegTsContainer::~MpegTsContainer()
@@ -177,8 +177,9 @@ private:
 
 class MpegTs : public IPipelineElementUpstream
 {
-private:
+public:
     static const TUint kPacketBytes = 188;
+private:
     static const TUint kAdaptionFieldLengthBytes = 1;
     static const TUint kStreamHeaderBytes = MpegTsTransportStreamHeader::kTransportStreamHeaderBytes;
 
@@ -0,0 +1,132 @@
+#include <OpenHome/Media/Codec/SeekPointCache.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Standard.h>
+
+#include <algorithm>
+#include <list>
+#include <vector>
+
+using namespace OpenHome;
+using namespace OpenHome::Media;
+using namespace OpenHome::Media::Codec;
+
+// SeekPointCache::Track
+
+SeekPointCache::Track::Track(const Brx& aUri, TUint64 aStreamBytes)
+    : iUri(aUri)
+    , iStreamBytes(aStreamBytes)
+    , iSpacing(0)
+{
+}
+
+TBool SeekPointCache::Track::Matches(const Brx& aUri, TUint64 aStreamBytes) const
+{
+    return iStreamBytes == aStreamBytes && iUri == aUri;
+}
+
+
+// SeekPointCache
+
+SeekPointCache::SeekPointCache(TUint aMaxTracks, TUint aMaxPointsPerTrack)
+    : iMaxTracks(aMaxTracks)
+    , iMaxPointsPerTrack(aMaxPointsPerTrack)
+    , iCurrent(nullptr)
+{
+    ASSERT(iMaxTracks > 0);
+    ASSERT(iMaxPointsPerTrack >= 4);
+}
+
+SeekPointCache::~SeekPointCache()
+{
+    for (auto track : iTracks) {
+        delete track;
+    }
+}
+
+void SeekPointCache::SetStream(const Brx& aUri, TUint64 aStreamBytes)
+{
+    iCurrent = nullptr;
+    if (aStreamBytes == 0 || aUri.Bytes() == 0) {
+        return;
+    }
+    for (auto it=iTracks.begin(); it!=iTracks.end(); ++it) {
+        if ((*it)->Matches(aUri, aStreamBytes)) {
+            iCurrent = *it;
+            iTracks.erase(it);
+            iTracks.push_front(iCurrent);
+            return;
+        }
+    }
+    if (iTracks.size() == iMaxTracks) {
+        delete iTracks.back();
+        iTracks.pop_back();
+    }
+    iCurrent = new Track(aUri, aStreamBytes);
+    iTracks.push_front(iCurrent);
+}
+
+void SeekPointCache::Add(TUint64 aSample, TUint64 aBytePos)
+{
+    if (iCurrent == nullptr) {
+        return;
+    }
+    auto& points = iCurrent->iPoints;
+    auto it = std::lower_bound(points.begin(), points.end(), aSample,
+                               [](const Point& aPoint, TUint64 aSample) {
+                                   return aPoint.iSample < aSample;
+                               });
+    if (it != points.end() && it->iSample == aSample) {
+        return; // already known (e.g. on replay)
+    }
+    if (points.size() == iMaxPointsPerTrack) {
+        Thin(*iCurrent);
+        it = std::lower_bound(points.begin(), points.end(), aSample,
+                              [](const Point& aPoint, TUint64 aSample) {
+                                  return aPoint.iSample < aSample;
+                              });
+    }
+    const TUint64 spacing = iCurrent->iSpacing;
+    if ((it != points.begin() && (it-1)->iSample + spacing > aSample) ||
+        (it != points.end() && aSample + spacing > it->iSample)) {
+        return; // closer to a neighbour than the rest of the track is sampled
+    }
+    const Point point = { aSample, aBytePos };
+    (void)points.insert(it, point);
+}
+
+TBool SeekPointCache::TryFind(TUint64 aSample, TUint64& aSamplePoint, TUint64& aBytePos) const
+{
+    if (iCurrent == nullptr) {
+        return false;
+    }
+    const auto& points = iCurrent->iPoints;
+    auto it = std::upper_bound(points.begin(), points.end(), aSample,
+                               [](TUint64 aSample, const Point& aPoint) {
+                                   return aSample < aPoint.iSample;
+                               });
+    if (it == points.begin()) {
+        return false;
+    }
+    --it;
+    aSamplePoint = it->iSample;
+    aBytePos = it->iBytePos;
+    return true;
+}
+
+void SeekPointCache::Thin(Track& aTrack)
+{
+    /* Widen the spacing enough to free half of the table, then apply it to the whole track.
+       Add() rejects points closer than this so later regions aren't held more densely than
+       earlier, already thinned, ones. */
+    auto& points = aTrack.iPoints;
+    const TUint64 span = points.back().iSample - points.front().iSample;
+    aTrack.iSpacing = std::max(2 * aTrack.iSpacing, span / (iMaxPointsPerTrack / 2));
+    TUint j = 1;
+    for (TUint i=1; i<points.size(); i++) {
+        if (points[i].iSample >= points[j-1].iSample + aTrack.iSpacing) {
+            points[j++] = points[i];
+        }
+    }
+    points.resize(j);
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Standard.h>
+
+#include <list>
+#include <vector>
+
+namespace OpenHome {
+namespace Media {
+namespace Codec {
+
+/**
+ * Byte offsets of known sample positions, remembered across plays of a track.
+ *
+ * Codecs which can only estimate the byte offset of a sample (VBR MP3) or which have
+ * to search for it (FLAC without a SEEKTABLE) record (sample, byte offset) pairs as they
+ * decode and consult them on later seeks.  Tracks are identified by uri and length in bytes.
+ *
+ * Memory use is bounded: the least recently played track is forgotten once aMaxTracks
+ * are held.  Once a track holds aMaxPointsPerTrack, the minimum spacing between its points
+ * is (at least) doubled and applied to the whole track, so the points left are evenly spread.
+ * Not thread-safe; owned by CodecController and only used from its thread.
+ *
+ * Points are held in memory only, so are lost on restart.  Persisting them would need the
+ * Configuration store, which nothing below PipelineManager depends on, and would write to it
+ * on most track changes.
+ */
+class SeekPointCache : private INonCopyable
+{
+public:
+    SeekPointCache(TUint aMaxTracks, TUint aMaxPointsPerTrack);
+    ~SeekPointCache();
+    /**
+     * Select the track subsequent calls to Add() and TryFind() apply to.
+     *
+     * aStreamBytes of 0 (unknown length) disables the cache until the next call.
+     */
+    void SetStream(const Brx& aUri, TUint64 aStreamBytes);
+    void Add(TUint64 aSample, TUint64 aBytePos);
+    /**
+     * Find the last known point at or before aSample.
+     *
+     * @return     true if a point was found (aSamplePoint <= aSample); false otherwise.
+     */
+    TBool TryFind(TUint64 aSample, TUint64& aSamplePoint, TUint64& aBytePos) const;
+private:
+    class Point
+    {
+    public:
+        TUint64 iSample;
+        TUint64 iBytePos;
+    };
+    class Track : private INonCopyable
+    {
+    public:
+        Track(const Brx& aUri, TUint64 aStreamBytes);
+        TBool Matches(const Brx& aUri, TUint64 aStreamBytes) const;
+    public:
+        Brh iUri;
+        TUint64 iStreamBytes;
+        std::vector<Point> iPoints;  // ordered by sample
+        TUint64 iSpacing;            // minimum samples between points
+    };
+private:
+    void Thin(Track& aTrack);
+private:
+    const TUint iMaxTracks;
+    const TUint iMaxPointsPerTrack;
+    std::list<Track*> iTracks;  // most recently used first
+    Track* iCurrent;
+};
+
+} // namespace Codec
+} // namespace Media
+} // namespace OpenHome
@@ -133,6 +133,9 @@ CodecVorbis::CodecVorbis(IMimeTypeList& aMimeTypeList)
     aMimeTypeList.Add("audio/ogg");
     aMimeTypeList.Add("audio/x-ogg");
     aMimeTypeList.Add("application/ogg");
+    iSignature.AddMagic(0, Brn("OggS"), 28, Brn("\x01vorbis")); // identification header in first Ogg page
+    iSignature.AddExtension("ogg");
+    iSignature.AddExtension("oga");
 }
 
 CodecVorbis::~CodecVorbis()
@@ -188,7 +191,6 @@ void CodecVorbis::StreamInitialise()
     iNewStreamStarted = false;
     iTotalSamplesOutput = 0;
     iInBuf.SetBytes(0);
-    iOutBuf.SetBytes(0);
     iSamplesTotal = 0;
     iTrackLengthJiffies = 0;
     iTrackOffset = 0;
@@ -248,7 +250,6 @@ TBool CodecVorbis::TrySeekBytes(TUint aStreamId, TUint64 aSample, TUint64 aByteP
         iTotalSamplesOutput = aSample;
         iTrackOffset = (aSample * Jiffies::kPerSecond) / iSampleRate;
         iInBuf.SetBytes(0);
-        iOutBuf.SetBytes(0);
         iController->OutputDecodedStream(0, kBitDepth, iSampleRate, iChannels, kCodecVorbis, iTrackLengthJiffies, aSample, false, DeriveProfile(iChannels));
     }
     return canSeek;
@@ -357,25 +358,36 @@ TUint64 CodecVorbis::GetTotalSamples()
     THROW(CodecStreamCorrupt);
 }
 
-// copy audio data to output buffer, converting to big endian if required.
-void CodecVorbis::BigEndian(TInt16* aDst, TInt16* aSrc, TUint aSamples)
+// ov_read() outputs audio in host byte order
+#ifdef DEFINE_BIG_ENDIAN
+static const AudioDataEndian kHostEndian = AudioDataEndian::Big;
+#else
+static const AudioDataEndian kHostEndian = AudioDataEndian::Little;
+#endif
+
+// reverse the byte order of audio data in place
+void CodecVorbis::SwapEndian(TInt16* aData, TUint aSamples)
 {
     aSamples *= iChannels;
     while(aSamples--) {
-        *aDst++ = Arch::BigEndian2(*aSrc++);
+        const TUint16 subsample = static_cast<TUint16>(*aData);
+        *aData++ = static_cast<TInt16>((subsample << 8) | (subsample >> 8));
     }
 }
 
 void CodecVorbis::Process()
 {
     TInt bitstream = 0;
-    TUint iPrevBytes = iOutBuf.Bytes();
 
     if(!iStreamEnded || !iNewStreamStarted) {
         LOG(kCodec, "CodecVorbis::Process bitstream %d\n", bitstream);
         try {
-            char *pcm = (char *)iInBuf.Ptr();
-            TInt request = (iOutBuf.MaxBytes() - iOutBuf.Bytes());
+            // decode straight into a pipeline audio buffer
+            TByte* dest;
+            TUint samplesDest;
+            iController->GetAudioBuf(dest, samplesDest);
+            char *pcm = reinterpret_cast<char*>(dest);
+            TInt request = samplesDest * iBytesPerSample;
             ASSERT((TInt)iInBuf.MaxBytes() >= request);
 
             TInt bytes = 0;
@@ -401,12 +413,11 @@ void CodecVorbis::Process()
 
                 // Encountered a new logical bitstream. Better push any
                 // buffered PCM from previous stream.
-                if (iOutBuf.Bytes() > 0) {
-                    iTrackOffset += iController->OutputAudioPcm(iOutBuf, iChannels, iSampleRate,
-                        kBitDepth, AudioDataEndian::Big, iTrackOffset);
-                    iOutBuf.SetBytes(0);
-                    LOG(kCodec, "CodecVorbis::Process output (new bitstream detected) - total samples = %llu\n", iTotalSamplesOutput);
-                }
+                // Audio just decoded belongs to the new stream and would be lost when its pipeline
+                // buffer is output so move it out of the way until its format is known.
+                iInBuf.Replace(Brn(dest, bytes));
+                pcm = (char *)iInBuf.Ptr();
+                iController->FlushAudioBuf();
 
                 // From ov_read() docs:
                 // "However, when reading audio back, the application must be aware that multiple bitstream sections do not necessarily use the same number of channels or sampling rate."
@@ -438,19 +449,18 @@ void CodecVorbis::Process()
             }
 
             TUint samples = bytes/iBytesPerSample;
-            TByte* dstByte = const_cast<TByte*>(iOutBuf.Ptr()) + iOutBuf.Bytes();
-            TInt16* dst = reinterpret_cast<TInt16*>(dstByte);
-            BigEndian(dst, (TInt16 *)pcm, samples);
-            iOutBuf.SetBytes(iOutBuf.Bytes()+bytes);
-            iTotalSamplesOutput += samples;
-
-            LOG(kCodec, "CodecVorbis::Process read - bytes %d, iPrevBytes %d\n", bytes, iPrevBytes);
-            if (iOutBuf.MaxBytes() - iOutBuf.Bytes() < (TUint)((kBitDepth/8) * iChannels)) {
-                iTrackOffset += iController->OutputAudioPcm(iOutBuf, iChannels, iSampleRate,
-                    kBitDepth, AudioDataEndian::Big, iTrackOffset);
-                iOutBuf.SetBytes(0);
-                LOG(kCodec, "CodecVorbis::Process output - total samples = %llu\n", iTotalSamplesOutput);
+            if (pcm == reinterpret_cast<char*>(dest)) {
+                if (iController->AudioBufEndian() != kHostEndian) {
+                    SwapEndian(reinterpret_cast<TInt16*>(pcm), samples);
+                }
+                iController->AppendAudioBuf(samples, iTrackOffset);
+            }
+            else {
+                Brn audio(iInBuf.Ptr(), bytes);
+                AudioBufWriter::WriteInterleaved(*iController, audio, kBitDepth, iChannels, kHostEndian, iTrackOffset);
             }
+            iTotalSamplesOutput += samples;
+            LOG(kCodec, "CodecVorbis::Process read - bytes %d, total samples = %llu\n", bytes, iTotalSamplesOutput);
         }
         catch(CodecStreamEnded&) {
             iStreamEnded = true;
@@ -469,11 +479,7 @@ void CodecVorbis::FlushOutput()
     LOG(kCodec, "CodecVorbis::FlushOutput\n");
 
     if (iStreamEnded || iNewStreamStarted) {
-        if (iOutBuf.Bytes() > 0) {
-            iTrackOffset += iController->OutputAudioPcm(iOutBuf, iChannels, iSampleRate,
-                kBitDepth, AudioDataEndian::Big, iTrackOffset);
-            iOutBuf.SetBytes(0);
-        }
+        iController->FlushAudioBuf();
         if (iNewStreamStarted) {
             THROW(CodecStreamStart);
         }
@@ -42,7 +42,7 @@ public:
 private:
     TBool FindSync();
     TUint64 GetTotalSamples();
-    void BigEndian(TInt16* aDst, TInt16* aSrc, TUint aSamples);
+    void SwapEndian(TInt16* aData, TUint aSamples);
     void FlushOutput();
     TBool StreamInfoChanged(TUint aChannels, TUint aSampleRate) const;
     void OutputMetaData();
@@ -51,7 +51,6 @@ private:
     std::unique_ptr<Pimpl> iPimpl;
 
     Bws<DecodedAudio::kMaxBytes> iInBuf;
-    Bws<DecodedAudio::kMaxBytes> iOutBuf;
     Bws<2*kSearchChunkSize> iSeekBuf;   // can store 2 read chunks, to check for sync word across read boundaries
 
     TUint iSampleRate;
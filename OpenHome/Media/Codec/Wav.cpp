@@ -78,6 +78,8 @@ CodecWav::CodecWav(IMimeTypeList& aMimeTypeList)
     aMimeTypeList.Add("audio/wav");
     aMimeTypeList.Add("audio/wave");
     aMimeTypeList.Add("audio/x-wav");
+    iSignature.AddMagic(0, Brn("RIFF"), 8, Brn("WAVE"));
+    iSignature.AddExtension("wav");
 }
 
 CodecWav::~CodecWav()
@@ -383,6 +385,21 @@ void CodecWav::WriteSamples(TByte*& aDest, TUint& aSamplesWritten, TUint aSample
 void CodecWav::WriteSamples(TByte*& aDest, const TByte* aSrc, TUint aSamples)
 {
     const auto bytes = aSamples * iSampleBytesSrc;
+    if (iController->AudioBufEndian() == AudioDataEndian::Little) {
+        // wav data is already little endian
+        if (iBitDepthSrc == 32 && iBitDepth <= 24) {
+            for (TUint i = 0; i < bytes; i += 4) {
+                *aDest++ = aSrc[i + 1];
+                *aDest++ = aSrc[i + 2];
+                *aDest++ = aSrc[i + 3];
+            }
+        }
+        else {
+            (void)memcpy(aDest, aSrc, bytes);
+            aDest += bytes;
+        }
+        return;
+    }
     switch (iBitDepthSrc)
     {
     case 8:
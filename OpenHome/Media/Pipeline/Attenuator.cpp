@@ -23,17 +23,57 @@ const TUint Attenuator::kSupportedMsgTypes =   eMode
                                          | eSilence
                                          | eQuit;
 
+const Brn Attenuator::kModeRaop("RAOP");
+
+Attenuator::ModeAttenuation::ModeAttenuation(const Brx& aMode, TUint aAttenuation)
+    : iMode(aMode)
+    , iAttenuation(aAttenuation)
+{
+}
+
 Attenuator::Attenuator(IPipelineElementUpstream& aUpstreamElement)
     : PipelineElement(kSupportedMsgTypes)
     , iUpstreamElement(aUpstreamElement)
+    , iLock("ATTN")
     , iAttenuation(kUnityAttenuation)
-    , iActive(false)
 {
 }
 
 void Attenuator::SetAttenuation(TUint aAttenuation)
 {
-    iAttenuation = aAttenuation;
+    SetAttenuation(kModeRaop, aAttenuation);
+}
+
+void Attenuator::SetAttenuation(const Brx& aMode, TUint aAttenuation)
+{
+    if (aAttenuation > kUnityAttenuation) {
+        aAttenuation = kUnityAttenuation;
+    }
+    AutoMutex _(iLock);
+    TBool found = false;
+    for (auto& mode : iModes) {
+        if (mode.iMode == aMode) {
+            mode.iAttenuation = aAttenuation;
+            found = true;
+            break;
+        }
+    }
+    if (!found) {
+        iModes.push_back(ModeAttenuation(aMode, aAttenuation));
+    }
+    if (iMode == aMode) {
+        iAttenuation = aAttenuation;
+    }
+}
+
+TUint Attenuator::AttenuationLocked(const Brx& aMode) const
+{
+    for (const auto& mode : iModes) {
+        if (mode.iMode == aMode) {
+            return mode.iAttenuation;
+        }
+    }
+    return kUnityAttenuation;
 }
 
 Msg* Attenuator::Pull()
@@ -46,16 +86,17 @@ Msg* Attenuator::Pull()
 
 Msg* Attenuator::ProcessMsg(MsgMode* aMsg)
 {
-    iActive = aMsg->Mode() == Brn("RAOP");
-
+    AutoMutex _(iLock);
+    iMode.Replace(aMsg->Mode());
+    iAttenuation = AttenuationLocked(iMode);
     return aMsg;
 }
 
-
 Msg* Attenuator::ProcessMsg(MsgAudioPcm* aMsg)
 {
-    if (iActive) {
-        aMsg->SetAttenuation(iAttenuation);
+    const TUint attenuation = iAttenuation.load();
+    if (attenuation != kUnityAttenuation) {
+        aMsg->SetAttenuation(attenuation);
     }
     return aMsg;
 }
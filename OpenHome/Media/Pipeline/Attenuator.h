@@ -4,7 +4,9 @@
 #include <OpenHome/Private/Standard.h>
 #include <OpenHome/Media/Pipeline/Msg.h>
 #include <OpenHome/Av/VolumeManager.h>
+#include <OpenHome/Private/Thread.h>
 #include <atomic>
+#include <vector>
 
 namespace OpenHome {
 namespace Media {
@@ -14,30 +16,51 @@ class IAttenuator
 public:
     static const TUint kUnityAttenuation = 256;
 public:
-    virtual void SetAttenuation(TUint aAttenuation) = 0;
+    virtual void SetAttenuation(TUint aAttenuation) = 0; // applies to RAOP
+    // Applies attenuation in [0..kUnityAttenuation] to audio in mode aMode (and only that mode).
+    // Attenuation for each mode is retained until set again.
+    // Implementations which don't support per-mode attenuation needn't override this;
+    // by default it is passed to SetAttenuation(TUint).
+    virtual void SetAttenuation(const Brx& /*aMode*/, TUint aAttenuation) { SetAttenuation(aAttenuation); }
     virtual ~IAttenuator() {}
 };
 
 /*
-Element which sets attenuation value in PCM audio message:
+Element which sets attenuation value in PCM audio message.
+Attenuation is applied when the message is read (see MsgPlayablePcm).
 */
 
 class Attenuator : public PipelineElement, public IPipelineElementUpstream, public IAttenuator, private INonCopyable
 {
     static const TUint kSupportedMsgTypes;
+    static const Brn kModeRaop;
 public:
     Attenuator(IPipelineElementUpstream& aUpstreamElement);
 public: // from IAttenuator
     void SetAttenuation(TUint aAttenuation) override;
+    void SetAttenuation(const Brx& aMode, TUint aAttenuation) override;
 public: // from IPipelineElementUpstream
     Msg* Pull() override;
 private: // IMsgProcessor
     Msg* ProcessMsg(MsgMode* aMsg) override;
     Msg* ProcessMsg(MsgAudioPcm* aMsg) override;
+private:
+    TUint AttenuationLocked(const Brx& aMode) const;
+private:
+    class ModeAttenuation
+    {
+    public:
+        ModeAttenuation(const Brx& aMode, TUint aAttenuation);
+    public:
+        BwsMode iMode;
+        TUint iAttenuation;
+    };
 private:
     IPipelineElementUpstream& iUpstreamElement;
-    std::atomic<TUint> iAttenuation;
-    TBool iActive;
+    Mutex iLock;
+    std::vector<ModeAttenuation> iModes;
+    BwsMode iMode;
+    std::atomic<TUint> iAttenuation; // for iMode
 };
 
 } // namespace Media
@@ -0,0 +1,213 @@
+#include <OpenHome/Media/Pipeline/CodecLookahead.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Media/Debug.h>
+
+using namespace OpenHome;
+using namespace OpenHome::Media;
+
+// CodecLookahead
+
+CodecLookahead::CodecLookahead(MsgFactory& aMsgFactory, IPipelineElementUpstream& aUpstream,
+                               TUint aMaxAudioMsgs, TUint aMaxStreamCount, TUint aThreadPriority)
+    : iMsgFactory(aMsgFactory)
+    , iUpstream(aUpstream)
+    , iMaxAudioMsgs(aMaxAudioMsgs)
+    , iMaxStreamCount(aMaxStreamCount)
+    , iLock("CLAH")
+    , iSem("CLAH", 0)
+    , iSemPaused("CLAP", 0)
+    , iSemResume("CLAR", 0)
+    , iExit(false)
+    , iPauseRequested(false)
+    , iPaused(false)
+    , iExited(false)
+    , iStreamHandler(nullptr)
+    , iStreamId(IPipelineIdProvider::kStreamIdInvalid)
+    , iQueuedStreamId(IPipelineIdProvider::kStreamIdInvalid)
+    , iExpectedFlushId(MsgFlush::kIdInvalid)
+{
+    ASSERT(iMaxAudioMsgs > 0);
+    iThread = new ThreadFunctor("CodecLookahead", MakeFunctor(*this, &CodecLookahead::LookaheadThread), aThreadPriority);
+}
+
+CodecLookahead::~CodecLookahead()
+{
+    delete iThread;
+}
+
+void CodecLookahead::Start()
+{
+    iThread->Start();
+}
+
+Msg* CodecLookahead::Pull()
+{
+    Msg* msg = DoDequeue();
+    AutoMutex _(iLock);
+    if (!IsFull()) {
+        iSem.Signal();
+    }
+    return msg;
+}
+
+void CodecLookahead::LookaheadThread()
+{
+    do {
+        iLock.Wait();
+        const TBool pause = iPauseRequested;
+        if (pause) {
+            iPaused = true;
+            iSemPaused.Signal();
+        }
+        iLock.Signal();
+        if (pause) {
+            iSemResume.Wait();
+            continue;
+        }
+
+        Msg* msg = iUpstream.Pull();
+        iLock.Wait();
+        DoEnqueue(msg);
+        const TBool isFull = IsFull() && !iPauseRequested;
+        if (isFull) {
+            (void)iSem.Clear();
+        }
+        iLock.Signal();
+        if (isFull) {
+            iSem.Wait();
+        }
+    } while (!iExit);
+
+    AutoMutex _(iLock);
+    iExited = true;
+    iSemPaused.Signal(); // release any seek waiting for us to pause
+}
+
+inline TBool CodecLookahead::IsFull() const
+{
+    return (EncodedAudioCount() >= iMaxAudioMsgs || EncodedStreamCount() >= iMaxStreamCount);
+}
+
+TBool CodecLookahead::TryPause()
+{
+    {
+        AutoMutex _(iLock);
+        if (iExited) {
+            return false;
+        }
+        iPauseRequested = true;
+        (void)iSemPaused.Clear();
+    }
+    iSem.Signal(); // wake the lookahead thread if it is waiting for space
+    try {
+        iSemPaused.Wait(kPauseTimeoutMs);
+    }
+    catch (Timeout&) {
+        // Still pulling from upstream.  Withdraw the request unless the thread paused since the timeout.
+        AutoMutex _(iLock);
+        if (!iPaused) {
+            iPauseRequested = false;
+            return false;
+        }
+    }
+    AutoMutex _(iLock);
+    return iPaused; // false if the thread exited instead
+}
+
+void CodecLookahead::Resume()
+{
+    AutoMutex _(iLock);
+    iPauseRequested = false;
+    if (iPaused) {
+        iPaused = false;
+        iSemResume.Signal();
+    }
+}
+
+void CodecLookahead::ProcessMsgIn(MsgEncodedStream* aMsg)
+{
+    iQueuedStreamId = aMsg->StreamId();
+}
+
+void CodecLookahead::ProcessMsgIn(MsgQuit* /*aMsg*/)
+{
+    iExit = true;
+}
+
+Msg* CodecLookahead::ProcessMsgOut(MsgEncodedStream* aMsg)
+{
+    iStreamHandler.store(aMsg->StreamHandler());
+    if (aMsg->StreamId() != iStreamId) {
+        iStreamId = aMsg->StreamId();
+        iExpectedFlushId = MsgFlush::kIdInvalid; // a flush for an earlier stream won't arrive
+    }
+    auto msg = iMsgFactory.CreateMsgEncodedStream(aMsg, this);
+    aMsg->RemoveRef();
+    return msg;
+}
+
+Msg* CodecLookahead::ProcessMsgOut(MsgAudioEncoded* aMsg)
+{
+    if (iExpectedFlushId != MsgFlush::kIdInvalid) {
+        aMsg->RemoveRef(); // read from before the current seek point
+        AutoMutex _(iLock);
+        iSem.Signal(); // Pull() won't return until the flush arrives so make space for it now
+        return nullptr;
+    }
+    return aMsg;
+}
+
+Msg* CodecLookahead::ProcessMsgOut(MsgFlush* aMsg)
+{
+    if (aMsg->Id() == iExpectedFlushId) {
+        iExpectedFlushId = MsgFlush::kIdInvalid;
+    }
+    return aMsg; // CodecController also waits for this flush
+}
+
+EStreamPlay CodecLookahead::OkToPlay(TUint aStreamId)
+{
+    return iStreamHandler.load()->OkToPlay(aStreamId);
+}
+
+TUint CodecLookahead::TrySeek(TUint aStreamId, TUint64 aOffset)
+{
+    // Called from the codec thread.  Containers may only be seeked while the lookahead thread
+    // isn't pulling through them.
+    if (!TryPause()) {
+        LOG(kPipeline, "CodecLookahead::TrySeek(%u, %llu) - failure: lookahead didn't pause (exited or upstream pull blocked)\n", aStreamId, aOffset);
+        return MsgFlush::kIdInvalid;
+    }
+    TUint flushId = MsgFlush::kIdInvalid;
+    if (aStreamId != iStreamId || aStreamId != iQueuedStreamId) {
+        LOG(kPipeline, "CodecLookahead::TrySeek(%u, %llu) - failure: lookahead has moved on to stream %u\n", aStreamId, aOffset, iQueuedStreamId);
+    }
+    else {
+        flushId = iStreamHandler.load()->TrySeek(aStreamId, aOffset);
+        if (flushId != MsgFlush::kIdInvalid) {
+            iExpectedFlushId = flushId;
+        }
+    }
+    Resume();
+    return flushId;
+}
+
+TUint CodecLookahead::TryDiscard(TUint aJiffies)
+{
+    return iStreamHandler.load()->TryDiscard(aJiffies);
+}
+
+TUint CodecLookahead::TryStop(TUint aStreamId)
+{
+    return iStreamHandler.load()->TryStop(aStreamId);
+}
+
+void CodecLookahead::NotifyStarving(const Brx& aMode, TUint aStreamId, TBool aStarving)
+{
+    auto streamHandler = iStreamHandler.load();
+    if (streamHandler != nullptr) {
+        streamHandler->NotifyStarving(aMode, aStreamId, aStarving);
+    }
+}
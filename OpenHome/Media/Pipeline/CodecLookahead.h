@@ -0,0 +1,80 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Private/Standard.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+
+#include <atomic>
+
+namespace OpenHome {
+namespace Media {
+
+/*
+Optional element which runs the stages in front of CodecController on a thread of its own.
+Pulls from ContainerController and queues up to [aMaxAudioMsgs] MsgAudioEncoded for the codec.
+Container recognition and any out-of-band reads (e.g. a trailing MPEG4 moov) for the next stream
+therefore overlap with the codec decoding the end of the current stream, rather than leaving
+DecodedAudioReservoir to drain while they run.  Msgs are passed on unchanged and in order.
+
+Containers are not thread safe so seeks are serialised with the lookahead thread.  TrySeek()
+pauses that thread, runs the seek on the codec thread then discards queued audio up to the
+resulting MsgFlush.  If the thread is pulling from upstream, TrySeek() waits up to
+[kPauseTimeoutMs] for that pull to complete.  A pull can block indefinitely (e.g. the rest of
+the stream is already queued) so the seek fails if it doesn't; Seeker then restreams from the
+seek point.  A seek is never reported as successful before the container has accepted it.
+Seeks also fail once the container has moved on to a later stream; it no longer holds the
+current stream's seek tables.
+Only the container stage runs ahead; streams are still decoded one at a time by CodecController.
+*/
+
+class CodecLookahead : public IPipelineElementUpstream, private MsgReservoir, private IStreamHandler, private INonCopyable
+{
+    friend class SuiteCodecLookahead;
+    static const TUint kPauseTimeoutMs = 500; // arbitrary; much longer than a pull that is receiving data takes
+public:
+    CodecLookahead(MsgFactory& aMsgFactory, IPipelineElementUpstream& aUpstream,
+                   TUint aMaxAudioMsgs, TUint aMaxStreamCount, TUint aThreadPriority);
+    ~CodecLookahead();
+    void Start();
+public: // from IPipelineElementUpstream
+    Msg* Pull() override;
+private:
+    void LookaheadThread();
+    inline TBool IsFull() const;
+    TBool TryPause();
+    void Resume();
+private: // from MsgReservoir
+    void ProcessMsgIn(MsgEncodedStream* aMsg) override;
+    void ProcessMsgIn(MsgQuit* aMsg) override;
+    Msg* ProcessMsgOut(MsgEncodedStream* aMsg) override;
+    Msg* ProcessMsgOut(MsgAudioEncoded* aMsg) override;
+    Msg* ProcessMsgOut(MsgFlush* aMsg) override;
+private: // from IStreamHandler
+    EStreamPlay OkToPlay(TUint aStreamId) override;
+    TUint TrySeek(TUint aStreamId, TUint64 aOffset) override;
+    TUint TryDiscard(TUint aJiffies) override;
+    TUint TryStop(TUint aStreamId) override;
+    void NotifyStarving(const Brx& aMode, TUint aStreamId, TBool aStarving) override;
+private:
+    MsgFactory& iMsgFactory;
+    IPipelineElementUpstream& iUpstream;
+    const TUint iMaxAudioMsgs;
+    const TUint iMaxStreamCount;
+    Mutex iLock;
+    Semaphore iSem;
+    Semaphore iSemPaused;
+    Semaphore iSemResume;
+    ThreadFunctor* iThread;
+    TBool iExit;
+    TBool iPauseRequested;
+    TBool iPaused;
+    TBool iExited;
+    std::atomic<IStreamHandler*> iStreamHandler;
+    TUint iStreamId;
+    TUint iQueuedStreamId;
+    TUint iExpectedFlushId;
+};
+
+} // namespace Media
+} // namespace OpenHome
@@ -16,7 +16,7 @@ class DrainerBase : public PipelineElement, public IPipelineElementUpstream, pri
 protected:
     DrainerBase(MsgFactory& aMsgFactory, IPipelineElementUpstream& aUpstream);
     ~DrainerBase();
-private: // from IPipelineElementUpstream
+public: // from IPipelineElementUpstream
     Msg* Pull() override;
 protected:
     MsgFactory& iMsgFactory;
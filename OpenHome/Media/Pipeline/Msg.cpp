@@ -9,6 +9,7 @@
 #include <OpenHome/Private/Thread.h>
 #include <OpenHome/Private/Arch.h>
 #include <OpenHome/Media/ClockPuller.h>
+#include <OpenHome/Media/Utils/PcmKernels.h>
 #include <OpenHome/Private/Printer.h>
 #include <OpenHome/Private/Debug.h>
 #include <OpenHome/Media/Debug.h>
@@ -31,29 +32,24 @@ const Brn AllocatorBase::kQueryMemory = Brn("memory");
 
 AllocatorBase::~AllocatorBase()
 {
-    LOG(kPipeline, "> ~AllocatorBase for %s. (Peak %u/%u)\n", iName, iCellsUsedMax, iFree.Slots());
-    const TUint slots = iFree.Slots();
-    for (TUint i=0; i<slots; i++) {
-        //Log::Print("  %u", i);
-        try {
-            Allocated* ptr = Read();
-            //Log::Print("(%p)", ptr);
-            delete ptr;
-        }
-        catch (AssertionFailed&) {
-            Log::Print("...leak at %u of %u\n", i+1, slots);
-            ASSERTS();
-        }
+    LOG(kPipeline, "> ~AllocatorBase for %s. (Peak %u/%u)\n", iName, iCellsUsedMax.load(), iCellsTotal);
+    const TUint cellsUsed = iCellsUsed.load();
+    if (cellsUsed != 0) {
+        Log::Print("...leak of %u of %u cells\n", cellsUsed, iCellsTotal);
+        ASSERTS();
     }
+    for (TUint i=0; i<iCellsAdded; i++) {
+        delete iCells[i];
+    }
+    delete[] iCells;
+    delete[] iFreeNext;
     LOG(kPipeline, "< ~AllocatorBase for %s\n", iName);
 }
 
 void AllocatorBase::Free(Allocated* aPtr)
 {
-    iLock.Wait();
     iCellsUsed--;
-    iFree.Write(aPtr);
-    iLock.Signal();
+    Write(aPtr);
 }
 
 TUint AllocatorBase::CellsTotal() const
@@ -68,75 +64,102 @@ TUint AllocatorBase::CellBytes() const
 
 TUint AllocatorBase::CellsUsed() const
 {
-    iLock.Wait();
-    TUint cellsUsed = iCellsUsed;
-    iLock.Signal();
-    return cellsUsed;
+    return iCellsUsed.load();
 }
 
 TUint AllocatorBase::CellsUsedMax() const
 {
-    iLock.Wait();
-    TUint cellsUsedMax = iCellsUsedMax;
-    iLock.Signal();
-    return cellsUsedMax;
+    return iCellsUsedMax.load();
+}
+
+TUint AllocatorBase::Contention() const
+{
+    return iContention.load();
 }
 
 void AllocatorBase::GetStats(TUint& aCellsTotal, TUint& aCellBytes, TUint& aCellsUsed, TUint& aCellsUsedMax) const
 {
     aCellsTotal = iCellsTotal;
     aCellBytes = iCellBytes;
-    iLock.Wait();
-    aCellsUsed = iCellsUsed;
-    aCellsUsedMax = iCellsUsedMax;
-    iLock.Signal();
+    aCellsUsed = iCellsUsed.load();
+    aCellsUsedMax = iCellsUsedMax.load();
 }
 
 AllocatorBase::AllocatorBase(const TChar* aName, TUint aNumCells, TUint aCellBytes, IInfoAggregator& aInfoAggregator)
-    : iFree(aNumCells)
-    , iLock("PAL1")
-    , iName(aName)
+    : iName(aName)
     , iCellsTotal(aNumCells)
     , iCellBytes(aCellBytes)
+    , iFreeHead(kFreeListEnd)
+    , iCellsAdded(0)
     , iCellsUsed(0)
     , iCellsUsedMax(0)
+    , iContention(0)
 {
+    ASSERT_VA(aNumCells < kFreeListEnd, "%s requested %u cells\n", aName, aNumCells);
+    iCells = new Allocated*[aNumCells];
+    iFreeNext = new std::atomic<TUint32>[aNumCells];
     std::vector<Brn> infoQueries;
     infoQueries.push_back(kQueryMemory);
     aInfoAggregator.Register(*this, infoQueries);
 }
 
+void AllocatorBase::AddCell(Allocated* aCell)
+{
+    ASSERT(iCellsAdded < iCellsTotal);
+    aCell->iCellIndex = iCellsAdded;
+    iCells[iCellsAdded++] = aCell;
+    Write(aCell);
+}
+
 Allocated* AllocatorBase::DoAllocate()
 {
-    iLock.Wait();
     Allocated* cell = Read();
     ASSERT_VA(cell->iRefCount == 0, "%s has count %u\n", iName, cell->iRefCount.load());
     cell->iRefCount = 1;
-    iCellsUsed++;
-    if (iCellsUsed > iCellsUsedMax) {
-        iCellsUsedMax = iCellsUsed;
+    const TUint cellsUsed = ++iCellsUsed;
+    TUint cellsUsedMax = iCellsUsedMax.load(std::memory_order_relaxed);
+    while (cellsUsed > cellsUsedMax &&
+           !iCellsUsedMax.compare_exchange_weak(cellsUsedMax, cellsUsed, std::memory_order_relaxed)) {
     }
-    iLock.Signal();
     return cell;
 }
 
 Allocated* AllocatorBase::Read()
 {
-    Allocated* p = nullptr;
-    try {
-        p = iFree.Read();
+    FreeListHead head = iFreeHead.load(std::memory_order_acquire);
+    for (;;) {
+        const TUint32 index = (TUint32)(head & kFreeListIndexMask);
+        if (index == kFreeListEnd) {
+            Log::Print("Warning: Allocator error for %s\n", iName);
+            ASSERTS();
+        }
+        const FreeListHead tag = (head >> kFreeListIndexBits) + 1;
+        const FreeListHead next = (tag << kFreeListIndexBits) | iFreeNext[index].load(std::memory_order_relaxed);
+        if (iFreeHead.compare_exchange_weak(head, next, std::memory_order_acquire, std::memory_order_acquire)) {
+            return iCells[index];
+        }
+        iContention.fetch_add(1, std::memory_order_relaxed);
     }
-    catch (FifoReadError&) {
-        Log::Print("Warning: Allocator error for %s\n", iName);
-        ASSERTS();
+}
+
+void AllocatorBase::Write(Allocated* aCell)
+{
+    const TUint32 index = aCell->iCellIndex;
+    FreeListHead head = iFreeHead.load(std::memory_order_relaxed);
+    for (;;) {
+        iFreeNext[index].store((TUint32)(head & kFreeListIndexMask), std::memory_order_relaxed);
+        const FreeListHead tag = (head >> kFreeListIndexBits) + 1;
+        const FreeListHead next = (tag << kFreeListIndexBits) | index;
+        if (iFreeHead.compare_exchange_weak(head, next, std::memory_order_release, std::memory_order_relaxed)) {
+            return;
+        }
+        iContention.fetch_add(1, std::memory_order_relaxed);
     }
-    return p;
 }
 
 void AllocatorBase::QueryInfo(const Brx& aQuery, IWriter& aWriter)
 {
-    // Note that value of iCellsUsed may be slightly out of date as Allocator doesn't hold any lock while updating its fifo and iCellsUsed
-    AutoMutex a(iLock);
+    // Note that values reported may be slightly out of date as other threads may be allocating or freeing cells
     if (aQuery == kQueryMemory) {
         WriterAscii writer(aWriter);
         writer.Write(Brn("Allocator: "));
@@ -146,10 +169,12 @@ void AllocatorBase::QueryInfo(const Brx& aQuery, IWriter& aWriter)
         writer.Write(Brn(" cells x "));
         writer.WriteUint(iCellBytes);
         writer.Write(Brn(" bytes, in use:"));
-        writer.WriteUint(iCellsUsed);
+        writer.WriteUint(iCellsUsed.load());
         writer.Write(Brn(" cells, peak:"));
-        writer.WriteUint(iCellsUsedMax);
-        aWriter.Write(Brn(" cells\n"));
+        writer.WriteUint(iCellsUsedMax.load());
+        writer.Write(Brn(" cells, contention:"));
+        writer.WriteUint(iContention.load());
+        aWriter.Write(Brn("\n"));
     }
 }
 
@@ -178,6 +203,7 @@ void Allocated::Clear()
 Allocated::Allocated(AllocatorBase& aAllocator)
     : iAllocator(aAllocator)
     , iRefCount(0)
+    , iCellIndex(0)
 {
     ASSERT(iRefCount.is_lock_free());
 }
@@ -193,6 +219,7 @@ const TUint AudioData::kMaxBytes;
 
 AudioData::AudioData(AllocatorBase& aAllocator)
     : Allocated(aAllocator)
+    , iEndian(AudioDataEndian::Big)
 {
 #ifdef TIMESTAMP_LOGGING_ENABLE
     iOsCtx = gEnv->OsCtx();
@@ -222,6 +249,11 @@ void AudioData::SetBytes(TUint aBytes)
     iData.SetBytes(aBytes);
 }
 
+AudioDataEndian AudioData::Endian() const
+{
+    return iEndian;
+}
+
 #ifdef TIMESTAMP_LOGGING_ENABLE
 void AudioData::SetTimestamp(const TChar* aId)
 {
@@ -251,6 +283,7 @@ void AudioData::Clear()
     memset(const_cast<TByte*>(iData.Ptr()), 0xde, iData.Bytes());
 #endif // DEFINE_DEBUG
     iData.SetBytes(0);
+    iEndian = AudioDataEndian::Big;
 #ifdef TIMESTAMP_LOGGING_ENABLE
     for (TUint i=0; i<iNextTimestampIndex; i++) {
         iTimestamps[i].Reset();
@@ -334,9 +367,18 @@ DecodedAudio::DecodedAudio(AllocatorBase& aAllocator)
 {
 }
 
-void DecodedAudio::Aggregate(DecodedAudio& aDecodedAudio)
+void DecodedAudio::Aggregate(DecodedAudio& aDecodedAudio, TUint aBitDepth)
 {
-    iData.Append(aDecodedAudio.iData);
+    if (aDecodedAudio.iEndian == iEndian || aBitDepth == 8) {
+        iData.Append(aDecodedAudio.iData);
+    }
+    else {
+        const TUint bytes = aDecodedAudio.iData.Bytes();
+        ASSERT(iData.Bytes() + bytes <= iData.MaxBytes());
+        TByte* ptr = const_cast<TByte*>(iData.Ptr()) + iData.Bytes();
+        PcmKernels::CopySwapped(aDecodedAudio.iData.Ptr(), ptr, bytes, aBitDepth/8);
+        iData.SetBytes(iData.Bytes() + bytes);
+    }
 }
 
 void DecodedAudio::SetBytes(TUint aBytes)
@@ -344,67 +386,38 @@ void DecodedAudio::SetBytes(TUint aBytes)
     iData.SetBytes(aBytes);
 }
 
-void DecodedAudio::ConstructPcm(const Brx& aData, TUint aBitDepth, AudioDataEndian aEndian)
+void DecodedAudio::ConstructPcm(const Brx& aData, TUint aBitDepth, AudioDataEndian aEndian, AudioDataEndian aStorageEndian)
 {
     ASSERT((aBitDepth & 7) == 0);
+    ASSERT(aBitDepth <= 32);
     ASSERT(aData.Bytes() % (aBitDepth/8) == 0);
+    ASSERT(aStorageEndian != AudioDataEndian::Invalid);
     TByte* ptr = const_cast<TByte*>(iData.Ptr());
-    if (aEndian == AudioDataEndian::Big || aBitDepth == 8) {
+    if (aEndian == aStorageEndian || aBitDepth == 8) {
         (void)memcpy(ptr, aData.Ptr(), aData.Bytes());
     }
-    else if (aBitDepth == 16) {
-        CopyToBigEndian16(aData, ptr);
-    }
-    else if (aBitDepth == 24) {
-        CopyToBigEndian24(aData, ptr);
-    }
-    else if (aBitDepth == 32) {
-        CopyToBigEndian32(aData, ptr);
-    }
-    else { // unsupported bit depth
-        ASSERTS();
+    else {
+        PcmKernels::CopySwapped(aData.Ptr(), ptr, aData.Bytes(), aBitDepth/8);
     }
     iData.SetBytes(aData.Bytes());
+    iEndian = aStorageEndian;
 }
 
 void DecodedAudio::ConstructDsd(const Brx& aData)
 {
     iData.Replace(aData);
+    iEndian = AudioDataEndian::Big;
 }
 
-void DecodedAudio::Construct()
+void DecodedAudio::Construct(AudioDataEndian aEndian)
 {
     iData.Replace(Brx::Empty());
+    iEndian = aEndian;
 }
 
-void DecodedAudio::CopyToBigEndian16(const Brx& aData, TByte* aDest)
-{ // static
-    const TByte* src = aData.Ptr();
-    for (TUint i=0; i<aData.Bytes(); i+=2) {
-        *aDest++ = src[i+1];
-        *aDest++ = src[i];
-    }
-}
-
-void DecodedAudio::CopyToBigEndian24(const Brx& aData, TByte* aDest)
-{ // static
-    const TByte* src = aData.Ptr();
-    for (TUint i=0; i<aData.Bytes(); i+=3) {
-        *aDest++ = src[i+2];
-        *aDest++ = src[i+1];
-        *aDest++ = src[i];
-    }
-}
-
-void DecodedAudio::CopyToBigEndian32(const Brx& aData, TByte* aDest)
-{ // static
-    const TByte* src = aData.Ptr();
-    for (TUint i=0; i<aData.Bytes(); i+=4) {
-        *aDest++ = src[i+3];
-        *aDest++ = src[i+2];
-        *aDest++ = src[i+1];
-        *aDest++ = src[i];
-    }
+void DecodedAudio::ConstructFromEncoded()
+{
+    iEndian = AudioDataEndian::Big;
 }
 
 
@@ -817,85 +830,140 @@ RampApplicator::RampApplicator(const Media::Ramp& aRamp)
 {
 }
 
-TUint RampApplicator::Start(const Brx& aData, TUint aBitDepth, TUint aNumChannels)
+TUint RampApplicator::Start(const Brx& aData, TUint aBitDepth, TUint aNumChannels, AudioDataEndian aEndian)
 {
     iPtr = aData.Ptr();
+    iEndian = aEndian;
     iBitDepth = aBitDepth;
     iNumChannels = aNumChannels;
+    ASSERT(iNumChannels <= kMaxChannels);
     ASSERT_DEBUG(aData.Bytes() % ((iBitDepth/8) * iNumChannels) == 0);
-    iNumSamples = (TInt)(aData.Bytes() / ((iBitDepth/8) * iNumChannels));
-    iTotalRamp = (iRamp.Start() - iRamp.End());
-    iLoopCount = 0;
+    iNumSamples = aData.Bytes() / ((iBitDepth/8) * iNumChannels);
+
+    // Ramp level for sample n is Start - (n * (Start - End)) / (iNumSamples - 1), rounded towards zero.
+    // Calculate the quotient and remainder of the first step here; later steps are then
+    // additions, avoiding a division per sample
+    iRampStart = (TInt)iRamp.Start();
+    const TInt totalRamp = iRampStart - (TInt)iRamp.End();
+    iRampSign = (totalRamp < 0? -1 : 1);
+    const TUint totalRampAbs = (TUint)(totalRamp * iRampSign);
+    iRampDivisor = (iNumSamples > 1? iNumSamples - 1 : 1);
+    iRampStepQuotient = (iNumSamples > 1? totalRampAbs / iRampDivisor : 0);
+    iRampStepRemainder = (iNumSamples > 1? totalRampAbs % iRampDivisor : 0);
+    iRampQuotient = 0;
+    iRampRemainder = 0;
     return iNumSamples;
 }
 
 void RampApplicator::GetNextSample(TByte* aDest)
 {
-    ASSERT_DEBUG(iPtr != nullptr);
-    const TUint16 ramp = (iNumSamples==1? (TUint16)iRamp.Start() : (TUint16)(iRamp.Start() - ((iLoopCount * iTotalRamp)/(iNumSamples-1))));
-    //Log::Print(" %04x ", ramp);
+    ApplyBlock(aDest, 1);
+}
+
+void RampApplicator::GetNextSamples(TByte* aDest, TUint aNumSamples)
+{
+    const TUint bytesPerSample = (iBitDepth/8) * iNumChannels;
+    while (aNumSamples > 0) {
+        const TUint blockSamples = std::min(aNumSamples, kMaxBlockSamples);
+        ApplyBlock(aDest, blockSamples);
+        aDest += blockSamples * bytesPerSample;
+        aNumSamples -= blockSamples;
+    }
+}
+
+inline TUint RampApplicator::NextMultiplier()
+{
+    const TUint ramp = (TUint)(iRampStart - iRampSign * (TInt)iRampQuotient);
+    iRampQuotient += iRampStepQuotient;
+    iRampRemainder += iRampStepRemainder;
+    if (iRampRemainder >= iRampDivisor) {
+        iRampQuotient++;
+        iRampRemainder -= iRampDivisor;
+    }
     const TUint rampIndex = std::min(kRampArrayCount-1, (kFullRampSpan - ramp + (1<<4)) >> 5); // assumes fullRampSpan==2^14 and kRampArray has 512 (2^9) items. (1<<4 allows rounding up)
-    for (TUint i=0; i<iNumChannels; i++) {
-        TInt16 subsample16 = 0;
-        switch (iBitDepth)
-        {
-        case 8:
-            subsample16 = *iPtr++ << 8;
-            break;
-        case 16:
-            subsample16 = *iPtr++ << 8;
-            subsample16 += *iPtr++;
-            break;
-        case 24:
-            subsample16 = *iPtr++ << 8;
-            subsample16 += *iPtr++;
-            iPtr++;
-            break;
-        case 32:
-            subsample16 = *iPtr++ << 8;
-            subsample16 += *iPtr++;
-            iPtr++;
-            iPtr++;
-            break;
-        default:
-            ASSERTS();
+    return kRampArray[rampIndex];
+}
+
+void RampApplicator::ApplyBlock(TByte* aDest, TUint aNumSamples)
+{
+    ASSERT_DEBUG(iPtr != nullptr);
+    ASSERT_DEBUG(aNumSamples <= kMaxBlockSamples);
+    const TUint numChannels = iNumChannels;
+    const TUint numSubsamples = aNumSamples * numChannels;
+    TInt16* gain = iGains;
+    for (TUint i=0; i<aNumSamples; i++) {
+        const TInt16 mult = (TInt16)NextMultiplier();
+        for (TUint j=0; j<numChannels; j++) {
+            *gain++ = mult;
         }
-        //Log::Print(" %03u ", rampIndex);
-        const TUint16 rampMult = static_cast<TUint16>(kRampArray[rampIndex]);
-        TInt rampedSubsample = (rampIndex==512? 0 : (subsample16 * rampMult) >> 15);
-        //Log::Print("Original=%04x (%d), ramped=%04x (%d), rampIndex=%u\n", subsample, subsample, rampedSubsample, rampedSubsample, rampIndex);
-
-        switch (iBitDepth)
-        {
-        case 8:
-            *aDest++ = (TByte)(rampedSubsample >> 8);
-            break;
-        case 16:
-            *aDest++ = (TByte)(rampedSubsample >> 8);
-            *aDest++ = (TByte)rampedSubsample;
-            break;
-        case 24:
-            *aDest++ = (TByte)(rampedSubsample >> 8);
-            *aDest++ = (TByte)rampedSubsample;
-            *aDest++ = (TByte)0;
-            break;
-        case 32:
-            *aDest++ = (TByte)(rampedSubsample >> 8);
-            *aDest++ = (TByte)rampedSubsample;
-            *aDest++ = (TByte)0;
-            if(iNumChannels == 6) {
-                *aDest++ = (TByte)i<<4; //set channel id for efficiency on 6channel 192k
-            }
-            else {
-                *aDest++ = (TByte)0;
+    }
+
+    // Each subsample is scaled by (subsample * mult) >> 15, retaining the source's full bit depth
+    const TByte* src = iPtr;
+    const TBool bigEndian = (iEndian == AudioDataEndian::Big);
+    switch (iBitDepth)
+    {
+    case 8:
+        for (TUint i=0; i<numSubsamples; i++) {
+            aDest[i] = (TByte)(((TInt8)src[i] * iGains[i]) >> 15);
+        }
+        break;
+    case 16:
+        if (bigEndian) {
+            PcmKernels::ApplyGain16BigEndian(src, aDest, iGains, numSubsamples);
+        }
+        else {
+            PcmKernels::ApplyGain16LittleEndian(src, aDest, iGains, numSubsamples);
+        }
+        break;
+    case 24:
+        if (bigEndian) {
+            ApplyBlockWide<true, 3>(aDest, numSubsamples);
+        }
+        else {
+            ApplyBlockWide<false, 3>(aDest, numSubsamples);
+        }
+        break;
+    case 32:
+        if (bigEndian) {
+            ApplyBlockWide<true, 4>(aDest, numSubsamples);
+        }
+        else {
+            ApplyBlockWide<false, 4>(aDest, numSubsamples);
+        }
+        if (numChannels == 6) {
+            // set channel id for efficiency on 6channel 192k
+            const TUint lsbOffset = (bigEndian? 3 : 0);
+            for (TUint i=0; i<numSubsamples; i++) {
+                aDest[(i * 4) + lsbOffset] = (TByte)((i % 6) << 4);
             }
-            break;
-        default:
-            ASSERTS();
         }
+        break;
+    default:
+        ASSERTS();
     }
+    iPtr += numSubsamples * (iBitDepth/8);
+}
 
-    iLoopCount++;
+template <TBool kBigEndian, TUint kBytes>
+void RampApplicator::ApplyBlockWide(TByte* aDest, TUint aNumSubsamples)
+{
+    // 24 or 32-bit subsamples are left-aligned in a TInt32 then scaled with 64-bit precision
+    const TByte* src = iPtr;
+    for (TUint i=0; i<aNumSubsamples; i++) {
+        TUint32 packed = 0;
+        for (TUint j=0; j<kBytes; j++) {
+            const TUint shift = (kBigEndian? 24 - (8 * j) : (32 - (8 * kBytes)) + (8 * j));
+            packed |= (TUint32)src[j] << shift;
+        }
+        const TInt32 ramped = (TInt32)(((TInt64)(TInt32)packed * iGains[i]) >> 15);
+        for (TUint j=0; j<kBytes; j++) {
+            const TUint shift = (kBigEndian? 24 - (8 * j) : (32 - (8 * kBytes)) + (8 * j));
+            aDest[j] = (TByte)((TUint32)ramped >> shift);
+        }
+        src += kBytes;
+        aDest += kBytes;
+    }
 }
 
 TUint RampApplicator::MedianMultiplier(const Media::Ramp& aRamp)
@@ -915,7 +983,7 @@ TUint RampApplicator::MedianMultiplier(const Media::Ramp& aRamp)
         medRamp = aRamp.Start();
         break;
     }
-    const TUint rampIndex = (Ramp::kMax - Ramp::kMin - medRamp + (1<<4)) >> 5; // assumes (Ramp::kMax - Ramp::kMin)==2^14 and kRampArray has 512 (2^9) items. (1<<4 allows rounding up)
+    const TUint rampIndex = std::min(kRampArrayCount-1, (kFullRampSpan - medRamp + (1<<4)) >> 5); // assumes (Ramp::kMax - Ramp::kMin)==2^14 and kRampArray has 512 (2^9) items. (1<<4 allows rounding up)
     return kRampArray[rampIndex];
 }
 
@@ -2120,7 +2188,7 @@ void MsgAudioDecoded::Aggregate(MsgAudioDecoded* aMsg)
     ASSERT(aMsg->iTrackOffset == iTrackOffset + Jiffies()); // aMsg must logically follow this one
     ASSERT(!iRamp.IsEnabled() && !aMsg->iRamp.IsEnabled()); // no ramps allowed
 
-    iAudioData->Aggregate(*(aMsg->iAudioData));
+    iAudioData->Aggregate(*(aMsg->iAudioData), iBitDepth);
     iSize += aMsg->Jiffies();
     aMsg->RemoveRef();
 
@@ -2733,56 +2801,36 @@ void MsgPlayablePcm::Initialise(DecodedAudio* aDecodedAudio, TUint aSizeBytes, T
     iAttenuation = aAttenuation;
 }
 
-void MsgPlayablePcm::ApplyAttenuation(Bwx& aData)
-{
-    if (iAttenuation == MsgAudioPcm::kUnityAttenuation) {
-        return;
-    }
-    ASSERT(iBitDepth == 16);
-    TByte* ptr = (TByte*)aData.Ptr();
-    const TUint samples = aData.Bytes() / 2;
-    for (TUint sampleIndex = 0; sampleIndex < samples; sampleIndex++) {
-        TInt16 sample = *ptr << 8;
-        sample += *(ptr + 1);
-        TInt16 attenuatedSample = (TInt16)(((TInt)sample) * iAttenuation / MsgAudioPcm::kUnityAttenuation);
-        *ptr++ = (TByte)(attenuatedSample >> 8);
-        *ptr++ = (TByte)attenuatedSample;
-    }
-}
-
 void MsgPlayablePcm::ReadBlock(IPcmProcessor& aProcessor)
 {
-    Bwn audioBuf(iAudioData->Ptr(iOffset), iSize, iSize);
-    ApplyAttenuation(audioBuf);
+    // DecodedAudio may be shared with clones of this msg so is never modified.
+    // Byte order conversion, attenuation and ramping each write to iRampedData.
+    Brn audioBuf(iAudioData->Ptr(iOffset), iSize);
 
     const TUint numChannels = iNumChannels;
     const TUint bitDepth = iBitDepth;
     const TUint subsampleBytes = bitDepth / 8;
+    const AudioDataEndian endian = aProcessor.Endian();
+    const Brx* data = &audioBuf;
+    TByte* out = const_cast<TByte*>(iRampedData.Ptr());
+    if (endian != iAudioData->Endian() && subsampleBytes > 1) {
+        PcmKernels::CopySwapped(audioBuf.Ptr(), out, audioBuf.Bytes(), subsampleBytes);
+        iRampedData.SetBytes(audioBuf.Bytes());
+        data = &iRampedData;
+    }
+    if (iAttenuation != MsgAudioPcm::kUnityAttenuation) {
+        PcmKernels::Attenuate(data->Ptr(), out, audioBuf.Bytes(), subsampleBytes, endian == AudioDataEndian::Big, iAttenuation);
+        iRampedData.SetBytes(audioBuf.Bytes());
+        data = &iRampedData;
+    }
     if (iRamp.IsEnabled()) {
-        Bws<256> rampedBuf;
         RampApplicator ra(iRamp);
-        const TUint numSamples = ra.Start(audioBuf, bitDepth, numChannels);
-        const TUint bytesPerSample = subsampleBytes * numChannels;
-        const TUint samplesPerFragment = rampedBuf.MaxBytes() / bytesPerSample;
-        TByte* ptr = (TByte*)rampedBuf.Ptr();
-        TUint fragmentSamples = 0;
-        for (TUint i=0; i<numSamples; i++) {
-            ra.GetNextSample(ptr);
-
-            fragmentSamples++;
-            ptr += bytesPerSample;
-            if (fragmentSamples == samplesPerFragment || i == numSamples-1) {
-                rampedBuf.SetBytes(fragmentSamples * bytesPerSample);
-                aProcessor.ProcessFragment(rampedBuf, numChannels, subsampleBytes);
-                ptr = (TByte*)rampedBuf.Ptr();
-                fragmentSamples = 0;
-            }
-        }
+        const TUint numSamples = ra.Start(*data, bitDepth, numChannels, endian);
+        ra.GetNextSamples(const_cast<TByte*>(iRampedData.Ptr()), numSamples);
+        iRampedData.SetBytes(audioBuf.Bytes());
+        data = &iRampedData;
     }
-    else {
-        aProcessor.ProcessFragment(audioBuf, numChannels, subsampleBytes);
-    }
-
+    aProcessor.ProcessFragment(*data, numChannels, subsampleBytes);
 }
 
 TBool MsgPlayablePcm::TryLogTimestamps()
@@ -2875,6 +2923,7 @@ void MsgPlayableSilence::ReadBlock(IPcmProcessor& aProcessor)
 {
     static const TByte silence[DecodedAudio::kMaxBytes] = { 0 };
     static const TByte silence6ch[DecodedAudio::kMaxBytes] = { 0, 0, 0, 0x00,  0, 0, 0, 0x10, 0, 0, 0, 0x20,  0, 0, 0, 0x30,  0, 0, 0, 0x40,  0, 0, 0, 0x50, 0, 0, 0, 0x60,  0, 0, 0, 0x70 };
+    static const TByte silence6chLe[DecodedAudio::kMaxBytes] = { 0x00, 0, 0, 0,  0x10, 0, 0, 0, 0x20, 0, 0, 0,  0x30, 0, 0, 0,  0x40, 0, 0, 0,  0x50, 0, 0, 0, 0x60, 0, 0, 0,  0x70, 0, 0, 0 };
     TUint remainingBytes = iSize;
     const TUint subsampleBytes = iBitDepth / 8;
     const TUint maxBytes = DecodedAudio::kMaxBytes - (DecodedAudio::kMaxBytes % (iNumChannels * subsampleBytes));
@@ -2882,7 +2931,7 @@ void MsgPlayableSilence::ReadBlock(IPcmProcessor& aProcessor)
         TUint bytes = (remainingBytes > maxBytes? maxBytes : remainingBytes);
         Brn audioBuf;
         if(iNumChannels == 6) {
-            audioBuf.Set(silence6ch, bytes);
+            audioBuf.Set(aProcessor.Endian() == AudioDataEndian::Big? silence6ch : silence6chLe, bytes);
         }
         else {
             audioBuf.Set(silence, bytes);
@@ -3776,7 +3825,9 @@ MsgFactory::MsgFactory(IInfoAggregator& aInfoAggregator, const MsgFactoryInitPar
     , iAllocatorMsgPlayableSilence("MsgPlayableSilence", aInitParams.iMsgPlayableSilenceCount, aInfoAggregator)
     , iAllocatorMsgPlayableSilenceDsd("MsgPlayableSilenceDsd", aInitParams.iMsgPlayableSilenceCount, aInfoAggregator)
     , iAllocatorMsgQuit("MsgQuit", aInitParams.iMsgQuitCount, aInfoAggregator)
+    , iDecodedAudioEndian(aInitParams.iDecodedAudioEndian)
 {
+    ASSERT(iDecodedAudioEndian != AudioDataEndian::Invalid);
 }
 
 MsgMode* MsgFactory::CreateMsgMode(const Brx& aMode, const ModeInfo& aInfo,
@@ -3967,9 +4018,10 @@ MsgAudioPcm* MsgFactory::CreateMsgAudioPcm(const Brx& aData, TUint aChannels, TU
 MsgAudioPcm* MsgFactory::CreateMsgAudioPcm(MsgAudioEncoded* aAudio, TUint aChannels, TUint aSampleRate, TUint aBitDepth, TUint64 aTrackOffset)
 {
     AudioData* audioData = aAudio->iAudioData;
-    audioData->AddRef();
-    return CreateMsgAudioPcm(static_cast<DecodedAudio*>(audioData),
-                             aChannels, aSampleRate, aBitDepth, aTrackOffset);
+    auto decodedAudio = static_cast<DecodedAudio*>(audioData);
+    decodedAudio->AddRef();
+    decodedAudio->ConstructFromEncoded();
+    return CreateMsgAudioPcm(decodedAudio, aChannels, aSampleRate, aBitDepth, aTrackOffset);
 }
 
 MsgAudioDsd* MsgFactory::CreateMsgAudioDsd(const Brx& aData, TUint aChannels, TUint aSampleRate, TUint aSampleBlockWords, TUint64 aTrackOffset, TUint aPadBytesPerChunk)
@@ -3982,8 +4034,10 @@ MsgAudioDsd* MsgFactory::CreateMsgAudioDsd(const Brx& aData, TUint aChannels, TU
 MsgAudioDsd* MsgFactory::CreateMsgAudioDsd(MsgAudioEncoded* aAudio, TUint aChannels, TUint aSampleRate, TUint aSampleBlockWords, TUint64 aTrackOffset, TUint aPadBytesPerChunk)
 {
     AudioData* audioData = aAudio->iAudioData;
-    audioData->AddRef();
-    return CreateMsgAudioDsd(static_cast<DecodedAudio*>(audioData), aChannels, aSampleRate, aSampleBlockWords, aTrackOffset, aPadBytesPerChunk);
+    auto decodedAudio = static_cast<DecodedAudio*>(audioData);
+    decodedAudio->AddRef();
+    decodedAudio->ConstructFromEncoded();
+    return CreateMsgAudioDsd(decodedAudio, aChannels, aSampleRate, aSampleBlockWords, aTrackOffset, aPadBytesPerChunk);
 }
 
 MsgSilence* MsgFactory::CreateMsgSilence(TUint& aSizeJiffies, TUint aSampleRate, TUint aBitDepth, TUint aChannels)
@@ -4007,7 +4061,9 @@ MsgQuit* MsgFactory::CreateMsgQuit()
 
 DecodedAudio* MsgFactory::CreateDecodedAudio()
 {
-    return static_cast<DecodedAudio*>(iAllocatorAudioData.Allocate());
+    DecodedAudio* decodedAudio = static_cast<DecodedAudio*>(iAllocatorAudioData.Allocate());
+    decodedAudio->Construct(iDecodedAudioEndian);
+    return decodedAudio;
 }
 
 EncodedAudio* MsgFactory::CreateEncodedAudio(const Brx& aData)
@@ -4020,7 +4076,7 @@ EncodedAudio* MsgFactory::CreateEncodedAudio(const Brx& aData)
 DecodedAudio* MsgFactory::CreateDecodedAudio(const Brx& aData, TUint aBitDepth, AudioDataEndian aEndian)
 {
     DecodedAudio* decodedAudio = static_cast<DecodedAudio*>(iAllocatorAudioData.Allocate());
-    decodedAudio->ConstructPcm(aData, aBitDepth, aEndian);
+    decodedAudio->ConstructPcm(aData, aBitDepth, aEndian, iDecodedAudioEndian);
     return decodedAudio;
 }
 
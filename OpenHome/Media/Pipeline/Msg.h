@@ -26,8 +26,24 @@ namespace Media {
 
 class Allocated;
 
+/**
+ * Fixed size pool of Allocated cells.
+ *
+ * Free cells are held in a lock-free (Treiber) stack so that the codec, StarvationRamper
+ * and driver threads can all allocate from / free to the same pool without serialising
+ * on a mutex.  Each link in the stack is the index of a cell; the head also holds a tag
+ * that is incremented on every update to avoid ABA problems.
+ */
 class AllocatorBase : private IInfoProvider
 {
+#if ATOMIC_LLONG_LOCK_FREE == 2
+    typedef TUint64 FreeListHead; // ABA tag in upper 32 bits, index of first free cell in lower 32 bits
+#else
+    typedef TUint32 FreeListHead; // ABA tag in upper 16 bits, index of first free cell in lower 16 bits
+#endif
+    static const TUint kFreeListIndexBits = sizeof(FreeListHead) * 4;
+    static const FreeListHead kFreeListIndexMask = (((FreeListHead)1) << kFreeListIndexBits) - 1;
+    static const TUint32 kFreeListEnd = (TUint32)kFreeListIndexMask;
 public:
     ~AllocatorBase();
     void Free(Allocated* aPtr);
@@ -35,25 +51,30 @@ public:
     TUint CellBytes() const;
     TUint CellsUsed() const;
     TUint CellsUsedMax() const;
+    TUint Contention() const; // number of times an update to the free list had to be retried
     void GetStats(TUint& aCellsTotal, TUint& aCellBytes, TUint& aCellsUsed, TUint& aCellsUsedMax) const;
     inline const TChar* Name() const;
     static const Brn kQueryMemory;
 protected:
     AllocatorBase(const TChar* aName, TUint aNumCells, TUint aCellBytes, IInfoAggregator& aInfoAggregator);
+    void AddCell(Allocated* aCell); // only valid during construction of derived class
     Allocated* DoAllocate();
 private:
     Allocated* Read();
+    void Write(Allocated* aCell);
 private: // from IInfoProvider
     void QueryInfo(const Brx& aQuery, IWriter& aWriter);
-protected:
-    FifoLiteDynamic<Allocated*> iFree;
 private:
-    mutable Mutex iLock;
     const TChar* iName;
     const TUint iCellsTotal;
     const TUint iCellBytes;
-    TUint iCellsUsed;
-    TUint iCellsUsedMax;
+    Allocated** iCells;
+    std::atomic<TUint32>* iFreeNext;
+    std::atomic<FreeListHead> iFreeHead;
+    TUint iCellsAdded;
+    std::atomic<TUint> iCellsUsed;
+    std::atomic<TUint> iCellsUsedMax;
+    std::atomic<TUint> iContention;
 };
 
 template <class T> class Allocator : public AllocatorBase
@@ -68,7 +89,7 @@ template <class T> Allocator<T>::Allocator(const TChar* aName, TUint aNumCells,
     : AllocatorBase(aName, aNumCells, sizeof(T), aInfoAggregator)
 {
     for (TUint i=0; i<aNumCells; i++) {
-        iFree.Write(new T(*this));
+        AddCell(new T(*this));
     }
 }
 
@@ -102,6 +123,7 @@ protected:
     AllocatorBase& iAllocator;
 private:
     std::atomic<TUint> iRefCount;
+    TUint iCellIndex;
 };
 
 enum class AudioDataEndian
@@ -124,6 +146,7 @@ public:
     TUint Bytes() const;
     TByte* PtrW();
     void SetBytes(TUint aBytes);
+    AudioDataEndian Endian() const; // byte order of (pcm) data
 #ifdef TIMESTAMP_LOGGING_ENABLE
     void SetTimestamp(const TChar* aId);
     TBool TryLogTimestamps();
@@ -132,6 +155,7 @@ private: // from Allocated
     void Clear() override;
 protected:
     Bws<kMaxBytes> iData;
+    AudioDataEndian iEndian; // held here, not in DecodedAudio, as MsgFactory allocates all cells as AudioData
 #ifdef TIMESTAMP_LOGGING_ENABLE
 private:
     class Timestamp
@@ -170,16 +194,14 @@ class DecodedAudio : public AudioData
 public:
     static const TUint kMaxNumChannels = 8;
 public:
-    void Aggregate(DecodedAudio& aDecodedAudio);
+    void Aggregate(DecodedAudio& aDecodedAudio, TUint aBitDepth);
     void SetBytes(TUint aBytes);
 private:
     DecodedAudio(AllocatorBase& aAllocator);
-    void ConstructPcm(const Brx& aData, TUint aBitDepth, AudioDataEndian aEndian);
+    void ConstructPcm(const Brx& aData, TUint aBitDepth, AudioDataEndian aEndian, AudioDataEndian aStorageEndian);
     void ConstructDsd(const Brx& aData);
-    void Construct();
-    static void CopyToBigEndian16(const Brx& aData, TByte* aDest);
-    static void CopyToBigEndian24(const Brx& aData, TByte* aDest);
-    static void CopyToBigEndian32(const Brx& aData, TByte* aDest);
+    void Construct(AudioDataEndian aEndian); // for data written via PtrW() in byte order aEndian
+    void ConstructFromEncoded(); // for EncodedAudio reused as-is; data must be big endian
 };
 
 /**
@@ -288,19 +310,34 @@ private:
 class RampApplicator : private INonCopyable
 {
     static const TUint kFullRampSpan;
+    static const TUint kMaxChannels = 8;     // DecodedAudio::kMaxNumChannels (not yet declared)
+    static const TUint kMaxBlockSamples = 128; // number of samples whose gains are calculated together
 public:
     RampApplicator(const Media::Ramp& aRamp);
-    TUint Start(const Brx& aData, TUint aBitDepth, TUint aNumChannels); // returns number of samples
+    TUint Start(const Brx& aData, TUint aBitDepth, TUint aNumChannels,
+                AudioDataEndian aEndian = AudioDataEndian::Big); // returns number of samples.  Output has same endianness as aData
     void GetNextSample(TByte* aDest);
+    void GetNextSamples(TByte* aDest, TUint aNumSamples); // ramps aNumSamples into aDest
     static TUint MedianMultiplier(const Media::Ramp& aRamp);
+private:
+    TUint NextMultiplier();
+    void ApplyBlock(TByte* aDest, TUint aNumSamples);
+    template <TBool kBigEndian, TUint kBytes> void ApplyBlockWide(TByte* aDest, TUint aNumSubsamples);
 private:
     const Media::Ramp& iRamp;
     const TByte* iPtr;
+    AudioDataEndian iEndian;
     TUint iBitDepth;
     TUint iNumChannels;
-    TInt iNumSamples;
-    TInt iTotalRamp;
-    TInt iLoopCount;
+    TUint iNumSamples;
+    TInt iRampStart;
+    TInt iRampSign;      // -1 for ramps up, +1 for ramps down
+    TUint iRampDivisor;  // ramp level for sample n is iRampStart - iRampSign * (n * |total ramp|) / iRampDivisor
+    TUint iRampStepQuotient;
+    TUint iRampStepRemainder;
+    TUint iRampQuotient; // ...calculated incrementally as quotient + remainder
+    TUint iRampRemainder;
+    TInt16 iGains[kMaxBlockSamples * kMaxChannels];
 };
 
 class MsgFactory;
@@ -1095,11 +1132,10 @@ private: // from MsgPlayable
     TBool TryLogTimestamps() override;
 private: // from Msg
     void Clear() override;
-private:
-    void ApplyAttenuation(Bwx& aData);
 private:
     DecodedAudio* iAudioData;
     TUint iAttenuation;
+    Bws<DecodedAudio::kMaxBytes> iRampedData; // DecodedAudio may be shared so attenuation/ramps can't be applied in place
 };
 
 class MsgPlayableDsd : public MsgPlayable
@@ -1214,7 +1250,8 @@ public:
     /**
      * Copy a block of audio data.
      *
-     * @param aData            Packed big endian pcm data.  Will always be a complete number of samples.
+     * @param aData            Packed pcm data, in the byte order reported by Endian().
+     *                         Will always be a complete number of samples.
      * @param aNumChannels     Number of channels.
      * @param aSubsampleBytes  Number of bytes per sample per channel (1, 2, 3 for 8, 16, 24-bit)
      */
@@ -1222,7 +1259,8 @@ public:
     /**
      * Copy a block of (silent) audio data.
      *
-     * @param aData            Packed big endian pcm data.  Will always be a complete number of samples.
+     * @param aData            Packed pcm data, in the byte order reported by Endian().
+     *                         Will always be a complete number of samples.
      * @param aNumChannels     Number of channels.
      * @param aSubsampleBytes  Number of bytes per sample per channel (1, 2, 3 for 8, 16, 24-bit)
      */
@@ -1237,6 +1275,18 @@ public:
      * If this is called, the processor should pass on any buffered audio.
      */
     virtual void Flush() = 0;
+    /**
+     * Byte order that ProcessFragment and ProcessSilence expect.
+     *
+     * Audio stored in a different order (see MsgFactoryInitParams::SetDecodedAudioEndian)
+     * is converted before being passed on.  Processors that can accept either order should
+     * report the order audio is stored in.
+     *
+     * Unlike the rest of this interface, this has a default.  Processors written before the
+     * byte order was configurable (including drivers that live outside this repo) all expect
+     * big endian, and keep working unchanged.
+     */
+    virtual AudioDataEndian Endian() const { return AudioDataEndian::Big; }
 };
 
 /**
@@ -1957,6 +2007,7 @@ public:
     inline void SetMsgSilenceCount(TUint aCount);
     inline void SetMsgPlayableCount(TUint aPcmCount, TUint aDsdCount, TUint aSilenceCount);
     inline void SetMsgQuitCount(TUint aCount);
+    inline void SetDecodedAudioEndian(AudioDataEndian aEndian); // byte order pcm is stored in
 private:
     TUint iMsgModeCount;
     TUint iMsgTrackCount;
@@ -1980,6 +2031,7 @@ private:
     TUint iMsgPlayableDsdCount;
     TUint iMsgPlayableSilenceCount;
     TUint iMsgQuitCount;
+    AudioDataEndian iDecodedAudioEndian;
 };
 
 class MsgFactory
@@ -2017,7 +2069,8 @@ public:
     MsgSilence* CreateMsgSilence(TUint& aSizeJiffies, TUint aSampleRate, TUint aBitDepth, TUint aChannels);
     MsgSilence* CreateMsgSilenceDsd(TUint& aSizeJiffies, TUint aSampleRate, TUint aChannels, TUint aSampleBlockWords, TUint aPadBytesPerChunk);
     MsgQuit* CreateMsgQuit();
-    DecodedAudio* CreateDecodedAudio();
+    DecodedAudio* CreateDecodedAudio(); // for pcm written via PtrW() in byte order DecodedAudioEndian()
+    inline AudioDataEndian DecodedAudioEndian() const;
 public:
     inline TUint AllocatorModeCount() const;
     inline TUint AllocatorTrackCount() const;
@@ -2070,6 +2123,7 @@ private:
     Allocator<MsgPlayableSilence> iAllocatorMsgPlayableSilence;
     Allocator<MsgPlayableSilenceDsd> iAllocatorMsgPlayableSilenceDsd;
     Allocator<MsgQuit> iAllocatorMsgQuit;
+    const AudioDataEndian iDecodedAudioEndian;
 };
 
 #include <OpenHome/Media/Pipeline/Msg.inl>
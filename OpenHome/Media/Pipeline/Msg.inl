@@ -319,6 +319,7 @@ inline MsgFactoryInitParams::MsgFactoryInitParams()
     , iMsgPlayableDsdCount(1)
     , iMsgPlayableSilenceCount(1)
     , iMsgQuitCount(1)
+    , iDecodedAudioEndian(AudioDataEndian::Big)
 {
 }
 inline void MsgFactoryInitParams::SetMsgModeCount(TUint aCount)
@@ -397,10 +398,19 @@ inline void MsgFactoryInitParams::SetMsgQuitCount(TUint aCount)
 {
     iMsgQuitCount = aCount;
 }
+inline void MsgFactoryInitParams::SetDecodedAudioEndian(AudioDataEndian aEndian)
+{
+    iDecodedAudioEndian = aEndian;
+}
 
 
 // MsgFactory
 
+inline AudioDataEndian MsgFactory::DecodedAudioEndian() const
+{
+    return iDecodedAudioEndian;
+}
+
 inline TUint MsgFactory::AllocatorModeCount() const
 {
     return iAllocatorMsgMode.CellsUsed();
@@ -44,7 +44,7 @@ public:
 public: // from IMute
     void Mute() override;
     void Unmute() override;
-private: // from IPipelineElementUpstream
+public: // from IPipelineElementUpstream
     Msg* Pull() override;
 private: // IMsgProcessor
     Msg* ProcessMsg(MsgHalt* aMsg) override;
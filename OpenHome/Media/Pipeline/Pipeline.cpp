@@ -7,6 +7,7 @@
 #include <OpenHome/Media/Pipeline/EncodedAudioReservoir.h>
 #include <OpenHome/Media/Codec/Container.h>
 #include <OpenHome/Media/Codec/CodecController.h>
+#include <OpenHome/Media/Pipeline/CodecLookahead.h>
 #include <OpenHome/Media/Codec/Id3v2.h>
 #include <OpenHome/Media/Codec/Mpeg4.h>
 #include <OpenHome/Media/Codec/MpegTs.h>
@@ -29,6 +30,7 @@
 #include <OpenHome/Media/Pipeline/Drainer.h>
 #include <OpenHome/Media/Pipeline/Attenuator.h>
 #include <OpenHome/Media/Pipeline/Logger.h>
+#include <OpenHome/Media/Pipeline/Profiler.h>
 #include <OpenHome/Media/Pipeline/PhaseAdjuster.h>
 #include <OpenHome/Media/Pipeline/StarterTimed.h>
 #include <OpenHome/Media/Pipeline/StarvationRamper.h>
@@ -65,6 +67,9 @@ PipelineInitParams::PipelineInitParams()
     , iSupportElements(EPipelineSupportElementsAll)
     , iMuter(kMuterDefault)
     , iDsdMaxSampleRate(kDsdMaxSampleRateDefault)
+    , iDecodedAudioEndian(kDecodedAudioEndianDefault)
+    , iCodecLookaheadMsgs(kCodecLookaheadMsgsDefault)
+    , iDecodedAudioCacheBytes(kDecodedAudioCacheBytesDefault)
 {
     SetThreadPriorityMax(kThreadPriorityMax);
 }
@@ -152,6 +157,22 @@ void PipelineInitParams::SetDsdMaxSampleRate(TUint aMaxSampleRate)
     iDsdMaxSampleRate = aMaxSampleRate;
 }
 
+void PipelineInitParams::SetDecodedAudioEndian(AudioDataEndian aEndian)
+{
+    ASSERT(aEndian != AudioDataEndian::Invalid);
+    iDecodedAudioEndian = aEndian;
+}
+
+void PipelineInitParams::SetCodecLookahead(TUint aEncodedMsgs)
+{
+    iCodecLookaheadMsgs = aEncodedMsgs;
+}
+
+void PipelineInitParams::SetDecodedAudioCache(TUint aBytes)
+{
+    iDecodedAudioCacheBytes = aBytes;
+}
+
 TUint PipelineInitParams::EncodedReservoirBytes() const
 {
     return iEncodedReservoirBytes;
@@ -232,6 +253,21 @@ TUint OpenHome::Media::PipelineInitParams::DsdMaxSampleRate() const
     return iDsdMaxSampleRate;
 }
 
+AudioDataEndian PipelineInitParams::DecodedAudioEndian() const
+{
+    return iDecodedAudioEndian;
+}
+
+TUint PipelineInitParams::CodecLookaheadMsgs() const
+{
+    return iCodecLookaheadMsgs;
+}
+
+TUint PipelineInitParams::DecodedAudioCacheBytes() const
+{
+    return iDecodedAudioCacheBytes;
+}
+
 
 // Pipeline
 
@@ -247,6 +283,11 @@ TUint OpenHome::Media::PipelineInitParams::DsdMaxSampleRate() const
         }                                                       \
     } while (0)
 
+// Counters for element id, whose time includes that of prev_stats (the element most recently
+// measured in the same thread) unless decoupled (its time includes waits for another thread)
+#define ELEMENT_STATS(id, decoupled, prev_stats)                               \
+    (prev_stats = &iProfile->Add(id, (decoupled)? nullptr : prev_stats), *prev_stats)
+
 static Pipeline* gPipeline = nullptr;
 Pipeline::Pipeline(
     PipelineInitParams* aInitParams,
@@ -268,12 +309,15 @@ Pipeline::Pipeline(
     , iMaxSampleRatePcm(0)
     , iMaxSampleRateDsd(0)
 {
-    const TUint perStreamMsgCount = aInitParams->MaxStreamsPerReservoir() * kReservoirCount;
+    const TUint codecLookaheadMsgs = aInitParams->CodecLookaheadMsgs();
+    const TUint reservoirCount = kReservoirCount + (codecLookaheadMsgs > 0? 1 : 0);
+    const TUint perStreamMsgCount = aInitParams->MaxStreamsPerReservoir() * reservoirCount;
     TUint encodedAudioCount = ((aInitParams->EncodedReservoirBytes() + EncodedAudio::kMaxBytes - 1) / EncodedAudio::kMaxBytes); // this may only be required on platforms that don't guarantee priority based thread scheduling
     encodedAudioCount = std::max(encodedAudioCount, // songcast and some hardware inputs won't use the full capacity of each encodedAudio
                                  (kReceiverMaxLatency + kSongcastFrameJiffies - 1) / kSongcastFrameJiffies);
     const TUint maxEncodedReservoirMsgs = encodedAudioCount;
     encodedAudioCount += kRewinderMaxMsgs; // this may only be required on platforms that don't guarantee priority based thread scheduling
+    encodedAudioCount += codecLookaheadMsgs;
     const TUint msgEncodedAudioCount = encodedAudioCount + 100; // +100 allows for Split()ing by Container and CodecController
     const TUint decodedReservoirSize = aInitParams->DecodedReservoirJiffies() + aInitParams->StarvationRamperMinJiffies();
 
@@ -336,12 +380,17 @@ Pipeline::Pipeline(
     msgInit.SetMsgSilenceCount(kMsgCountSilence);
     msgInit.SetMsgPlayableCount(kMsgCountPlayablePcm, kMsgCountPlayableDsd, kMsgCountPlayableSilence);
     msgInit.SetMsgQuitCount(kMsgCountQuit);
+    msgInit.SetDecodedAudioEndian(aInitParams->DecodedAudioEndian());
     iMsgFactory = new MsgFactory(aInfoAggregator, msgInit);
 
     iEventThread = new PipelineElementObserverThread(aInitParams->ThreadPriorityEvent());
+    iProfile = new PipelineProfile(aInfoAggregator);
     IPipelineElementDownstream* downstream = nullptr;
     IPipelineElementUpstream* upstream = nullptr;
-    const auto elementsSupported = aInitParams->SupportElements();
+    PipelineElementStats* pullStats = nullptr;
+    PipelineElementStats* pushStats = nullptr;
+    // masking with a compile-time constant lets the compiler discard construction of elements excluded from this build
+    const auto elementsSupported = aInitParams->SupportElements() & kPipelineSupportElementsBuild;
 
     // disable "conditional expression is constant" warnings from ATTACH_ELEMENT
 #ifdef _WIN32
@@ -365,16 +414,24 @@ Pipeline::Pipeline(
     }
 
     const TBool createLoggers = (elementsSupported & EPipelineSupportElementsLogger);
-    ATTACH_ELEMENT(iContainer, new Codec::ContainerController(*iMsgFactory, *upstream, aUrlBlockWriter, createLoggers),
+    ATTACH_ELEMENT(iContainer, new ProfiledUpstream<Codec::ContainerController>(ELEMENT_STATS("Codec Container", true, pullStats), *iMsgFactory, *upstream, aUrlBlockWriter, createLoggers),
                    upstream, elementsSupported, EPipelineSupportElementsMandatory);
     ATTACH_ELEMENT(iLoggerContainer, new Logger(*iContainer, "Codec Container"),
                    upstream, elementsSupported, EPipelineSupportElementsLogger);
+    iCodecLookahead = nullptr;
+    if (codecLookaheadMsgs > 0) {
+        iCodecLookahead = new ProfiledUpstream<CodecLookahead>(ELEMENT_STATS("Codec Lookahead", true, pullStats),
+                                                               *iMsgFactory, *upstream, codecLookaheadMsgs,
+                                                               aInitParams->MaxStreamsPerReservoir(), aInitParams->ThreadPriorityCodec());
+        upstream = iCodecLookahead;
+    }
 
     // Construct decoded reservoir out of sequence.  It doesn't pull from the left so doesn't need to know its preceding element
-    iDecodedAudioReservoir = new DecodedAudioReservoir(*iMsgFactory, *this,
-                                                       aInitParams->DecodedReservoirJiffies(),
-                                                       aInitParams->MaxStreamsPerReservoir(),
-                                                       aInitParams->GorgeDurationJiffies());
+    iDecodedAudioReservoir = new ProfiledUpstream<DecodedAudioReservoir>(ELEMENT_STATS("Decoded Audio Reservoir", true, pullStats),
+                                                                         *iMsgFactory, *this,
+                                                                         aInitParams->DecodedReservoirJiffies(),
+                                                                         aInitParams->MaxStreamsPerReservoir(),
+                                                                         aInitParams->GorgeDurationJiffies());
     downstream = iDecodedAudioReservoir;
 
     ATTACH_ELEMENT(iDecodedAudioValidatorDecodedAudioAggregator, new DecodedAudioValidator("Decoded Audio Aggregator", *iDecodedAudioReservoir),
@@ -382,14 +439,14 @@ Pipeline::Pipeline(
     ATTACH_ELEMENT(iLoggerDecodedAudioAggregator,
                    new Logger("Decoded Audio Aggregator", *downstream),
                    downstream, elementsSupported, EPipelineSupportElementsLogger);
-    ATTACH_ELEMENT(iDecodedAudioAggregator, new DecodedAudioAggregator(*downstream),
+    ATTACH_ELEMENT(iDecodedAudioAggregator, new ProfiledDownstream<DecodedAudioAggregator>(ELEMENT_STATS("Decoded Audio Aggregator", true, pushStats), *downstream),
                    downstream, elementsSupported, EPipelineSupportElementsMandatory);
 
     ATTACH_ELEMENT(iDecodedAudioValidatorStreamValidator, new DecodedAudioValidator("StreamValidator", *iDecodedAudioAggregator),
                    downstream, elementsSupported, EPipelineSupportElementsDecodedAudioValidator);
     ATTACH_ELEMENT(iLoggerStreamValidator, new Logger("StreamValidator", *downstream),
                    downstream, elementsSupported, EPipelineSupportElementsLogger);
-    ATTACH_ELEMENT(iStreamValidator, new StreamValidator(*iMsgFactory, *downstream),
+    ATTACH_ELEMENT(iStreamValidator, new ProfiledDownstream<StreamValidator>(ELEMENT_STATS("StreamValidator", false, pushStats), *iMsgFactory, *downstream),
                    downstream, elementsSupported, EPipelineSupportElementsMandatory);
 
     // construct push logger slightly out of sequence
@@ -402,6 +459,9 @@ Pipeline::Pipeline(
     iCodecController = new Codec::CodecController(*iMsgFactory, *upstream, *downstream, aUrlBlockWriter,
                                                   kSongcastFrameJiffies, aInitParams->ThreadPriorityCodec(),
                                                   createLoggers);
+    if (aInitParams->DecodedAudioCacheBytes() > 0) {
+        iCodecController->EnableDecodedAudioCache(aInitParams->DecodedAudioCacheBytes(), *this);
+    }
 
     upstream = iDecodedAudioReservoir;
     ATTACH_ELEMENT(iLoggerDecodedAudioReservoir,
@@ -409,7 +469,7 @@ Pipeline::Pipeline(
                    upstream, elementsSupported, EPipelineSupportElementsLogger);
     ATTACH_ELEMENT(iDecodedAudioValidatorDecodedAudioReservoir, new DecodedAudioValidator(*upstream, "Decoded Audio Reservoir"),
                    upstream, elementsSupported, EPipelineSupportElementsDecodedAudioValidator);
-    ATTACH_ELEMENT(iRamper, new Ramper(*upstream, aInitParams->RampLongJiffies(), aInitParams->RampShortJiffies()),
+    ATTACH_ELEMENT(iRamper, new ProfiledUpstream<Ramper>(ELEMENT_STATS("Ramper", false, pullStats), *upstream, aInitParams->RampLongJiffies(), aInitParams->RampShortJiffies()),
                    upstream, elementsSupported, EPipelineSupportElementsMandatory);
     ATTACH_ELEMENT(iLoggerRamper, new Logger(*iRamper, "Ramper"),
                    upstream, elementsSupported, EPipelineSupportElementsLogger);
@@ -417,7 +477,7 @@ Pipeline::Pipeline(
                    upstream, elementsSupported, EPipelineSupportElementsRampValidator);
     ATTACH_ELEMENT(iDecodedAudioValidatorRamper, new DecodedAudioValidator(*upstream, "Ramper"),
                     upstream, elementsSupported, EPipelineSupportElementsDecodedAudioValidator);
-    ATTACH_ELEMENT(iSeeker, new Seeker(*iMsgFactory, *upstream, *iCodecController, aSeekRestreamer, aInitParams->RampShortJiffies()),
+    ATTACH_ELEMENT(iSeeker, new ProfiledUpstream<Seeker>(ELEMENT_STATS("Seeker", false, pullStats), *iMsgFactory, *upstream, *iCodecController, aSeekRestreamer, aInitParams->RampShortJiffies()),
                    upstream, elementsSupported, EPipelineSupportElementsMandatory);
     ATTACH_ELEMENT(iLoggerSeeker, new Logger(*iSeeker, "Seeker"),
                    upstream, elementsSupported, EPipelineSupportElementsLogger);
@@ -425,14 +485,14 @@ Pipeline::Pipeline(
                    upstream, elementsSupported, EPipelineSupportElementsRampValidator);
     ATTACH_ELEMENT(iDecodedAudioValidatorSeeker, new DecodedAudioValidator(*upstream, "Seeker"),
                    upstream, elementsSupported, EPipelineSupportElementsDecodedAudioValidator);
-    ATTACH_ELEMENT(iDrainer1, new DrainerLeft(*iMsgFactory, *upstream),
+    ATTACH_ELEMENT(iDrainer1, new ProfiledUpstream<DrainerLeft>(ELEMENT_STATS("DrainerLeft", false, pullStats), *iMsgFactory, *upstream),
                    upstream, elementsSupported, EPipelineSupportElementsMandatory);
     ATTACH_ELEMENT(iLoggerDrainer1, new Logger(*iDrainer1, "DrainerLeft"),
                    upstream, elementsSupported, EPipelineSupportElementsLogger);
     ATTACH_ELEMENT(iVariableDelay1,
-                   new VariableDelayLeft(*iMsgFactory, *upstream,
-                                         aInitParams->RampEmergencyJiffies(),
-                                         iInitParams->SenderMinLatency()),
+                   new ProfiledUpstream<VariableDelayLeft>(ELEMENT_STATS("VariableDelay1", false, pullStats), *iMsgFactory, *upstream,
+                                                           aInitParams->RampEmergencyJiffies(),
+                                                           iInitParams->SenderMinLatency()),
                    upstream, elementsSupported, EPipelineSupportElementsMandatory);
     ATTACH_ELEMENT(iLoggerVariableDelay1, new Logger(*iVariableDelay1, "VariableDelay1"),
                    upstream, elementsSupported, EPipelineSupportElementsLogger);
@@ -440,8 +500,8 @@ Pipeline::Pipeline(
                    upstream, elementsSupported, EPipelineSupportElementsRampValidator);
     ATTACH_ELEMENT(iDecodedAudioValidatorDelay1, new DecodedAudioValidator(*upstream, "VariableDelay1"),
                    upstream, elementsSupported, EPipelineSupportElementsDecodedAudioValidator);
-    ATTACH_ELEMENT(iSkipper, new Skipper(*iMsgFactory, *upstream,
-                                         aInitParams->RampLongJiffies(), aInitParams->RampShortJiffies()),
+    ATTACH_ELEMENT(iSkipper, new ProfiledUpstream<Skipper>(ELEMENT_STATS("Skipper", false, pullStats), *iMsgFactory, *upstream,
+                                                           aInitParams->RampLongJiffies(), aInitParams->RampShortJiffies()),
                    upstream, elementsSupported, EPipelineSupportElementsMandatory);
     ATTACH_ELEMENT(iLoggerSkipper, new Logger(*iSkipper, "Skipper"),
                    upstream, elementsSupported, EPipelineSupportElementsLogger);
@@ -449,11 +509,11 @@ Pipeline::Pipeline(
                    upstream, elementsSupported, EPipelineSupportElementsRampValidator);
     ATTACH_ELEMENT(iDecodedAudioValidatorSkipper, new DecodedAudioValidator(*upstream, "Skipper"),
                    upstream, elementsSupported, EPipelineSupportElementsDecodedAudioValidator);
-    ATTACH_ELEMENT(iTrackInspector, new TrackInspector(*upstream),
+    ATTACH_ELEMENT(iTrackInspector, new ProfiledUpstream<TrackInspector>(ELEMENT_STATS("TrackInspector", false, pullStats), *upstream),
                    upstream, elementsSupported, EPipelineSupportElementsMandatory);
     ATTACH_ELEMENT(iLoggerTrackInspector, new Logger(*iTrackInspector, "TrackInspector"),
                    upstream, elementsSupported, EPipelineSupportElementsLogger);
-    ATTACH_ELEMENT(iWaiter, new Waiter(*iMsgFactory, *upstream, *this, *iEventThread, aInitParams->RampShortJiffies()),
+    ATTACH_ELEMENT(iWaiter, new ProfiledUpstream<Waiter>(ELEMENT_STATS("Waiter", false, pullStats), *iMsgFactory, *upstream, *this, *iEventThread, aInitParams->RampShortJiffies()),
                    upstream, elementsSupported, EPipelineSupportElementsMandatory);
     ATTACH_ELEMENT(iLoggerWaiter, new Logger(*iWaiter, "Waiter"),
                    upstream, elementsSupported, EPipelineSupportElementsLogger);
@@ -461,8 +521,9 @@ Pipeline::Pipeline(
                    upstream, elementsSupported, EPipelineSupportElementsRampValidator);
     ATTACH_ELEMENT(iDecodedAudioValidatorWaiter, new DecodedAudioValidator(*upstream, "Waiter"),
                    upstream, elementsSupported, EPipelineSupportElementsDecodedAudioValidator);
-    ATTACH_ELEMENT(iStopper, new Stopper(*iMsgFactory, *upstream, *this, *iEventThread,
-                                         aInitParams->RampLongJiffies(), aInitParams->RampShortJiffies()),
+    ATTACH_ELEMENT(iStopper, new ProfiledUpstream<Stopper>(ELEMENT_STATS("Stopper", false, pullStats), *iMsgFactory, *upstream,
+                                                           static_cast<IStopperObserver&>(*this), *iEventThread,
+                                                           aInitParams->RampLongJiffies(), aInitParams->RampShortJiffies()),
                    upstream, elementsSupported, EPipelineSupportElementsMandatory);
     iStopper->SetStreamPlayObserver(aStreamPlayObserver);
     ATTACH_ELEMENT(iLoggerStopper, new Logger(*iStopper, "Stopper"),
@@ -471,38 +532,38 @@ Pipeline::Pipeline(
                    upstream, elementsSupported, EPipelineSupportElementsRampValidator);
     ATTACH_ELEMENT(iDecodedAudioValidatorStopper, new DecodedAudioValidator(*upstream, "Stopper"),
                    upstream, elementsSupported, EPipelineSupportElementsDecodedAudioValidator);
-    ATTACH_ELEMENT(iAsyncTrackObserver, new Media::AsyncTrackObserver(*upstream, *iMsgFactory, aTrackFactory),
+    ATTACH_ELEMENT(iAsyncTrackObserver, new ProfiledUpstream<Media::AsyncTrackObserver>(ELEMENT_STATS("AsyncTrackObserver", false, pullStats), *upstream, *iMsgFactory, aTrackFactory),
                    upstream, elementsSupported, EPipelineSupportElementsMandatory);
     ATTACH_ELEMENT(iLoggerTrackReporter, new Logger(*iAsyncTrackObserver, "AsyncTrackObserver"),
                    upstream, elementsSupported, EPipelineSupportElementsLogger);
-    ATTACH_ELEMENT(iAirplayReporter, new Media::AirplayReporter(*upstream, *iMsgFactory, aTrackFactory),
+    ATTACH_ELEMENT(iAirplayReporter, new ProfiledUpstream<Media::AirplayReporter>(ELEMENT_STATS("AirplayReporter", false, pullStats), *upstream, *iMsgFactory, aTrackFactory),
                    upstream, elementsSupported, EPipelineSupportElementsMandatory);
-    ATTACH_ELEMENT(iSpotifyReporter, new Media::SpotifyReporter(*upstream, *iMsgFactory, aTrackFactory),
+    ATTACH_ELEMENT(iSpotifyReporter, new ProfiledUpstream<Media::SpotifyReporter>(ELEMENT_STATS("SpotifyReporter", false, pullStats), *upstream, *iMsgFactory, aTrackFactory),
                    upstream, elementsSupported, EPipelineSupportElementsMandatory);
     ATTACH_ELEMENT(iLoggerSpotifyReporter, new Logger(*iSpotifyReporter, "SpotifyReporter"),
                    upstream, elementsSupported, EPipelineSupportElementsLogger);
-    ATTACH_ELEMENT(iReporter, new Reporter(*upstream, aObserver, *iEventThread),
+    ATTACH_ELEMENT(iReporter, new ProfiledUpstream<Reporter>(ELEMENT_STATS("Reporter", false, pullStats), *upstream, aObserver, *iEventThread),
                    upstream, elementsSupported, EPipelineSupportElementsMandatory);
     ATTACH_ELEMENT(iLoggerReporter, new Logger(*iReporter, "Reporter"),
                    upstream, elementsSupported, EPipelineSupportElementsLogger);
-    ATTACH_ELEMENT(iRouter, new Router(*upstream),
+    ATTACH_ELEMENT(iRouter, new ProfiledUpstream<Router>(ELEMENT_STATS("Router", false, pullStats), *upstream),
                    upstream, elementsSupported, EPipelineSupportElementsMandatory);
     ATTACH_ELEMENT(iLoggerRouter, new Logger(*iRouter, "Router"),
                    upstream, elementsSupported, EPipelineSupportElementsLogger);
-    ATTACH_ELEMENT(iAttenuator, new Attenuator(*upstream),
+    ATTACH_ELEMENT(iAttenuator, new ProfiledUpstream<Attenuator>(ELEMENT_STATS("Attenuator", false, pullStats), *upstream),
                    upstream, elementsSupported, EPipelineSupportElementsMandatory);
     ATTACH_ELEMENT(iLoggerAttenuator, new Logger(*iAttenuator, "Attenuator"),
                    upstream, elementsSupported, EPipelineSupportElementsLogger);
     ATTACH_ELEMENT(iDecodedAudioValidatorRouter, new DecodedAudioValidator(*upstream, "Router"),
                    upstream, elementsSupported, EPipelineSupportElementsDecodedAudioValidator);
-    ATTACH_ELEMENT(iDrainer2, new DrainerRight(*iMsgFactory, *upstream),
+    ATTACH_ELEMENT(iDrainer2, new ProfiledUpstream<DrainerRight>(ELEMENT_STATS("DrainerRight", false, pullStats), *iMsgFactory, *upstream),
                    upstream, elementsSupported, EPipelineSupportElementsMandatory);
     ATTACH_ELEMENT(iLoggerDrainer2, new Logger(*iDrainer2, "DrainerRight"),
                    upstream, elementsSupported, EPipelineSupportElementsLogger);
     ATTACH_ELEMENT(iVariableDelay2,
-                   new VariableDelayRight(*iMsgFactory, *upstream,
-                                          aInitParams->RampEmergencyJiffies(),
-                                          aInitParams->StarvationRamperMinJiffies()),
+                   new ProfiledUpstream<VariableDelayRight>(ELEMENT_STATS("VariableDelay2", false, pullStats), *iMsgFactory, *upstream,
+                                                            aInitParams->RampEmergencyJiffies(),
+                                                            aInitParams->StarvationRamperMinJiffies()),
                    upstream, elementsSupported, EPipelineSupportElementsMandatory);
     iVariableDelay1->SetObserver(*iVariableDelay2);
     ATTACH_ELEMENT(iLoggerVariableDelay2, new Logger(*iVariableDelay2, "VariableDelay2"),
@@ -512,10 +573,11 @@ Pipeline::Pipeline(
     ATTACH_ELEMENT(iDecodedAudioValidatorDelay2, new DecodedAudioValidator(*upstream, "VariableDelay2"),
                    upstream, elementsSupported, EPipelineSupportElementsDecodedAudioValidator);
     ATTACH_ELEMENT(iStarvationRamper,
-                   new StarvationRamper(*iMsgFactory, *upstream, *this, *iEventThread,
-                                        aInitParams->StarvationRamperMinJiffies(),
-                                        aInitParams->ThreadPriorityStarvationRamper(),
-                                        aInitParams->RampShortJiffies(), aInitParams->MaxStreamsPerReservoir()),
+                   new ProfiledUpstream<StarvationRamper>(ELEMENT_STATS("StarvationRamper", true, pullStats), *iMsgFactory, *upstream,
+                                                          static_cast<IStarvationRamperObserver&>(*this), *iEventThread,
+                                                          aInitParams->StarvationRamperMinJiffies(),
+                                                          aInitParams->ThreadPriorityStarvationRamper(),
+                                                          aInitParams->RampShortJiffies(), aInitParams->MaxStreamsPerReservoir()),
                                         upstream, elementsSupported, EPipelineSupportElementsMandatory);
     ATTACH_ELEMENT(iLoggerStarvationRamper, new Logger(*iStarvationRamper, "StarvationRamper"),
                    upstream, elementsSupported, EPipelineSupportElementsLogger);
@@ -524,10 +586,10 @@ Pipeline::Pipeline(
     ATTACH_ELEMENT(iDecodedAudioValidatorStarvationRamper,
                    new DecodedAudioValidator(*upstream, "StarvationRamper"),
                    upstream, elementsSupported, EPipelineSupportElementsDecodedAudioValidator);
-    ATTACH_ELEMENT(iPhaseAdjuster, new PhaseAdjuster(*iMsgFactory, *upstream, *iStarvationRamper,
-        aInitParams->RampLongJiffies(),
-        aInitParams->RampShortJiffies(),
-        aInitParams->StarvationRamperMinJiffies()),
+    ATTACH_ELEMENT(iPhaseAdjuster, new ProfiledUpstream<PhaseAdjuster>(ELEMENT_STATS("PhaseAdjuster", false, pullStats), *iMsgFactory, *upstream, *iStarvationRamper,
+                                                                       aInitParams->RampLongJiffies(),
+                                                                       aInitParams->RampShortJiffies(),
+                                                                       aInitParams->StarvationRamperMinJiffies()),
         upstream, elementsSupported, EPipelineSupportElementsMandatory);
     ATTACH_ELEMENT(iLoggerPhaseAdjuster, new Logger(*iPhaseAdjuster, "PhaseAdjuster"),
         upstream, elementsSupported, EPipelineSupportElementsLogger);
@@ -537,7 +599,7 @@ Pipeline::Pipeline(
         new DecodedAudioValidator(*upstream, "PhaseAdjuster"),
         upstream, elementsSupported, EPipelineSupportElementsDecodedAudioValidator);
     if (aAudioTime.Ok()) {
-        ATTACH_ELEMENT(iStarterTimed, new StarterTimed(*iMsgFactory, *upstream, aAudioTime.Unwrap()),
+        ATTACH_ELEMENT(iStarterTimed, new ProfiledUpstream<StarterTimed>(ELEMENT_STATS("StarterTimed", false, pullStats), *iMsgFactory, *upstream, aAudioTime.Unwrap()),
                        upstream, elementsSupported, EPipelineSupportElementsMandatory);
         ATTACH_ELEMENT(iLoggerStarterTimed, new Logger(*iStarterTimed, "StarterTimed"),
                        upstream, elementsSupported, EPipelineSupportElementsLogger);
@@ -548,7 +610,7 @@ Pipeline::Pipeline(
     }
     IMute* muter = nullptr;
     if (aInitParams->Muter() == PipelineInitParams::MuterImpl::eRampSamples) {
-        ATTACH_ELEMENT(iMuterSamples, new Muter(*iMsgFactory, *upstream, aInitParams->RampLongJiffies()),
+        ATTACH_ELEMENT(iMuterSamples, new ProfiledUpstream<Muter>(ELEMENT_STATS("Muter", false, pullStats), *iMsgFactory, *upstream, aInitParams->RampLongJiffies()),
                        upstream, elementsSupported, EPipelineSupportElementsMandatory);
         muter = iMuterSamples;
         iMuterVolume = nullptr;
@@ -556,7 +618,7 @@ Pipeline::Pipeline(
                        upstream, elementsSupported, EPipelineSupportElementsLogger);
     }
     else {
-        ATTACH_ELEMENT(iMuterVolume, new MuterVolume(*iMsgFactory, *upstream),
+        ATTACH_ELEMENT(iMuterVolume, new ProfiledUpstream<MuterVolume>(ELEMENT_STATS("Muter", false, pullStats), *iMsgFactory, *upstream),
                        upstream, elementsSupported, EPipelineSupportElementsMandatory);
         muter = iMuterVolume;
         iMuterSamples = nullptr;
@@ -565,22 +627,20 @@ Pipeline::Pipeline(
     }
     ATTACH_ELEMENT(iDecodedAudioValidatorMuter, new DecodedAudioValidator(*upstream, "Muter"),
                    upstream, elementsSupported, EPipelineSupportElementsDecodedAudioValidator | EPipelineSupportElementsValidatorMinimal);
-    ATTACH_ELEMENT(iVolumeRamper, new VolumeRamper(*iMsgFactory, *upstream),
+    ATTACH_ELEMENT(iVolumeRamper, new ProfiledUpstream<VolumeRamper>(ELEMENT_STATS("VolumeRamper", false, pullStats), *iMsgFactory, *upstream),
                    upstream, elementsSupported, EPipelineSupportElementsMandatory);
     ATTACH_ELEMENT(iLoggerVolumeRamper, new Logger(*iVolumeRamper, "VolumeRamper"),
                    upstream, elementsSupported, EPipelineSupportElementsLogger);
-    ATTACH_ELEMENT(iPreDriver, new PreDriver(*upstream),
+    ATTACH_ELEMENT(iPreDriver, new ProfiledUpstream<PreDriver>(ELEMENT_STATS("PreDriver", false, pullStats), *upstream),
                    upstream, elementsSupported, EPipelineSupportElementsMandatory);
-    iLoggerPreDriver = new Logger(*iPreDriver, "PreDriver");
+    ATTACH_ELEMENT(iLoggerPreDriver, new Logger(*iPreDriver, "PreDriver"),
+                   upstream, elementsSupported, EPipelineSupportElementsLogger);
 
 #ifdef _WIN32
 # pragma warning( pop )
 #endif // _WIN32
 
-    iPipelineEnd = iLoggerPreDriver;
-    if (iPipelineEnd == nullptr) {
-        iPipelineEnd = iPreDriver;
-    }
+    iPipelineEnd = upstream;
     iMuteCounted = new MuteCounted(*muter);
 
     gPipeline = this;
@@ -613,9 +673,12 @@ Pipeline::Pipeline(
     //iLoggerVolumeRamper->SetEnabled(true);
 
     // A logger that is enabled will block waiting for MsgQuit in its dtor
-    // ~Pipeline (below) relies on this to synchronise its destruction
+    // ~Pipeline (below) relies on this (or iPreDriver's dtor, if loggers aren't
+    // supported) to synchronise its destruction
     // i.e. NEVER DISABLE THIS LOGGER
-    iLoggerPreDriver->SetEnabled(true);
+    if (iLoggerPreDriver != nullptr) {
+        iLoggerPreDriver->SetEnabled(true);
+    }
 
     //iLoggerEncodedAudioReservoir->SetFilter(Logger::EMsgAll);
     //iLoggerContainer->SetFilter(Logger::EMsgAll);
@@ -730,12 +793,14 @@ Pipeline::~Pipeline()
     delete iDecodedAudioValidatorCodec;
     delete iRampValidatorCodec;
     delete iLoggerCodecController;
+    delete iCodecLookahead;
     delete iLoggerContainer;
     delete iContainer;
     delete iAudioDumper;
     delete iLoggerEncodedAudioReservoir;
     delete iEncodedAudioReservoir;
     delete iEventThread;
+    delete iProfile;
     delete iMsgFactory;
     delete iInitParams;
 }
@@ -756,6 +821,9 @@ void Pipeline::Start(IVolumeRamper& aVolumeRamper, IVolumeMuterStepped& aVolumeM
     if (iMuterVolume != nullptr) {
         iMuterVolume->Start(aVolumeMuter);
     }
+    if (iCodecLookahead != nullptr) {
+        iCodecLookahead->Start();
+    }
     iCodecController->Start();
     iEventThread->Start();
 }
@@ -975,6 +1043,11 @@ static void LogComponentAudioThroughput(Logger* aLogger) {
 }
 #endif // PIPELINE_LOG_AUDIO_THROUGHPUT
 
+IPipelineProfile& Pipeline::Profile()
+{
+    return *iProfile;
+}
+
 void Pipeline::LogBuffers() const
 {
     const TUint encodedBytes = iEncodedAudioReservoir->SizeInBytes();
@@ -1061,8 +1134,9 @@ void Pipeline::PipelinePlaying()
 
 TUint Pipeline::NextFlushId()
 {
-    /* non-use of iLock is deliberate.  It isn't absolutely required since all callers
-       run in the Filler thread.  If we re-instate the lock, the call to
+    /* non-use of iLock is deliberate.  Most callers run in the Filler thread but
+       DecodedAudioReservoir and CodecController (when seeking within cached audio) don't
+       so iNextFlushId is atomic instead.  If we re-instate the lock, the call to
        RemoveCurrentStream() in Stop() will need to move outside its lock. */
     TUint id = iNextFlushId++;
     return id;
@@ -1101,6 +1175,11 @@ void Pipeline::SetAttenuation(TUint aAttenuation)
     iAttenuator->SetAttenuation(aAttenuation);
 }
 
+void Pipeline::SetAttenuation(const Brx& aMode, TUint aAttenuation)
+{
+    iAttenuator->SetAttenuation(aMode, aAttenuation);
+}
+
 void Pipeline::DrainAllAudio()
 {
     iStarvationRamper->DrainAllAudio();
@@ -13,6 +13,8 @@
 #include <OpenHome/Media/MuteManager.h>
 #include <OpenHome/Media/Pipeline/Attenuator.h>
 
+#include <atomic>
+
 EXCEPTION(PipelineStreamNotPausable)
 
 namespace OpenHome {
@@ -29,6 +31,22 @@ enum EPipelineSupportElements {
     EPipelineSupportElementsAll                   = 0x7fffffff
 };
 
+/*
+Loggers and validators are debugging aids.  Release builds compile them out of the pipeline
+entirely, ignoring any request for them via PipelineInitParams::SetSupportElements, unless
+they define PIPELINE_DEBUG_ELEMENTS (waf configure --pipeline-debug-elements).  CI builds
+other than publish define it so tests keep running with validators.
+*/
+#if defined(DEFINE_DEBUG) || defined(PIPELINE_DEBUG_ELEMENTS)
+static const TUint kPipelineSupportElementsDebug = 0;
+#else
+static const TUint kPipelineSupportElementsDebug = EPipelineSupportElementsLogger
+                                                 | EPipelineSupportElementsDecodedAudioValidator
+                                                 | EPipelineSupportElementsRampValidator
+                                                 | EPipelineSupportElementsValidatorMinimal;
+#endif
+static const TUint kPipelineSupportElementsBuild = EPipelineSupportElementsAll & ~kPipelineSupportElementsDebug;
+
 class PipelineInitParams
 {
 public:
@@ -56,6 +74,15 @@ public:
     void SetSupportElements(TUint aElements); // EPipelineSupportElements members OR'd together
     void SetMuter(MuterImpl aMuter);
     void SetDsdMaxSampleRate(TUint aMaxSampleRate);
+    /*
+     * Byte order of pcm within the pipeline.  Should match the order the driver's IPcmProcessor
+     * reports from Endian(); audio is swapped on output otherwise.  Little endian only avoids
+     * swaps for platform drivers that override Endian() - Songcast, the only driver in this tree,
+     * sends big endian.
+     */
+    void SetDecodedAudioEndian(AudioDataEndian aEndian);
+    void SetCodecLookahead(TUint aEncodedMsgs); // encoded msgs queued ahead of the codec by a second thread.  0 (default) disables
+    void SetDecodedAudioCache(TUint aBytes); // recently decoded pcm held for instant short seeks backwards and repeats.  0 (default) disables
     // getters
     TUint EncodedReservoirBytes() const;
     TUint DecodedReservoirJiffies() const;
@@ -73,6 +100,9 @@ public:
     TUint SupportElements() const;
     MuterImpl Muter() const;
     TUint DsdMaxSampleRate() const;
+    AudioDataEndian DecodedAudioEndian() const;
+    TUint CodecLookaheadMsgs() const;
+    TUint DecodedAudioCacheBytes() const;
 private:
     PipelineInitParams();
 private:
@@ -92,6 +122,9 @@ private:
     TUint iSupportElements;
     MuterImpl iMuter;
     TUint iDsdMaxSampleRate;
+    AudioDataEndian iDecodedAudioEndian;
+    TUint iCodecLookaheadMsgs;
+    TUint iDecodedAudioCacheBytes;
 private:
     static const TUint kEncodedReservoirSizeBytes       = 1536 * 1024;
     static const TUint kDecodedReservoirSize            = Jiffies::kPerMs * 2000;
@@ -106,6 +139,9 @@ private:
     static const TUint kMaxLatencyDefault               = Jiffies::kPerMs * 2000;
     static const MuterImpl kMuterDefault                = MuterImpl::eRampSamples;
     static const TUint kDsdMaxSampleRateDefault         = 0;
+    static const AudioDataEndian kDecodedAudioEndianDefault = AudioDataEndian::Big;
+    static const TUint kCodecLookaheadMsgsDefault       = 0;
+    static const TUint kDecodedAudioCacheBytesDefault   = 0;
 };
 
 namespace Codec {
@@ -118,6 +154,9 @@ class PipelineElementObserverThread;
 class AudioDumper;
 class EncodedAudioReservoir;
 class Logger;
+class CodecLookahead;
+class PipelineProfile;
+class IPipelineProfile;
 class DecodedAudioValidator;
 class StreamValidator;
 class DecodedAudioAggregator;
@@ -222,6 +261,7 @@ public:
     void GetThreadPriorities(TUint& aFlywheelRamper, TUint& aStarvationRamper, TUint& aCodec, TUint& aEvent);
     void GetMaxSupportedSampleRates(TUint& aPcm, TUint& aDsd) const;
     void LogBuffers() const;
+    IPipelineProfile& Profile();
 public: // from IPipelineElementDownstream
     void Push(Msg* aMsg) override;
 public: // from IPipeline
@@ -240,6 +280,7 @@ public: // from IPostPipelineLatencyObserver
     void PostPipelineLatencyChanged() override;
 public: // from IAttenuator
     void SetAttenuation(TUint aAttenuation) override;
+    void SetAttenuation(const Brx& aMode, TUint aAttenuation) override;
 public: // from IPipelineDrainer
     void DrainAllAudio() override;
 public: // from IStarterTimed
@@ -271,6 +312,7 @@ private:
     Logger* iLoggerEncodedAudioReservoir;
     Codec::ContainerController* iContainer;
     Logger* iLoggerContainer;
+    CodecLookahead* iCodecLookahead;
     Codec::CodecController* iCodecController;
     Logger* iLoggerCodecController;
     RampValidator* iRampValidatorCodec;
@@ -351,13 +393,14 @@ private:
     Logger* iLoggerPreDriver;
     IPipelineElementDownstream* iPipelineStart;
     IPipelineElementUpstream* iPipelineEnd;
+    PipelineProfile* iProfile;
     IMute* iMuteCounted;
     EStatus iState;
     EPipelineState iLastReportedState;
     TBool iBuffering;
     TBool iWaiting;
     TBool iQuitting;
-    TUint iNextFlushId;
+    std::atomic<TUint> iNextFlushId;
     TUint iMaxSampleRatePcm;
     TUint iMaxSampleRateDsd;
 };
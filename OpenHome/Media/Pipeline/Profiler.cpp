@@ -0,0 +1,343 @@
+#include <OpenHome/Media/Pipeline/Profiler.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/OsWrapper.h>
+#include <OpenHome/Private/Env.h>
+#include <OpenHome/Net/Private/Globals.h>
+
+using namespace OpenHome;
+using namespace OpenHome::Media;
+
+// PipelineElementStats
+
+PipelineElementStats::PipelineElementStats(const TChar* aId, const PipelineElementStats* aInner)
+    : iId(aId)
+    , iInner(aInner)
+    , iOsCtx(gEnv->OsCtx())
+{
+    Reset();
+}
+
+const TChar* PipelineElementStats::Id() const
+{
+    return iId;
+}
+
+TUint64 PipelineElementStats::Calls() const
+{
+    return iCalls.load(std::memory_order_relaxed);
+}
+
+TUint64 PipelineElementStats::TimeUs() const
+{
+    return iTimeUs.load(std::memory_order_relaxed);
+}
+
+TUint64 PipelineElementStats::SelfTimeUs() const
+{
+    TUint64 us = iTimeUs.load(std::memory_order_relaxed);
+    if (iInner != nullptr) {
+        const TUint64 innerUs = iInner->iTimeUs.load(std::memory_order_relaxed);
+        // counters are read at slightly different times so may be momentarily inconsistent
+        us = (innerUs < us? us - innerUs : 0);
+    }
+    return us;
+}
+
+TBool PipelineElementStats::HasSelfTime() const
+{
+    return iInner != nullptr;
+}
+
+TUint64 PipelineElementStats::TimeMaxUs() const
+{
+    return iTimeMaxUs.load(std::memory_order_relaxed);
+}
+
+TUint64 PipelineElementStats::Jiffies() const
+{
+    return iJiffies.load(std::memory_order_relaxed);
+}
+
+TUint64 PipelineElementStats::MsgCount(EMsgType aType) const
+{
+    ASSERT(aType < EMsgTypeCount);
+    return iMsgCounts[aType].load(std::memory_order_relaxed);
+}
+
+void PipelineElementStats::Report(IWriter& aWriter) const
+{
+    // Note that values reported may be slightly out of date as the pipeline may be running
+    WriterAscii writer(aWriter);
+    writer.Write(Brn("Element: "));
+    writer.Write(Brn(iId));
+    writer.Write(Brn(", calls:"));
+    writer.WriteUint64(Calls());
+    writer.Write(Brn(", total:"));
+    writer.WriteUint64(TimeUs());
+    writer.Write(Brn("us, self:"));
+    if (!HasSelfTime()) {
+        writer.Write(Brn("-"));
+    }
+    else {
+        writer.WriteUint64(SelfTimeUs());
+        writer.Write(Brn("us"));
+    }
+    writer.Write(Brn(", max:"));
+    writer.WriteUint64(TimeMaxUs());
+    writer.Write(Brn("us, jiffies:"));
+    writer.WriteUint64(Jiffies());
+    writer.Write(Brn(", msgs:"));
+    for (TUint i=0; i<EMsgTypeCount; i++) {
+        const TUint64 count = MsgCount((EMsgType)i);
+        if (count > 0) {
+            writer.Write(' ');
+            writer.Write(Brn(MsgTypeName((EMsgType)i)));
+            writer.Write('=');
+            writer.WriteUint64(count);
+        }
+    }
+    aWriter.Write(Brn("\n"));
+}
+
+void PipelineElementStats::Reset()
+{
+    iCalls.store(0);
+    iTimeUs.store(0);
+    iTimeMaxUs.store(0);
+    iJiffies.store(0);
+    for (TUint i=0; i<EMsgTypeCount; i++) {
+        iMsgCounts[i].store(0);
+    }
+}
+
+const TChar* PipelineElementStats::MsgTypeName(EMsgType aType)
+{ // static
+    static const TChar* kNames[EMsgTypeCount] = {
+        "Mode", "Track", "Drain", "Delay", "EncodedStream", "StreamSegment", "AudioEncoded",
+        "MetaText", "StreamInterrupted", "Halt", "Flush", "Wait", "DecodedStream",
+        "AudioPcm", "AudioDsd", "Silence", "Playable", "Quit"
+    };
+    ASSERT(aType < EMsgTypeCount);
+    return kNames[aType];
+}
+
+TUint64 PipelineElementStats::Now() const
+{
+    return Os::TimeInUs(iOsCtx);
+}
+
+Msg* PipelineElementStats::Pulled(Msg* aMsg, TUint64 aStartUs)
+{
+    AddTime(aStartUs);
+    if (aMsg != nullptr) {
+        aMsg = aMsg->Process(*this);
+    }
+    return aMsg;
+}
+
+void PipelineElementStats::Pushing(Msg* aMsg)
+{
+    (void)aMsg->Process(*this);
+}
+
+void PipelineElementStats::Pushed(TUint64 aStartUs)
+{
+    AddTime(aStartUs);
+}
+
+inline void PipelineElementStats::Increment(std::atomic<TUint64>& aCounter, TUint64 aValue)
+{
+    // Only the thread calling the element writes counters so a locked read-modify-write isn't required.
+    // Reset() may race with this but will only lose a single update.
+    aCounter.store(aCounter.load(std::memory_order_relaxed) + aValue, std::memory_order_relaxed);
+}
+
+inline void PipelineElementStats::AddTime(TUint64 aStartUs)
+{
+    const TUint64 us = Os::TimeInUs(iOsCtx) - aStartUs;
+    Increment(iCalls, 1);
+    Increment(iTimeUs, us);
+    if (us > iTimeMaxUs.load(std::memory_order_relaxed)) {
+        iTimeMaxUs.store(us, std::memory_order_relaxed);
+    }
+}
+
+inline void PipelineElementStats::CountMsg(EMsgType aType)
+{
+    Increment(iMsgCounts[aType], 1);
+}
+
+inline void PipelineElementStats::CountAudio(EMsgType aType, TUint aJiffies)
+{
+    Increment(iMsgCounts[aType], 1);
+    Increment(iJiffies, aJiffies);
+}
+
+Msg* PipelineElementStats::ProcessMsg(MsgMode* aMsg)
+{
+    CountMsg(EMsgMode);
+    return aMsg;
+}
+
+Msg* PipelineElementStats::ProcessMsg(MsgTrack* aMsg)
+{
+    CountMsg(EMsgTrack);
+    return aMsg;
+}
+
+Msg* PipelineElementStats::ProcessMsg(MsgDrain* aMsg)
+{
+    CountMsg(EMsgDrain);
+    return aMsg;
+}
+
+Msg* PipelineElementStats::ProcessMsg(MsgDelay* aMsg)
+{
+    CountMsg(EMsgDelay);
+    return aMsg;
+}
+
+Msg* PipelineElementStats::ProcessMsg(MsgEncodedStream* aMsg)
+{
+    CountMsg(EMsgEncodedStream);
+    return aMsg;
+}
+
+Msg* PipelineElementStats::ProcessMsg(MsgStreamSegment* aMsg)
+{
+    CountMsg(EMsgStreamSegment);
+    return aMsg;
+}
+
+Msg* PipelineElementStats::ProcessMsg(MsgAudioEncoded* aMsg)
+{
+    CountMsg(EMsgAudioEncoded);
+    return aMsg;
+}
+
+Msg* PipelineElementStats::ProcessMsg(MsgMetaText* aMsg)
+{
+    CountMsg(EMsgMetaText);
+    return aMsg;
+}
+
+Msg* PipelineElementStats::ProcessMsg(MsgStreamInterrupted* aMsg)
+{
+    CountMsg(EMsgStreamInterrupted);
+    return aMsg;
+}
+
+Msg* PipelineElementStats::ProcessMsg(MsgHalt* aMsg)
+{
+    CountMsg(EMsgHalt);
+    return aMsg;
+}
+
+Msg* PipelineElementStats::ProcessMsg(MsgFlush* aMsg)
+{
+    CountMsg(EMsgFlush);
+    return aMsg;
+}
+
+Msg* PipelineElementStats::ProcessMsg(MsgWait* aMsg)
+{
+    CountMsg(EMsgWait);
+    return aMsg;
+}
+
+Msg* PipelineElementStats::ProcessMsg(MsgDecodedStream* aMsg)
+{
+    CountMsg(EMsgDecodedStream);
+    return aMsg;
+}
+
+Msg* PipelineElementStats::ProcessMsg(MsgAudioPcm* aMsg)
+{
+    CountAudio(EMsgAudioPcm, aMsg->Jiffies());
+    return aMsg;
+}
+
+Msg* PipelineElementStats::ProcessMsg(MsgAudioDsd* aMsg)
+{
+    CountAudio(EMsgAudioDsd, aMsg->Jiffies());
+    return aMsg;
+}
+
+Msg* PipelineElementStats::ProcessMsg(MsgSilence* aMsg)
+{
+    CountAudio(EMsgSilence, aMsg->Jiffies());
+    return aMsg;
+}
+
+Msg* PipelineElementStats::ProcessMsg(MsgPlayable* aMsg)
+{
+    CountAudio(EMsgPlayable, aMsg->Jiffies());
+    return aMsg;
+}
+
+Msg* PipelineElementStats::ProcessMsg(MsgQuit* aMsg)
+{
+    CountMsg(EMsgQuit);
+    return aMsg;
+}
+
+
+// PipelineProfile
+
+const Brn PipelineProfile::kQueryPipeline("pipeline");
+
+PipelineProfile::PipelineProfile(IInfoAggregator& aInfoAggregator)
+{
+    std::vector<Brn> infoQueries;
+    infoQueries.push_back(kQueryPipeline);
+    aInfoAggregator.Register(*this, infoQueries);
+}
+
+PipelineProfile::~PipelineProfile()
+{
+    for (auto stats : iElements) {
+        delete stats;
+    }
+}
+
+PipelineElementStats& PipelineProfile::Add(const TChar* aId, const PipelineElementStats* aInner)
+{
+    auto stats = new PipelineElementStats(aId, aInner);
+    iElements.push_back(stats);
+    return *stats;
+}
+
+void PipelineProfile::Report(IWriter& aWriter)
+{
+    for (auto stats : iElements) {
+        stats->Report(aWriter);
+    }
+}
+
+void PipelineProfile::Reset()
+{
+    for (auto stats : iElements) {
+        stats->Reset();
+    }
+}
+
+TUint PipelineProfile::ElementCount() const
+{
+    return (TUint)iElements.size();
+}
+
+const PipelineElementStats& PipelineProfile::ElementAt(TUint aIndex) const
+{
+    ASSERT(aIndex < iElements.size());
+    return *iElements[aIndex];
+}
+
+void PipelineProfile::QueryInfo(const Brx& aQuery, IWriter& aWriter)
+{
+    if (aQuery == kQueryPipeline) {
+        Report(aWriter);
+    }
+}
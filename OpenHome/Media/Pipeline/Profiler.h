@@ -0,0 +1,193 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Standard.h>
+#include <OpenHome/Private/Env.h>
+#include <OpenHome/Private/InfoProvider.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+
+#include <atomic>
+#include <utility>
+#include <vector>
+
+namespace OpenHome {
+class IWriter;
+namespace Media {
+
+/*
+Counters for a single pipeline element: msgs passing through (by type), jiffies and the time
+spent in the element's Pull() or Push().
+Counters are only updated by the thread that calls the element but may be read from any thread.
+Updating them costs two clock reads and a Process() call per msg so they are always enabled.
+*/
+
+class PipelineElementStats : private IMsgProcessor, private INonCopyable
+{
+public:
+    enum EMsgType
+    {
+        EMsgMode
+       ,EMsgTrack
+       ,EMsgDrain
+       ,EMsgDelay
+       ,EMsgEncodedStream
+       ,EMsgStreamSegment
+       ,EMsgAudioEncoded
+       ,EMsgMetaText
+       ,EMsgStreamInterrupted
+       ,EMsgHalt
+       ,EMsgFlush
+       ,EMsgWait
+       ,EMsgDecodedStream
+       ,EMsgAudioPcm
+       ,EMsgAudioDsd
+       ,EMsgSilence
+       ,EMsgPlayable
+       ,EMsgQuit
+       ,EMsgTypeCount
+    };
+public:
+    // aInner is the nearest measured element which runs in the same thread and whose time is
+    // included in this element's (its upstream for Pull(), its downstream for Push()).
+    // Time spent there is subtracted from this element's time when reporting its self time.
+    // Pass nullptr if this element's time includes waits for another thread (e.g. a reservoir).
+    PipelineElementStats(const TChar* aId, const PipelineElementStats* aInner);
+    const TChar* Id() const;
+    TUint64 Calls() const;
+    TUint64 TimeUs() const;     // inclusive of aInner
+    TUint64 SelfTimeUs() const; // TimeUs, less time spent in aInner
+    TBool HasSelfTime() const;  // false if constructed with no aInner; TimeUs then includes waits for other threads
+    TUint64 TimeMaxUs() const;
+    TUint64 Jiffies() const;
+    TUint64 MsgCount(EMsgType aType) const;
+    void Report(IWriter& aWriter) const;
+    void Reset();
+    static const TChar* MsgTypeName(EMsgType aType);
+public: // for use by ProfiledUpstream/ProfiledDownstream
+    TUint64 Now() const;
+    Msg* Pulled(Msg* aMsg, TUint64 aStartUs);
+    void Pushing(Msg* aMsg);
+    void Pushed(TUint64 aStartUs);
+private:
+    inline void Increment(std::atomic<TUint64>& aCounter, TUint64 aValue);
+    inline void AddTime(TUint64 aStartUs);
+    inline void CountMsg(EMsgType aType);
+    inline void CountAudio(EMsgType aType, TUint aJiffies);
+private: // IMsgProcessor
+    Msg* ProcessMsg(MsgMode* aMsg) override;
+    Msg* ProcessMsg(MsgTrack* aMsg) override;
+    Msg* ProcessMsg(MsgDrain* aMsg) override;
+    Msg* ProcessMsg(MsgDelay* aMsg) override;
+    Msg* ProcessMsg(MsgEncodedStream* aMsg) override;
+    Msg* ProcessMsg(MsgStreamSegment* aMsg) override;
+    Msg* ProcessMsg(MsgAudioEncoded* aMsg) override;
+    Msg* ProcessMsg(MsgMetaText* aMsg) override;
+    Msg* ProcessMsg(MsgStreamInterrupted* aMsg) override;
+    Msg* ProcessMsg(MsgHalt* aMsg) override;
+    Msg* ProcessMsg(MsgFlush* aMsg) override;
+    Msg* ProcessMsg(MsgWait* aMsg) override;
+    Msg* ProcessMsg(MsgDecodedStream* aMsg) override;
+    Msg* ProcessMsg(MsgAudioPcm* aMsg) override;
+    Msg* ProcessMsg(MsgAudioDsd* aMsg) override;
+    Msg* ProcessMsg(MsgSilence* aMsg) override;
+    Msg* ProcessMsg(MsgPlayable* aMsg) override;
+    Msg* ProcessMsg(MsgQuit* aMsg) override;
+private:
+    const TChar* iId;
+    const PipelineElementStats* iInner;
+    OsContext* iOsCtx;
+    std::atomic<TUint64> iCalls;
+    std::atomic<TUint64> iTimeUs;
+    std::atomic<TUint64> iTimeMaxUs;
+    std::atomic<TUint64> iJiffies;
+    std::atomic<TUint64> iMsgCounts[EMsgTypeCount];
+};
+
+/*
+Pipeline element T, with its Pull() measured.
+T::Pull() is called directly so this adds no extra element (or virtual call) to the pipeline.
+*/
+
+template <class T>
+class ProfiledUpstream : public T
+{
+public:
+    template <typename... Args>
+    ProfiledUpstream(PipelineElementStats& aStats, Args&&... aArgs)
+        : T(std::forward<Args>(aArgs)...)
+        , iStats(aStats)
+    {}
+public: // from IPipelineElementUpstream
+    Msg* Pull() override
+    {
+        const TUint64 start = iStats.Now();
+        return iStats.Pulled(T::Pull(), start);
+    }
+private:
+    PipelineElementStats& iStats;
+};
+
+/*
+Pipeline element T, with its Push() measured.
+*/
+
+template <class T>
+class ProfiledDownstream : public T
+{
+public:
+    template <typename... Args>
+    ProfiledDownstream(PipelineElementStats& aStats, Args&&... aArgs)
+        : T(std::forward<Args>(aArgs)...)
+        , iStats(aStats)
+    {}
+public: // from IPipelineElementDownstream
+    void Push(Msg* aMsg) override
+    {
+        const TUint64 start = iStats.Now();
+        iStats.Pushing(aMsg); // aMsg may be passed on (and freed) by T::Push()
+        T::Push(aMsg);
+        iStats.Pushed(start);
+    }
+private:
+    PipelineElementStats& iStats;
+};
+
+class IPipelineProfile
+{
+public:
+    virtual ~IPipelineProfile() {}
+    virtual void Report(IWriter& aWriter) = 0;
+    virtual void Reset() = 0;
+    virtual TUint ElementCount() const = 0;
+    virtual const PipelineElementStats& ElementAt(TUint aIndex) const = 0; // in order of construction
+};
+
+/*
+Owns the counters for all measured elements in a pipeline.
+Results are available via the "pipeline" info query (e.g. "info pipeline" from the shell)
+or ShellCommandProfile.
+*/
+
+class PipelineProfile : public IPipelineProfile, private IInfoProvider, private INonCopyable
+{
+public:
+    static const Brn kQueryPipeline;
+public:
+    PipelineProfile(IInfoAggregator& aInfoAggregator);
+    ~PipelineProfile();
+    // Returns counters for a new element.  See PipelineElementStats for aInner.
+    PipelineElementStats& Add(const TChar* aId, const PipelineElementStats* aInner);
+public: // from IPipelineProfile
+    void Report(IWriter& aWriter) override;
+    void Reset() override;
+    TUint ElementCount() const override;
+    const PipelineElementStats& ElementAt(TUint aIndex) const override;
+private: // from IInfoProvider
+    void QueryInfo(const Brx& aQuery, IWriter& aWriter) override;
+private:
+    std::vector<PipelineElementStats*> iElements;
+};
+
+} // namespace Media
+} // namespace OpenHome
@@ -12,7 +12,7 @@ class Router : public IPipelineElementUpstream, private INonCopyable
 public:
     Router(IPipelineElementUpstream& aUpstream);
     IPipelineElementUpstream& InsertElements(IPipelineElementUpstream& aTail);
-private: // from IPipelineElementUpstream
+public: // from IPipelineElementUpstream
     Msg* Pull() override;
 private:
     IPipelineElementUpstream& iUpstream;
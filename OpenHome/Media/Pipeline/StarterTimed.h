@@ -38,7 +38,7 @@ public:
     void SetAnimator(IPipelineAnimator& aAnimator);
 public: // from IStarterTimed
     void StartAt(TUint64 aTime) override;
-private: // from IPipelineElementUpstream
+public: // from IPipelineElementUpstream
     Msg* Pull() override;
 private: // from PipelineElement
     Msg* ProcessMsg(MsgDecodedStream* aMsg) override;
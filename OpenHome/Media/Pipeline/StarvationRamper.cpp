@@ -350,17 +350,25 @@ void RampGenerator::ProcessSilence(const Brx& /*aData*/, TUint /*aNumChannels*/,
 
 void RampGenerator::EndBlock()
 {
-    auto audio = iMsgFactory.CreateMsgAudioPcm(*iFlywheelAudio, iNumChannels, iSampleRate, iBitDepth, AudioDataEndian::Big, MsgAudioPcm::kTrackOffsetInvalid);
-    if (iCurrentRampValue == Ramp::kMin) {
-        audio->SetMuted();
-    }
-    else {
-        MsgAudio* split;
-        iCurrentRampValue = audio->SetRamp(iCurrentRampValue, iRemainingRampSize, Ramp::EDown, split);
-        ASSERT(split == nullptr);
+    // a 1ms block of high sample rate, many channel audio won't fit in a single DecodedAudio
+    const TUint bytesPerSample = iNumChannels * (iBitDepth / 8);
+    const TUint maxMsgBytes = (DecodedAudio::kMaxBytes / bytesPerSample) * bytesPerSample;
+    Brn block(*iFlywheelAudio);
+    while (block.Bytes() > 0) {
+        const TUint bytes = std::min(block.Bytes(), maxMsgBytes);
+        auto audio = iMsgFactory.CreateMsgAudioPcm(block.Split(0, bytes), iNumChannels, iSampleRate, iBitDepth, AudioDataEndian::Big, MsgAudioPcm::kTrackOffsetInvalid);
+        block.Set(block.Split(bytes));
+        if (iCurrentRampValue == Ramp::kMin) {
+            audio->SetMuted();
+        }
+        else {
+            MsgAudio* split;
+            iCurrentRampValue = audio->SetRamp(iCurrentRampValue, iRemainingRampSize, Ramp::EDown, split);
+            ASSERT(split == nullptr);
+        }
+        iQueue.Enqueue(audio);
+        iSem.Signal();
     }
-    iQueue.Enqueue(audio);
-    iSem.Signal();
 }
 
 void RampGenerator::Flush()
@@ -32,7 +32,7 @@ public:
 
 class FlywheelInput : public IPcmProcessor
 {
-    static const TUint kMaxSampleRate = 192000;
+    static const TUint kMaxSampleRate = 384000;
     static const TUint kMaxChannels = 10;
     static const TUint kSubsampleBytes = 4;
 public:
@@ -61,7 +61,7 @@ class FlywheelRamperManager;
 
 class RampGenerator : public IPcmProcessor
 {
-    static const TUint kMaxSampleRate = 192000; // FIXME - duplicated in FlywheelInput
+    static const TUint kMaxSampleRate = 384000; // FIXME - duplicated in FlywheelInput
     static const TUint kMaxChannels = 8;
     static const TUint kSubsampleBytes = 4;
 public:
@@ -128,7 +128,7 @@ private:
     void ApplyRamp(MsgAudioDecoded* aMsg);
     void SetBuffering(TBool aBuffering);
     void EventCallback();
-private: // from IPipelineElementUpstream
+public: // from IPipelineElementUpstream
     Msg* Pull() override;
 private: // from MsgReservoir
     void ProcessMsgIn(MsgTrack* aMsg) override;
@@ -14,7 +14,7 @@ class StreamValidator : public PipelineElement, public IPipelineElementDownstrea
 public:
     StreamValidator(MsgFactory& aMsgFactory, IPipelineElementDownstream& aDownstreamElement);
     void SetAnimator(IPipelineAnimator& aPipelineAnimator);
-private: // from IPipelineElementDownstream
+public: // from IPipelineElementDownstream
     void Push(Msg* aMsg) override;
 private: // from IMsgProcessor
     Msg* ProcessMsg(MsgMode* aMsg) override;
@@ -27,7 +27,7 @@ public:
     VolumeRamper(MsgFactory& aMsgFactory, IPipelineElementUpstream& aUpstream);
     ~VolumeRamper();
     void SetVolumeRamper(IVolumeRamper& aVolumeRamper);
-private: // from IPipelineElementUpstream
+public: // from IPipelineElementUpstream
     Msg* Pull() override;
 private: // IMsgProcessor
     Msg* ProcessMsg(MsgDrain* aMsg) override;
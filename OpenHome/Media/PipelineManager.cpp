@@ -369,6 +369,11 @@ void PipelineManager::GetMaxSupportedSampleRates(TUint& aPcm, TUint& aDsd) const
     iPipeline->GetMaxSupportedSampleRates(aPcm, aDsd);
 }
 
+IPipelineProfile& PipelineManager::Profile()
+{
+    return iPipeline->Profile();
+}
+
 Msg* PipelineManager::Pull()
 {
     return iPipeline->Pull();
@@ -419,6 +424,11 @@ void PipelineManager::SetAttenuation(TUint aAttenuation)
     iPipeline->SetAttenuation(aAttenuation);
 }
 
+void PipelineManager::SetAttenuation(const Brx& aMode, TUint aAttenuation)
+{
+    iPipeline->SetAttenuation(aMode, aAttenuation);
+}
+
 void PipelineManager::DrainAllAudio()
 {
     iPipeline->DrainAllAudio();
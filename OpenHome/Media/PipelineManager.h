@@ -36,6 +36,7 @@ class IVolumeRamper;
 class IVolumeMuterStepped;
 class IDRMProvider;
 class IAudioTime;
+class IPipelineProfile;
 
 class PriorityArbitratorPipeline : public IPriorityArbitrator, private INonCopyable
 {
@@ -306,6 +307,7 @@ public:
     void GetThreadPriorityRange(TUint& aMin, TUint& aMax) const;
     void GetThreadPriorities(TUint& aFiller, TUint& aFlywheelRamper, TUint& aStarvationRamper, TUint& aCodec, TUint& aEvent);
     void GetMaxSupportedSampleRates(TUint& aPcm, TUint& aDsd) const;
+    IPipelineProfile& Profile();
 public: // from IPipelineObservable
     void AddObserver(IPipelineObserver& aObserver) override;
     void RemoveObserver(IPipelineObserver& aObserver) override;
@@ -326,6 +328,7 @@ private: // from IPostPipelineLatencyObserver
     void PostPipelineLatencyChanged() override;
 private: // from IAttenuator
     void SetAttenuation(TUint aAttenuation) override;
+    void SetAttenuation(const Brx& aMode, TUint aAttenuation) override;
 private: // from IPipelineDrainer
     void DrainAllAudio() override;
 private: // from IStarterTimed
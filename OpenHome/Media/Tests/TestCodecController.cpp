@@ -10,7 +10,9 @@
 #include <OpenHome/Media/Utils/ProcessorAudioUtils.h>
 #include <OpenHome/Media/MimeTypeList.h>
 
+#include <algorithm>
 #include <list>
+#include <vector>
 #include <limits.h>
 
 using namespace OpenHome;
@@ -53,13 +55,13 @@ class SuiteCodecControllerBase : public SuiteUnitTest
                                , private IMsgProcessor
 {
 public:
-    SuiteCodecControllerBase(const TChar* aName);
+    SuiteCodecControllerBase(const TChar* aName, AudioDataEndian aDecodedAudioEndian = AudioDataEndian::Big);
 protected: // from SuiteUnitTest
     void Setup() override;
     void TearDown() override;
 private: // from IPipelineElementUpstream
     Msg* Pull() override;
-private: // from IPipelineElementDownstream
+protected: // from IPipelineElementDownstream
     void Push(Msg* aMsg) override;
 private: // from IStreamHandler
     EStreamPlay OkToPlay(TUint aStreamId) override;
@@ -114,9 +116,10 @@ protected:
     void PullNext();
     void PullNext(EMsgType aExpectedMsg);
     void PullNext(EMsgType aExpectedMsg, TUint64 aExpectedJiffies);
-    Msg* CreateTrack();
-    Msg* CreateEncodedStream();
+    Msg* CreateTrack(const Brx& aUri = Brx::Empty());
+    Msg* CreateEncodedStream(TUint64 aTotalBytes = 1<<21);
     MsgFlush* CreateFlush();
+    virtual void CheckAudio(const Brx& aPcm); // aPcm is in the pipeline's storage byte order
 protected:
     static const TUint kMaxMsgBytes = 960;
     static const TUint kWavHeaderBytes = 44;
@@ -139,9 +142,10 @@ protected:
     std::list<Msg*> iPendingMsgs;
     std::list<Msg*> iReceivedMsgs;
     EMsgType iLastReceivedMsg;
+    TrackFactory* iTrackFactory;
 private:
+    const AudioDataEndian iDecodedAudioEndian;
     AllocatorInfoLogger iInfoAggregator;
-    TrackFactory* iTrackFactory;
     Semaphore* iSemPending;
     Semaphore* iSemReceived;
     Mutex* iLockPending;
@@ -204,6 +208,59 @@ private:
     TestCodecControllerDummyCodec* iCodec;
 };
 
+/**
+ * Dummy codec that writes each block it reads back to the pipeline via AudioBufWriter.
+ * Planar writers deinterleave the block first, as a codec whose decoder outputs
+ * per-channel arrays would.
+ */
+class TestCodecControllerDummyCodecAudioBuf : public TestCodecControllerDummyCodec
+{
+public:
+    enum EWriter
+    {
+        EPlanarInt32
+       ,EPlanar
+       ,EInterleaved
+    };
+public:
+    TestCodecControllerDummyCodecAudioBuf(TUint aReadBufBytes);
+    void SetWriter(EWriter aWriter);
+public: // from TestCodecControllerDummyCodec
+    void Process() override;
+private:
+    EWriter iWriter;
+    std::vector<TInt32> iSubsamples;
+};
+
+class SuiteCodecControllerAudioBuf : public SuiteCodecControllerBase
+{
+private:
+    static const TUint kBitsPerSample = 16;
+    static const TUint kSamplesPerMsg = 16;
+    static const TUint kAudioBytesPerMsg = 2*2*kSamplesPerMsg; // 16 bits (2 bytes) * 2 channels * kSamplesPerMsg
+public:
+    SuiteCodecControllerAudioBuf(const TChar* aName, AudioDataEndian aDecodedAudioEndian);
+private: // from SuiteCodecControllerBase
+    void Setup() override;
+    void TearDown() override;
+    void CheckAudio(const Brx& aPcm) override;
+private:
+    static TByte EncodedByte(TUint aIndex);
+    Msg* CreateAudio();
+    void StreamAudio(TestCodecControllerDummyCodecAudioBuf::EWriter aWriter, AudioDataEndian aEncodedEndian);
+    void TestPlanarAudioFillsMsgs();
+    void TestPlanarInt32LittleEndian();
+    void TestPlanarBigEndian();
+    void TestPlanarLittleEndian();
+    void TestInterleavedBigEndian();
+    void TestInterleavedLittleEndian();
+private:
+    const AudioDataEndian iDecodedAudioEndian;
+    TestCodecControllerDummyCodecAudioBuf* iCodec;
+    AudioDataEndian iEncodedEndian;
+    TUint iPcmBytes;
+};
+
 class TestCodecControllerDummyCodecStreamInitialise : public TestCodecControllerDummyCodec
 {
 public:
@@ -254,6 +311,36 @@ private:
     TestCodecControllerDummyCodec* iCodec;
 };
 
+class SuiteCodecControllerDecodedAudioCache : public SuiteCodecControllerBase
+                                           , public ISeekObserver
+                                           , private IFlushIdProvider
+{
+private:
+    static const TUint kAudioBytesPerMsg = 1024;
+    static const TUint kCacheFlushId = 100;
+public:
+    SuiteCodecControllerDecodedAudioCache();
+private: // from SuiteCodecControllerBase
+    void Setup() override;
+    void TearDown() override;
+    void Push(Msg* aMsg) override;
+private: // from ISeekObserver
+    void NotifySeekComplete(TUint aHandle, TUint aFlushId) override;
+private: // from IFlushIdProvider
+    TUint NextFlushId() override;
+private:
+    void QueueAudio();
+    void TestBackSeekFromCache();
+    void TestSeekInCachedRepeat();
+private:
+    Semaphore* iSemSeek;
+    Semaphore* iSemAudio;
+    TBool iBlockAudio;
+    TUint iHandle;
+    TUint iFlushId;
+    TestCodecControllerDummyCodec* iCodec;
+};
+
 /**
  * Misbehaving codec that buffers some of its decoded audio and attempts to
  * flush its internal buffer when it detects a CodecStreamStart/CodecStreamEnded
@@ -303,6 +390,53 @@ private:
     TestCodecControllerDummyCodec* iCodec;
 };
 
+class TestFormatSignatureCandidate
+{
+public:
+    FormatSignature& Signature() { return iSignature; }
+private:
+    FormatSignature iSignature;
+};
+
+class SuiteFormatSignature : public Suite
+{
+public:
+    SuiteFormatSignature();
+    void Test() override;
+private:
+    void TestMagic();
+    void TestUri();
+    void TestOrder();
+};
+
+class SuiteSeekPointCache : public Suite
+{
+public:
+    SuiteSeekPointCache();
+    void Test() override;
+private:
+    void TestFind();
+    void TestTracks();
+    void TestBounds();
+};
+
+class SuiteDecodedAudioCache : public Suite
+{
+    static const TUint kBytesPerSample = 4; // 16-bit stereo
+public:
+    SuiteDecodedAudioCache();
+    void Test() override;
+private:
+    void TestRun();
+    void TestDiscontinuity();
+    void TestEndian();
+    void TestComplete();
+    void TestBounds();
+private:
+    static void SetFormat(DecodedAudioCache& aCache);
+    static void AddChunk(DecodedAudioCache& aCache, TUint64 aSample, TUint aSamples);
+};
+
 } // namespace Media
 } // namespace OpenHome
 
@@ -311,8 +445,9 @@ private:
 
 const SpeakerProfile SuiteCodecControllerBase::kProfile(2);
 
-SuiteCodecControllerBase::SuiteCodecControllerBase(const TChar* aName)
+SuiteCodecControllerBase::SuiteCodecControllerBase(const TChar* aName, AudioDataEndian aDecodedAudioEndian)
     : SuiteUnitTest(aName)
+    , iDecodedAudioEndian(aDecodedAudioEndian)
 {
 }
 
@@ -331,6 +466,7 @@ void SuiteCodecControllerBase::Setup()
     init.SetMsgHaltCount(2);
     init.SetMsgFlushCount(2);
     init.SetMsgDecodedStreamCount(2);
+    init.SetDecodedAudioEndian(iDecodedAudioEndian);
     iMsgFactory = new MsgFactory(iInfoAggregator, init);
     iController = new CodecController(*iMsgFactory, *this, *this, *this, Jiffies::kPerMs * 5, kPriorityNormal, true);
     iSemPending = new Semaphore("TCSP", 0);
@@ -517,18 +653,9 @@ Msg* SuiteCodecControllerBase::ProcessMsg(MsgAudioPcm* aMsg)
     iMsgOffset = aMsg->TrackOffset();
     iJiffies += aMsg->Jiffies();
     MsgPlayable* playable = aMsg->CreatePlayable();
-    ProcessorPcmBufTest pcmProcessor;
+    ProcessorPcmBufTest pcmProcessor(iDecodedAudioEndian); // no conversion so that stored bytes are checked
     playable->Read(pcmProcessor);
-    Brn buf(pcmProcessor.Buf());
-    ASSERT(buf.Bytes() >= 4);   // check we have enough bytes to examine first
-                                // and last subsamples before manipulating pointers
-    const TByte* ptr = buf.Ptr();
-    const TUint bytes = buf.Bytes();
-    const TUint firstSubsample = (ptr[0]<<8) | ptr[1];
-    TEST(firstSubsample == 0x7f7f);
-    const TUint lastSubsample = (ptr[bytes-2]<<8) | ptr[bytes-1];
-    TEST(lastSubsample == 0x7f7f);
-
+    CheckAudio(pcmProcessor.Buf());
     return playable;
 }
 
@@ -595,17 +722,17 @@ void SuiteCodecControllerBase::PullNext(EMsgType aExpectedMsg, TUint64 aExpected
     TEST(jiffiesDiff == aExpectedJiffies);
 }
 
-Msg* SuiteCodecControllerBase::CreateTrack()
+Msg* SuiteCodecControllerBase::CreateTrack(const Brx& aUri)
 {
-    Track* track = iTrackFactory->CreateTrack(Brx::Empty(), Brx::Empty());
+    Track* track = iTrackFactory->CreateTrack(aUri, Brx::Empty());
     Msg* msg = iMsgFactory->CreateMsgTrack(*track);
     track->RemoveRef();
     return msg;
 }
 
-Msg* SuiteCodecControllerBase::CreateEncodedStream()
+Msg* SuiteCodecControllerBase::CreateEncodedStream(TUint64 aTotalBytes)
 {
-    return iMsgFactory->CreateMsgEncodedStream(Brx::Empty(), Brx::Empty(), 1<<21, 0, ++iNextStreamId, iSeekable, false, Multiroom::Allowed, this);
+    return iMsgFactory->CreateMsgEncodedStream(Brx::Empty(), Brx::Empty(), aTotalBytes, 0, ++iNextStreamId, iSeekable, false, Multiroom::Allowed, this);
 }
 
 MsgFlush* SuiteCodecControllerBase::CreateFlush()
@@ -613,6 +740,18 @@ MsgFlush* SuiteCodecControllerBase::CreateFlush()
     return iMsgFactory->CreateMsgFlush(kExpectedFlushId);
 }
 
+void SuiteCodecControllerBase::CheckAudio(const Brx& aPcm)
+{
+    ASSERT(aPcm.Bytes() >= 4);  // check we have enough bytes to examine first
+                                // and last subsamples before manipulating pointers
+    const TByte* ptr = aPcm.Ptr();
+    const TUint bytes = aPcm.Bytes();
+    const TUint firstSubsample = (ptr[0]<<8) | ptr[1];
+    TEST(firstSubsample == 0x7f7f);
+    const TUint lastSubsample = (ptr[bytes-2]<<8) | ptr[bytes-1];
+    TEST(lastSubsample == 0x7f7f);
+}
+
 
 // SuiteCodecControllerStream
 
@@ -1171,6 +1310,140 @@ void SuiteCodecControllerPcmSize::TestPcmIsExpectedSize()
 }
 
 
+// SuiteCodecControllerAudioBuf
+
+SuiteCodecControllerAudioBuf::SuiteCodecControllerAudioBuf(const TChar* aName, AudioDataEndian aDecodedAudioEndian)
+    : SuiteCodecControllerBase(aName, aDecodedAudioEndian)
+    , iDecodedAudioEndian(aDecodedAudioEndian)
+{
+    AddTest(MakeFunctor(*this, &SuiteCodecControllerAudioBuf::TestPlanarAudioFillsMsgs), "TestPlanarAudioFillsMsgs");
+    AddTest(MakeFunctor(*this, &SuiteCodecControllerAudioBuf::TestPlanarInt32LittleEndian), "TestPlanarInt32LittleEndian");
+    AddTest(MakeFunctor(*this, &SuiteCodecControllerAudioBuf::TestPlanarBigEndian), "TestPlanarBigEndian");
+    AddTest(MakeFunctor(*this, &SuiteCodecControllerAudioBuf::TestPlanarLittleEndian), "TestPlanarLittleEndian");
+    AddTest(MakeFunctor(*this, &SuiteCodecControllerAudioBuf::TestInterleavedBigEndian), "TestInterleavedBigEndian");
+    AddTest(MakeFunctor(*this, &SuiteCodecControllerAudioBuf::TestInterleavedLittleEndian), "TestInterleavedLittleEndian");
+}
+
+void SuiteCodecControllerAudioBuf::Setup()
+{
+    SuiteCodecControllerBase::Setup();
+    iCodec = new TestCodecControllerDummyCodecAudioBuf(kAudioBytesPerMsg);
+    iController->AddCodec(iCodec);  // Takes ownership.
+    iController->Start();
+    iEncodedEndian = AudioDataEndian::Invalid;
+    iPcmBytes = 0;
+}
+
+void SuiteCodecControllerAudioBuf::TearDown()
+{
+    SuiteCodecControllerBase::TearDown();
+}
+
+void SuiteCodecControllerAudioBuf::CheckAudio(const Brx& aPcm)
+{
+    // Subsamples should have been stored in the pipeline's byte order, so must have been
+    // swapped if (and only if) the encoded audio used the other order.
+    const TUint swap = (iEncodedEndian == iDecodedAudioEndian? 0 : 1);
+    TBool ok = true;
+    for (TUint i=0; i<aPcm.Bytes(); i++) {
+        if (aPcm[i] != EncodedByte((iPcmBytes + i) ^ swap)) {
+            ok = false;
+        }
+    }
+    TEST(ok);
+    iPcmBytes += aPcm.Bytes();
+}
+
+TByte SuiteCodecControllerAudioBuf::EncodedByte(TUint aIndex)
+{ // static
+    // no two adjacent bytes are equal so any byte order error is detected
+    return static_cast<TByte>((aIndex * 13) + (aIndex >> 8));
+}
+
+Msg* SuiteCodecControllerAudioBuf::CreateAudio()
+{
+    TByte encodedAudioData[kAudioBytesPerMsg];
+    for (TUint i=0; i<kAudioBytesPerMsg; i++) {
+        encodedAudioData[i] = EncodedByte(iTrackOffsetBytes + i);
+    }
+    Brn encodedAudioBuf(encodedAudioData, kAudioBytesPerMsg);
+    MsgAudioEncoded* audio = iMsgFactory->CreateMsgAudioEncoded(encodedAudioBuf);
+
+    iTrackOffset += kSamplesPerMsg * Jiffies::PerSample(kSampleRate);
+    iTrackOffsetBytes += kAudioBytesPerMsg;
+    return audio;
+}
+
+void SuiteCodecControllerAudioBuf::StreamAudio(TestCodecControllerDummyCodecAudioBuf::EWriter aWriter, AudioDataEndian aEncodedEndian)
+{
+    static const TUint kAudioBytes = 6144;
+    const TUint64 kJiffiesPerMsg = Jiffies::ToSamples(Jiffies::kPerMs * 5, kSampleRate) * static_cast<TUint64>(Jiffies::PerSample(kSampleRate));
+
+    iTotalBytes = kWavHeaderBytes + kAudioBytes;
+    iEncodedEndian = aEncodedEndian;
+    iCodec->SetWriter(aWriter);
+    iCodec->SetStreamInfo(kAudioBytesPerMsg, kNumChannels, kSampleRate, kBitsPerSample, aEncodedEndian, kProfile);
+
+    Queue(CreateTrack());
+    PullNext(EMsgTrack);
+    Queue(CreateEncodedStream());
+    PullNext(EMsgEncodedStream);
+
+    while (iTrackOffsetBytes < kAudioBytes) {
+        Queue(CreateAudio());
+    }
+    Queue(CreateEncodedStream());
+
+    // Codec outputs tiny blocks but these should be gathered into full-sized msgs,
+    // with any remainder output at the end of the stream.
+    PullNext(EMsgDecodedStream);
+    TUint msgCount = 0;
+    while (iJiffies < iTrackOffset) {
+        const TUint64 expected = std::min(kJiffiesPerMsg, iTrackOffset - iJiffies);
+        const TUint64 expectedOffset = iJiffies;
+        PullNext(EMsgAudioPcm, expected);
+        TEST(iMsgOffset == expectedOffset);
+        msgCount++;
+    }
+    PullNext(EMsgEncodedStream);
+    PullNext(EMsgDecodedStream);
+
+    TEST(iJiffies == iTrackOffset);
+    TEST(msgCount == (iTrackOffset + kJiffiesPerMsg - 1) / kJiffiesPerMsg);
+    TEST(iPcmBytes == kAudioBytes);
+}
+
+void SuiteCodecControllerAudioBuf::TestPlanarAudioFillsMsgs()
+{
+    StreamAudio(TestCodecControllerDummyCodecAudioBuf::EPlanarInt32, AudioDataEndian::Big);
+}
+
+void SuiteCodecControllerAudioBuf::TestPlanarInt32LittleEndian()
+{
+    StreamAudio(TestCodecControllerDummyCodecAudioBuf::EPlanarInt32, AudioDataEndian::Little);
+}
+
+void SuiteCodecControllerAudioBuf::TestPlanarBigEndian()
+{
+    StreamAudio(TestCodecControllerDummyCodecAudioBuf::EPlanar, AudioDataEndian::Big);
+}
+
+void SuiteCodecControllerAudioBuf::TestPlanarLittleEndian()
+{
+    StreamAudio(TestCodecControllerDummyCodecAudioBuf::EPlanar, AudioDataEndian::Little);
+}
+
+void SuiteCodecControllerAudioBuf::TestInterleavedBigEndian()
+{
+    StreamAudio(TestCodecControllerDummyCodecAudioBuf::EInterleaved, AudioDataEndian::Big);
+}
+
+void SuiteCodecControllerAudioBuf::TestInterleavedLittleEndian()
+{
+    StreamAudio(TestCodecControllerDummyCodecAudioBuf::EInterleaved, AudioDataEndian::Little);
+}
+
+
 // TestCodecControllerDummyCodec
 
 const TChar* TestCodecControllerDummyCodec::kId("DUMC");
@@ -1244,6 +1517,56 @@ void TestCodecControllerDummyCodec::StreamCompleted()
 }
 
 
+// TestCodecControllerDummyCodecAudioBuf
+
+TestCodecControllerDummyCodecAudioBuf::TestCodecControllerDummyCodecAudioBuf(TUint aReadBufBytes)
+    : TestCodecControllerDummyCodec(aReadBufBytes)
+    , iWriter(EPlanarInt32)
+{
+}
+
+void TestCodecControllerDummyCodecAudioBuf::SetWriter(EWriter aWriter)
+{
+    iWriter = aWriter;
+}
+
+void TestCodecControllerDummyCodecAudioBuf::Process()
+{
+    iReadBuf.SetBytes(0);
+    iController->Read(iReadBuf, iReadBytes);
+    if (iReadBuf.Bytes() < iReadBytes) {
+        THROW(CodecStreamEnded);
+    }
+
+    ASSERT(iBitDepth == 16);
+    if (iWriter == EInterleaved) {
+        AudioBufWriter::WriteInterleaved(*iController, iReadBuf, iBitDepth, iChannels, iEndianness, iTrackOffset);
+        return;
+    }
+    const TUint samples = iReadBuf.Bytes() / (iChannels * 2);
+    iSubsamples.resize(samples * iChannels);
+    const TByte* p = iReadBuf.Ptr();
+    for (TUint i=0; i<samples; i++) {
+        for (TUint j=0; j<iChannels; j++) {
+            const TUint subsample = (iEndianness == AudioDataEndian::Big? (p[0] << 8) | p[1] : (p[1] << 8) | p[0]);
+            iSubsamples[(j * samples) + i] = static_cast<TInt16>(subsample);
+            p += 2;
+        }
+    }
+    std::vector<const TInt32*> channels;
+    for (TUint j=0; j<iChannels; j++) {
+        channels.push_back(&iSubsamples[j * samples]);
+    }
+    if (iWriter == EPlanarInt32) {
+        AudioBufWriter::WritePlanarInt32(*iController, &channels[0], iChannels, iBitDepth, samples, iTrackOffset);
+    }
+    else {
+        AudioBufWriter::WritePlanar(*iController, &channels[0], iChannels, iBitDepth, samples, iTrackOffset,
+                                    [](TInt32 aSubsample) { return aSubsample; });
+    }
+}
+
+
 // TestCodecControllerDummyCodecStreamInitialise
 
 TestCodecControllerDummyCodecStreamInitialise::TestCodecControllerDummyCodecStreamInitialise(TUint aReadBufBytes, Semaphore& aSemStreamInitPending, Semaphore& aSemStreamInitContinue)
@@ -1421,6 +1744,179 @@ void SuiteCodecControllerSeekInvalid::TestSeekInvalid()
 }
 
 
+// SuiteCodecControllerDecodedAudioCache
+
+SuiteCodecControllerDecodedAudioCache::SuiteCodecControllerDecodedAudioCache()
+    : SuiteCodecControllerBase("SuiteCodecControllerDecodedAudioCache")
+{
+    AddTest(MakeFunctor(*this, &SuiteCodecControllerDecodedAudioCache::TestBackSeekFromCache), "TestBackSeekFromCache");
+    AddTest(MakeFunctor(*this, &SuiteCodecControllerDecodedAudioCache::TestSeekInCachedRepeat), "TestSeekInCachedRepeat");
+}
+
+void SuiteCodecControllerDecodedAudioCache::Setup()
+{
+    SuiteCodecControllerBase::Setup();
+    iSemSeek = new Semaphore("SCDC", 0);
+    iSemAudio = new Semaphore("SCDA", 0);
+    iBlockAudio = false;
+    iHandle = ISeeker::kHandleError;
+    iFlushId = MsgFlush::kIdInvalid;
+    iController->EnableDecodedAudioCache(64 * 1024, *this);
+    iCodec = new TestCodecControllerDummyCodec(kAudioBytesPerMsg);
+    iController->AddCodec(iCodec);  // Takes ownership.
+    iController->Start();
+}
+
+void SuiteCodecControllerDecodedAudioCache::TearDown()
+{
+    delete iSemSeek;
+    delete iSemAudio;
+    SuiteCodecControllerBase::TearDown();
+}
+
+void SuiteCodecControllerDecodedAudioCache::Push(Msg* aMsg)
+{
+    // optionally hold CodecController after each pcm msg it outputs
+    const TBool block = (iBlockAudio && dynamic_cast<MsgAudioPcm*>(aMsg) != nullptr);
+    SuiteCodecControllerBase::Push(aMsg);
+    if (block) {
+        iSemAudio->Wait();
+    }
+}
+
+void SuiteCodecControllerDecodedAudioCache::NotifySeekComplete(TUint aHandle, TUint aFlushId)
+{
+    iHandle = aHandle;
+    iFlushId = aFlushId;
+    iSemSeek->Signal();
+}
+
+TUint SuiteCodecControllerDecodedAudioCache::NextFlushId()
+{
+    return kCacheFlushId;
+}
+
+void SuiteCodecControllerDecodedAudioCache::QueueAudio()
+{
+    TByte encodedAudioData[kAudioBytesPerMsg];
+    (void)memset(encodedAudioData, 0x7f, kAudioBytesPerMsg);
+    Queue(iMsgFactory->CreateMsgAudioEncoded(Brn(encodedAudioData, kAudioBytesPerMsg)));
+}
+
+void SuiteCodecControllerDecodedAudioCache::TestBackSeekFromCache()
+{
+    static const TUint kBytesPerSample = 4; // 16-bit stereo
+    const TUint64 kJiffiesPerMsg = (kAudioBytesPerMsg / kBytesPerSample) * static_cast<TUint64>(Jiffies::PerSample(kSampleRate));
+    iCodec->SetStreamInfo(kAudioBytesPerMsg, kNumChannels, kSampleRate, 16, AudioDataEndian::Little, SpeakerProfile());
+
+    Queue(CreateTrack(Brn("http://1.2.3.4/track.wav")));
+    PullNext(EMsgTrack);
+    Queue(CreateEncodedStream());
+    PullNext(EMsgEncodedStream);
+
+    static const TUint kMsgsBeforeSeek = 4;
+    for (TUint i=0; i<kMsgsBeforeSeek; i++) {
+        QueueAudio();
+    }
+    PullNext(EMsgDecodedStream);
+    while (iJiffies < kMsgsBeforeSeek * kJiffiesPerMsg) {
+        PullNext(EMsgAudioPcm);
+    }
+
+    // Seek back to the start of the stream.  The codec is now blocked waiting for more encoded audio.
+    ISeeker& seeker = *iController;
+    TUint handle = ISeeker::kHandleError;
+    seeker.StartSeek(iStreamId, 0, *this, handle);
+    TEST(handle != ISeeker::kHandleError);
+    QueueAudio();
+
+    // Seek is served from the cache.  SuiteCodecControllerBase::TrySeek() asserts so this also
+    // checks that the codec wasn't asked to seek.
+    iSemSeek->Wait(kSemWaitMs);
+    TEST(iHandle == handle);
+    TEST(iFlushId == kCacheFlushId);
+
+    // Audio decoded before the seek started is output first, followed by our own flush...
+    do {
+        PullNext();
+    } while (iLastReceivedMsg == EMsgAudioPcm);
+    TEST(iLastReceivedMsg == EMsgFlush);
+    const TUint64 jiffiesCached = (kMsgsBeforeSeek + 1) * kJiffiesPerMsg;
+    TEST(iJiffies == jiffiesCached);
+
+    // ...then all cached audio from the seek point, followed by the codec carrying on
+    // decoding from where it was before the seek.
+    PullNext(EMsgDecodedStream);
+    iJiffies = 0;
+    QueueAudio();
+    while (iJiffies < jiffiesCached + kJiffiesPerMsg) {
+        const TUint64 offset = iJiffies;
+        PullNext(EMsgAudioPcm);
+        TEST(iMsgOffset == offset);
+    }
+    TEST(iJiffies == jiffiesCached + kJiffiesPerMsg);
+}
+
+
+void SuiteCodecControllerDecodedAudioCache::TestSeekInCachedRepeat()
+{
+    static const TUint kBytesPerSample = 4; // 16-bit stereo
+    static const TUint kMsgsPerTrack = 4;
+    const TUint64 kJiffiesPerMsg = (kAudioBytesPerMsg / kBytesPerSample) * static_cast<TUint64>(Jiffies::PerSample(kSampleRate));
+    const TUint64 kJiffiesPerTrack = kMsgsPerTrack * kJiffiesPerMsg;
+    iCodec->SetStreamInfo(kAudioBytesPerMsg, kNumChannels, kSampleRate, 16, AudioDataEndian::Little, SpeakerProfile());
+    Track* track = iTrackFactory->CreateTrack(Brn("http://1.2.3.4/track.wav"), Brx::Empty());
+
+    // Decode the whole track, leaving it held in the cache.  The codec sees the end of the
+    // stream when the repeat's MsgTrack arrives.
+    Queue(iMsgFactory->CreateMsgTrack(*track));
+    PullNext(EMsgTrack);
+    Queue(CreateEncodedStream(kMsgsPerTrack * kAudioBytesPerMsg));
+    PullNext(EMsgEncodedStream);
+    for (TUint i=0; i<kMsgsPerTrack; i++) {
+        QueueAudio();
+    }
+    Queue(iMsgFactory->CreateMsgTrack(*track));
+    track->RemoveRef();
+    PullNext(EMsgDecodedStream);
+    while (iJiffies < kJiffiesPerTrack) {
+        PullNext(EMsgAudioPcm);
+    }
+    PullNext(EMsgTrack);
+
+    // Repeat is played from the cache.  Seek back to the start once it has output some audio.
+    iBlockAudio = true;
+    Queue(CreateEncodedStream(kMsgsPerTrack * kAudioBytesPerMsg));
+    PullNext(EMsgEncodedStream);
+    PullNext(EMsgDecodedStream);
+    PullNext(EMsgAudioPcm);
+    ISeeker& seeker = *iController;
+    TUint handle = ISeeker::kHandleError;
+    seeker.StartSeek(iStreamId, 0, *this, handle);
+    TEST(handle != ISeeker::kHandleError);
+    iBlockAudio = false;
+    iSemAudio->Signal();
+
+    // Seek is served from the cache.  SuiteCodecControllerBase::TrySeek() asserts so this also
+    // checks that the encoded stream wasn't asked to seek.
+    iSemSeek->Wait(kSemWaitMs);
+    TEST(iHandle == handle);
+    TEST(iFlushId == kCacheFlushId);
+    PullNext(EMsgFlush);
+    PullNext(EMsgDecodedStream);
+    iJiffies = 0;
+    while (iJiffies < kJiffiesPerTrack) {
+        const TUint64 offset = iJiffies;
+        PullNext(EMsgAudioPcm);
+        TEST(iMsgOffset == offset);
+    }
+    TEST(iJiffies == kJiffiesPerTrack);
+
+    // remainder of the encoded stream is then stopped
+    iSemStop->Wait(kSemWaitMs);
+    TEST(iStopCount == 1);
+}
+
 // TestCodecControllerDummyCodecBuffered
 
 TestCodecControllerDummyCodecBuffered::TestCodecControllerDummyCodecBuffered(TUint aReadBufBytes)
@@ -1635,16 +2131,450 @@ void SuiteCodecControllerFlush::TestInvalidFlush()
 }
 
 
+// SuiteFormatSignature
+
+SuiteFormatSignature::SuiteFormatSignature()
+    : Suite("FormatSignature")
+{
+}
+
+void SuiteFormatSignature::Test()
+{
+    TestMagic();
+    TestUri();
+    TestOrder();
+}
+
+void SuiteFormatSignature::TestMagic()
+{
+    static const TByte kWav[] = { 'R', 'I', 'F', 'F', 0x24, 0x08, 0x00, 0x00, 'W', 'A', 'V', 'E', 'f', 'm', 't', ' ' };
+    static const TByte kMp4[] = { 0x00, 0x00, 0x00, 0x20, 'f', 't', 'y', 'p', 'M', '4', 'A', ' ' };
+    const Brn wav(kWav, sizeof(kWav));
+    const Brn mp4(kMp4, sizeof(kMp4));
+
+    FormatSignature sig;
+    TEST(sig.ProbeBytes() == 0);
+    TEST(!sig.MatchesData(wav));
+
+    sig.AddMagic(0, Brn("RIFF"), 8, Brn("WAVE"));
+    TEST(sig.ProbeBytes() == 12);
+    TEST(sig.MatchesData(wav));
+    TEST(sig.MatchesData(Brn("RIFFabcdWAVE")));
+    TEST(!sig.MatchesData(Brn("RIFFabcdAVI ")));
+    TEST(!sig.MatchesData(Brn("RIFFabcdWAV"))); // too short
+    TEST(!sig.MatchesData(Brx::Empty()));
+
+    sig.AddMagic(4, Brn("ftyp"));
+    TEST(sig.ProbeBytes() == 12);
+    TEST(sig.MatchesData(mp4));
+    TEST(sig.MatchesData(Brn("RIFFabcdWAVE")));
+    TEST(!sig.MatchesData(Brn("ftyp")));
+
+    TEST_THROWS(sig.AddMagic(FormatSignature::kMaxProbeBytes - 3, Brn("abcd")), AssertionFailed);
+    TEST_THROWS(sig.AddMagic(0, Brx::Empty()), AssertionFailed);
+    TEST_THROWS(sig.AddMagic(0, Brn("ab"), Brn("\xff")), AssertionFailed);
+    TEST_THROWS(sig.AddMagic(0, Brn("abcd"), 2, Brn("cd")), AssertionFailed);
+
+    // '?' has no special meaning so can itself be matched
+    FormatSignature literal;
+    literal.AddMagic(0, Brn("a?b"));
+    TEST(literal.MatchesData(Brn("a?b")));
+    TEST(!literal.MatchesData(Brn("axb")));
+
+    // only bits set in the mask are compared
+    FormatSignature masked;
+    masked.AddMagic(0, Brn("\xf0\x01"), Brn("\xf0\xff"));
+    TEST(masked.ProbeBytes() == 2);
+    TEST(masked.MatchesData(Brn("\xf0\x01")));
+    TEST(masked.MatchesData(Brn("\xfa\x01")));
+    TEST(!masked.MatchesData(Brn("\xe0\x01")));
+    TEST(!masked.MatchesData(Brn("\xf0\x02")));
+
+    // MPEG-TS: a single 0x47 isn't enough, the sync byte must repeat at the next packet
+    static const TUint kTsPacketBytes = 188;
+    FormatSignature ts;
+    ts.AddMagic(0, Brn("\x47"), kTsPacketBytes, Brn("\x47"));
+    TEST(ts.ProbeBytes() == kTsPacketBytes + 1);
+    Bws<FormatSignature::kMaxProbeBytes> probe;
+    probe.Append((TByte)0x47);
+    while (probe.Bytes() < ts.ProbeBytes()) {
+        probe.Append((TByte)0x00);
+    }
+    TEST(!ts.MatchesData(probe));
+    probe[kTsPacketBytes] = 0x47;
+    TEST(ts.MatchesData(probe));
+    probe.SetBytes(kTsPacketBytes);
+    TEST(!ts.MatchesData(probe)); // too short
+}
+
+void SuiteFormatSignature::TestUri()
+{
+    FormatSignature sig;
+    TEST(!sig.MatchesUri(Brn("http://host/track.flac")));
+    sig.AddExtension("flac");
+    TEST(sig.MatchesUri(Brn("http://host/track.flac")));
+    TEST(sig.MatchesUri(Brn("http://host/TRACK.FLAC")));
+    TEST(sig.MatchesUri(Brn("http://host/track.flac?token=a.b")));
+    TEST(sig.MatchesUri(Brn("file:///music/track.flac#t=10")));
+    TEST(!sig.MatchesUri(Brn("http://host/track.flac.mp3")));
+    TEST(!sig.MatchesUri(Brn("http://host.flac/track")));
+    TEST(!sig.MatchesUri(Brn("http://host/track")));
+    TEST(!sig.MatchesUri(Brn("http://host/trackflac")));
+    TEST(!sig.MatchesUri(Brx::Empty()));
+}
+
+void SuiteFormatSignature::TestOrder()
+{
+    TestFormatSignatureCandidate none;
+    TestFormatSignatureCandidate wav;
+    wav.Signature().AddMagic(0, Brn("RIFF"), 8, Brn("WAVE"));
+    wav.Signature().AddExtension("wav");
+    TestFormatSignatureCandidate flac;
+    flac.Signature().AddMagic(0, Brn("fLaC"));
+    flac.Signature().AddExtension("flac");
+    TestFormatSignatureCandidate mp3;
+    mp3.Signature().AddExtension("mp3");
+
+    std::vector<TestFormatSignatureCandidate*> candidates;
+    candidates.push_back(&wav);
+    candidates.push_back(&none);
+    candidates.push_back(&mp3);
+    candidates.push_back(&flac);
+    std::vector<TestFormatSignatureCandidate*> ordered;
+
+    // no hints - original order is preserved
+    FormatSignature::Order(candidates, Brx::Empty(), Brx::Empty(), ordered);
+    TEST(ordered == candidates);
+
+    // magic match comes first
+    FormatSignature::Order(candidates, Brn("fLaC"), Brn("http://host/track"), ordered);
+    TEST(ordered.size() == 4);
+    TEST(ordered[0] == &flac);
+    TEST(ordered[1] == &wav);
+    TEST(ordered[2] == &none);
+    TEST(ordered[3] == &mp3);
+
+    // extension match comes after magic match
+    FormatSignature::Order(candidates, Brn("fLaC"), Brn("http://host/track.mp3"), ordered);
+    TEST(ordered.size() == 4);
+    TEST(ordered[0] == &flac);
+    TEST(ordered[1] == &mp3);
+    TEST(ordered[2] == &wav);
+    TEST(ordered[3] == &none);
+
+    // misleading extension doesn't override content
+    FormatSignature::Order(candidates, Brn("RIFFabcdWAVE"), Brn("http://host/track.flac"), ordered);
+    TEST(ordered.size() == 4);
+    TEST(ordered[0] == &wav);
+    TEST(ordered[1] == &flac);
+    TEST(ordered[2] == &none);
+    TEST(ordered[3] == &mp3);
+}
+
+
+// SuiteSeekPointCache
+
+SuiteSeekPointCache::SuiteSeekPointCache()
+    : Suite("SeekPointCache")
+{
+}
+
+void SuiteSeekPointCache::Test()
+{
+    TestFind();
+    TestTracks();
+    TestBounds();
+}
+
+void SuiteSeekPointCache::TestFind()
+{
+    SeekPointCache cache(2, 8);
+    TUint64 sample = 0;
+    TUint64 bytes = 0;
+    cache.Add(0, 100); // no stream set => ignored
+    cache.SetStream(Brn("http://1.2.3.4/a.mp3"), 10000);
+    TEST(!cache.TryFind(0, sample, bytes));
+
+    cache.Add(44100, 1200);
+    cache.Add(0, 100);
+    cache.Add(88200, 2400);
+    TEST(cache.TryFind(44099, sample, bytes));
+    TEST(sample == 0);
+    TEST(bytes == 100);
+    TEST(cache.TryFind(44100, sample, bytes));
+    TEST(sample == 44100);
+    TEST(bytes == 1200);
+    TEST(cache.TryFind(1000000, sample, bytes));
+    TEST(sample == 88200);
+    TEST(bytes == 2400);
+
+    // streams of unknown length aren't cached
+    cache.SetStream(Brn("http://1.2.3.4/live"), 0);
+    cache.Add(0, 100);
+    TEST(!cache.TryFind(0, sample, bytes));
+}
+
+void SuiteSeekPointCache::TestTracks()
+{
+    SeekPointCache cache(2, 8);
+    TUint64 sample = 0;
+    TUint64 bytes = 0;
+    const Brn uriA("http://1.2.3.4/a.flac");
+    const Brn uriB("http://1.2.3.4/b.flac");
+
+    cache.SetStream(uriA, 1000);
+    cache.Add(10, 11);
+    cache.SetStream(uriB, 2000);
+    cache.Add(20, 21);
+
+    // points are kept across plays
+    cache.SetStream(uriA, 1000);
+    TEST(cache.TryFind(15, sample, bytes));
+    TEST(sample == 10);
+    TEST(bytes == 11);
+
+    // same uri with a different length is a different track
+    cache.SetStream(uriA, 1001);
+    TEST(!cache.TryFind(15, sample, bytes));
+
+    // A (length 1000) was more recently used than B so B was evicted
+    cache.SetStream(uriB, 2000);
+    TEST(!cache.TryFind(25, sample, bytes));
+    cache.SetStream(uriA, 1000);
+    TEST(!cache.TryFind(15, sample, bytes));
+}
+
+void SuiteSeekPointCache::TestBounds()
+{
+    static const TUint kMaxPoints = 8;
+    SeekPointCache cache(1, kMaxPoints);
+    TUint64 sample = 0;
+    TUint64 bytes = 0;
+    cache.SetStream(Brn("http://1.2.3.4/a.mp3"), 1000000);
+    for (TUint i=0; i<4*kMaxPoints; i++) {
+        cache.Add(i * 1000, i * 10);
+    }
+    // older points are thinned out rather than discarded wholesale
+    TEST(cache.TryFind(0, sample, bytes));
+    TEST(sample == 0);
+
+    // ...and remaining points are spread evenly across the whole track
+    TUint found = 0;
+    TUint64 prev = 0;
+    TUint64 minGap = ~0ull;
+    TUint64 maxGap = 0;
+    for (TUint i=1; i<4*kMaxPoints; i++) {
+        if (cache.TryFind(i * 1000, sample, bytes) && sample != prev) {
+            TEST(bytes == sample / 100);
+            minGap = std::min(minGap, sample - prev);
+            maxGap = std::max(maxGap, sample - prev);
+            prev = sample;
+            found++;
+        }
+    }
+    TEST(found < kMaxPoints);
+    TEST(maxGap <= 2 * minGap);
+    TEST((4*kMaxPoints - 1) * 1000 - prev < maxGap);
+}
+
+// SuiteDecodedAudioCache
+
+SuiteDecodedAudioCache::SuiteDecodedAudioCache()
+    : Suite("DecodedAudioCache")
+{
+}
+
+void SuiteDecodedAudioCache::Test()
+{
+    TestRun();
+    TestDiscontinuity();
+    TestEndian();
+    TestComplete();
+    TestBounds();
+}
+
+void SuiteDecodedAudioCache::SetFormat(DecodedAudioCache& aCache)
+{ // static
+    DecodedAudioCache::Format format;
+    format.iBitDepth = 16;
+    format.iSampleRate = 44100;
+    format.iNumChannels = 2;
+    format.iCodecName.Replace(Brn("TEST"));
+    aCache.SetFormat(format);
+}
+
+void SuiteDecodedAudioCache::AddChunk(DecodedAudioCache& aCache, TUint64 aSample, TUint aSamples)
+{ // static
+    // each byte holds the (truncated) number of the sample it is part of
+    Bwh data(aSamples * kBytesPerSample);
+    for (TUint i=0; i<aSamples; i++) {
+        const TByte val = static_cast<TByte>(aSample + i);
+        for (TUint j=0; j<kBytesPerSample; j++) {
+            data.Append(val);
+        }
+    }
+    aCache.Add(data, AudioDataEndian::Big, aSample);
+}
+
+void SuiteDecodedAudioCache::TestRun()
+{
+    DecodedAudioCache cache(64 * 1024);
+    Brn audio;
+    AddChunk(cache, 0, 10); // no stream set => ignored
+    TEST(!cache.Contains(0));
+
+    cache.SetStream(1, Brn("http://1.2.3.4/a.flac"), 10000);
+    AddChunk(cache, 0, 10); // no format set => ignored
+    TEST(!cache.Contains(0));
+    SetFormat(cache);
+    AddChunk(cache, 0, 10);
+    AddChunk(cache, 10, 10);
+    TEST(cache.Contains(0));
+    TEST(cache.Contains(19));
+    TEST(!cache.Contains(20));
+
+    TEST(cache.TryRead(5, audio));
+    TEST(audio.Bytes() == 5 * kBytesPerSample);
+    TEST(audio[0] == 5);
+    TEST(cache.TryRead(10, audio));
+    TEST(audio.Bytes() == 10 * kBytesPerSample);
+    TEST(audio[audio.Bytes() - 1] == 19);
+    TEST(!cache.TryRead(20, audio));
+
+    // streams of unknown length aren't cached
+    cache.SetStream(2, Brn("http://1.2.3.4/live"), 0);
+    SetFormat(cache);
+    AddChunk(cache, 0, 10);
+    TEST(!cache.Contains(0));
+
+    // audio is kept across plays but can't be used for seeks until the codec outputs audio that follows on from it
+    cache.SetStream(1, Brn("http://1.2.3.4/a.flac"), 10000);
+    TEST(!cache.Contains(5));
+    TEST(cache.TryRead(5, audio));
+    AddChunk(cache, 20, 10);
+    TEST(cache.Contains(5));
+
+    // same track id with a different uri is a different track
+    cache.SetStream(1, Brn("http://1.2.3.4/b.flac"), 10000);
+    TEST(!cache.TryRead(5, audio));
+}
+
+void SuiteDecodedAudioCache::TestDiscontinuity()
+{
+    DecodedAudioCache cache(64 * 1024);
+    cache.SetStream(1, Brn("http://1.2.3.4/a.flac"), 10000);
+    SetFormat(cache);
+    AddChunk(cache, 0, 10);
+    AddChunk(cache, 10, 10);
+
+    // codec seeks; held audio no longer leads up to the codec's position
+    cache.MarkDiscontinuity();
+    TEST(!cache.Contains(5));
+
+    // audio that doesn't follow on from the run replaces it
+    AddChunk(cache, 100, 10);
+    TEST(cache.Contains(100));
+    TEST(!cache.Contains(5));
+
+    // incompatible format discards held audio
+    DecodedAudioCache::Format format;
+    format.iBitDepth = 24;
+    format.iSampleRate = 44100;
+    format.iNumChannels = 2;
+    cache.SetFormat(format);
+    TEST(!cache.Contains(100));
+}
+
+void SuiteDecodedAudioCache::TestEndian()
+{
+    DecodedAudioCache cache(64 * 1024);
+    cache.SetStream(1, Brn("http://1.2.3.4/a.wav"), 10000);
+    SetFormat(cache);
+    const TByte le[] = { 0x01, 0x02, 0x03, 0x04 };
+    cache.Add(Brn(le, sizeof(le)), AudioDataEndian::Little, 0);
+    Brn audio;
+    TEST(cache.TryRead(0, audio));
+    const TByte be[] = { 0x02, 0x01, 0x04, 0x03 };
+    TEST(audio == Brn(be, sizeof(be)));
+}
+
+void SuiteDecodedAudioCache::TestComplete()
+{
+    DecodedAudioCache cache(64 * 1024);
+    cache.SetStream(1, Brn("http://1.2.3.4/a.flac"), 10000);
+    SetFormat(cache);
+    AddChunk(cache, 0, 10);
+    TEST(!cache.IsComplete());
+    cache.SetComplete();
+    TEST(cache.IsComplete());
+    TEST(cache.CurrentFormat().iCodecName == Brn("TEST"));
+
+    cache.SetStream(2, Brn("http://1.2.3.4/b.flac"), 10000);
+    TEST(!cache.IsComplete());
+    cache.SetStream(1, Brn("http://1.2.3.4/a.flac"), 10000);
+    TEST(cache.IsComplete());
+
+    // a track that wasn't decoded from its start is never complete
+    cache.SetStream(3, Brn("http://1.2.3.4/c.flac"), 10000);
+    SetFormat(cache);
+    AddChunk(cache, 100, 10);
+    cache.SetComplete();
+    TEST(!cache.IsComplete());
+
+    cache.SetStream(1, Brn("http://1.2.3.4/a.flac"), 10000);
+    cache.Discard();
+    TEST(!cache.IsComplete());
+}
+
+void SuiteDecodedAudioCache::TestBounds()
+{
+    static const TUint kChunkSamples = 10;
+    static const TUint kMaxChunks = 4;
+    DecodedAudioCache cache(kMaxChunks * kChunkSamples * kBytesPerSample);
+    cache.SetStream(1, Brn("http://1.2.3.4/a.flac"), 10000);
+    SetFormat(cache);
+    AddChunk(cache, 0, kChunkSamples);
+    cache.SetComplete();
+    cache.SetStream(2, Brn("http://1.2.3.4/b.flac"), 10000);
+    SetFormat(cache);
+    for (TUint i=0; i<kMaxChunks; i++) {
+        AddChunk(cache, i * kChunkSamples, kChunkSamples);
+    }
+    // least recently played track is discarded first...
+    TEST(cache.Contains(0));
+    cache.SetStream(1, Brn("http://1.2.3.4/a.flac"), 10000);
+    TEST(!cache.IsComplete());
+
+    // ...then the oldest audio for the current track
+    cache.SetStream(2, Brn("http://1.2.3.4/b.flac"), 10000);
+    SetFormat(cache);
+    AddChunk(cache, kMaxChunks * kChunkSamples, kChunkSamples);
+    TEST(!cache.Contains(0));
+    TEST(cache.Contains(kChunkSamples));
+    TEST(cache.Contains((kMaxChunks + 1) * kChunkSamples - 1));
+
+    // audio larger than the cache isn't held
+    AddChunk(cache, (kMaxChunks + 1) * kChunkSamples, (kMaxChunks + 1) * kChunkSamples);
+    TEST(!cache.Contains(kChunkSamples));
+}
+
+
 
 void TestCodecController()
 {
     Runner runner("CodecController tests\n");
     runner.Add(new SuiteCodecControllerStream());
     runner.Add(new SuiteCodecControllerPcmSize());
+    runner.Add(new SuiteCodecControllerAudioBuf("SuiteCodecControllerAudioBufBigEndian", AudioDataEndian::Big));
+    runner.Add(new SuiteCodecControllerAudioBuf("SuiteCodecControllerAudioBufLittleEndian", AudioDataEndian::Little));
     runner.Add(new SuiteCodecControllerStopDuringStreamInit());
     runner.Add(new SuiteCodecControllerSeekInvalid());
+    runner.Add(new SuiteCodecControllerDecodedAudioCache());
     runner.Add(new SuiteCodecControllerUnexpectedFlush());
     runner.Add(new SuiteCodecControllerFlush());
+    runner.Add(new SuiteFormatSignature());
+    runner.Add(new SuiteSeekPointCache());
+    runner.Add(new SuiteDecodedAudioCache());
     runner.Run();
 }
 
@@ -0,0 +1,430 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Media/Codec/CodecController.h>
+#include <OpenHome/Media/Codec/CodecFactory.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Media/Utils/AllocatorInfoLogger.h>
+#include <OpenHome/Media/MimeTypeList.h>
+#include <OpenHome/Private/OptionParser.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Private/Env.h>
+#include <OpenHome/OsWrapper.h>
+
+#include <algorithm>
+#include <math.h>
+#include <vector>
+
+/*
+ * FLAC decode benchmark.
+ *
+ * Synthesises a FLAC stream (FIXED order 2 subframes, the commonest choice for real encoders
+ * at high sample rates) then times CodecController decoding it, from stream start to the final
+ * MsgAudioPcm.  Run against successive builds to compare decoder throughput.
+ *
+ * Results are written as a single JSON object.
+ */
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Media;
+using namespace OpenHome::Media::Codec;
+
+namespace OpenHome {
+namespace Media {
+
+class FlacStreamSynthesiser
+{
+    static const TUint kBlockSamples = 4096;
+    static const TUint kChannels = 2;
+public:
+    static void Synthesise(TUint aSampleRate, TUint aBitDepth, TUint aSeconds, std::vector<TByte>& aStream, TUint64& aSamples);
+private:
+    FlacStreamSynthesiser(std::vector<TByte>& aStream);
+    void Write(TUint32 aValue, TUint aBits);
+    void WriteUnary(TUint32 aZeros);
+    void WriteUtf8(TUint32 aValue);
+    void AlignToByte();
+    void WriteStreamInfo(TUint aSampleRate, TUint aBitDepth, TUint64 aSamples);
+    void WriteFrame(TUint aFrameNumber, const std::vector<TInt32>* aChannels, TUint aBitDepth);
+    void WriteSubframe(const std::vector<TInt32>& aSamples, TUint aBitDepth);
+    static TUint8 Crc8(const TByte* aData, TUint aBytes);
+    static TUint16 Crc16(const TByte* aData, TUint aBytes);
+private:
+    std::vector<TByte>& iStream;
+    TUint64 iAcc;
+    TUint iAccBits;
+};
+
+class SuiteCodecFlacPerf : public Suite
+                         , private IPipelineElementUpstream
+                         , private IPipelineElementDownstream
+                         , private IStreamHandler
+                         , private IUrlBlockWriter
+                         , private IMimeTypeList
+{
+public:
+    SuiteCodecFlacPerf(Environment& aEnv, TUint aSampleRate, TUint aBitDepth, TUint aSeconds);
+    void Test() override;
+private: // from IPipelineElementUpstream
+    Msg* Pull() override;
+private: // from IPipelineElementDownstream
+    void Push(Msg* aMsg) override;
+private: // from IStreamHandler
+    EStreamPlay OkToPlay(TUint aStreamId) override;
+    TUint TrySeek(TUint aStreamId, TUint64 aOffset) override;
+    TUint TryDiscard(TUint aJiffies) override;
+    TUint TryStop(TUint aStreamId) override;
+    void NotifyStarving(const Brx& aMode, TUint aStreamId, TBool aStarving) override;
+private: // from IUrlBlockWriter
+    TBool TryGet(IWriter& aWriter, const Brx& aUrl, TUint64 aOffset, TUint aBytes) override;
+private: // from IMimeTypeList
+    void Add(const TChar* aMimeType) override;
+private:
+    Environment& iEnv;
+    const TUint iSampleRate;
+    const TUint iBitDepth;
+    const TUint iSeconds;
+    AllocatorInfoLogger iInfoAggregator;
+    TrackFactory* iTrackFactory;
+    MsgFactory* iMsgFactory;
+    std::vector<TByte> iStream;
+    TUint iStreamOffset;
+    TUint iPullCount;
+    TUint64 iSamples;
+    TUint64 iStartUs;
+    TUint64 iEndUs;
+    Semaphore iSemQuit;
+};
+
+} // namespace Media
+} // namespace OpenHome
+
+
+// FlacStreamSynthesiser
+
+void FlacStreamSynthesiser::Synthesise(TUint aSampleRate, TUint aBitDepth, TUint aSeconds, std::vector<TByte>& aStream, TUint64& aSamples)
+{ // static
+    const TUint frames = (aSampleRate * aSeconds + kBlockSamples - 1) / kBlockSamples;
+    aSamples = static_cast<TUint64>(frames) * kBlockSamples;
+    aStream.clear();
+    aStream.reserve(static_cast<size_t>(aSamples * kChannels * aBitDepth / 12)); // rough guess at compression ratio
+
+    FlacStreamSynthesiser writer(aStream);
+    writer.WriteStreamInfo(aSampleRate, aBitDepth, aSamples);
+
+    // a pair of tones plus a little noise, so that residuals are representative of real material
+    static const double kPi = 3.14159265358979323846;
+    const double amplitude = static_cast<double>(1 << (aBitDepth - 3));
+    const TInt32 noiseMask = (1 << (aBitDepth - 14)) - 1;
+    TUint32 lcg = 1;
+    std::vector<TInt32> channels[kChannels];
+    for (TUint ch=0; ch<kChannels; ch++) {
+        channels[ch].resize(kBlockSamples);
+    }
+    TUint64 sample = 0;
+    for (TUint frame=0; frame<frames; frame++) {
+        for (TUint i=0; i<kBlockSamples; i++, sample++) {
+            const double t = static_cast<double>(sample) / aSampleRate;
+            for (TUint ch=0; ch<kChannels; ch++) {
+                lcg = lcg * 1664525u + 1013904223u;
+                const double tone = sin(2 * kPi * (440.0 + 110.0 * ch) * t) + 0.5 * sin(2 * kPi * 3520.0 * t);
+                channels[ch][i] = static_cast<TInt32>(amplitude * tone) + (static_cast<TInt32>(lcg >> 8) & noiseMask) - (noiseMask / 2);
+            }
+        }
+        writer.WriteFrame(frame, channels, aBitDepth);
+    }
+}
+
+FlacStreamSynthesiser::FlacStreamSynthesiser(std::vector<TByte>& aStream)
+    : iStream(aStream)
+    , iAcc(0)
+    , iAccBits(0)
+{
+}
+
+void FlacStreamSynthesiser::Write(TUint32 aValue, TUint aBits)
+{
+    ASSERT(aBits <= 32);
+    if (aBits == 0) {
+        return;
+    }
+    const TUint64 mask = (static_cast<TUint64>(1) << aBits) - 1;
+    iAcc = (iAcc << aBits) | (aValue & mask);
+    iAccBits += aBits;
+    while (iAccBits >= 8) {
+        iAccBits -= 8;
+        iStream.push_back(static_cast<TByte>(iAcc >> iAccBits));
+    }
+}
+
+void FlacStreamSynthesiser::WriteUnary(TUint32 aZeros)
+{
+    while (aZeros >= 32) {
+        Write(0, 32);
+        aZeros -= 32;
+    }
+    Write(1, aZeros + 1);
+}
+
+void FlacStreamSynthesiser::WriteUtf8(TUint32 aValue)
+{
+    ASSERT(aValue < 0x80000000);
+    if (aValue < 0x80) {
+        Write(aValue, 8);
+        return;
+    }
+    TUint extra = 1;
+    while (extra < 5 && aValue >= (1u << (6 + 5 * extra))) {
+        extra++;
+    }
+    const TUint32 lead = (0xff00 >> (extra + 1)) & 0xff;
+    Write(lead | (aValue >> (6 * extra)), 8);
+    for (TUint i=extra; i>0; i--) {
+        Write(0x80 | ((aValue >> (6 * (i - 1))) & 0x3f), 8);
+    }
+}
+
+void FlacStreamSynthesiser::AlignToByte()
+{
+    if (iAccBits > 0) {
+        Write(0, 8 - iAccBits);
+    }
+}
+
+void FlacStreamSynthesiser::WriteStreamInfo(TUint aSampleRate, TUint aBitDepth, TUint64 aSamples)
+{
+    static const TUint kStreamInfoBytes = 34;
+    Write('f', 8);
+    Write('L', 8);
+    Write('a', 8);
+    Write('C', 8);
+    Write(0x80, 8); // last metadata block, STREAMINFO
+    Write(kStreamInfoBytes, 24);
+    Write(kBlockSamples, 16); // min block size
+    Write(kBlockSamples, 16); // max block size
+    Write(0, 24);             // min frame size (unknown)
+    Write(0, 24);             // max frame size (unknown)
+    Write(aSampleRate, 20);
+    Write(kChannels - 1, 3);
+    Write(aBitDepth - 1, 5);
+    Write(static_cast<TUint32>(aSamples >> 32), 4);
+    Write(static_cast<TUint32>(aSamples), 32);
+    for (TUint i=0; i<4; i++) {
+        Write(0, 32);         // MD5 (not calculated)
+    }
+}
+
+void FlacStreamSynthesiser::WriteFrame(TUint aFrameNumber, const std::vector<TInt32>* aChannels, TUint aBitDepth)
+{
+    const size_t frameStart = iStream.size();
+    Write(0xfff8, 16);        // sync, fixed block size
+    Write(0xc, 4);            // block size 4096
+    Write(0, 4);              // sample rate from STREAMINFO
+    Write(kChannels - 1, 4);  // independent channels
+    Write(0, 3);              // bit depth from STREAMINFO
+    Write(0, 1);
+    WriteUtf8(aFrameNumber);
+    Write(Crc8(&iStream[frameStart], static_cast<TUint>(iStream.size() - frameStart)), 8);
+    for (TUint ch=0; ch<kChannels; ch++) {
+        WriteSubframe(aChannels[ch], aBitDepth);
+    }
+    AlignToByte();
+    Write(Crc16(&iStream[frameStart], static_cast<TUint>(iStream.size() - frameStart)), 16);
+}
+
+void FlacStreamSynthesiser::WriteSubframe(const std::vector<TInt32>& aSamples, TUint aBitDepth)
+{
+    static const TUint kOrder = 2;
+    Write(0, 1);
+    Write(0x08 | kOrder, 6);  // FIXED
+    Write(0, 1);              // no wasted bits
+    for (TUint i=0; i<kOrder; i++) {
+        Write(static_cast<TUint32>(aSamples[i]), aBitDepth);
+    }
+
+    std::vector<TUint32> residuals;
+    residuals.reserve(aSamples.size());
+    TUint64 sum = 0;
+    for (size_t i=kOrder; i<aSamples.size(); i++) {
+        const TInt32 residual = aSamples[i] - 2 * aSamples[i-1] + aSamples[i-2];
+        const TUint32 folded = (residual >= 0? static_cast<TUint32>(residual) << 1 : ((static_cast<TUint32>(-residual) << 1) - 1));
+        residuals.push_back(folded);
+        sum += folded;
+    }
+    const TUint64 mean = sum / residuals.size();
+    TUint param = 0;
+    while (param < 14 && (mean >> (param + 1)) > 0) {
+        param++;
+    }
+
+    Write(0, 2);              // rice coding, 4-bit parameter
+    Write(0, 4);              // partition order 0
+    Write(param, 4);
+    for (auto folded : residuals) {
+        WriteUnary(folded >> param);
+        Write(folded, param);
+    }
+}
+
+TUint8 FlacStreamSynthesiser::Crc8(const TByte* aData, TUint aBytes)
+{ // static
+    TUint8 crc = 0;
+    for (TUint i=0; i<aBytes; i++) {
+        crc ^= aData[i];
+        for (TUint j=0; j<8; j++) {
+            crc = static_cast<TUint8>((crc & 0x80)? (crc << 1) ^ 0x07 : crc << 1);
+        }
+    }
+    return crc;
+}
+
+TUint16 FlacStreamSynthesiser::Crc16(const TByte* aData, TUint aBytes)
+{ // static
+    TUint16 crc = 0;
+    for (TUint i=0; i<aBytes; i++) {
+        crc ^= static_cast<TUint16>(aData[i] << 8);
+        for (TUint j=0; j<8; j++) {
+            crc = static_cast<TUint16>((crc & 0x8000)? (crc << 1) ^ 0x8005 : crc << 1);
+        }
+    }
+    return crc;
+}
+
+
+// SuiteCodecFlacPerf
+
+SuiteCodecFlacPerf::SuiteCodecFlacPerf(Environment& aEnv, TUint aSampleRate, TUint aBitDepth, TUint aSeconds)
+    : Suite("FLAC decode performance")
+    , iEnv(aEnv)
+    , iSampleRate(aSampleRate)
+    , iBitDepth(aBitDepth)
+    , iSeconds(aSeconds)
+    , iSemQuit("TFPQ", 0)
+{
+}
+
+void SuiteCodecFlacPerf::Test()
+{
+    TUint64 expectedSamples = 0;
+    FlacStreamSynthesiser::Synthesise(iSampleRate, iBitDepth, iSeconds, iStream, expectedSamples);
+
+    iTrackFactory = new TrackFactory(iInfoAggregator, 1);
+    MsgFactoryInitParams init;
+    init.SetMsgAudioEncodedCount(100, 100);
+    init.SetMsgAudioPcmCount(100, 100);
+    init.SetMsgTrackCount(2);
+    init.SetMsgEncodedStreamCount(2);
+    init.SetMsgDecodedStreamCount(2);
+    iMsgFactory = new MsgFactory(iInfoAggregator, init);
+    auto controller = new CodecController(*iMsgFactory, *this, *this, *this, Jiffies::kPerMs * 5, kPriorityNormal, false);
+    controller->AddCodec(CodecFactory::NewFlac(*this));
+    iStreamOffset = 0;
+    iPullCount = 0;
+    iSamples = 0;
+    iStartUs = iEndUs = Os::TimeInUs(iEnv.OsCtx());
+    controller->Start();
+    iSemQuit.Wait();
+    delete controller;
+    delete iMsgFactory;
+    delete iTrackFactory;
+
+    TEST(iSamples == expectedSamples);
+    const TUint64 us = std::max(iEndUs - iStartUs, static_cast<TUint64>(1));
+    const double samplesPerSec = static_cast<double>(iSamples) * 1000000 / us;
+    Log::Print("{\"format\":\"flac-%u-%u-stereo\",\"encoded_bytes\":%u,\"samples\":%llu,\"decode_us\":%llu",
+               iBitDepth, iSampleRate, static_cast<TUint>(iStream.size()), iSamples, us);
+    Log::Print(",\"samples_per_sec\":%.0f,\"realtime_factor\":%.1f}\n", samplesPerSec, samplesPerSec / iSampleRate);
+}
+
+Msg* SuiteCodecFlacPerf::Pull()
+{
+    // Called from CodecController's thread
+    switch (iPullCount++)
+    {
+    case 0:
+    {
+        Track* track = iTrackFactory->CreateTrack(Brn("file:///perf.flac"), Brx::Empty());
+        Msg* msg = iMsgFactory->CreateMsgTrack(*track);
+        track->RemoveRef();
+        return msg;
+    }
+    case 1:
+        return iMsgFactory->CreateMsgEncodedStream(Brn("file:///perf.flac"), Brx::Empty(), iStream.size(), 0, 1, false, false, Multiroom::Allowed, this);
+    default:
+        break;
+    }
+    if (iStreamOffset < iStream.size()) {
+        const TUint maxBytes = AudioData::kMaxBytes;
+        const TUint bytes = std::min(static_cast<TUint>(iStream.size()) - iStreamOffset, maxBytes);
+        Msg* msg = iMsgFactory->CreateMsgAudioEncoded(Brn(&iStream[iStreamOffset], bytes));
+        iStreamOffset += bytes;
+        return msg;
+    }
+    return iMsgFactory->CreateMsgQuit();
+}
+
+void SuiteCodecFlacPerf::Push(Msg* aMsg)
+{
+    auto audio = dynamic_cast<MsgAudioPcm*>(aMsg);
+    if (audio != nullptr) {
+        iSamples += audio->Jiffies() / Jiffies::PerSample(iSampleRate);
+        iEndUs = Os::TimeInUs(iEnv.OsCtx());
+    }
+    const TBool quit = (dynamic_cast<MsgQuit*>(aMsg) != nullptr);
+    aMsg->RemoveRef();
+    if (quit) {
+        iSemQuit.Signal();
+    }
+}
+
+EStreamPlay SuiteCodecFlacPerf::OkToPlay(TUint /*aStreamId*/)
+{
+    return ePlayYes;
+}
+
+TUint SuiteCodecFlacPerf::TrySeek(TUint /*aStreamId*/, TUint64 /*aOffset*/)
+{
+    return MsgFlush::kIdInvalid;
+}
+
+TUint SuiteCodecFlacPerf::TryDiscard(TUint /*aJiffies*/)
+{
+    return MsgFlush::kIdInvalid;
+}
+
+TUint SuiteCodecFlacPerf::TryStop(TUint /*aStreamId*/)
+{
+    return MsgFlush::kIdInvalid;
+}
+
+void SuiteCodecFlacPerf::NotifyStarving(const Brx& /*aMode*/, TUint /*aStreamId*/, TBool /*aStarving*/)
+{
+}
+
+TBool SuiteCodecFlacPerf::TryGet(IWriter& /*aWriter*/, const Brx& /*aUrl*/, TUint64 /*aOffset*/, TUint /*aBytes*/)
+{
+    return false;
+}
+
+void SuiteCodecFlacPerf::Add(const TChar* /*aMimeType*/)
+{
+}
+
+
+
+void TestCodecFlacPerf(Environment& aEnv, const std::vector<Brn>& aArgs)
+{
+    OptionParser parser;
+    OptionUint optionRate("-r", "--rate", 192000, "sample rate of synthesised stream");
+    parser.AddOption(&optionRate);
+    OptionUint optionDepth("-b", "--bitdepth", 24, "bit depth of synthesised stream (16 or 24)");
+    parser.AddOption(&optionDepth);
+    OptionUint optionSeconds("-s", "--seconds", 60, "duration (in seconds) of synthesised stream");
+    parser.AddOption(&optionSeconds);
+    if (!parser.Parse(aArgs) || parser.HelpDisplayed()) {
+        return;
+    }
+
+    Runner runner("FLAC decode performance\n");
+    runner.Add(new SuiteCodecFlacPerf(aEnv, optionRate.Value(), optionDepth.Value(), optionSeconds.Value()));
+    runner.Run();
+}
@@ -0,0 +1,16 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/OptionParser.h>
+#include <OpenHome/Net/Private/Globals.h>
+
+#include <vector>
+
+extern void TestCodecFlacPerf(OpenHome::Environment& aEnv, const std::vector<OpenHome::Brn>& aArgs);
+
+void OpenHome::TestFramework::Runner::Main(TInt aArgc, TChar* aArgv[], Net::InitialisationParams* aInitParams)
+{
+    std::vector<Brn> args = OptionParser::ConvertArgs(aArgc, aArgv);
+    Net::UpnpLibrary::InitialiseMinimal(aInitParams);
+    TestCodecFlacPerf(*gEnv, args);
+    delete aInitParams;
+    Net::UpnpLibrary::Close();
+}
@@ -0,0 +1,402 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Private/Standard.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Media/Pipeline/CodecLookahead.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Media/Utils/AllocatorInfoLogger.h>
+
+#include <list>
+#include <vector>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Media;
+
+namespace OpenHome {
+namespace Media {
+
+class SuiteCodecLookahead : public SuiteUnitTest, private IPipelineElementUpstream, private IStreamHandler, private INonCopyable
+{
+    static const TUint kMaxAudioMsgs = 4;
+    static const TUint kMaxStreams = 2;
+    static const TUint kSettleMs = 50;
+    static const TUint kFlushId = 42;
+public:
+    SuiteCodecLookahead();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private: // from IPipelineElementUpstream
+    Msg* Pull() override;
+private: // from IStreamHandler
+    EStreamPlay OkToPlay(TUint aStreamId) override;
+    TUint TrySeek(TUint aStreamId, TUint64 aOffset) override;
+    TUint TryDiscard(TUint aJiffies) override;
+    TUint TryStop(TUint aStreamId) override;
+    void NotifyStarving(const Brx& aMode, TUint aStreamId, TBool aStarving) override;
+private:
+    void Queue(Msg* aMsg);
+    MsgAudioEncoded* CreateAudio();
+    MsgEncodedStream* CreateEncodedStream();
+    TUint UpstreamPullCount();
+    TUint SeekCount();
+    IStreamHandler* PullStreamHandler();
+    void QueueAudioDelayed();
+private:
+    void TestMsgsPassedInOrder();
+    void TestBlocksWhenAudioFull();
+    void TestBlocksWhenStreamsFull();
+    void TestSeekPausesLookahead();
+    void TestSeekDiscardsAudioBeforeFlush();
+    void TestSeekWaitsForPull();
+    void TestSeekFailsWhenPullBlocked();
+    void TestSeekFailsAfterNextStream();
+private:
+    AllocatorInfoLogger iInfoAggregator;
+    MsgFactory* iMsgFactory;
+    CodecLookahead* iLookahead;
+    Mutex iLock;
+    Semaphore iSemPending;
+    std::list<Msg*> iPendingMsgs;
+    TUint iPullCount;
+    TUint iNextStreamId;
+    TUint iSeekCount;
+    TBool iPausedDuringSeek;
+};
+
+} // namespace Media
+} // namespace OpenHome
+
+
+SuiteCodecLookahead::SuiteCodecLookahead()
+    : SuiteUnitTest("CodecLookahead")
+    , iLock("TCLA")
+    , iSemPending("TCLA", 0)
+{
+    AddTest(MakeFunctor(*this, &SuiteCodecLookahead::TestMsgsPassedInOrder), "TestMsgsPassedInOrder");
+    AddTest(MakeFunctor(*this, &SuiteCodecLookahead::TestBlocksWhenAudioFull), "TestBlocksWhenAudioFull");
+    AddTest(MakeFunctor(*this, &SuiteCodecLookahead::TestBlocksWhenStreamsFull), "TestBlocksWhenStreamsFull");
+    AddTest(MakeFunctor(*this, &SuiteCodecLookahead::TestSeekPausesLookahead), "TestSeekPausesLookahead");
+    AddTest(MakeFunctor(*this, &SuiteCodecLookahead::TestSeekDiscardsAudioBeforeFlush), "TestSeekDiscardsAudioBeforeFlush");
+    AddTest(MakeFunctor(*this, &SuiteCodecLookahead::TestSeekWaitsForPull), "TestSeekWaitsForPull");
+    AddTest(MakeFunctor(*this, &SuiteCodecLookahead::TestSeekFailsWhenPullBlocked), "TestSeekFailsWhenPullBlocked");
+    AddTest(MakeFunctor(*this, &SuiteCodecLookahead::TestSeekFailsAfterNextStream), "TestSeekFailsAfterNextStream");
+}
+
+void SuiteCodecLookahead::Setup()
+{
+    MsgFactoryInitParams init;
+    init.SetMsgAudioEncodedCount(20, 20);
+    init.SetMsgEncodedStreamCount(5);
+    init.SetMsgHaltCount(2);
+    init.SetMsgFlushCount(3);
+    iMsgFactory = new MsgFactory(iInfoAggregator, init);
+    iLookahead = new CodecLookahead(*iMsgFactory, *this, kMaxAudioMsgs, kMaxStreams, kPriorityNormal);
+    (void)iSemPending.Clear();
+    iPullCount = 0;
+    iNextStreamId = 1;
+    iSeekCount = 0;
+    iPausedDuringSeek = false;
+    iLookahead->Start();
+}
+
+void SuiteCodecLookahead::TearDown()
+{
+    Queue(iMsgFactory->CreateMsgQuit());
+    for (;;) {
+        Msg* msg = iLookahead->Pull();
+        const TBool quit = (dynamic_cast<MsgQuit*>(msg) != nullptr);
+        msg->RemoveRef();
+        if (quit) {
+            break;
+        }
+    }
+    delete iLookahead;
+    ASSERT(iPendingMsgs.size() == 0);
+    delete iMsgFactory;
+}
+
+Msg* SuiteCodecLookahead::Pull()
+{
+    iSemPending.Wait();
+    AutoMutex _(iLock);
+    ASSERT(iPendingMsgs.size() > 0);
+    Msg* msg = iPendingMsgs.front();
+    iPendingMsgs.pop_front();
+    iPullCount++;
+    return msg;
+}
+
+EStreamPlay SuiteCodecLookahead::OkToPlay(TUint /*aStreamId*/)
+{
+    ASSERTS();
+    return ePlayNo;
+}
+
+TUint SuiteCodecLookahead::TrySeek(TUint /*aStreamId*/, TUint64 /*aOffset*/)
+{
+    {
+        AutoMutex _(iLookahead->iLock);
+        iPausedDuringSeek = iLookahead->iPaused;
+    }
+    AutoMutex _(iLock);
+    iSeekCount++;
+    return kFlushId;
+}
+
+TUint SuiteCodecLookahead::TryDiscard(TUint /*aJiffies*/)
+{
+    ASSERTS();
+    return MsgFlush::kIdInvalid;
+}
+
+TUint SuiteCodecLookahead::TryStop(TUint /*aStreamId*/)
+{
+    ASSERTS();
+    return MsgFlush::kIdInvalid;
+}
+
+void SuiteCodecLookahead::NotifyStarving(const Brx& /*aMode*/, TUint /*aStreamId*/, TBool /*aStarving*/)
+{
+}
+
+void SuiteCodecLookahead::Queue(Msg* aMsg)
+{
+    iLock.Wait();
+    iPendingMsgs.push_back(aMsg);
+    iLock.Signal();
+    iSemPending.Signal();
+}
+
+MsgAudioEncoded* SuiteCodecLookahead::CreateAudio()
+{
+    TByte data[64];
+    (void)memset(data, 0x7f, sizeof(data));
+    return iMsgFactory->CreateMsgAudioEncoded(Brn(data, sizeof(data)));
+}
+
+MsgEncodedStream* SuiteCodecLookahead::CreateEncodedStream()
+{
+    return iMsgFactory->CreateMsgEncodedStream(Brn("http://1.2.3.4:5"), Brx::Empty(), 0, 0, iNextStreamId++, true, false, Multiroom::Allowed, this);
+}
+
+TUint SuiteCodecLookahead::UpstreamPullCount()
+{
+    Thread::Sleep(kSettleMs);
+    AutoMutex _(iLock);
+    return iPullCount;
+}
+
+TUint SuiteCodecLookahead::SeekCount()
+{
+    Thread::Sleep(kSettleMs);
+    AutoMutex _(iLock);
+    return iSeekCount;
+}
+
+IStreamHandler* SuiteCodecLookahead::PullStreamHandler()
+{
+    Msg* msg = iLookahead->Pull();
+    auto stream = dynamic_cast<MsgEncodedStream*>(msg);
+    ASSERT(stream != nullptr);
+    IStreamHandler* streamHandler = stream->StreamHandler();
+    msg->RemoveRef();
+    return streamHandler;
+}
+
+void SuiteCodecLookahead::QueueAudioDelayed()
+{
+    Thread::Sleep(kSettleMs); // well within CodecLookahead::kPauseTimeoutMs
+    Queue(CreateAudio());
+}
+
+void SuiteCodecLookahead::TestMsgsPassedInOrder()
+{
+    std::vector<Msg*> expected;
+    expected.push_back(CreateEncodedStream());
+    expected.push_back(CreateAudio());
+    expected.push_back(CreateAudio());
+    expected.push_back(iMsgFactory->CreateMsgHalt());
+    expected.push_back(CreateEncodedStream());
+    expected.push_back(CreateAudio());
+    for (auto msg : expected) {
+        Queue(msg);
+    }
+    for (auto msg : expected) {
+        Msg* pulled = iLookahead->Pull();
+        // MsgEncodedStream is replaced so that seeks are routed via CodecLookahead
+        auto stream = dynamic_cast<MsgEncodedStream*>(pulled);
+        if (stream != nullptr) {
+            TEST(stream->StreamId() == static_cast<MsgEncodedStream*>(msg)->StreamId());
+            TEST(stream->StreamHandler() == iLookahead);
+        }
+        else {
+            TEST(pulled == msg);
+        }
+        pulled->RemoveRef();
+    }
+}
+
+void SuiteCodecLookahead::TestBlocksWhenAudioFull()
+{
+    Queue(CreateEncodedStream());
+    for (TUint i=0; i<kMaxAudioMsgs+3; i++) {
+        Queue(CreateAudio());
+    }
+    TEST(UpstreamPullCount() == kMaxAudioMsgs + 1);
+
+    // pulling one msg out lets the lookahead thread fetch one more
+    iLookahead->Pull()->RemoveRef(); // MsgEncodedStream
+    TEST(UpstreamPullCount() == kMaxAudioMsgs + 1);
+    iLookahead->Pull()->RemoveRef();
+    TEST(UpstreamPullCount() == kMaxAudioMsgs + 2);
+
+    for (TUint i=0; i<kMaxAudioMsgs+2; i++) {
+        Msg* msg = iLookahead->Pull();
+        TEST(dynamic_cast<MsgAudioEncoded*>(msg) != nullptr);
+        msg->RemoveRef();
+    }
+}
+
+void SuiteCodecLookahead::TestBlocksWhenStreamsFull()
+{
+    for (TUint i=0; i<kMaxStreams+1; i++) {
+        Queue(CreateEncodedStream());
+    }
+    TEST(UpstreamPullCount() == kMaxStreams);
+
+    iLookahead->Pull()->RemoveRef();
+    TEST(UpstreamPullCount() == kMaxStreams + 1);
+    for (TUint i=0; i<kMaxStreams; i++) {
+        Msg* msg = iLookahead->Pull();
+        TEST(dynamic_cast<MsgEncodedStream*>(msg) != nullptr);
+        msg->RemoveRef();
+    }
+}
+void SuiteCodecLookahead::TestSeekPausesLookahead()
+{
+    Queue(CreateEncodedStream());
+    for (TUint i=0; i<kMaxAudioMsgs; i++) {
+        Queue(CreateAudio());
+    }
+    IStreamHandler* streamHandler = PullStreamHandler();
+    TEST(UpstreamPullCount() == kMaxAudioMsgs + 1);
+
+    // seek runs on the calling (codec) thread while the lookahead thread is parked
+    TEST(streamHandler->TrySeek(1, 0) == kFlushId);
+    TEST(iSeekCount == 1);
+    TEST(iPausedDuringSeek);
+    TEST(!iLookahead->iPaused);
+
+    // lookahead resumes pulling afterwards
+    Queue(iMsgFactory->CreateMsgFlush(kFlushId));
+    Queue(CreateAudio());
+    Msg* msg = iLookahead->Pull();
+    TEST(dynamic_cast<MsgFlush*>(msg) != nullptr);
+    msg->RemoveRef();
+    msg = iLookahead->Pull();
+    TEST(dynamic_cast<MsgAudioEncoded*>(msg) != nullptr);
+    msg->RemoveRef();
+    TEST(UpstreamPullCount() == kMaxAudioMsgs + 3);
+}
+
+void SuiteCodecLookahead::TestSeekDiscardsAudioBeforeFlush()
+{
+    Queue(CreateEncodedStream());
+    for (TUint i=0; i<kMaxAudioMsgs; i++) {
+        Queue(CreateAudio());
+    }
+    IStreamHandler* streamHandler = PullStreamHandler();
+    (void)UpstreamPullCount();
+    TEST(streamHandler->TrySeek(1, 0) == kFlushId);
+
+    // audio queued before the seek, or pulled before the flush arrives, is read from the old position
+    Queue(CreateAudio());
+    Queue(iMsgFactory->CreateMsgFlush(kFlushId));
+    MsgAudioEncoded* audio = CreateAudio();
+    Queue(audio);
+    Msg* msg = iLookahead->Pull();
+    TEST(dynamic_cast<MsgFlush*>(msg) != nullptr);
+    msg->RemoveRef();
+    msg = iLookahead->Pull();
+    TEST(msg == audio);
+    msg->RemoveRef();
+}
+
+void SuiteCodecLookahead::TestSeekWaitsForPull()
+{
+    // lookahead thread is pulling from upstream; seek runs once that pull completes
+    Queue(CreateEncodedStream());
+    Queue(CreateAudio());
+    IStreamHandler* streamHandler = PullStreamHandler();
+    TEST(UpstreamPullCount() == 2);
+    ThreadFunctor* queuer = new ThreadFunctor("TCLQ", MakeFunctor(*this, &SuiteCodecLookahead::QueueAudioDelayed));
+    queuer->Start();
+    TEST(streamHandler->TrySeek(1, 0) == kFlushId);
+    TEST(iSeekCount == 1);
+    TEST(iPausedDuringSeek);
+    delete queuer;
+
+    // both audio msgs were read from before the seek point
+    Queue(iMsgFactory->CreateMsgFlush(kFlushId));
+    MsgAudioEncoded* audio = CreateAudio();
+    Queue(audio);
+    Msg* msg = iLookahead->Pull();
+    TEST(dynamic_cast<MsgFlush*>(msg) != nullptr);
+    msg->RemoveRef();
+    msg = iLookahead->Pull();
+    TEST(msg == audio);
+    msg->RemoveRef();
+}
+
+void SuiteCodecLookahead::TestSeekFailsWhenPullBlocked()
+{
+    // lookahead thread is blocked pulling from upstream for longer than a seek will wait
+    Queue(CreateEncodedStream());
+    Queue(CreateAudio());
+    IStreamHandler* streamHandler = PullStreamHandler();
+    TEST(UpstreamPullCount() == 2);
+    TEST(streamHandler->TrySeek(1, 0) == MsgFlush::kIdInvalid);
+    TEST(SeekCount() == 0);
+
+    // nothing is discarded; lookahead carries on after its pull completes
+    Msg* msg = iLookahead->Pull();
+    TEST(dynamic_cast<MsgAudioEncoded*>(msg) != nullptr);
+    msg->RemoveRef();
+    MsgAudioEncoded* audio = CreateAudio();
+    Queue(audio);
+    msg = iLookahead->Pull();
+    TEST(msg == audio);
+    msg->RemoveRef();
+}
+
+void SuiteCodecLookahead::TestSeekFailsAfterNextStream()
+{
+    // ContainerController has moved on to stream 2 so can no longer seek stream 1
+    Queue(CreateEncodedStream());
+    Queue(CreateEncodedStream());
+    for (TUint i=0; i<kMaxAudioMsgs; i++) {
+        Queue(CreateAudio());
+    }
+    IStreamHandler* streamHandler = PullStreamHandler();
+    TEST(UpstreamPullCount() == kMaxAudioMsgs + 2);
+    TEST(streamHandler->TrySeek(1, 0) == MsgFlush::kIdInvalid);
+    TEST(iSeekCount == 0);
+
+    (void)PullStreamHandler();
+    for (TUint i=0; i<kMaxAudioMsgs; i++) {
+        Msg* msg = iLookahead->Pull();
+        TEST(dynamic_cast<MsgAudioEncoded*>(msg) != nullptr);
+        msg->RemoveRef();
+    }
+}
+
+
+
+void TestCodecLookahead()
+{
+    Runner runner("CodecLookahead tests\n");
+    runner.Add(new SuiteCodecLookahead());
+    runner.Run();
+}
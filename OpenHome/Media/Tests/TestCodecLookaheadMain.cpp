@@ -0,0 +1,11 @@
+#include <OpenHome/Private/TestFramework.h>
+
+extern void TestCodecLookahead();
+
+void OpenHome::TestFramework::Runner::Main(TInt /*aArgc*/, TChar* /*aArgv*/[], Net::InitialisationParams* aInitParams)
+{
+    Net::UpnpLibrary::InitialiseMinimal(aInitParams);
+    TestCodecLookahead();
+    delete aInitParams;
+    Net::UpnpLibrary::Close();
+}
@@ -0,0 +1,364 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Media/Codec/CodecController.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Media/Utils/PcmKernels.h>
+#include <OpenHome/Private/OptionParser.h>
+#include <OpenHome/Private/Env.h>
+#include <OpenHome/OsWrapper.h>
+
+#include <vector>
+
+/*
+ * Codec output micro-benchmark.
+ *
+ * Measures the cost of interleaving planar decoder output (as produced by FLAC and MP3) into
+ * pipeline audio buffers, comparing the per-subsample AudioBufWriter::WritePlanar() path ("before")
+ * with the vectorised AudioBufWriter::WritePlanarInt32() path ("after").  Decoding itself is not
+ * included so the figures show the maximum gain available to a codec.
+ *
+ * Results are written as one JSON object per line (one per format).
+ */
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Media;
+using namespace OpenHome::Media::Codec;
+
+namespace OpenHome {
+namespace Media {
+
+class CodecOutputFormat
+{
+public:
+    const TChar* iName;
+    TUint iBitDepth;
+    TUint iNumChannels;
+    TUint iBlockSamples; // samples output per call, matching a typical decoded frame
+    TUint iShift;        // non-zero for libmad fixed point output
+};
+
+// Accepts audio from AudioBufWriter, discarding it.  Other ICodecController functions are not used.
+class CodecControllerOutputPerf : public ICodecController
+{
+public:
+    CodecControllerOutputPerf();
+    void SetFormat(TUint aBitDepth, TUint aNumChannels);
+    TUint64 Samples() const;
+private: // from ICodecController
+    void Read(Bwx& aBuf, TUint aBytes) override;
+    void ReadNextMsg(Bwx& aBuf) override;
+    MsgAudioEncoded* ReadNextMsg() override;
+    TBool Read(IWriter& aWriter, TUint64 aOffset, TUint aBytes) override;
+    TBool TrySeekTo(TUint aStreamId, TUint64 aBytePos) override;
+    TUint64 StreamLength() const override;
+    TUint64 StreamPos() const override;
+    void AddSeekPoint(TUint64 aSample, TUint64 aBytePos) override;
+    TBool TryGetSeekPoint(TUint64 aSample, TUint64& aSamplePoint, TUint64& aBytePos) override;
+    void OutputDecodedStream(TUint aBitRate, TUint aBitDepth, TUint aSampleRate, TUint aNumChannels,
+                             const Brx& aCodecName, TUint64 aTrackLength, TUint64 aSampleStart, TBool aLossless,
+                             SpeakerProfile aProfile, TBool aAnalogBypass = false) override;
+    void OutputDecodedStreamDsd(TUint aSampleRate, TUint aNumChannels, const Brx& aCodecName,
+                                TUint64 aTrackLength, TUint64 aSampleStart, SpeakerProfile aProfile) override;
+    TUint64 OutputAudioPcm(const Brx& aData, TUint aChannels, TUint aSampleRate, TUint aBitDepth, AudioDataEndian aEndian, TUint64 aTrackOffset) override;
+    TUint64 OutputAudioPcm(MsgAudioEncoded* aMsg, TUint aChannels, TUint aSampleRate, TUint aBitDepth, TUint64 aTrackOffset) override;
+    TUint64 OutputAudioDsd(const Brx& aData, TUint aChannels, TUint aSampleRate, TUint aSampleBlockWords, TUint64 aTrackOffset, TUint aPadBytesPerChunk) override;
+    TUint64 OutputAudioDsd(MsgAudioEncoded* aMsg, TUint aChannels, TUint aSampleRate, TUint aSampleBlockWords, TUint64 aTrackOffset, TUint aPadBytesPerChunk) override;
+    void OutputMetaText(const Brx& aMetaText) override;
+    void OutputStreamInterrupted() override;
+    void GetAudioBuf(TByte*& aDest, TUint& aSamples) override;
+    AudioDataEndian AudioBufEndian() const override;
+    void OutputAudioBuf(TUint aSamples, TUint64& aTrackOffset) override;
+    void AppendAudioBuf(TUint aSamples, TUint64& aTrackOffset) override;
+    void FlushAudioBuf() override;
+    TUint MaxBitDepth() const override;
+private:
+    TByte iBuf[DecodedAudio::kMaxBytes];
+    TUint iBytesPerSample;
+    TUint iSamplesHeld;
+    TUint64 iSamples;
+};
+
+class SuiteCodecOutputPerf : public Suite
+{
+    static const TUint kMaxChannels = 6;
+    static const TUint kMaxBlockSamples = 4608;
+public:
+    SuiteCodecOutputPerf(Environment& aEnv, TUint aSamples);
+    void Test() override;
+private:
+    TUint64 Run(const CodecOutputFormat& aFormat, TBool aVectorised);
+    void Report(const CodecOutputFormat& aFormat, TUint64 aBeforeUs, TUint64 aAfterUs);
+private:
+    Environment& iEnv;
+    const TUint iSamples;
+    CodecControllerOutputPerf iController;
+    std::vector<TInt32> iPlanar[kMaxChannels];
+};
+
+} // namespace Media
+} // namespace OpenHome
+
+
+// CodecControllerOutputPerf
+
+CodecControllerOutputPerf::CodecControllerOutputPerf()
+    : iBytesPerSample(1)
+    , iSamplesHeld(0)
+    , iSamples(0)
+{
+}
+
+void CodecControllerOutputPerf::SetFormat(TUint aBitDepth, TUint aNumChannels)
+{
+    iBytesPerSample = (aBitDepth / 8) * aNumChannels;
+    iSamplesHeld = 0;
+    iSamples = 0;
+}
+
+TUint64 CodecControllerOutputPerf::Samples() const
+{
+    return iSamples;
+}
+
+void CodecControllerOutputPerf::Read(Bwx& /*aBuf*/, TUint /*aBytes*/)
+{
+    ASSERTS();
+}
+
+void CodecControllerOutputPerf::ReadNextMsg(Bwx& /*aBuf*/)
+{
+    ASSERTS();
+}
+
+MsgAudioEncoded* CodecControllerOutputPerf::ReadNextMsg()
+{
+    ASSERTS();
+    return nullptr;
+}
+
+TBool CodecControllerOutputPerf::Read(IWriter& /*aWriter*/, TUint64 /*aOffset*/, TUint /*aBytes*/)
+{
+    ASSERTS();
+    return false;
+}
+
+TBool CodecControllerOutputPerf::TrySeekTo(TUint /*aStreamId*/, TUint64 /*aBytePos*/)
+{
+    ASSERTS();
+    return false;
+}
+
+TUint64 CodecControllerOutputPerf::StreamLength() const
+{
+    ASSERTS();
+    return 0;
+}
+
+TUint64 CodecControllerOutputPerf::StreamPos() const
+{
+    ASSERTS();
+    return 0;
+}
+
+void CodecControllerOutputPerf::AddSeekPoint(TUint64 /*aSample*/, TUint64 /*aBytePos*/)
+{
+    ASSERTS();
+}
+
+TBool CodecControllerOutputPerf::TryGetSeekPoint(TUint64 /*aSample*/, TUint64& /*aSamplePoint*/, TUint64& /*aBytePos*/)
+{
+    ASSERTS();
+    return false;
+}
+
+void CodecControllerOutputPerf::OutputDecodedStream(TUint /*aBitRate*/, TUint /*aBitDepth*/, TUint /*aSampleRate*/, TUint /*aNumChannels*/,
+                                                    const Brx& /*aCodecName*/, TUint64 /*aTrackLength*/, TUint64 /*aSampleStart*/, TBool /*aLossless*/,
+                                                    SpeakerProfile /*aProfile*/, TBool /*aAnalogBypass*/)
+{
+    ASSERTS();
+}
+
+void CodecControllerOutputPerf::OutputDecodedStreamDsd(TUint /*aSampleRate*/, TUint /*aNumChannels*/, const Brx& /*aCodecName*/,
+                                                       TUint64 /*aTrackLength*/, TUint64 /*aSampleStart*/, SpeakerProfile /*aProfile*/)
+{
+    ASSERTS();
+}
+
+TUint64 CodecControllerOutputPerf::OutputAudioPcm(const Brx& /*aData*/, TUint /*aChannels*/, TUint /*aSampleRate*/, TUint /*aBitDepth*/,
+                                                  AudioDataEndian /*aEndian*/, TUint64 /*aTrackOffset*/)
+{
+    ASSERTS();
+    return 0;
+}
+
+TUint64 CodecControllerOutputPerf::OutputAudioPcm(MsgAudioEncoded* /*aMsg*/, TUint /*aChannels*/, TUint /*aSampleRate*/, TUint /*aBitDepth*/,
+                                                  TUint64 /*aTrackOffset*/)
+{
+    ASSERTS();
+    return 0;
+}
+
+TUint64 CodecControllerOutputPerf::OutputAudioDsd(const Brx& /*aData*/, TUint /*aChannels*/, TUint /*aSampleRate*/, TUint /*aSampleBlockWords*/,
+                                                  TUint64 /*aTrackOffset*/, TUint /*aPadBytesPerChunk*/)
+{
+    ASSERTS();
+    return 0;
+}
+
+TUint64 CodecControllerOutputPerf::OutputAudioDsd(MsgAudioEncoded* /*aMsg*/, TUint /*aChannels*/, TUint /*aSampleRate*/, TUint /*aSampleBlockWords*/,
+                                                  TUint64 /*aTrackOffset*/, TUint /*aPadBytesPerChunk*/)
+{
+    ASSERTS();
+    return 0;
+}
+
+void CodecControllerOutputPerf::OutputMetaText(const Brx& /*aMetaText*/)
+{
+    ASSERTS();
+}
+
+void CodecControllerOutputPerf::OutputStreamInterrupted()
+{
+    ASSERTS();
+}
+
+void CodecControllerOutputPerf::GetAudioBuf(TByte*& aDest, TUint& aSamples)
+{
+    aDest = iBuf + (iSamplesHeld * iBytesPerSample);
+    aSamples = (sizeof(iBuf) / iBytesPerSample) - iSamplesHeld;
+}
+
+AudioDataEndian CodecControllerOutputPerf::AudioBufEndian() const
+{
+    return AudioDataEndian::Big;
+}
+
+void CodecControllerOutputPerf::OutputAudioBuf(TUint aSamples, TUint64& aTrackOffset)
+{
+    AppendAudioBuf(aSamples, aTrackOffset);
+    FlushAudioBuf();
+}
+
+void CodecControllerOutputPerf::AppendAudioBuf(TUint aSamples, TUint64& aTrackOffset)
+{
+    iSamplesHeld += aSamples;
+    iSamples += aSamples;
+    aTrackOffset += aSamples;
+    if (iSamplesHeld == sizeof(iBuf) / iBytesPerSample) {
+        FlushAudioBuf();
+    }
+}
+
+void CodecControllerOutputPerf::FlushAudioBuf()
+{
+    iSamplesHeld = 0;
+}
+
+TUint CodecControllerOutputPerf::MaxBitDepth() const
+{
+    return 32;
+}
+
+
+// SuiteCodecOutputPerf
+
+// Conversion used by CodecMp3 before packing was vectorised: clip to +/-1.0 then take the top 24 bits
+static TInt32 MadFixedTo24(TInt32 aFixed)
+{
+    const TInt32 kOne = 1 << 28;
+    if (aFixed >= kOne) {
+        return 0x7fffff;
+    }
+    if (aFixed <= -kOne) {
+        return -0x800000;
+    }
+    return aFixed >> 5;
+}
+
+SuiteCodecOutputPerf::SuiteCodecOutputPerf(Environment& aEnv, TUint aSamples)
+    : Suite("Codec output performance")
+    , iEnv(aEnv)
+    , iSamples(aSamples)
+{
+    // a quiet-ish signal, with occasional values that need clipping
+    for (TUint i=0; i<kMaxChannels; i++) {
+        iPlanar[i].resize(kMaxBlockSamples);
+        for (TUint j=0; j<kMaxBlockSamples; j++) {
+            const TUint32 hash = ((j * 7) + (i * 131) + 1) * 2654435761u;
+            iPlanar[i][j] = (TInt32)hash >> (8 + (j % 5));
+        }
+    }
+}
+
+void SuiteCodecOutputPerf::Test()
+{
+    static const CodecOutputFormat kFormats[] = {
+        { "flac-16-mono",   16, 1, 4096, 0 },
+        { "flac-16-stereo", 16, 2, 4096, 0 },
+        { "flac-24-stereo", 24, 2, 4096, 0 },
+        { "flac-24-5.1",    24, 6, 4096, 0 },
+        { "mp3-mono",       24, 1, 1152, 5 },
+        { "mp3-stereo",     24, 2, 1152, 5 },
+    };
+    for (TUint i=0; i<sizeof(kFormats)/sizeof(kFormats[0]); i++) {
+        const CodecOutputFormat& format = kFormats[i];
+        const TUint64 beforeUs = Run(format, false);
+        const TUint64 afterUs = Run(format, true);
+        Report(format, beforeUs, afterUs);
+        TEST(iController.Samples() >= iSamples);
+    }
+}
+
+TUint64 SuiteCodecOutputPerf::Run(const CodecOutputFormat& aFormat, TBool aVectorised)
+{
+    const TInt32* channels[kMaxChannels];
+    for (TUint i=0; i<kMaxChannels; i++) {
+        channels[i] = &iPlanar[i][0];
+    }
+    iController.SetFormat(aFormat.iBitDepth, aFormat.iNumChannels);
+    TUint64 trackOffset = 0;
+    OsContext* osCtx = iEnv.OsCtx();
+    const TUint64 start = Os::TimeInUs(osCtx);
+    while (iController.Samples() < iSamples) {
+        if (aVectorised) {
+            AudioBufWriter::WritePlanarInt32(iController, channels, aFormat.iNumChannels, aFormat.iBitDepth,
+                                             aFormat.iBlockSamples, trackOffset, aFormat.iShift);
+        }
+        else if (aFormat.iShift == 0) {
+            AudioBufWriter::WritePlanar(iController, channels, aFormat.iNumChannels, aFormat.iBitDepth,
+                                        aFormat.iBlockSamples, trackOffset, [](TInt32 aSubsample) { return aSubsample; });
+        }
+        else {
+            AudioBufWriter::WritePlanar(iController, channels, aFormat.iNumChannels, aFormat.iBitDepth,
+                                        aFormat.iBlockSamples, trackOffset, MadFixedTo24);
+        }
+    }
+    return Os::TimeInUs(osCtx) - start;
+}
+
+void SuiteCodecOutputPerf::Report(const CodecOutputFormat& aFormat, TUint64 aBeforeUs, TUint64 aAfterUs)
+{
+    const double samples = (double)iController.Samples();
+    const double before = samples * 1000000 / (aBeforeUs == 0? 1 : aBeforeUs);
+    const double after = samples * 1000000 / (aAfterUs == 0? 1 : aAfterUs);
+    Log::Print("{\"format\":\"%s\",\"bit_depth\":%u,\"channels\":%u,\"block_samples\":%u,\"kernels\":\"%s\"",
+               aFormat.iName, aFormat.iBitDepth, aFormat.iNumChannels, aFormat.iBlockSamples, PcmKernels::Implementation());
+    Log::Print(",\"samples\":%llu,\"before_samples_per_sec\":%.0f,\"after_samples_per_sec\":%.0f,\"speedup\":%.2f}\n",
+               iController.Samples(), before, after, after / before);
+}
+
+
+
+void TestCodecOutputPerf(Environment& aEnv, const std::vector<Brn>& aArgs)
+{
+    OptionParser parser;
+    OptionUint optionSamples("-s", "--samples", 50000000, "samples to output for each format");
+    parser.AddOption(&optionSamples);
+    if (!parser.Parse(aArgs) || parser.HelpDisplayed()) {
+        return;
+    }
+
+    Runner runner("Codec output performance\n");
+    runner.Add(new SuiteCodecOutputPerf(aEnv, optionSamples.Value()));
+    runner.Run();
+}
@@ -0,0 +1,240 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Media/Codec/DsdPacker.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Private/Env.h>
+#include <OpenHome/OsWrapper.h>
+
+#include <string.h>
+#include <vector>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Media;
+
+namespace OpenHome {
+namespace Media {
+
+class SuiteDsdPacker : public SuiteUnitTest, private INonCopyable
+{
+    static const TUint kMaxChunks = 4;
+    static const TUint kMaxBytes = kMaxChunks * 8;
+public:
+    SuiteDsdPacker();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    void TestChunksNoPadding();
+    void TestChunksPadding();
+    void TestInterleavedBytes();
+    void TestPlanarLsbFirst();
+    void TestSilence();
+    void TestChunks32Bit();
+private:
+    TByte iDest[kMaxBytes];
+};
+
+/*
+ * Time taken to pack DSD256 stereo from each codec's layout, for each padding size.
+ *
+ * Results are written as one JSON object per line.  "realtime" is seconds of audio packed
+ * per second of CPU time.
+ */
+class SuiteDsdPackerThroughput : public Suite, private INonCopyable
+{
+    static const TUint kBytesPerSecondDsd256 = 2 * (256 * 44100 / 8); // stereo
+    static const TUint kChunksPerSecondDsd256 = kBytesPerSecondDsd256 / DsdPacker::kPlayableBytesPerChunk;
+    static const TUint kBlockChunks = 4096; // similar to the chunks packed per call by the codecs
+public:
+    SuiteDsdPackerThroughput(Environment& aEnv, TUint aSeconds);
+    void Test() override;
+private:
+    enum class ESource {
+        Dsf,
+        Dff,
+        Raw
+    };
+    TUint64 Run(DsdPacker& aPacker, ESource aSource);
+    static const TChar* SourceName(ESource aSource);
+private:
+    Environment& iEnv;
+    const TUint iSeconds;
+    std::vector<TByte> iSrc;
+    std::vector<TByte> iDest;
+};
+
+} // namespace Media
+} // namespace OpenHome
+
+
+// SuiteDsdPacker
+
+SuiteDsdPacker::SuiteDsdPacker()
+    : SuiteUnitTest("DsdPacker")
+{
+    AddTest(MakeFunctor(*this, &SuiteDsdPacker::TestChunksNoPadding), "TestChunksNoPadding");
+    AddTest(MakeFunctor(*this, &SuiteDsdPacker::TestChunksPadding), "TestChunksPadding");
+    AddTest(MakeFunctor(*this, &SuiteDsdPacker::TestInterleavedBytes), "TestInterleavedBytes");
+    AddTest(MakeFunctor(*this, &SuiteDsdPacker::TestPlanarLsbFirst), "TestPlanarLsbFirst");
+    AddTest(MakeFunctor(*this, &SuiteDsdPacker::TestSilence), "TestSilence");
+    AddTest(MakeFunctor(*this, &SuiteDsdPacker::TestChunks32Bit), "TestChunks32Bit");
+}
+
+void SuiteDsdPacker::Setup()
+{
+    (void)memset(iDest, 0xff, sizeof(iDest));
+}
+
+void SuiteDsdPacker::TearDown()
+{
+}
+
+void SuiteDsdPacker::TestChunksNoPadding()
+{
+    DsdPacker packer(0);
+    TEST(packer.BytesPerChunk() == 4);
+    const TByte src[] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08 };
+    packer.PackChunks(src, iDest, 2);
+    TEST(Brn(iDest, sizeof(src)) == Brn(src, sizeof(src)));
+    TEST(iDest[sizeof(src)] == 0xff);
+}
+
+void SuiteDsdPacker::TestChunksPadding()
+{
+    DsdPacker packer(2);
+    TEST(packer.BytesPerChunk() == 6);
+    const TByte src[] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08 };
+    const TByte expected[] = { 0x00, 0x01, 0x02, 0x00, 0x03, 0x04,
+                               0x00, 0x05, 0x06, 0x00, 0x07, 0x08 };
+    packer.PackChunks(src, iDest, 2);
+    TEST(Brn(iDest, sizeof(expected)) == Brn(expected, sizeof(expected)));
+    TEST(iDest[sizeof(expected)] == 0xff);
+}
+
+void SuiteDsdPacker::TestInterleavedBytes()
+{
+    DsdPacker packer(2);
+    // L0 R0 L1 R1
+    const TByte src[] = { 0x11, 0x21, 0x12, 0x22, 0x13, 0x23, 0x14, 0x24 };
+    const TByte expected[] = { 0x00, 0x11, 0x12, 0x00, 0x21, 0x22,
+                               0x00, 0x13, 0x14, 0x00, 0x23, 0x24 };
+    packer.PackInterleavedBytes(src, iDest, 2);
+    TEST(Brn(iDest, sizeof(expected)) == Brn(expected, sizeof(expected)));
+}
+
+void SuiteDsdPacker::TestPlanarLsbFirst()
+{
+    DsdPacker packer(2);
+    const TByte left[]  = { 0x01, 0x03, 0x0f, 0x80 };
+    const TByte right[] = { 0x02, 0x55, 0xf0, 0xc4 };
+    const TByte expected[] = { 0x00, 0x80, 0xc0, 0x00, 0x40, 0xaa,
+                               0x00, 0xf0, 0x01, 0x00, 0x0f, 0x23 };
+    packer.PackPlanarLsbFirst(left, right, iDest, 2);
+    TEST(Brn(iDest, sizeof(expected)) == Brn(expected, sizeof(expected)));
+}
+
+void SuiteDsdPacker::TestSilence()
+{
+    DsdPacker packer(2);
+    const TByte expected[] = { 0x00, 0x69, 0x69, 0x00, 0x69, 0x69 };
+    packer.PackSilence(iDest, 1);
+    TEST(Brn(iDest, sizeof(expected)) == Brn(expected, sizeof(expected)));
+    TEST(iDest[sizeof(expected)] == 0xff);
+}
+
+void SuiteDsdPacker::TestChunks32Bit()
+{
+    DsdPacker packer(4);
+    TEST(packer.BytesPerChunk() == 8);
+    const TByte src[] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08 };
+    const TByte expected[] = { 0x00, 0x00, 0x01, 0x02, 0x00, 0x00, 0x03, 0x04,
+                               0x00, 0x00, 0x05, 0x06, 0x00, 0x00, 0x07, 0x08 };
+    packer.PackChunks(src, iDest, 2);
+    TEST(Brn(iDest, sizeof(expected)) == Brn(expected, sizeof(expected)));
+    TEST(iDest[sizeof(expected)] == 0xff);
+}
+
+
+// SuiteDsdPackerThroughput
+
+SuiteDsdPackerThroughput::SuiteDsdPackerThroughput(Environment& aEnv, TUint aSeconds)
+    : Suite("DsdPacker throughput")
+    , iEnv(aEnv)
+    , iSeconds(aSeconds)
+    , iSrc(kBlockChunks * DsdPacker::kPlayableBytesPerChunk)
+    , iDest(kBlockChunks * (DsdPacker::kPlayableBytesPerChunk + 4))
+{
+    for (TUint i=0; i<iSrc.size(); i++) {
+        iSrc[i] = (TByte)((i * 7) + 1);
+    }
+}
+
+void SuiteDsdPackerThroughput::Test()
+{
+    static const ESource kSources[] = { ESource::Dsf, ESource::Dff, ESource::Raw };
+    static const TUint kPadBytes[] = { 0, 2, 4 };
+    for (TUint i=0; i<sizeof(kSources)/sizeof(kSources[0]); i++) {
+        for (TUint j=0; j<sizeof(kPadBytes)/sizeof(kPadBytes[0]); j++) {
+            DsdPacker packer(kPadBytes[j]);
+            const TUint64 us = Run(packer, kSources[i]);
+            const double realtime = (double)iSeconds * 1000000 / (us == 0? 1 : us);
+            Log::Print("{\"format\":\"dsd256-stereo\",\"layout\":\"%s\",\"pad_bytes\":%u,\"seconds\":%u,\"elapsed_us\":%llu,\"realtime\":%.0f}\n",
+                       SourceName(kSources[i]), kPadBytes[j], iSeconds, us, realtime);
+            TEST(realtime > 1);
+        }
+    }
+}
+
+TUint64 SuiteDsdPackerThroughput::Run(DsdPacker& aPacker, ESource aSource)
+{
+    const TByte* src = &iSrc[0];
+    const TByte* right = src + (iSrc.size() / 2);
+    TByte* dest = &iDest[0];
+    TUint64 remaining = (TUint64)iSeconds * kChunksPerSecondDsd256;
+    OsContext* osCtx = iEnv.OsCtx();
+    const TUint64 start = Os::TimeInUs(osCtx);
+    while (remaining > 0) {
+        const TUint chunks = (remaining < kBlockChunks? (TUint)remaining : kBlockChunks);
+        switch (aSource)
+        {
+        case ESource::Dsf:
+            aPacker.PackPlanarLsbFirst(src, right, dest, chunks);
+            break;
+        case ESource::Dff:
+            aPacker.PackInterleavedBytes(src, dest, chunks);
+            break;
+        case ESource::Raw:
+            aPacker.PackChunks(src, dest, chunks);
+            break;
+        }
+        remaining -= chunks;
+    }
+    return Os::TimeInUs(osCtx) - start;
+}
+
+const TChar* SuiteDsdPackerThroughput::SourceName(ESource aSource)
+{
+    switch (aSource)
+    {
+    case ESource::Dsf:
+        return "dsf";
+    case ESource::Dff:
+        return "dff";
+    case ESource::Raw:
+        return "raw";
+    }
+    return "";
+}
+
+
+
+void TestDsdPacker(Environment& aEnv)
+{
+    static const TUint kThroughputSeconds = 10;
+    Runner runner("DsdPacker tests\n");
+    runner.Add(new SuiteDsdPacker());
+    runner.Add(new SuiteDsdPackerThroughput(aEnv, kThroughputSeconds));
+    runner.Run();
+}
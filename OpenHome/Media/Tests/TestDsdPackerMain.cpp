@@ -0,0 +1,12 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Net/Private/Globals.h>
+
+extern void TestDsdPacker(OpenHome::Environment& aEnv);
+
+void OpenHome::TestFramework::Runner::Main(TInt /*aArgc*/, TChar* /*aArgv*/[], Net::InitialisationParams* aInitParams)
+{
+    Net::UpnpLibrary::InitialiseMinimal(aInitParams);
+    TestDsdPacker(*gEnv);
+    delete aInitParams;
+    Net::UpnpLibrary::Close();
+}
@@ -0,0 +1,287 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Media/Codec/Mpeg4.h>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Media::Codec;
+
+namespace OpenHome {
+namespace Media {
+namespace Codec {
+
+class SuiteSampleSizeTable : public SuiteUnitTest, private INonCopyable
+{
+public:
+    SuiteSampleSizeTable();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    void TestBytes();
+    void TestFixed();
+    void TestWiden();
+    void TestOverflow();
+    void TestSerialise();
+private:
+    SampleSizeTable iTable;
+};
+
+class SuiteSeekTable : public SuiteUnitTest, private INonCopyable
+{
+public:
+    SuiteSeekTable();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    void TestStartSample();
+    void TestOffset();
+    void TestOffsetOutOfRange();
+    void TestWideOffsets();
+    void TestSerialise();
+private:
+    SeekTable iTable;
+};
+
+} // namespace Codec
+} // namespace Media
+} // namespace OpenHome
+
+
+// SuiteSampleSizeTable
+
+SuiteSampleSizeTable::SuiteSampleSizeTable()
+    : SuiteUnitTest("SampleSizeTable")
+{
+    AddTest(MakeFunctor(*this, &SuiteSampleSizeTable::TestBytes), "TestBytes");
+    AddTest(MakeFunctor(*this, &SuiteSampleSizeTable::TestFixed), "TestFixed");
+    AddTest(MakeFunctor(*this, &SuiteSampleSizeTable::TestWiden), "TestWiden");
+    AddTest(MakeFunctor(*this, &SuiteSampleSizeTable::TestOverflow), "TestOverflow");
+    AddTest(MakeFunctor(*this, &SuiteSampleSizeTable::TestSerialise), "TestSerialise");
+}
+
+void SuiteSampleSizeTable::Setup()
+{
+}
+
+void SuiteSampleSizeTable::TearDown()
+{
+    iTable.Clear();
+}
+
+void SuiteSampleSizeTable::TestBytes()
+{
+    // span several skip list intervals
+    static const TUint kCount = 3 * SampleSizeTable::kSkipInterval + 5;
+    iTable.Init(kCount);
+    for (TUint i=0; i<kCount; i++) {
+        iTable.AddSampleSize(i + 1);
+    }
+    TEST(iTable.Count() == kCount);
+    TEST(iTable.SampleSize(0) == 1);
+    TEST(iTable.SampleSize(kCount-1) == kCount);
+    TEST_THROWS(iTable.SampleSize(kCount), MediaMpeg4FileInvalid);
+
+    for (TUint first=0; first<kCount; first+=7) {
+        for (TUint count=0; first+count<=kCount; count+=11) {
+            TUint64 expected = 0;
+            for (TUint i=first; i<first+count; i++) {
+                expected += i + 1;
+            }
+            TEST(iTable.Bytes(first, count) == expected);
+        }
+    }
+    TEST(iTable.Bytes(0, kCount) == (static_cast<TUint64>(kCount) * (kCount + 1)) / 2);
+    TEST_THROWS(iTable.Bytes(kCount, 1), MediaMpeg4FileInvalid);
+    TEST_THROWS(iTable.Bytes(1, kCount), MediaMpeg4FileInvalid);
+}
+
+void SuiteSampleSizeTable::TestFixed()
+{
+    iTable.InitFixed(1000, 417);
+    TEST(iTable.Count() == 1000);
+    TEST(iTable.SampleSize(0) == 417);
+    TEST(iTable.SampleSize(999) == 417);
+    TEST(iTable.Bytes(10, 20) == 20 * 417);
+    TEST_THROWS(iTable.SampleSize(1000), MediaMpeg4FileInvalid);
+}
+
+void SuiteSampleSizeTable::TestWiden()
+{
+    iTable.Init(4);
+    iTable.AddSampleSize(100);
+    iTable.AddSampleSize(200);
+    iTable.AddSampleSize(70000);
+    iTable.AddSampleSize(300);
+    TEST(iTable.SampleSize(0) == 100);
+    TEST(iTable.SampleSize(1) == 200);
+    TEST(iTable.SampleSize(2) == 70000);
+    TEST(iTable.SampleSize(3) == 300);
+    TEST(iTable.Bytes(1, 3) == 70500);
+}
+
+void SuiteSampleSizeTable::TestOverflow()
+{
+    iTable.Init(2);
+    iTable.AddSampleSize(1);
+    iTable.AddSampleSize(2);
+    TEST_THROWS(iTable.AddSampleSize(3), MediaMpeg4FileInvalid);
+}
+
+void SuiteSampleSizeTable::TestSerialise()
+{
+    static const TUint kCount = 100;
+    iTable.Init(kCount);
+    for (TUint i=0; i<kCount; i++) {
+        iTable.AddSampleSize((i == 50? 100000 : i * 3));
+    }
+
+    // write in small pieces, as MsgAudioEncodedWriter would
+    WriterBwh writer(1024);
+    iTable.WriteInit();
+    while (!iTable.WriteComplete()) {
+        iTable.Write(writer, 13);
+    }
+
+    SampleSizeTable table;
+    ReaderBuffer reader(writer.Buffer());
+    SampleSizeTableInitialiser initialiser(table, reader);
+    initialiser.Init();
+    TEST(reader.BytesRemaining() == 0);
+    TEST(table.Count() == kCount);
+    for (TUint i=0; i<kCount; i++) {
+        TEST(table.SampleSize(i) == iTable.SampleSize(i));
+    }
+    TEST(table.Bytes(0, kCount) == iTable.Bytes(0, kCount));
+
+    // fixed size tables are serialised without entries
+    SampleSizeTable fixed;
+    fixed.InitFixed(kCount, 5);
+    WriterBwh writerFixed(64);
+    fixed.WriteInit();
+    fixed.Write(writerFixed, 64);
+    TEST(fixed.WriteComplete());
+    TEST(writerFixed.Buffer().Bytes() == 12);
+}
+
+
+// SuiteSeekTable
+
+SuiteSeekTable::SuiteSeekTable()
+    : SuiteUnitTest("SeekTable")
+{
+    AddTest(MakeFunctor(*this, &SuiteSeekTable::TestStartSample), "TestStartSample");
+    AddTest(MakeFunctor(*this, &SuiteSeekTable::TestOffset), "TestOffset");
+    AddTest(MakeFunctor(*this, &SuiteSeekTable::TestOffsetOutOfRange), "TestOffsetOutOfRange");
+    AddTest(MakeFunctor(*this, &SuiteSeekTable::TestWideOffsets), "TestWideOffsets");
+    AddTest(MakeFunctor(*this, &SuiteSeekTable::TestSerialise), "TestSerialise");
+}
+
+void SuiteSeekTable::Setup()
+{
+    // chunks 1-3 hold 4 codec samples each, chunks 4-6 hold 2 each
+    iTable.InitialiseSamplesPerChunk(2);
+    iTable.SetSamplesPerChunk(1, 4, 1);
+    iTable.SetSamplesPerChunk(4, 2, 1);
+    // first 10 codec samples hold 1024 audio samples each, last 8 hold 512 each
+    iTable.InitialiseAudioSamplesPerSample(2);
+    iTable.SetAudioSamplesPerSample(10, 1024);
+    iTable.SetAudioSamplesPerSample(8, 512);
+    iTable.InitialiseOffsets(6);
+    for (TUint i=0; i<6; i++) {
+        iTable.SetOffset(1000 + i * 100);
+    }
+}
+
+void SuiteSeekTable::TearDown()
+{
+    iTable.Deinitialise();
+}
+
+void SuiteSeekTable::TestStartSample()
+{
+    TEST(iTable.Initialised());
+    TEST(iTable.ChunkCount() == 6);
+    const TUint expected[] = { 0, 4, 8, 12, 14, 16 };
+    for (TUint i=0; i<6; i++) {
+        TEST(iTable.StartSample(i) == expected[i]);
+    }
+    TEST(iTable.SamplesPerChunk(2) == 4);
+    TEST(iTable.SamplesPerChunk(3) == 2);
+}
+
+void SuiteSeekTable::TestOffset()
+{
+    TUint64 audioSample = 0;
+    TUint64 sample = 0;
+    TEST(iTable.Offset(audioSample, sample) == 1000);
+    TEST(audioSample == 0);
+    TEST(sample == 0);
+
+    // audio sample 9000 is in codec sample 8 (chunk 3)
+    audioSample = 9000;
+    TEST(iTable.Offset(audioSample, sample) == 1200);
+    TEST(sample == 8);
+    TEST(audioSample == 8 * 1024);
+
+    // audio sample 10240 + 1100 is in codec sample 12 (chunk 4), which lies in the second stts entry
+    audioSample = 10240 + 1100;
+    TEST(iTable.Offset(audioSample, sample) == 1300);
+    TEST(sample == 12);
+    TEST(audioSample == 10240 + 2 * 512);
+}
+
+void SuiteSeekTable::TestOffsetOutOfRange()
+{
+    TUint64 audioSample = 10240 + 8 * 512 + 1;
+    TUint64 sample = 0;
+    TEST_THROWS(iTable.Offset(audioSample, sample), MediaMpeg4OutOfRange);
+}
+
+void SuiteSeekTable::TestWideOffsets()
+{
+    iTable.Deinitialise();
+    iTable.SetSamplesPerChunk(1, 1, 1);
+    iTable.SetAudioSamplesPerSample(3, 1024);
+    iTable.SetOffset(10);
+    iTable.SetOffset(0x100000000ULL);
+    iTable.SetOffset(0x100000010ULL);
+    TEST(iTable.ChunkCount() == 3);
+    TEST(iTable.GetOffset(0) == 10);
+    TEST(iTable.GetOffset(1) == 0x100000000ULL);
+    TEST(iTable.GetOffset(2) == 0x100000010ULL);
+}
+
+void SuiteSeekTable::TestSerialise()
+{
+    iTable.SetOffset(0x100000000ULL); // force 64-bit offsets
+    WriterBwh writer(1024);
+    iTable.WriteInit();
+    while (!iTable.WriteComplete()) {
+        iTable.Write(writer, 10);
+    }
+
+    SeekTable table;
+    ReaderBuffer reader(writer.Buffer());
+    SeekTableInitialiser initialiser(table, reader);
+    initialiser.Init();
+    TEST(reader.BytesRemaining() == 0);
+    TEST(table.ChunkCount() == 7);
+    TEST(table.AudioSamplesPerSample() == 2);
+    for (TUint i=0; i<7; i++) {
+        TEST(table.GetOffset(i) == iTable.GetOffset(i));
+        TEST(table.StartSample(i) == iTable.StartSample(i));
+    }
+}
+
+
+
+void TestMpeg4()
+{
+    Runner runner("Mpeg4 tests\n");
+    runner.Add(new SuiteSampleSizeTable());
+    runner.Add(new SuiteSeekTable());
+    runner.Run();
+}
@@ -0,0 +1,11 @@
+#include <OpenHome/Private/TestFramework.h>
+
+extern void TestMpeg4();
+
+void OpenHome::TestFramework::Runner::Main(TInt /*aArgc*/, TChar* /*aArgv*/[], Net::InitialisationParams* aInitParams)
+{
+    Net::UpnpLibrary::InitialiseMinimal(aInitParams);
+    TestMpeg4();
+    delete aInitParams;
+    Net::UpnpLibrary::Close();
+}
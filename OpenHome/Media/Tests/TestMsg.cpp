@@ -3,6 +3,7 @@
 #include <OpenHome/Media/Pipeline/RampArray.h>
 #include <OpenHome/Media/Utils/AllocatorInfoLogger.h>
 #include <OpenHome/Media/Utils/ProcessorAudioUtils.h>
+#include <OpenHome/Media/Utils/PcmKernels.h>
 
 #include <string.h>
 #include <vector>
@@ -14,14 +15,22 @@ using namespace OpenHome::Media;
 namespace OpenHome {
 namespace Media {
 
+class TestCell;
+
 class SuiteAllocator : public Suite
 {
 public:
     SuiteAllocator();
     void Test() override;
+private:
+    void AllocateFreeThread();
 private:
     static const TUint kNumTestCells = 10;
+    static const TUint kNumThreads = 4;
+    static const TUint kNumThreadIterations = 10000;
     AllocatorInfoLogger iInfoAggregator;
+    Allocator<TestCell>* iAllocator;
+    Semaphore iSemThreadComplete;
 };
 
 class TestCell : public Allocated
@@ -99,6 +108,42 @@ private:
     AllocatorInfoLogger iInfoAggregator;
 };
 
+class SuiteDecodedAudioEndian : public Suite
+{
+    static const TUint kMsgCount = 4;
+public:
+    SuiteDecodedAudioEndian();
+    ~SuiteDecodedAudioEndian();
+    void Test() override;
+private:
+    Brn ReadPlayable(MsgAudioPcm* aMsg, ProcessorPcmBufTest& aProcessor);
+private:
+    MsgFactory* iMsgFactory;
+    AllocatorInfoLogger iInfoAggregator;
+};
+
+class SuitePcmKernels : public Suite
+{
+    static const TUint kMaxBytes = DecodedAudio::kMaxBytes;
+    static const TUint kMaxPlanarChannels = 6;
+    static const TUint kMaxPlanarSamples = kMaxBytes / 4;
+public:
+    SuitePcmKernels();
+    void Test() override;
+private:
+    void TestKnownValues();
+    void TestMatchesScalar(TUint aSubsampleBytes);
+    void TestAttenuateKnownValues();
+    void TestAttenuateMatchesScalar(TUint aSubsampleBytes, TBool aBigEndian);
+    void TestPackPlanarKnownValues();
+    void TestPackPlanarMatchesScalar(TUint aSubsampleBytes);
+private:
+    TByte iSrc[kMaxBytes + 1];
+    TInt32 iPlanar[kMaxPlanarChannels][kMaxPlanarSamples];
+    TByte iDest[kMaxBytes + 2];
+    TByte iDestScalar[kMaxBytes + 2];
+};
+
 class SuiteRamp : public Suite
 {
     static const TUint kMsgCount = 8;
@@ -444,6 +489,8 @@ void TestCell::CheckIsFilled(TChar aVal) const
 
 SuiteAllocator::SuiteAllocator()
     : Suite("Allocator tests")
+    , iAllocator(nullptr)
+    , iSemThreadComplete("SATC", 0)
 {
 }
 
@@ -503,6 +550,38 @@ void SuiteAllocator::Test()
         allocator->Free(cells[i]);
     }
     delete allocator;
+
+    //Print("\nAllocate and free cells from several threads at once.  Check that no cell is handed out twice and that stats are consistent\n");
+    iAllocator = new Allocator<TestCell>("TestCell", kNumTestCells, iInfoAggregator);
+    std::vector<ThreadFunctor*> threads;
+    for (TUint i=0; i<kNumThreads; i++) {
+        threads.push_back(new ThreadFunctor("AllocatorTest", MakeFunctor(*this, &SuiteAllocator::AllocateFreeThread)));
+        threads.back()->Start();
+    }
+    for (TUint i=0; i<kNumThreads; i++) {
+        iSemThreadComplete.Wait();
+    }
+    for (auto thread : threads) {
+        delete thread;
+    }
+    TEST(iAllocator->CellsUsed() == 0);
+    TEST(iAllocator->CellsUsedMax() <= kNumThreads * 2);
+    delete iAllocator;
+    iAllocator = nullptr;
+}
+
+void SuiteAllocator::AllocateFreeThread()
+{
+    for (TUint i=0; i<kNumThreadIterations; i++) {
+        TestCell* cell1 = iAllocator->Allocate();
+        TestCell* cell2 = iAllocator->Allocate();
+        TEST_QUIETLY(cell1 != cell2);
+        TEST_QUIETLY(cell1->RefCount() == 1);
+        TEST_QUIETLY(cell2->RefCount() == 1);
+        cell1->RemoveRef();
+        cell2->RemoveRef();
+    }
+    iSemThreadComplete.Signal();
 }
 
 
@@ -979,20 +1058,45 @@ void SuiteMsgAudio::Test()
     TEST(jiffies == minJiffies);
     msg->RemoveRef();
 
-    // Attenuation (RAOP only)
+    // Attenuation
     {
         const TByte b = 0x7f;
         TByte sample[] = { b, b, b, b };
         Brn sampleBuf(sample, sizeof sample);
         auto pcm = iMsgFactory->CreateMsgAudioPcm(sampleBuf, 2, 44100, 16, AudioDataEndian::Little, Jiffies::kPerSecond);
+        auto clone = pcm->Clone();
         pcm->SetAttenuation(MsgAudioPcm::kUnityAttenuation / 4);
         playable = pcm->CreatePlayable();
         playable->Read(pcmProcessor);
         playable->RemoveRef();
         ptr = pcmProcessor.Ptr();
-        const TInt16 subsample = (ptr[0] << 8) + ptr[1];
+        TInt16 subsample = (ptr[0] << 8) + ptr[1];
         TInt16 expected = ((b << 8) + b) / 4;
         TEST(subsample == expected);
+
+        // attenuation must not be applied to audio shared with a clone
+        playable = clone->CreatePlayable();
+        playable->Read(pcmProcessor);
+        playable->RemoveRef();
+        ptr = pcmProcessor.Ptr();
+        subsample = (ptr[0] << 8) + ptr[1];
+        TEST(subsample == (b << 8) + b);
+    }
+    {
+        TByte sample[] = { 0x00, 0x00, 0x80, 0xff, 0xff, 0x7f }; // min, max 24-bit subsamples
+        Brn sampleBuf(sample, sizeof sample);
+        auto pcm = iMsgFactory->CreateMsgAudioPcm(sampleBuf, 2, 44100, 24, AudioDataEndian::Little, Jiffies::kPerSecond);
+        pcm->SetAttenuation(MsgAudioPcm::kUnityAttenuation / 4);
+        playable = pcm->CreatePlayable();
+        playable->Read(pcmProcessor);
+        playable->RemoveRef();
+        ptr = pcmProcessor.Ptr();
+        TEST(ptr[0] == 0xe0);
+        TEST(ptr[1] == 0x00);
+        TEST(ptr[2] == 0x00);
+        TEST(ptr[3] == 0x1f);
+        TEST(ptr[4] == 0xff);
+        TEST(ptr[5] == 0xff);
     }
 
     // IPipelineBufferObserver
@@ -1371,6 +1475,325 @@ void SuiteMsgPlayable::ValidateSilence(MsgPlayable* aMsg)
 }
 
 
+// SuiteDecodedAudioEndian
+
+SuiteDecodedAudioEndian::SuiteDecodedAudioEndian()
+    : Suite("DecodedAudio byte order tests")
+{
+    MsgFactoryInitParams init;
+    init.SetMsgAudioEncodedCount(kMsgCount, kMsgCount);
+    init.SetMsgAudioPcmCount(kMsgCount, kMsgCount);
+    init.SetMsgPlayableCount(kMsgCount, kMsgCount, kMsgCount);
+    init.SetDecodedAudioEndian(AudioDataEndian::Little);
+    iMsgFactory = new MsgFactory(iInfoAggregator, init);
+}
+
+SuiteDecodedAudioEndian::~SuiteDecodedAudioEndian()
+{
+    delete iMsgFactory;
+}
+
+Brn SuiteDecodedAudioEndian::ReadPlayable(MsgAudioPcm* aMsg, ProcessorPcmBufTest& aProcessor)
+{
+    MsgPlayable* playable = aMsg->CreatePlayable();
+    playable->Read(aProcessor);
+    playable->RemoveRef();
+    return aProcessor.Buf();
+}
+
+void SuiteDecodedAudioEndian::Test()
+{
+    static const TUint kDataBytes = 600; // whole number of samples for 16, 24 and 32-bit stereo
+    TByte le[kDataBytes];
+    TByte be[kDataBytes];
+    for (TUint i=0; i<kDataBytes; i++) {
+        le[i] = (TByte)(i * 13);
+    }
+    const TUint kBitDepths[] = { 16, 24, 32 };
+    for (TUint bitDepth : kBitDepths) {
+        const TUint subsampleBytes = bitDepth / 8;
+        for (TUint i=0; i<kDataBytes; i+=subsampleBytes) {
+            for (TUint j=0; j<subsampleBytes; j++) {
+                be[i+j] = le[i + subsampleBytes - 1 - j];
+            }
+        }
+        const Brn leBuf(le, kDataBytes);
+        const Brn beBuf(be, kDataBytes);
+
+        // little endian input is stored unconverted.  Processors get their preferred byte order
+        MsgAudioPcm* msg = iMsgFactory->CreateMsgAudioPcm(leBuf, 2, 44100, bitDepth, AudioDataEndian::Little, 0);
+        ProcessorPcmBufTest processorLe(AudioDataEndian::Little);
+        TEST(ReadPlayable(msg, processorLe) == leBuf);
+        msg = iMsgFactory->CreateMsgAudioPcm(leBuf, 2, 44100, bitDepth, AudioDataEndian::Little, 0);
+        ProcessorPcmBufTest processorBe;
+        TEST(ReadPlayable(msg, processorBe) == beBuf);
+
+        // big endian input is converted on the way in
+        msg = iMsgFactory->CreateMsgAudioPcm(beBuf, 2, 44100, bitDepth, AudioDataEndian::Big, 0);
+        ProcessorPcmBufTest processorLe2(AudioDataEndian::Little);
+        TEST(ReadPlayable(msg, processorLe2) == leBuf);
+
+        // encoded audio reused as pcm (e.g. by CodecPcm) is big endian, whatever the factory's byte order
+        MsgAudioEncoded* encoded = iMsgFactory->CreateMsgAudioEncoded(beBuf);
+        msg = iMsgFactory->CreateMsgAudioPcm(encoded, 2, 44100, bitDepth, 0);
+        encoded->RemoveRef();
+        ProcessorPcmBufTest processorEncodedLe(AudioDataEndian::Little);
+        TEST(ReadPlayable(msg, processorEncodedLe) == leBuf);
+        encoded = iMsgFactory->CreateMsgAudioEncoded(beBuf);
+        msg = iMsgFactory->CreateMsgAudioPcm(encoded, 2, 44100, bitDepth, 0);
+        encoded->RemoveRef();
+        ProcessorPcmBufTest processorEncodedBe;
+        TEST(ReadPlayable(msg, processorEncodedBe) == beBuf);
+
+        // ramped output is the same whichever byte order it is read in
+        MsgAudio* remaining = nullptr;
+        msg = iMsgFactory->CreateMsgAudioPcm(leBuf, 2, 44100, bitDepth, AudioDataEndian::Little, 0);
+        TUint remainingDuration = msg->Jiffies();
+        (void)msg->SetRamp(Ramp::kMax, remainingDuration, Ramp::EDown, remaining);
+        ProcessorPcmBufTest processorRampLe(AudioDataEndian::Little);
+        const Brn rampedLe = ReadPlayable(msg, processorRampLe);
+        msg = iMsgFactory->CreateMsgAudioPcm(leBuf, 2, 44100, bitDepth, AudioDataEndian::Little, 0);
+        remainingDuration = msg->Jiffies();
+        (void)msg->SetRamp(Ramp::kMax, remainingDuration, Ramp::EDown, remaining);
+        ProcessorPcmBufTest processorRampBe;
+        const Brn rampedBe = ReadPlayable(msg, processorRampBe);
+        TEST(rampedLe.Bytes() == kDataBytes);
+        TEST(rampedBe.Bytes() == kDataBytes);
+        TBool match = true;
+        for (TUint i=0; i<kDataBytes; i+=subsampleBytes) {
+            for (TUint j=0; j<subsampleBytes; j++) {
+                if (rampedBe[i+j] != rampedLe[i + subsampleBytes - 1 - j]) {
+                    match = false;
+                }
+            }
+        }
+        TEST(match);
+    }
+}
+
+
+// SuitePcmKernels
+
+SuitePcmKernels::SuitePcmKernels()
+    : Suite("PCM kernel tests")
+{
+    for (TUint i=0; i<sizeof(iSrc); i++) {
+        iSrc[i] = (TByte)((i * 7) ^ (i >> 8));
+    }
+    // values of varying magnitude so that packing exercises both clipped and unclipped subsamples
+    for (TUint i=0; i<kMaxPlanarChannels; i++) {
+        for (TUint j=0; j<kMaxPlanarSamples; j++) {
+            const TUint32 hash = ((j * 7) + (i * 131) + 1) * 2654435761u;
+            iPlanar[i][j] = (TInt32)hash >> ((i + j) % 23);
+        }
+    }
+}
+
+void SuitePcmKernels::Test()
+{
+    Print("Using %s implementation\n", PcmKernels::Implementation());
+    TestKnownValues();
+    TestMatchesScalar(2);
+    TestMatchesScalar(3);
+    TestMatchesScalar(4);
+    TestAttenuateKnownValues();
+    for (TUint i=1; i<=4; i++) {
+        TestAttenuateMatchesScalar(i, false);
+        TestAttenuateMatchesScalar(i, true);
+    }
+    TestPackPlanarKnownValues();
+    for (TUint i=1; i<=4; i++) {
+        TestPackPlanarMatchesScalar(i);
+    }
+}
+
+void SuitePcmKernels::TestKnownValues()
+{
+    static const TByte kLe[] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c };
+    static const TByte kBe16[] = { 0x02, 0x01, 0x04, 0x03, 0x06, 0x05, 0x08, 0x07, 0x0a, 0x09, 0x0c, 0x0b };
+    static const TByte kBe24[] = { 0x03, 0x02, 0x01, 0x06, 0x05, 0x04, 0x09, 0x08, 0x07, 0x0c, 0x0b, 0x0a };
+    static const TByte kBe32[] = { 0x04, 0x03, 0x02, 0x01, 0x08, 0x07, 0x06, 0x05, 0x0c, 0x0b, 0x0a, 0x09 };
+    TByte dest[sizeof(kLe)];
+    PcmKernels::CopyToBigEndian16Scalar(kLe, dest, sizeof(kLe));
+    TEST(memcmp(dest, kBe16, sizeof(dest)) == 0);
+    PcmKernels::CopyToBigEndian24Scalar(kLe, dest, sizeof(kLe));
+    TEST(memcmp(dest, kBe24, sizeof(dest)) == 0);
+    PcmKernels::CopyToBigEndian32Scalar(kLe, dest, sizeof(kLe));
+    TEST(memcmp(dest, kBe32, sizeof(dest)) == 0);
+}
+
+void SuitePcmKernels::TestMatchesScalar(TUint aSubsampleBytes)
+{
+    // check every length up to the size of a DecodedAudio, using both aligned and unaligned buffers
+    // bytes beyond the end of the output must be left untouched
+    TBool ok = true;
+    for (TUint offset=0; offset<2; offset++) {
+        for (TUint bytes=0; bytes<=kMaxBytes; bytes+=aSubsampleBytes) {
+            (void)memset(iDest, 0xa5, sizeof(iDest));
+            (void)memset(iDestScalar, 0xa5, sizeof(iDestScalar));
+            const TByte* src = &iSrc[offset];
+            switch (aSubsampleBytes)
+            {
+            case 2:
+                PcmKernels::CopyToBigEndian16(src, &iDest[offset], bytes);
+                PcmKernels::CopyToBigEndian16Scalar(src, &iDestScalar[offset], bytes);
+                break;
+            case 3:
+                PcmKernels::CopyToBigEndian24(src, &iDest[offset], bytes);
+                PcmKernels::CopyToBigEndian24Scalar(src, &iDestScalar[offset], bytes);
+                break;
+            case 4:
+                PcmKernels::CopyToBigEndian32(src, &iDest[offset], bytes);
+                PcmKernels::CopyToBigEndian32Scalar(src, &iDestScalar[offset], bytes);
+                break;
+            default:
+                ASSERTS();
+            }
+            if (memcmp(iDest, iDestScalar, sizeof(iDest)) != 0) {
+                ok = false;
+            }
+        }
+    }
+    TEST(ok);
+}
+
+void SuitePcmKernels::TestAttenuateKnownValues()
+{
+    // -1, 1, min, max subsamples halved; results round towards zero
+    static const TByte kSrc16[] = { 0xff, 0xff, 0x00, 0x01, 0x80, 0x00, 0x7f, 0xff };
+    static const TByte kExpected16[] = { 0x00, 0x00, 0x00, 0x00, 0xc0, 0x00, 0x3f, 0xff };
+    static const TByte kSrc32[] = { 0x80, 0x00, 0x00, 0x00, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
+    static const TByte kExpected32[] = { 0xc0, 0x00, 0x00, 0x00, 0x3f, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00 };
+    TByte dest[12];
+    PcmKernels::Attenuate(kSrc16, dest, sizeof(kSrc16), 2, true, 128);
+    TEST(memcmp(dest, kExpected16, sizeof(kExpected16)) == 0);
+    PcmKernels::Attenuate(kSrc32, dest, sizeof(kSrc32), 4, true, 128);
+    TEST(memcmp(dest, kExpected32, sizeof(kExpected32)) == 0);
+    PcmKernels::Attenuate(kSrc32, dest, sizeof(kSrc32), 4, true, 0);
+    for (TUint i=0; i<sizeof(kSrc32); i++) {
+        TEST(dest[i] == 0);
+    }
+
+    // every 16-bit subsample gives the same result as MsgPlayablePcm's original (s * a / 256) attenuation
+    static const TUint kNumSubsamples16 = 65536;
+    static TByte src16[2 * kNumSubsamples16];
+    static TByte dest16[2 * kNumSubsamples16];
+    for (TUint i=0; i<kNumSubsamples16; i++) {
+        src16[2*i] = (TByte)(i >> 8);
+        src16[2*i + 1] = (TByte)i;
+    }
+    static const TUint kAttenuations[] = { 1, 3, 64, 127, 255 };
+    TBool ok = true;
+    for (TUint i=0; i<sizeof(kAttenuations)/sizeof(kAttenuations[0]); i++) {
+        const TUint attenuation = kAttenuations[i];
+        PcmKernels::Attenuate(src16, dest16, sizeof(src16), 2, true, attenuation);
+        for (TUint j=0; j<kNumSubsamples16; j++) {
+            const TInt sample = (TInt16)j;
+            const TInt16 expected = (TInt16)(sample * (TInt)attenuation / (TInt)MsgAudioPcm::kUnityAttenuation);
+            if (dest16[2*j] != (TByte)(expected >> 8) || dest16[2*j + 1] != (TByte)expected) {
+                ok = false;
+            }
+        }
+    }
+    TEST(ok);
+}
+
+void SuitePcmKernels::TestAttenuateMatchesScalar(TUint aSubsampleBytes, TBool aBigEndian)
+{
+    // check every length up to the size of a DecodedAudio, for a range of attenuations, both in place and not
+    // bytes beyond the end of the output must be left untouched
+    static const TUint kAttenuations[] = { 0, 1, 64, 255, 256 };
+    TBool ok = true;
+    for (TUint i=0; i<sizeof(kAttenuations)/sizeof(kAttenuations[0]); i++) {
+        const TUint attenuation = kAttenuations[i];
+        for (TUint bytes=0; bytes<=kMaxBytes; bytes+=aSubsampleBytes) {
+            (void)memset(iDest, 0xa5, sizeof(iDest));
+            (void)memset(iDestScalar, 0xa5, sizeof(iDestScalar));
+            PcmKernels::Attenuate(&iSrc[1], &iDest[1], bytes, aSubsampleBytes, aBigEndian, attenuation);
+            PcmKernels::AttenuateScalar(&iSrc[1], &iDestScalar[1], bytes, aSubsampleBytes, aBigEndian, attenuation);
+            if (memcmp(iDest, iDestScalar, sizeof(iDest)) != 0) {
+                ok = false;
+            }
+            (void)memcpy(&iDest[1], &iSrc[1], bytes);
+            PcmKernels::Attenuate(&iDest[1], &iDest[1], bytes, aSubsampleBytes, aBigEndian, attenuation);
+            if (memcmp(iDest, iDestScalar, sizeof(iDest)) != 0) {
+                ok = false;
+            }
+        }
+    }
+    TEST(ok);
+}
+
+void SuitePcmKernels::TestPackPlanarKnownValues()
+{
+    // max, min, in range and -1 values, both shifted and clipped
+    static const TInt32 kLeft[] = { 0x7fffffff, (TInt32)0x80000000, 0x00123456, -1 };
+    static const TInt32 kRight[] = { 0x00000100, -0x00000100, 0x00007fff, 0x00800000 };
+    static const TByte kExpected16[] = { 0x7f, 0xff, 0x01, 0x00, 0x80, 0x00, 0xff, 0x00,
+                                         0x7f, 0xff, 0x7f, 0xff, 0xff, 0xff, 0x7f, 0xff };
+    static const TByte kExpected24Shifted[] = { 0x7f, 0xff, 0xff, 0x00, 0x00, 0x01, 0x80, 0x00, 0x00, 0xff, 0xff, 0xff,
+                                                0x00, 0x12, 0x34, 0x00, 0x00, 0x7f, 0xff, 0xff, 0xff, 0x00, 0x80, 0x00 };
+    static const TByte kExpected32[] = { 0x7f, 0xff, 0xff, 0xff, 0x80, 0x00, 0x00, 0x00, 0x00, 0x12, 0x34, 0x56, 0xff, 0xff, 0xff, 0xff };
+    const TInt32* channels[] = { kLeft, kRight };
+    TByte dest[24];
+    PcmKernels::PackPlanarBigEndian(channels, 2, 0, 4, 0, 2, dest);
+    TEST(memcmp(dest, kExpected16, sizeof(kExpected16)) == 0);
+    PcmKernels::PackPlanarBigEndian(channels, 2, 0, 4, 8, 3, dest);
+    TEST(memcmp(dest, kExpected24Shifted, sizeof(kExpected24Shifted)) == 0);
+    PcmKernels::PackPlanarBigEndian(channels, 1, 0, 4, 0, 4, dest);
+    TEST(memcmp(dest, kExpected32, sizeof(kExpected32)) == 0);
+
+    TByte expected[24];
+    PcmKernels::CopySwapped(kExpected16, expected, sizeof(kExpected16), 2);
+    PcmKernels::PackPlanarLittleEndian(channels, 2, 0, 4, 0, 2, dest);
+    TEST(memcmp(dest, expected, sizeof(kExpected16)) == 0);
+    PcmKernels::CopySwapped(kExpected24Shifted, expected, sizeof(kExpected24Shifted), 3);
+    PcmKernels::PackPlanarLittleEndian(channels, 2, 0, 4, 8, 3, dest);
+    TEST(memcmp(dest, expected, sizeof(kExpected24Shifted)) == 0);
+    PcmKernels::CopySwapped(kExpected32, expected, sizeof(kExpected32), 4);
+    PcmKernels::PackPlanarLittleEndian(channels, 1, 0, 4, 0, 4, dest);
+    TEST(memcmp(dest, expected, sizeof(kExpected32)) == 0);
+}
+
+void SuitePcmKernels::TestPackPlanarMatchesScalar(TUint aSubsampleBytes)
+{
+    // check every length that fits in a DecodedAudio for a range of channel counts, shifts and start positions
+    // bytes beyond the end of the output must be left untouched
+    static const TUint kChannels[] = { 1, 2, 3, kMaxPlanarChannels };
+    static const TUint kShifts[] = { 0, 5, 8, 16 };
+    const TInt32* channels[kMaxPlanarChannels];
+    for (TUint i=0; i<kMaxPlanarChannels; i++) {
+        channels[i] = iPlanar[i];
+    }
+    TBool ok = true;
+    for (TUint i=0; i<sizeof(kChannels)/sizeof(kChannels[0]); i++) {
+        const TUint numChannels = kChannels[i];
+        const TUint maxSamples = kMaxBytes / (numChannels * aSubsampleBytes);
+        for (TUint j=0; j<sizeof(kShifts)/sizeof(kShifts[0]); j++) {
+            for (TUint first=0; first<2; first++) {
+                for (TUint samples=0; samples<=maxSamples && first+samples<=kMaxPlanarSamples; samples++) {
+                    (void)memset(iDest, 0xa5, sizeof(iDest));
+                    (void)memset(iDestScalar, 0xa5, sizeof(iDestScalar));
+                    PcmKernels::PackPlanarBigEndian(channels, numChannels, first, samples, kShifts[j], aSubsampleBytes, &iDest[1]);
+                    PcmKernels::PackPlanarBigEndianScalar(channels, numChannels, first, samples, kShifts[j], aSubsampleBytes, &iDestScalar[1]);
+                    if (memcmp(iDest, iDestScalar, sizeof(iDest)) != 0) {
+                        ok = false;
+                    }
+                    (void)memset(iDest, 0xa5, sizeof(iDest));
+                    (void)memset(iDestScalar, 0xa5, sizeof(iDestScalar));
+                    PcmKernels::PackPlanarLittleEndian(channels, numChannels, first, samples, kShifts[j], aSubsampleBytes, &iDest[1]);
+                    PcmKernels::PackPlanarLittleEndianScalar(channels, numChannels, first, samples, kShifts[j], aSubsampleBytes, &iDestScalar[1]);
+                    if (memcmp(iDest, iDestScalar, sizeof(iDest)) != 0) {
+                        ok = false;
+                    }
+                }
+            }
+        }
+    }
+    TEST(ok);
+}
+
+
 // SuiteRamp
 
 SuiteRamp::SuiteRamp()
@@ -1527,6 +1950,45 @@ void SuiteRamp::Test()
         prevSampleVal = sampleVal;
     }
 
+    // Check that 24-bit ramps retain the full resolution of their input
+    ramp.Reset();
+    TEST(!ramp.Set(Ramp::kMax, kAudioDataSize, kAudioDataSize*2, Ramp::EDown, split, splitPos));
+    numSamples = applicator.Start(audioBuf, 24, 2);
+    TBool lsbSet = false;
+    for (TUint i=0; i<numSamples; i++) {
+        applicator.GetNextSample(sample);
+        if (sample[2] != 0) {
+            lsbSet = true;
+        }
+    }
+    TEST(lsbSet);
+
+    // Check that ramping a block of samples gives the same results as ramping one sample at a time
+    const TUint kBitDepths[] = { 8, 16, 24, 32 };
+    for (TUint bitDepth : kBitDepths) {
+        TByte rampedBlock[kAudioDataSize];
+        ramp.Reset();
+        TEST(!ramp.Set(Ramp::kMax, kAudioDataSize, kAudioDataSize, Ramp::EDown, split, splitPos));
+        numSamples = applicator.Start(audioBuf, bitDepth, 2);
+        applicator.GetNextSamples(rampedBlock, numSamples);
+        const TUint bytesPerSample = (bitDepth/8) * 2;
+        numSamples = applicator.Start(audioBuf, bitDepth, 2);
+        TBool match = true;
+        for (TUint i=0; i<numSamples; i++) {
+            applicator.GetNextSample(sample);
+            if (memcmp(sample, &rampedBlock[i * bytesPerSample], bytesPerSample) != 0) {
+                match = false;
+            }
+        }
+        TEST(match);
+    }
+
+    // Check that the median of a ramp ending at silence is still read from the ramp table
+    ramp.Reset();
+    TEST(!ramp.Set(Ramp::kMin + 20, kAudioDataSize, kAudioDataSize, Ramp::EDown, split, splitPos));
+    TEST(ramp.End() == Ramp::kMin);
+    TEST(RampApplicator::MedianMultiplier(ramp) == 0);
+
     // Apply ramp [Min...Max].  Check start/end values and that subsequent values never fall
     ramp.Reset();
     TEST(!ramp.Set(Ramp::kMin, kAudioDataSize, kAudioDataSize, Ramp::EUp, split, splitPos));
@@ -3697,6 +4159,8 @@ void TestMsg()
     runner.Add(new SuiteMsgAudio());
     runner.Add(new SuiteMsgPlayable());
     runner.Add(new SuiteMsgAudioDsd());
+    runner.Add(new SuitePcmKernels());
+    runner.Add(new SuiteDecodedAudioEndian());
     runner.Add(new SuiteAudioStream());
     runner.Add(new SuiteMetaText());
     runner.Add(new SuiteTrack());
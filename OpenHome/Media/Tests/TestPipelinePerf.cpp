@@ -0,0 +1,866 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Media/Pipeline/Pipeline.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Media/Codec/CodecController.h>
+#include <OpenHome/Media/Debug.h>
+#include <OpenHome/Media/Pipeline/MuterVolume.h>
+#include <OpenHome/Media/Pipeline/StarterTimed.h>
+#include <OpenHome/Media/Pipeline/Profiler.h>
+#include <OpenHome/Media/Pipeline/DecodedAudioAggregator.h>
+#include <OpenHome/Private/InfoProvider.h>
+#include <OpenHome/Private/OptionParser.h>
+#include <OpenHome/Private/Parser.h>
+#include <OpenHome/Private/Ascii.h>
+#include <OpenHome/OsWrapper.h>
+
+#include <algorithm>
+#include <atomic>
+#include <ctime>
+#include <string.h>
+#include <vector>
+
+/*
+ * Pipeline micro-benchmark.
+ *
+ * Runs a complete Pipeline for each of a range of audio formats, pulling from the
+ * PreDriver output as fast as the pipeline allows.  The supplier and codec are
+ * trivial so the figures reported reflect the cost of the pipeline elements.
+ *
+ * Results are written as one JSON object per line (one per format) so that runs can
+ * be compared by scripts.  Each line reports
+ *   msgs_per_sec      - msgs pulled per second (wall clock)
+ *   realtime_factor   - seconds of audio delivered per second (wall clock)
+ *   cpu_ns_per_jiffy  - process cpu time (all pipeline threads) per jiffy of audio delivered
+ *   pull_us           - latency percentiles for calls to Pipeline::Pull()
+ *   starvations       - number of times the pipeline reported buffering during the run
+ *   allocators        - capacity and high-water mark for each allocator
+ *   elements          - per-element self time per jiffy (ns), from the pipeline's Profile().
+ *                       Self time is only known for elements calling another measured element
+ *                       in the same thread; those pulling from or pushing to a reservoir (whose
+ *                       time includes waiting for another thread) report null.
+ */
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Media;
+using namespace OpenHome::Media::Codec;
+
+namespace OpenHome {
+namespace Media {
+
+class PerfFormat
+{
+public:
+    AudioFormat iFormat;
+    TUint iSampleRate;
+    TUint iBitDepth; // ignored for DSD
+    TUint iNumChannels;
+    const TChar* iName;
+};
+
+class PerfSupplier : public Thread, private IStreamHandler
+{
+public:
+    PerfSupplier(const PerfFormat& aFormat, MsgFactory& aMsgFactory, IPipelineElementDownstream& aDownstream, TrackFactory& aTrackFactory);
+    ~PerfSupplier();
+    void Exit();
+private:
+    void Drain();
+private: // from Thread
+    void Run() override;
+private: // from IStreamHandler
+    EStreamPlay OkToPlay(TUint aStreamId) override;
+    TUint TrySeek(TUint aStreamId, TUint64 aOffset) override;
+    TUint TryDiscard(TUint aJiffies) override;
+    TUint TryStop(TUint aStreamId) override;
+    void NotifyStarving(const Brx& aMode, TUint aStreamId, TBool aStarving) override;
+private:
+    const PerfFormat iFormat;
+    MsgFactory& iMsgFactory;
+    IPipelineElementDownstream& iDownstream;
+    TrackFactory& iTrackFactory;
+    Semaphore iDrain;
+    std::atomic<TBool> iQuit;
+};
+
+// Trivial codec which accepts all content and outputs it as decoded audio in a fixed format
+class PerfCodec : public CodecBase
+{
+public:
+    static const TUint kDsdSampleBlockWords = 6; // the padded layout StarterTimed and VariableDelay assume
+    static const TUint kDsdPadBytesPerChunk = 2;
+public:
+    PerfCodec(const PerfFormat& aFormat);
+private: // from CodecBase
+    void StreamInitialise() override;
+    TBool Recognise(const EncodedStreamInfo& aStreamInfo) override;
+    void Process() override;
+    TBool TrySeek(TUint aStreamId, TUint64 aSample) override;
+private:
+    Bws<DecodedAudio::kMaxBytes> iReadBuf;
+    const PerfFormat iFormat;
+    TUint64 iTrackOffsetJiffies;
+    TBool iSentDecodedInfo;
+};
+
+// Collects the high-water mark of every allocator created by the pipeline
+class AllocatorStats : public IInfoAggregator, private IWriter
+{
+public:
+    class Stats
+    {
+    public:
+        Bws<64> iName;
+        TUint iCapacity;
+        TUint iPeak;
+    };
+public:
+    AllocatorStats();
+    const std::vector<Stats>& Collect();
+private:
+    void ParseLine();
+private: // from IInfoAggregator
+    void Register(IInfoProvider& aProvider, std::vector<Brn>& aSupportedQueries) override;
+private: // from IWriter
+    void Write(TByte aValue) override;
+    void Write(const Brx& aBuffer) override;
+    void WriteFlush() override;
+private:
+    std::vector<IInfoProvider*> iInfoProviders;
+    std::vector<Stats> iStats;
+    Bws<256> iLine;
+};
+
+// Reads audio the way a driver would, touching every byte.
+// IPcmProcessor and IDsdProcessor share the signatures implemented here.
+class ProcessorPerf : public IPcmProcessor, public IDsdProcessor
+{
+public:
+    ProcessorPerf();
+    TUint Checksum() const;
+private:
+    void Accumulate(const Brx& aData);
+private: // from IPcmProcessor
+    void BeginBlock() override;
+    void ProcessFragment(const Brx& aData, TUint aNumChannels, TUint aSubsampleBytes) override;
+    void ProcessSilence(const Brx& aData, TUint aNumChannels, TUint aSubsampleBytes) override;
+    void EndBlock() override;
+    void Flush() override;
+private:
+    TUint iChecksum;
+};
+
+class SuitePipelinePerf : public Suite
+                        , private IPipelineObserver
+                        , private IMsgProcessor
+                        , private IStreamPlayObserver
+                        , private ISeekRestreamer
+                        , private IUrlBlockWriter
+                        , private IPipelineAnimator
+                        , private IVolumeRamper
+{
+    static const PerfFormat kFormats[];
+    static const TUint kNumFormats;
+    static const TUint kMaxPcmSampleRate = 384000;
+    static const TUint kMaxDsdSampleRate = 11289600; // DSD256
+    static const TUint kMaxShortMsgsInReservoir = 150;
+public:
+    SuitePipelinePerf(Environment& aEnv, TUint aDurationSecs);
+private: // from Suite
+    void Test() override;
+private:
+    void Run(const PerfFormat& aFormat);
+    void PullNext();
+    void Report(const PerfFormat& aFormat, TUint64 aWallUs, TUint64 aCpuNs, std::vector<TUint>& aLatencies, AllocatorStats& aAllocatorStats);
+    static TUint Percentile(const std::vector<TUint>& aSorted, TUint aPerMille);
+private: // from IPipelineObserver
+    void NotifyPipelineState(EPipelineState aState) override;
+    void NotifyMode(const Brx& aMode, const ModeInfo& aInfo,
+                    const ModeTransportControls& aTransportControls) override;
+    void NotifyTrack(Track& aTrack, TBool aStartOfStream) override;
+    void NotifyMetaText(const Brx& aText) override;
+    void NotifyTime(TUint aSeconds) override;
+    void NotifyStreamInfo(const DecodedStreamInfo& aStreamInfo) override;
+private: // from IMsgProcessor
+    Msg* ProcessMsg(MsgMode* aMsg) override;
+    Msg* ProcessMsg(MsgTrack* aMsg) override;
+    Msg* ProcessMsg(MsgDrain* aMsg) override;
+    Msg* ProcessMsg(MsgDelay* aMsg) override;
+    Msg* ProcessMsg(MsgEncodedStream* aMsg) override;
+    Msg* ProcessMsg(MsgStreamSegment* aMsg) override;
+    Msg* ProcessMsg(MsgAudioEncoded* aMsg) override;
+    Msg* ProcessMsg(MsgMetaText* aMsg) override;
+    Msg* ProcessMsg(MsgStreamInterrupted* aMsg) override;
+    Msg* ProcessMsg(MsgHalt* aMsg) override;
+    Msg* ProcessMsg(MsgFlush* aMsg) override;
+    Msg* ProcessMsg(MsgWait* aMsg) override;
+    Msg* ProcessMsg(MsgDecodedStream* aMsg) override;
+    Msg* ProcessMsg(MsgAudioPcm* aMsg) override;
+    Msg* ProcessMsg(MsgAudioDsd* aMsg) override;
+    Msg* ProcessMsg(MsgSilence* aMsg) override;
+    Msg* ProcessMsg(MsgPlayable* aMsg) override;
+    Msg* ProcessMsg(MsgQuit* aMsg) override;
+private: // from IStreamPlayObserver
+    void NotifyTrackFailed(TUint aTrackId) override;
+    void NotifyStreamPlayStatus(TUint aTrackId, TUint aStreamId, EStreamPlay aStatus) override;
+private: // from ISeekRestreamer
+    TUint SeekRestream(const Brx& aMode, TUint aTrackId) override;
+private: // from IUrlBlockWriter
+    TBool TryGet(IWriter& aWriter, const Brx& aUrl, TUint64 aOffset, TUint aBytes) override;
+private: // from IPipelineAnimator
+    TUint PipelineAnimatorBufferJiffies() const override;
+    TUint PipelineAnimatorDelayJiffies(AudioFormat aFormat, TUint aSampleRate, TUint aBitDepth, TUint aNumChannels) const override;
+    TUint PipelineAnimatorDsdBlockSizeWords() const override;
+    TUint PipelineAnimatorMaxBitDepth() const override;
+    void PipelineAnimatorGetMaxSampleRates(TUint& aPcm, TUint& aDsd) const override;
+private: // from IVolumeRamper
+    void ApplyVolumeMultiplier(TUint aValue) override;
+private:
+    Environment& iEnv;
+    const TUint64 iDurationJiffies;
+    Pipeline* iPipeline;
+    ProcessorPerf iProcessor;
+    AudioFormat iFormat;
+    TUint64 iJiffies;
+    TUint iMsgCount;
+    TBool iLastMsgWasAudio;
+    TBool iQuitReceived;
+    TBool iMeasuring;
+    std::atomic<TUint> iStarvations;
+};
+
+} // namespace Media
+} // namespace OpenHome
+
+
+// PerfSupplier
+
+PerfSupplier::PerfSupplier(const PerfFormat& aFormat, MsgFactory& aMsgFactory, IPipelineElementDownstream& aDownstream, TrackFactory& aTrackFactory)
+    : Thread("TSUP")
+    , iFormat(aFormat)
+    , iMsgFactory(aMsgFactory)
+    , iDownstream(aDownstream)
+    , iTrackFactory(aTrackFactory)
+    , iDrain("TSP2", 0)
+    , iQuit(false)
+{
+    Start();
+}
+
+PerfSupplier::~PerfSupplier()
+{
+    Kill();
+    Join();
+}
+
+void PerfSupplier::Exit()
+{
+    iQuit = true;
+}
+
+void PerfSupplier::Drain()
+{
+    iDrain.Signal();
+}
+
+void PerfSupplier::Run()
+{
+    TByte encodedAudioData[EncodedAudio::kMaxBytes];
+    (void)memset(encodedAudioData, 0x7f, sizeof(encodedAudioData));
+    Brn encodedAudioBuf(encodedAudioData, sizeof(encodedAudioData));
+
+    iDownstream.Push(iMsgFactory.CreateMsgDrain(MakeFunctor(*this, &PerfSupplier::Drain)));
+    iDrain.Wait();
+    Track* track = iTrackFactory.CreateTrack(Brx::Empty(), Brx::Empty());
+    iDownstream.Push(iMsgFactory.CreateMsgTrack(*track));
+    track->RemoveRef();
+    if (iFormat.iFormat == AudioFormat::Pcm) {
+        // CodecController only accepts more than 2 channels from streams announced as PCM
+        PcmStreamInfo pcmStream;
+        pcmStream.Set(iFormat.iBitDepth, iFormat.iSampleRate, iFormat.iNumChannels, AudioDataEndian::Little, SpeakerProfile(), 0LL);
+        iDownstream.Push(iMsgFactory.CreateMsgEncodedStream(Brx::Empty(), Brx::Empty(), 1LL<<40, 0, 1, false, false, Multiroom::Allowed, this, pcmStream));
+    }
+    else {
+        iDownstream.Push(iMsgFactory.CreateMsgEncodedStream(Brx::Empty(), Brx::Empty(), 1LL<<40, 0, 1, false, false, Multiroom::Allowed, this));
+    }
+    // No pacing - pipeline back-pressure limits how far ahead of the driver we get
+    while (!iQuit) {
+        CheckForKill();
+        iDownstream.Push(iMsgFactory.CreateMsgAudioEncoded(encodedAudioBuf));
+    }
+    iDownstream.Push(iMsgFactory.CreateMsgHalt());
+    iDownstream.Push(iMsgFactory.CreateMsgQuit());
+}
+
+EStreamPlay PerfSupplier::OkToPlay(TUint /*aStreamId*/)
+{
+    return ePlayYes;
+}
+
+TUint PerfSupplier::TrySeek(TUint /*aStreamId*/, TUint64 /*aOffset*/)
+{
+    ASSERTS();
+    return MsgFlush::kIdInvalid;
+}
+
+TUint PerfSupplier::TryDiscard(TUint /*aJiffies*/)
+{
+    ASSERTS();
+    return MsgFlush::kIdInvalid;
+}
+
+TUint PerfSupplier::TryStop(TUint /*aStreamId*/)
+{
+    return MsgFlush::kIdInvalid;
+}
+
+void PerfSupplier::NotifyStarving(const Brx& /*aMode*/, TUint /*aStreamId*/, TBool /*aStarving*/)
+{
+}
+
+
+// PerfCodec
+
+PerfCodec::PerfCodec(const PerfFormat& aFormat)
+    : CodecBase("Perf")
+    , iFormat(aFormat)
+    , iTrackOffsetJiffies(0)
+    , iSentDecodedInfo(false)
+{
+}
+
+void PerfCodec::StreamInitialise()
+{
+    iTrackOffsetJiffies = 0;
+    iSentDecodedInfo = false;
+}
+
+TBool PerfCodec::Recognise(const EncodedStreamInfo& /*aStreamInfo*/)
+{
+    return true;
+}
+
+void PerfCodec::Process()
+{
+    if (!iSentDecodedInfo) {
+        const SpeakerProfile profile = DeriveProfile(iFormat.iNumChannels);
+        if (iFormat.iFormat == AudioFormat::Dsd) {
+            iController->OutputDecodedStreamDsd(iFormat.iSampleRate, iFormat.iNumChannels, Brn("perf codec"), 1LL<<40, 0, profile);
+        }
+        else {
+            const TUint bitRate = iFormat.iSampleRate * iFormat.iBitDepth * iFormat.iNumChannels;
+            iController->OutputDecodedStream(bitRate, iFormat.iBitDepth, iFormat.iSampleRate, iFormat.iNumChannels,
+                                             Brn("perf codec"), 1LL<<40, 0, true, profile);
+        }
+        iSentDecodedInfo = true;
+    }
+    else {
+        // DecodedAudio::kMaxBytes holds a whole number of samples for every format we test
+        // Don't need any exit condition for loop below.  iController->Read will throw eventually.
+        iReadBuf.SetBytes(0);
+        iController->Read(iReadBuf, iReadBuf.MaxBytes());
+        if (iFormat.iFormat == AudioFormat::Dsd) {
+            iTrackOffsetJiffies += iController->OutputAudioDsd(iReadBuf, iFormat.iNumChannels, iFormat.iSampleRate,
+                                                               kDsdSampleBlockWords, iTrackOffsetJiffies, kDsdPadBytesPerChunk);
+        }
+        else {
+            iTrackOffsetJiffies += iController->OutputAudioPcm(iReadBuf, iFormat.iNumChannels, iFormat.iSampleRate,
+                                                               iFormat.iBitDepth, AudioDataEndian::Little, iTrackOffsetJiffies);
+        }
+    }
+}
+
+TBool PerfCodec::TrySeek(TUint /*aStreamId*/, TUint64 /*aSample*/)
+{
+    return false;
+}
+
+
+// AllocatorStats
+
+AllocatorStats::AllocatorStats()
+{
+}
+
+const std::vector<AllocatorStats::Stats>& AllocatorStats::Collect()
+{
+    iStats.clear();
+    for (auto provider : iInfoProviders) {
+        iLine.SetBytes(0);
+        provider->QueryInfo(AllocatorBase::kQueryMemory, *this);
+    }
+    return iStats;
+}
+
+void AllocatorStats::ParseLine()
+{
+    // Allocator: <name>, capacity:<n> cells x <n> bytes, in use:<n> cells, peak:<n> cells, contention:<n>
+    Parser parser(iLine);
+    iLine.SetBytes(0);
+    if (parser.Next(':') != Brn("Allocator")) {
+        return;
+    }
+    Stats stats;
+    stats.iName.Replace(parser.Next(','));
+    (void)parser.Next(':');
+    stats.iCapacity = Ascii::Uint(parser.Next(' '));
+    (void)parser.Next(':'); // in use
+    (void)parser.Next(':'); // peak
+    stats.iPeak = Ascii::Uint(parser.Next(' '));
+    iStats.push_back(stats);
+}
+
+void AllocatorStats::Register(IInfoProvider& aProvider, std::vector<Brn>& /*aSupportedQueries*/)
+{
+    iInfoProviders.push_back(&aProvider);
+}
+
+void AllocatorStats::Write(TByte aValue)
+{
+    if (aValue == '\n') {
+        ParseLine();
+    }
+    else if (iLine.Bytes() < iLine.MaxBytes()) {
+        iLine.Append(aValue);
+    }
+}
+
+void AllocatorStats::Write(const Brx& aBuffer)
+{
+    for (TUint i=0; i<aBuffer.Bytes(); i++) {
+        Write(aBuffer[i]);
+    }
+}
+
+void AllocatorStats::WriteFlush()
+{
+}
+
+
+// ProcessorPerf
+
+ProcessorPerf::ProcessorPerf()
+    : iChecksum(0)
+{
+}
+
+TUint ProcessorPerf::Checksum() const
+{
+    return iChecksum;
+}
+
+void ProcessorPerf::Accumulate(const Brx& aData)
+{
+    const TByte* ptr = aData.Ptr();
+    const TUint bytes = aData.Bytes();
+    TUint sum = iChecksum;
+    for (TUint i=0; i<bytes; i++) {
+        sum += ptr[i];
+    }
+    iChecksum = sum;
+}
+
+void ProcessorPerf::BeginBlock()
+{
+}
+
+void ProcessorPerf::ProcessFragment(const Brx& aData, TUint /*aNumChannels*/, TUint /*aSubsampleBytes*/)
+{
+    Accumulate(aData);
+}
+
+void ProcessorPerf::ProcessSilence(const Brx& aData, TUint /*aNumChannels*/, TUint /*aSubsampleBytes*/)
+{
+    Accumulate(aData);
+}
+
+void ProcessorPerf::EndBlock()
+{
+}
+
+void ProcessorPerf::Flush()
+{
+}
+
+
+// SuitePipelinePerf
+
+const PerfFormat SuitePipelinePerf::kFormats[] = {
+    { AudioFormat::Pcm, 44100,    16, 2, "pcm-44k1-16-2ch" },
+    { AudioFormat::Pcm, 48000,    24, 2, "pcm-48k-24-2ch" },
+    { AudioFormat::Pcm, 96000,    24, 2, "pcm-96k-24-2ch" },
+    { AudioFormat::Pcm, 192000,   24, 2, "pcm-192k-24-2ch" },
+    { AudioFormat::Pcm, 192000,   32, 2, "pcm-192k-32-2ch" },
+    { AudioFormat::Pcm, 384000,   32, 2, "pcm-384k-32-2ch" },
+    { AudioFormat::Pcm, 192000,   24, 6, "pcm-192k-24-6ch" },
+    { AudioFormat::Pcm, 384000,   32, 8, "pcm-384k-32-8ch" },
+    { AudioFormat::Dsd, 2822400,  1,  2, "dsd64-2ch" },
+    { AudioFormat::Dsd, 11289600, 1,  2, "dsd256-2ch" },
+};
+const TUint SuitePipelinePerf::kNumFormats = sizeof(SuitePipelinePerf::kFormats) / sizeof(SuitePipelinePerf::kFormats[0]);
+
+SuitePipelinePerf::SuitePipelinePerf(Environment& aEnv, TUint aDurationSecs)
+    : Suite("Pipeline performance")
+    , iEnv(aEnv)
+    , iDurationJiffies((TUint64)aDurationSecs * Jiffies::kPerSecond)
+    , iPipeline(nullptr)
+    , iFormat(AudioFormat::Pcm)
+    , iJiffies(0)
+    , iMsgCount(0)
+    , iLastMsgWasAudio(false)
+    , iQuitReceived(false)
+    , iMeasuring(false)
+    , iStarvations(0)
+{
+}
+
+void SuitePipelinePerf::Test()
+{
+    for (TUint i=0; i<kNumFormats; i++) {
+        Run(kFormats[i]);
+    }
+}
+
+void SuitePipelinePerf::Run(const PerfFormat& aFormat)
+{
+    AllocatorStats allocatorStats;
+    auto initParams = PipelineInitParams::New();
+    initParams->SetDsdMaxSampleRate(kMaxDsdSampleRate);
+    if (aFormat.iFormat == AudioFormat::Pcm) {
+        // Pipeline sizes its decoded audio allocators for a reservoir full of msgs of
+        // DecodedAudioAggregator::kMaxJiffies, plus 200 spare.  Multichannel hi-res msgs fill
+        // DecodedAudio::kMaxBytes sooner so limit the reservoir to a count of msgs within that spare.
+        const TUint bytesPerSample = aFormat.iNumChannels * (aFormat.iBitDepth / 8);
+        const TUint msgJiffies = (DecodedAudio::kMaxBytes / bytesPerSample) * Jiffies::PerSample(aFormat.iSampleRate);
+        if (msgJiffies < DecodedAudioAggregator::kMaxJiffies) {
+            initParams->SetDecodedReservoirSize(msgJiffies * kMaxShortMsgsInReservoir);
+        }
+    }
+    auto trackFactory = new TrackFactory(allocatorStats, 1);
+    auto audioTime = new AudioTimeCpu(iEnv);
+    VolumeRamperStub volumeRamper;
+    iPipeline = new Pipeline(initParams, allocatorStats, *trackFactory, *this, *this, *this, *this, *audioTime);
+    iPipeline->SetAnimator(*this);
+    auto supplier = new PerfSupplier(aFormat, iPipeline->Factory(), *iPipeline, *trackFactory);
+    iPipeline->AddCodec(new PerfCodec(aFormat));
+    iPipeline->Start(*this, volumeRamper);
+
+    iJiffies = 0;
+    iMsgCount = 0;
+    iLastMsgWasAudio = false;
+    iQuitReceived = false;
+    iMeasuring = false;
+    iStarvations = 0;
+
+    // run until audio starts flowing so that the results exclude start-up costs
+    iPipeline->Play();
+    do {
+        PullNext();
+    } while (!iLastMsgWasAudio);
+
+    std::vector<TUint> latencies;
+    latencies.reserve(1024 * 1024);
+    iJiffies = 0;
+    iMsgCount = 0;
+    iMeasuring = true;
+    iPipeline->Profile().Reset();
+    OsContext* osCtx = iEnv.OsCtx();
+    const std::clock_t cpuStart = std::clock();
+    const TUint64 wallStart = Os::TimeInUs(osCtx);
+    while (iJiffies < iDurationJiffies) {
+        const TUint64 pullStart = Os::TimeInUs(osCtx);
+        Msg* msg = iPipeline->Pull();
+        latencies.push_back((TUint)(Os::TimeInUs(osCtx) - pullStart));
+        (void)msg->Process(*this);
+    }
+    const TUint64 wallUs = Os::TimeInUs(osCtx) - wallStart;
+    const TUint64 cpuNs = (TUint64)(((double)(std::clock() - cpuStart) * 1000000000) / CLOCKS_PER_SEC);
+    iMeasuring = false;
+
+    Report(aFormat, wallUs, cpuNs, latencies, allocatorStats);
+    TEST(iJiffies >= iDurationJiffies);
+
+    supplier->Exit();
+    iPipeline->Quit();
+    while (!iQuitReceived) {
+        PullNext();
+    }
+    delete supplier;
+    delete iPipeline;
+    iPipeline = nullptr;
+    delete trackFactory;
+    delete audioTime;
+}
+
+void SuitePipelinePerf::PullNext()
+{
+    Msg* msg = iPipeline->Pull();
+    (void)msg->Process(*this);
+}
+
+void SuitePipelinePerf::Report(const PerfFormat& aFormat, TUint64 aWallUs, TUint64 aCpuNs, std::vector<TUint>& aLatencies, AllocatorStats& aAllocatorStats)
+{
+    std::sort(aLatencies.begin(), aLatencies.end());
+    const double wallSecs = (aWallUs == 0? 1 : aWallUs) / 1000000.0;
+    const double audioSecs = (double)iJiffies / Jiffies::kPerSecond;
+
+    Log::Print("{\"format\":\"%s\",\"sample_rate\":%u,\"bit_depth\":%u,\"channels\":%u",
+               aFormat.iName, aFormat.iSampleRate, aFormat.iBitDepth, aFormat.iNumChannels);
+    Log::Print(",\"msgs\":%u,\"jiffies\":%llu,\"wall_us\":%llu,\"cpu_ns\":%llu",
+               iMsgCount, iJiffies, aWallUs, aCpuNs);
+    Log::Print(",\"msgs_per_sec\":%.1f,\"realtime_factor\":%.2f,\"cpu_ns_per_jiffy\":%.4f,\"starvations\":%u",
+               iMsgCount / wallSecs, audioSecs / wallSecs, (iJiffies == 0? 0.0 : (double)aCpuNs / iJiffies), iStarvations.load());
+    Log::Print(",\"pull_us\":{\"p50\":%u,\"p90\":%u,\"p99\":%u,\"p999\":%u,\"max\":%u}",
+               Percentile(aLatencies, 500), Percentile(aLatencies, 900), Percentile(aLatencies, 990),
+               Percentile(aLatencies, 999), Percentile(aLatencies, 1000));
+    Log::Print(",\"allocators\":[");
+    const auto& stats = aAllocatorStats.Collect();
+    for (TUint i=0; i<stats.size(); i++) {
+        Log::Print("%s{\"name\":\"%.*s\",\"capacity\":%u,\"peak\":%u}",
+                   (i == 0? "" : ","), PBUF(stats[i].iName), stats[i].iCapacity, stats[i].iPeak);
+    }
+    Log::Print("],\"elements\":[");
+    const IPipelineProfile& profile = iPipeline->Profile();
+    for (TUint i=0; i<profile.ElementCount(); i++) {
+        const PipelineElementStats& stats = profile.ElementAt(i);
+        Log::Print("%s{\"id\":\"%s\",\"self_ns_per_jiffy\":", (i == 0? "" : ","), stats.Id());
+        if (!stats.HasSelfTime() || iJiffies == 0) {
+            Log::Print("null}");
+        }
+        else {
+            Log::Print("%.4f}", (double)stats.SelfTimeUs() * 1000 / iJiffies);
+        }
+    }
+    Log::Print("]}\n");
+}
+
+TUint SuitePipelinePerf::Percentile(const std::vector<TUint>& aSorted, TUint aPerMille)
+{
+    if (aSorted.size() == 0) {
+        return 0;
+    }
+    const size_t index = ((aSorted.size() - 1) * aPerMille) / 1000;
+    return aSorted[index];
+}
+
+void SuitePipelinePerf::NotifyPipelineState(EPipelineState aState)
+{
+    if (iMeasuring && aState == EPipelineBuffering) {
+        iStarvations++;
+    }
+}
+
+void SuitePipelinePerf::NotifyMode(const Brx& /*aMode*/,
+                                   const ModeInfo& /*aInfo*/,
+                                   const ModeTransportControls& /*aTransportControls*/)
+{
+}
+
+void SuitePipelinePerf::NotifyTrack(Track& /*aTrack*/, TBool /*aStartOfStream*/)
+{
+}
+
+void SuitePipelinePerf::NotifyMetaText(const Brx& /*aText*/)
+{
+}
+
+void SuitePipelinePerf::NotifyTime(TUint /*aSeconds*/)
+{
+}
+
+void SuitePipelinePerf::NotifyStreamInfo(const DecodedStreamInfo& /*aStreamInfo*/)
+{
+}
+
+Msg* SuitePipelinePerf::ProcessMsg(MsgMode* /*aMsg*/)
+{
+    ASSERTS();
+    return nullptr;
+}
+
+Msg* SuitePipelinePerf::ProcessMsg(MsgTrack* /*aMsg*/)
+{
+    ASSERTS();
+    return nullptr;
+}
+
+Msg* SuitePipelinePerf::ProcessMsg(MsgDrain* aMsg)
+{
+    iLastMsgWasAudio = false;
+    aMsg->ReportDrained();
+    aMsg->RemoveRef();
+    iMsgCount++;
+    return nullptr;
+}
+
+Msg* SuitePipelinePerf::ProcessMsg(MsgDelay* /*aMsg*/)
+{
+    ASSERTS();
+    return nullptr;
+}
+
+Msg* SuitePipelinePerf::ProcessMsg(MsgEncodedStream* /*aMsg*/)
+{
+    ASSERTS();
+    return nullptr;
+}
+
+Msg* SuitePipelinePerf::ProcessMsg(MsgStreamSegment* /*aMsg*/)
+{
+    ASSERTS();
+    return nullptr;
+}
+
+Msg* SuitePipelinePerf::ProcessMsg(MsgAudioEncoded* /*aMsg*/)
+{
+    ASSERTS();
+    return nullptr;
+}
+
+Msg* SuitePipelinePerf::ProcessMsg(MsgMetaText* /*aMsg*/)
+{
+    ASSERTS();
+    return nullptr;
+}
+
+Msg* SuitePipelinePerf::ProcessMsg(MsgStreamInterrupted* /*aMsg*/)
+{
+    ASSERTS();
+    return nullptr;
+}
+
+Msg* SuitePipelinePerf::ProcessMsg(MsgHalt* aMsg)
+{
+    iLastMsgWasAudio = false;
+    aMsg->ReportHalted();
+    aMsg->RemoveRef();
+    iMsgCount++;
+    return nullptr;
+}
+
+Msg* SuitePipelinePerf::ProcessMsg(MsgFlush* /*aMsg*/)
+{
+    ASSERTS();
+    return nullptr;
+}
+
+Msg* SuitePipelinePerf::ProcessMsg(MsgWait* /*aMsg*/)
+{
+    ASSERTS();
+    return nullptr;
+}
+
+Msg* SuitePipelinePerf::ProcessMsg(MsgDecodedStream* aMsg)
+{
+    iLastMsgWasAudio = false;
+    iFormat = aMsg->StreamInfo().Format();
+    aMsg->RemoveRef();
+    iMsgCount++;
+    return nullptr;
+}
+
+Msg* SuitePipelinePerf::ProcessMsg(MsgAudioPcm* /*aMsg*/)
+{
+    ASSERTS();
+    return nullptr;
+}
+
+Msg* SuitePipelinePerf::ProcessMsg(MsgAudioDsd* /*aMsg*/)
+{
+    ASSERTS();
+    return nullptr;
+}
+
+Msg* SuitePipelinePerf::ProcessMsg(MsgSilence* /*aMsg*/)
+{
+    ASSERTS();
+    return nullptr;
+}
+
+Msg* SuitePipelinePerf::ProcessMsg(MsgPlayable* aMsg)
+{
+    iLastMsgWasAudio = true;
+    iJiffies += aMsg->Jiffies();
+    if (iFormat == AudioFormat::Dsd) {
+        aMsg->Read(static_cast<IDsdProcessor&>(iProcessor));
+    }
+    else {
+        aMsg->Read(static_cast<IPcmProcessor&>(iProcessor));
+    }
+    aMsg->RemoveRef();
+    iMsgCount++;
+    return nullptr;
+}
+
+Msg* SuitePipelinePerf::ProcessMsg(MsgQuit* aMsg)
+{
+    iQuitReceived = true;
+    aMsg->RemoveRef();
+    return nullptr;
+}
+
+void SuitePipelinePerf::NotifyTrackFailed(TUint /*aTrackId*/)
+{
+}
+
+void SuitePipelinePerf::NotifyStreamPlayStatus(TUint /*aTrackId*/, TUint /*aStreamId*/, EStreamPlay /*aStatus*/)
+{
+}
+
+TUint SuitePipelinePerf::SeekRestream(const Brx& /*aMode*/, TUint /*aTrackId*/)
+{
+    ASSERTS();
+    return MsgFlush::kIdInvalid;
+}
+
+TBool SuitePipelinePerf::TryGet(IWriter& /*aWriter*/, const Brx& /*aUrl*/, TUint64 /*aOffset*/, TUint /*aBytes*/)
+{
+    return false;
+}
+
+TUint SuitePipelinePerf::PipelineAnimatorBufferJiffies() const
+{
+    return 0;
+}
+
+TUint SuitePipelinePerf::PipelineAnimatorDelayJiffies(AudioFormat /*aFormat*/, TUint /*aSampleRate*/, TUint /*aBitDepth*/, TUint /*aNumChannels*/) const
+{
+    return 0;
+}
+
+TUint SuitePipelinePerf::PipelineAnimatorDsdBlockSizeWords() const
+{
+    return PerfCodec::kDsdSampleBlockWords;
+}
+
+TUint SuitePipelinePerf::PipelineAnimatorMaxBitDepth() const
+{
+    return 32;
+}
+
+void SuitePipelinePerf::PipelineAnimatorGetMaxSampleRates(TUint& aPcm, TUint& aDsd) const
+{
+    aPcm = kMaxPcmSampleRate;
+    aDsd = kMaxDsdSampleRate;
+}
+
+void SuitePipelinePerf::ApplyVolumeMultiplier(TUint /*aValue*/)
+{
+}
+
+
+
+void TestPipelinePerf(Environment& aEnv, const std::vector<Brn>& aArgs)
+{
+    OptionParser parser;
+    OptionUint optionDuration("-d", "--duration", 10, "seconds of audio to pull for each format");
+    parser.AddOption(&optionDuration);
+    if (!parser.Parse(aArgs) || parser.HelpDisplayed()) {
+        return;
+    }
+
+    Runner runner("Pipeline performance\n");
+    runner.Add(new SuitePipelinePerf(aEnv, optionDuration.Value()));
+    runner.Run();
+}
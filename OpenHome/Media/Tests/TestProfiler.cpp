@@ -0,0 +1,327 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Private/Standard.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Private/Parser.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Private/InfoProvider.h>
+#include <OpenHome/Media/Pipeline/Profiler.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Media/Utils/AllocatorInfoLogger.h>
+
+#include <list>
+#include <vector>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Media;
+
+namespace OpenHome {
+namespace Media {
+
+class PullThrough : public IPipelineElementUpstream
+{
+public:
+    PullThrough(IPipelineElementUpstream& aUpstream);
+public: // from IPipelineElementUpstream
+    Msg* Pull() override;
+private:
+    IPipelineElementUpstream& iUpstream;
+};
+
+class PushThrough : public IPipelineElementDownstream
+{
+public:
+    PushThrough(IPipelineElementDownstream& aDownstream, TUint aDelayMs);
+public: // from IPipelineElementDownstream
+    void Push(Msg* aMsg) override;
+private:
+    IPipelineElementDownstream& iDownstream;
+    TUint iDelayMs;
+};
+
+class SuiteProfiler : public SuiteUnitTest, private IPipelineElementUpstream, private IPipelineElementDownstream, private IInfoAggregator, private INonCopyable
+{
+    static const TUint kSampleRate = 44100;
+    static const TUint kBitDepth = 16;
+    static const TUint kNumChannels = 2;
+    static const TUint kPullDelayMs = 5;
+public:
+    SuiteProfiler();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private: // from IPipelineElementUpstream
+    Msg* Pull() override;
+private: // from IPipelineElementDownstream
+    void Push(Msg* aMsg) override;
+private: // from IInfoAggregator
+    void Register(IInfoProvider& aProvider, std::vector<Brn>& aSupportedQueries) override;
+private:
+    MsgAudioPcm* CreateAudio();
+    MsgSilence* CreateSilence();
+    void PullAll(IPipelineElementUpstream& aElement);
+private:
+    void TestMsgsCounted();
+    void TestJiffiesCounted();
+    void TestReset();
+    void TestSelfTimeExcludesUpstream();
+    void TestPushMeasured();
+    void TestInfoQuery();
+private:
+    AllocatorInfoLogger iInfoAggregator;
+    TrackFactory* iTrackFactory;
+    MsgFactory* iMsgFactory;
+    PipelineProfile* iProfile;
+    std::list<Msg*> iPendingMsgs;
+    TUint iPullDelayMs;
+    IInfoProvider* iInfoProvider;
+    std::vector<Brn> iInfoQueries;
+};
+
+} // namespace Media
+} // namespace OpenHome
+
+
+// PullThrough
+
+PullThrough::PullThrough(IPipelineElementUpstream& aUpstream)
+    : iUpstream(aUpstream)
+{
+}
+
+Msg* PullThrough::Pull()
+{
+    return iUpstream.Pull();
+}
+
+
+// PushThrough
+
+PushThrough::PushThrough(IPipelineElementDownstream& aDownstream, TUint aDelayMs)
+    : iDownstream(aDownstream)
+    , iDelayMs(aDelayMs)
+{
+}
+
+void PushThrough::Push(Msg* aMsg)
+{
+    if (iDelayMs > 0) {
+        Thread::Sleep(iDelayMs);
+    }
+    iDownstream.Push(aMsg);
+}
+
+
+// SuiteProfiler
+
+SuiteProfiler::SuiteProfiler()
+    : SuiteUnitTest("Profiler")
+{
+    AddTest(MakeFunctor(*this, &SuiteProfiler::TestMsgsCounted), "TestMsgsCounted");
+    AddTest(MakeFunctor(*this, &SuiteProfiler::TestJiffiesCounted), "TestJiffiesCounted");
+    AddTest(MakeFunctor(*this, &SuiteProfiler::TestReset), "TestReset");
+    AddTest(MakeFunctor(*this, &SuiteProfiler::TestSelfTimeExcludesUpstream), "TestSelfTimeExcludesUpstream");
+    AddTest(MakeFunctor(*this, &SuiteProfiler::TestPushMeasured), "TestPushMeasured");
+    AddTest(MakeFunctor(*this, &SuiteProfiler::TestInfoQuery), "TestInfoQuery");
+}
+
+void SuiteProfiler::Setup()
+{
+    iTrackFactory = new TrackFactory(iInfoAggregator, 1);
+    MsgFactoryInitParams init;
+    init.SetMsgAudioPcmCount(10, 10);
+    init.SetMsgSilenceCount(10);
+    iMsgFactory = new MsgFactory(iInfoAggregator, init);
+    iInfoProvider = nullptr;
+    iInfoQueries.clear();
+    iProfile = new PipelineProfile(*this);
+    iPullDelayMs = 0;
+}
+
+void SuiteProfiler::TearDown()
+{
+    while (iPendingMsgs.size() > 0) {
+        iPendingMsgs.front()->RemoveRef();
+        iPendingMsgs.pop_front();
+    }
+    delete iProfile;
+    delete iMsgFactory;
+    delete iTrackFactory;
+}
+
+Msg* SuiteProfiler::Pull()
+{
+    ASSERT(iPendingMsgs.size() > 0);
+    if (iPullDelayMs > 0) {
+        Thread::Sleep(iPullDelayMs);
+    }
+    Msg* msg = iPendingMsgs.front();
+    iPendingMsgs.pop_front();
+    return msg;
+}
+
+void SuiteProfiler::Push(Msg* aMsg)
+{
+    aMsg->RemoveRef();
+}
+
+void SuiteProfiler::Register(IInfoProvider& aProvider, std::vector<Brn>& aSupportedQueries)
+{
+    iInfoProvider = &aProvider;
+    iInfoQueries = aSupportedQueries;
+}
+
+MsgAudioPcm* SuiteProfiler::CreateAudio()
+{
+    TByte audioData[480]; // 120 samples
+    (void)memset(audioData, 0x7f, sizeof(audioData));
+    Brn audioBuf(audioData, sizeof(audioData));
+    return iMsgFactory->CreateMsgAudioPcm(audioBuf, kNumChannels, kSampleRate, kBitDepth, AudioDataEndian::Little, 0);
+}
+
+MsgSilence* SuiteProfiler::CreateSilence()
+{
+    TUint size = Jiffies::kPerMs * 3;
+    return iMsgFactory->CreateMsgSilence(size, kSampleRate, kBitDepth, kNumChannels);
+}
+
+void SuiteProfiler::PullAll(IPipelineElementUpstream& aElement)
+{
+    while (iPendingMsgs.size() > 0) {
+        Msg* msg = aElement.Pull();
+        msg->RemoveRef();
+    }
+}
+
+void SuiteProfiler::TestMsgsCounted()
+{
+    auto& stats = iProfile->Add("test", nullptr);
+    ProfiledUpstream<PullThrough> element(stats, static_cast<IPipelineElementUpstream&>(*this));
+    Track* track = iTrackFactory->CreateTrack(Brx::Empty(), Brx::Empty());
+    iPendingMsgs.push_back(iMsgFactory->CreateMsgTrack(*track));
+    track->RemoveRef();
+    iPendingMsgs.push_back(iMsgFactory->CreateMsgHalt());
+    iPendingMsgs.push_back(iMsgFactory->CreateMsgHalt());
+    iPendingMsgs.push_back(iMsgFactory->CreateMsgQuit());
+    PullAll(element);
+
+    TEST(stats.Calls() == 4);
+    TEST(stats.MsgCount(PipelineElementStats::EMsgTrack) == 1);
+    TEST(stats.MsgCount(PipelineElementStats::EMsgHalt) == 2);
+    TEST(stats.MsgCount(PipelineElementStats::EMsgQuit) == 1);
+    TEST(stats.MsgCount(PipelineElementStats::EMsgAudioPcm) == 0);
+    TEST(stats.Jiffies() == 0);
+}
+
+void SuiteProfiler::TestJiffiesCounted()
+{
+    auto& stats = iProfile->Add("test", nullptr);
+    ProfiledUpstream<PullThrough> element(stats, static_cast<IPipelineElementUpstream&>(*this));
+    MsgAudioPcm* audio = CreateAudio();
+    MsgSilence* silence = CreateSilence();
+    const TUint64 expected = audio->Jiffies() + silence->Jiffies();
+    iPendingMsgs.push_back(audio);
+    iPendingMsgs.push_back(silence);
+    PullAll(element);
+
+    TEST(stats.MsgCount(PipelineElementStats::EMsgAudioPcm) == 1);
+    TEST(stats.MsgCount(PipelineElementStats::EMsgSilence) == 1);
+    TEST(stats.Jiffies() == expected);
+}
+
+void SuiteProfiler::TestReset()
+{
+    auto& stats = iProfile->Add("test", nullptr);
+    ProfiledUpstream<PullThrough> element(stats, static_cast<IPipelineElementUpstream&>(*this));
+    iPendingMsgs.push_back(CreateAudio());
+    iPendingMsgs.push_back(iMsgFactory->CreateMsgHalt());
+    PullAll(element);
+    TEST(stats.Calls() == 2);
+
+    iProfile->Reset();
+    TEST(stats.Calls() == 0);
+    TEST(stats.TimeUs() == 0);
+    TEST(stats.TimeMaxUs() == 0);
+    TEST(stats.Jiffies() == 0);
+    for (TUint i=0; i<PipelineElementStats::EMsgTypeCount; i++) {
+        TEST(stats.MsgCount((PipelineElementStats::EMsgType)i) == 0);
+    }
+}
+
+void SuiteProfiler::TestSelfTimeExcludesUpstream()
+{
+    auto& upstreamStats = iProfile->Add("upstream", nullptr);
+    ProfiledUpstream<PullThrough> upstream(upstreamStats, static_cast<IPipelineElementUpstream&>(*this));
+    auto& downstreamStats = iProfile->Add("downstream", &upstreamStats);
+    ProfiledUpstream<PullThrough> downstream(downstreamStats, upstream);
+    iPullDelayMs = kPullDelayMs;
+    iPendingMsgs.push_back(iMsgFactory->CreateMsgHalt());
+    iPendingMsgs.push_back(iMsgFactory->CreateMsgHalt());
+    PullAll(downstream);
+
+    TEST(upstreamStats.Calls() == 2);
+    TEST(downstreamStats.Calls() == 2);
+    TEST(upstreamStats.TimeUs() >= 2 * kPullDelayMs * 1000);
+    TEST(upstreamStats.TimeMaxUs() >= kPullDelayMs * 1000);
+    TEST(downstreamStats.TimeUs() >= upstreamStats.TimeUs());
+    TEST(downstreamStats.SelfTimeUs() < kPullDelayMs * 1000);
+    TEST(!upstreamStats.HasSelfTime());
+    TEST(upstreamStats.SelfTimeUs() == upstreamStats.TimeUs()); // no inner element to subtract
+}
+
+void SuiteProfiler::TestPushMeasured()
+{
+    auto& innerStats = iProfile->Add("inner", nullptr);
+    ProfiledDownstream<PushThrough> inner(innerStats, static_cast<IPipelineElementDownstream&>(*this), kPullDelayMs);
+    auto& outerStats = iProfile->Add("outer", &innerStats);
+    ProfiledDownstream<PushThrough> outer(outerStats, inner, 0);
+    outer.Push(iMsgFactory->CreateMsgHalt());
+    outer.Push(CreateAudio());
+
+    TEST(outerStats.Calls() == 2);
+    TEST(innerStats.Calls() == 2);
+    TEST(outerStats.MsgCount(PipelineElementStats::EMsgHalt) == 1);
+    TEST(outerStats.MsgCount(PipelineElementStats::EMsgAudioPcm) == 1);
+    TEST(outerStats.Jiffies() > 0);
+    TEST(outerStats.Jiffies() == innerStats.Jiffies());
+    TEST(innerStats.TimeUs() >= 2 * kPullDelayMs * 1000);
+    TEST(outerStats.TimeUs() >= innerStats.TimeUs());
+    TEST(outerStats.SelfTimeUs() < kPullDelayMs * 1000);
+}
+
+void SuiteProfiler::TestInfoQuery()
+{
+    TEST(iInfoProvider != nullptr);
+    TEST(iInfoQueries.size() == 1);
+    TEST(iInfoQueries[0] == PipelineProfile::kQueryPipeline);
+
+    auto& first = iProfile->Add("first", nullptr);
+    (void)iProfile->Add("second", &first);
+    TEST(iProfile->ElementCount() == 2);
+    TEST(&iProfile->ElementAt(0) == &first);
+
+    WriterBwh writer(1024);
+    iInfoProvider->QueryInfo(PipelineProfile::kQueryPipeline, writer);
+    Parser parser(writer.Buffer());
+    TEST(parser.Next(':') == Brn("Element"));
+    TEST(parser.Next(',') == Brn("first"));
+    (void)parser.Next('\n');
+    TEST(parser.Next(':') == Brn("Element"));
+    TEST(parser.Next(',') == Brn("second"));
+    (void)parser.Next('\n');
+    TEST(parser.Remaining().Bytes() == 0);
+
+    WriterBwh writerOther(1024);
+    iInfoProvider->QueryInfo(Brn("memory"), writerOther);
+    TEST(writerOther.Buffer().Bytes() == 0);
+}
+
+
+
+void TestProfiler()
+{
+    Runner runner("Profiler tests\n");
+    runner.Add(new SuiteProfiler());
+    runner.Run();
+}
@@ -109,6 +109,7 @@ private:
     void TestFlush();
     void TestDrainAllAudio();
     void TestAllSampleRates();
+    void TestRampHighSampleRateMultichannel();
     void TestPruneMsgsNotReqdDownstream();
     void TestDsdNoRampWhenFull();
     void TestDsdRampsDownOnStarvation();
@@ -139,6 +140,7 @@ private:
     TUint iStarvingStreamId;
     TUint iSampleRate;
     TUint iBitDepth;
+    TUint iNumChannels;
 };
 
 } // namespace Media
@@ -163,6 +165,7 @@ SuiteStarvationRamper::SuiteStarvationRamper()
     AddTest(MakeFunctor(*this, &SuiteStarvationRamper::TestFlush), "TestFlush");
     AddTest(MakeFunctor(*this, &SuiteStarvationRamper::TestDrainAllAudio), "TestDrainAllAudio");
     AddTest(MakeFunctor(*this, &SuiteStarvationRamper::TestAllSampleRates), "TestAllSampleRates");
+    AddTest(MakeFunctor(*this, &SuiteStarvationRamper::TestRampHighSampleRateMultichannel), "TestRampHighSampleRateMultichannel");
     AddTest(MakeFunctor(*this, &SuiteStarvationRamper::TestPruneMsgsNotReqdDownstream), "TestPruneMsgsNotReqdDownstream");
     AddTest(MakeFunctor(*this, &SuiteStarvationRamper::TestDsdNoRampWhenFull), "TestDsdNoRampWhenFull");
     AddTest(MakeFunctor(*this, &SuiteStarvationRamper::TestDsdRampsDownOnStarvation), "TestDsdRampsDownOnStarvation");
@@ -199,6 +202,7 @@ void SuiteStarvationRamper::Setup()
     iStarvingStreamId = IPipelineIdProvider::kStreamIdInvalid;
     iSampleRate = kSampleRateDefault;
     iBitDepth = kBitDepthDefault;
+    iNumChannels = kNumChannels;
 
     iTrackFactory = new TrackFactory(iInfoAggregator, 5);
     iEventCallback = new ElementObserverSync();
@@ -472,12 +476,12 @@ Msg* SuiteStarvationRamper::CreateTrack()
 
 Msg* SuiteStarvationRamper::CreateDecodedStream(AudioFormat aFormat)
 {
-    return iMsgFactory->CreateMsgDecodedStream(iNextStreamId, 100, iBitDepth, iSampleRate, kNumChannels, Brn("notARealCodec"), 1LL<<38, 0, true, true, false, false, aFormat, Multiroom::Allowed, kProfile, this, RampType::Sample);
+    return iMsgFactory->CreateMsgDecodedStream(iNextStreamId, 100, iBitDepth, iSampleRate, iNumChannels, Brn("notARealCodec"), 1LL<<38, 0, true, true, false, false, aFormat, Multiroom::Allowed, kProfile, this, RampType::Sample);
 }
 
 Msg* SuiteStarvationRamper::CreateAudio()
 {
-    MsgAudioPcm* audio = iMsgFactory->CreateMsgAudioPcm(iPcmData, kNumChannels, iSampleRate, iBitDepth, AudioDataEndian::Big, iTrackOffset);
+    MsgAudioPcm* audio = iMsgFactory->CreateMsgAudioPcm(iPcmData, iNumChannels, iSampleRate, iBitDepth, AudioDataEndian::Big, iTrackOffset);
     iTrackOffset += audio->Jiffies();
     return audio;
 }
@@ -914,6 +918,40 @@ void SuiteStarvationRamper::TestAllSampleRates()
     Quit();
 }
 
+void SuiteStarvationRamper::TestRampHighSampleRateMultichannel()
+{
+    // each 1ms block of the flywheel ramp is too large for a single msg at this format
+    iSampleRate = 384000;
+    iBitDepth = 32;
+    iNumChannels = 8;
+    const TUint bytesPerSample = (iBitDepth/8) * iNumChannels;
+    iPcmData.SetBytes((iPcmData.MaxBytes() / bytesPerSample) * bytesPerSample);
+    (void)memset(const_cast<TByte*>(iPcmData.Ptr()), 0x7f, iPcmData.Bytes());
+
+    AddPending(iMsgFactory->CreateMsgMode(kMode));
+    AddPending(CreateDecodedStream());
+    do {
+        AddPending(CreateAudio());
+    } while (iTrackOffset < StarvationRamper::kTrainingJiffies);
+
+    PullNext(EMsgMode);
+    PullNext(EMsgDecodedStream);
+    do {
+        PullNext(EMsgAudioPcm);
+    } while (iJiffies < iTrackOffset);
+    iRampingDown = true;
+    iJiffies = 0;
+    while (iRampingDown) {
+        PullNext(EMsgAudioPcm);
+    }
+    TUint expected = StarvationRamper::kRampDownJiffies;
+    Jiffies::RoundDown(expected, iSampleRate);
+    TEST(iJiffies == expected);
+    PullNext(EMsgHalt, false);
+
+    Quit();
+}
+
 void SuiteStarvationRamper::TestPruneMsgsNotReqdDownstream()
 {
     AddPending(CreateTrack());
@@ -0,0 +1,900 @@
+#include <OpenHome/Media/Utils/PcmKernels.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Private/Standard.h>
+
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define PCM_KERNELS_X86
+# define PCM_KERNELS_TARGET(aIsa) __attribute__((target(aIsa)))
+# include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+# define PCM_KERNELS_X86
+# define PCM_KERNELS_TARGET(aIsa)
+# include <intrin.h>
+# include <immintrin.h>
+#elif defined(PCM_KERNELS_ENABLE_NEON) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+// NEON versions are opt-in (waf --pcm-kernels-neon) until they've been verified on target hardware
+# define PCM_KERNELS_NEON
+# include <arm_neon.h>
+#endif
+
+using namespace OpenHome;
+using namespace OpenHome::Media;
+
+typedef void (*PcmCopyFunc)(const TByte* aSrc, TByte* aDest, TUint aBytes);
+typedef void (*PcmGainFunc)(const TByte* aSrc, TByte* aDest, const TInt16* aGains, TUint aNumSubsamples);
+typedef void (*PcmAttenuateFunc)(const TByte* aSrc, TByte* aDest, TUint aNumSubsamples, TUint aAttenuation);
+typedef void (*PcmPackFunc)(const TInt32* const* aChannels, TUint aNumChannels, TUint aFirstSample, TUint aNumSamples, TUint aShift, TByte* aDest);
+
+struct PcmKernelTable
+{
+    const TChar* iName;
+    PcmCopyFunc iCopyToBigEndian16;
+    PcmCopyFunc iCopyToBigEndian24;
+    PcmCopyFunc iCopyToBigEndian32;
+    PcmGainFunc iApplyGain16BigEndian;
+    PcmGainFunc iApplyGain16LittleEndian;
+    PcmAttenuateFunc iAttenuate[4][2]; // [subsample bytes - 1][big endian]
+    PcmPackFunc iPackPlanar[4][2][3]; // [subsample bytes - 1][big endian][mono, stereo, any number of channels]
+};
+
+template <TUint kSubsampleBytes, TBool kBigEndian>
+static void AttenuateSubsamples(const TByte* aSrc, TByte* aDest, TUint aNumSubsamples, TUint aAttenuation)
+{
+    for (TUint i=0; i<aNumSubsamples; i++) {
+        TInt64 subsample;
+        if (kBigEndian) {
+            subsample = (TInt8)aSrc[0];
+            for (TUint j=1; j<kSubsampleBytes; j++) {
+                subsample = subsample * 256 + aSrc[j];
+            }
+        }
+        else {
+            subsample = (TInt8)aSrc[kSubsampleBytes-1];
+            for (TUint j=kSubsampleBytes-1; j>0; j--) {
+                subsample = subsample * 256 + aSrc[j-1];
+            }
+        }
+        const TInt64 scaled = (subsample * (TInt64)aAttenuation) / 256; // rounds towards zero
+        for (TUint j=0; j<kSubsampleBytes; j++) {
+            const TByte b = (TByte)(scaled >> (8 * j));
+            if (kBigEndian) {
+                aDest[kSubsampleBytes-1-j] = b;
+            }
+            else {
+                aDest[j] = b;
+            }
+        }
+        aSrc += kSubsampleBytes;
+        aDest += kSubsampleBytes;
+    }
+}
+
+#define PCM_KERNELS_ATTENUATE_SCALAR(aSubsampleBytes) \
+    { AttenuateSubsamples<aSubsampleBytes, false>, AttenuateSubsamples<aSubsampleBytes, true> }
+
+template <TUint kSubsampleBytes, TBool kBigEndian, TUint kChannels>
+static void PackPlanarSubsamples(const TInt32* const* aChannels, TUint aNumChannels, TUint aFirstSample, TUint aNumSamples, TUint aShift, TByte* aDest)
+{ // kChannels of 0 packs aNumChannels channels
+    const TUint numChannels = (kChannels == 0? aNumChannels : kChannels);
+    const TInt32 max = (TInt32)((1u << (8 * kSubsampleBytes - 1)) - 1);
+    const TInt32 min = -max - 1;
+    const TUint end = aFirstSample + aNumSamples;
+    for (TUint i=aFirstSample; i<end; i++) {
+        for (TUint j=0; j<numChannels; j++) {
+            TInt32 subsample = aChannels[j][i] >> aShift;
+            if (kSubsampleBytes < 4) {
+                if (subsample > max) {
+                    subsample = max;
+                }
+                else if (subsample < min) {
+                    subsample = min;
+                }
+            }
+            if (kBigEndian) {
+                for (TUint k=kSubsampleBytes; k>0; k--) {
+                    *aDest++ = (TByte)(subsample >> (8 * (k-1)));
+                }
+            }
+            else {
+                for (TUint k=0; k<kSubsampleBytes; k++) {
+                    *aDest++ = (TByte)(subsample >> (8 * k));
+                }
+            }
+        }
+    }
+}
+
+#define PCM_KERNELS_PACK_SCALAR_ENDIAN(aSubsampleBytes, aBigEndian) \
+    { PackPlanarSubsamples<aSubsampleBytes, aBigEndian, 1>, PackPlanarSubsamples<aSubsampleBytes, aBigEndian, 2>, \
+      PackPlanarSubsamples<aSubsampleBytes, aBigEndian, 0> }
+#define PCM_KERNELS_PACK_SCALAR(aSubsampleBytes) \
+    { PCM_KERNELS_PACK_SCALAR_ENDIAN(aSubsampleBytes, false), PCM_KERNELS_PACK_SCALAR_ENDIAN(aSubsampleBytes, true) }
+
+
+#ifdef PCM_KERNELS_X86
+
+// Shuffle masks; each reverses the bytes within every subsample of a 16 byte vector.
+// The 24-bit mask converts 5 subsamples, leaving the final byte in place.
+alignas(16) static const TByte kShuffle16[16] = { 1,0, 3,2, 5,4, 7,6, 9,8, 11,10, 13,12, 15,14 };
+alignas(16) static const TByte kShuffle24[16] = { 2,1,0, 5,4,3, 8,7,6, 11,10,9, 14,13,12, 15 };
+alignas(16) static const TByte kShuffle32[16] = { 3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12 };
+
+PCM_KERNELS_TARGET("ssse3")
+static TUint ShuffleSsse3(const TByte* aSrc, TByte* aDest, TUint aBytes, const TByte* aMask, TUint aStride)
+{ // returns number of bytes converted
+    const __m128i mask = _mm_load_si128(reinterpret_cast<const __m128i*>(aMask));
+    TUint i = 0;
+    for (; i + 16 <= aBytes; i += aStride) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aSrc + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(aDest + i), _mm_shuffle_epi8(v, mask));
+    }
+    return i;
+}
+
+PCM_KERNELS_TARGET("avx2")
+static TUint ShuffleAvx2(const TByte* aSrc, TByte* aDest, TUint aBytes, const TByte* aMask)
+{ // returns number of bytes converted.  Only suitable for subsamples that divide 16 bytes
+    const __m128i mask128 = _mm_load_si128(reinterpret_cast<const __m128i*>(aMask));
+    const __m256i mask = _mm256_broadcastsi128_si256(mask128);
+    TUint i = 0;
+    for (; i + 32 <= aBytes; i += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(aSrc + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(aDest + i), _mm256_shuffle_epi8(v, mask));
+    }
+    return i;
+}
+
+static void CopyToBigEndian16Ssse3(const TByte* aSrc, TByte* aDest, TUint aBytes)
+{
+    const TUint done = ShuffleSsse3(aSrc, aDest, aBytes, kShuffle16, 16);
+    PcmKernels::CopyToBigEndian16Scalar(aSrc + done, aDest + done, aBytes - done);
+}
+
+static void CopyToBigEndian24Ssse3(const TByte* aSrc, TByte* aDest, TUint aBytes)
+{
+    const TUint done = ShuffleSsse3(aSrc, aDest, aBytes, kShuffle24, 15);
+    PcmKernels::CopyToBigEndian24Scalar(aSrc + done, aDest + done, aBytes - done);
+}
+
+static void CopyToBigEndian32Ssse3(const TByte* aSrc, TByte* aDest, TUint aBytes)
+{
+    const TUint done = ShuffleSsse3(aSrc, aDest, aBytes, kShuffle32, 16);
+    PcmKernels::CopyToBigEndian32Scalar(aSrc + done, aDest + done, aBytes - done);
+}
+
+static void CopyToBigEndian16Avx2(const TByte* aSrc, TByte* aDest, TUint aBytes)
+{
+    const TUint done = ShuffleAvx2(aSrc, aDest, aBytes, kShuffle16);
+    CopyToBigEndian16Ssse3(aSrc + done, aDest + done, aBytes - done);
+}
+
+static void CopyToBigEndian32Avx2(const TByte* aSrc, TByte* aDest, TUint aBytes)
+{
+    const TUint done = ShuffleAvx2(aSrc, aDest, aBytes, kShuffle32);
+    CopyToBigEndian32Ssse3(aSrc + done, aDest + done, aBytes - done);
+}
+
+// (s * g) >> 15 for 16-bit lanes, exact for any non-negative Q15 g.
+// The product of a subsample and a Q15 multiplier needs 31 bits so the high and low halves are recombined.
+
+template <TBool kBigEndian>
+PCM_KERNELS_TARGET("ssse3")
+static void ApplyGain16Ssse3(const TByte* aSrc, TByte* aDest, const TInt16* aGains, TUint aNumSubsamples)
+{
+    const __m128i swap = _mm_load_si128(reinterpret_cast<const __m128i*>(kShuffle16));
+    TUint i = 0;
+    for (; i + 8 <= aNumSubsamples; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aSrc + 2*i));
+        if (kBigEndian) {
+            v = _mm_shuffle_epi8(v, swap);
+        }
+        const __m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aGains + i));
+        const __m128i hi = _mm_mulhi_epi16(v, g);
+        const __m128i lo = _mm_mullo_epi16(v, g);
+        __m128i r = _mm_or_si128(_mm_slli_epi16(hi, 1), _mm_srli_epi16(lo, 15));
+        if (kBigEndian) {
+            r = _mm_shuffle_epi8(r, swap);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(aDest + 2*i), r);
+    }
+    if (kBigEndian) {
+        PcmKernels::ApplyGain16BigEndianScalar(aSrc + 2*i, aDest + 2*i, aGains + i, aNumSubsamples - i);
+    }
+    else {
+        PcmKernels::ApplyGain16LittleEndianScalar(aSrc + 2*i, aDest + 2*i, aGains + i, aNumSubsamples - i);
+    }
+}
+
+template <TBool kBigEndian>
+PCM_KERNELS_TARGET("avx2")
+static void ApplyGain16Avx2(const TByte* aSrc, TByte* aDest, const TInt16* aGains, TUint aNumSubsamples)
+{
+    const __m256i swap = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(kShuffle16)));
+    TUint i = 0;
+    for (; i + 16 <= aNumSubsamples; i += 16) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(aSrc + 2*i));
+        if (kBigEndian) {
+            v = _mm256_shuffle_epi8(v, swap);
+        }
+        const __m256i g = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(aGains + i));
+        const __m256i hi = _mm256_mulhi_epi16(v, g);
+        const __m256i lo = _mm256_mullo_epi16(v, g);
+        __m256i r = _mm256_or_si256(_mm256_slli_epi16(hi, 1), _mm256_srli_epi16(lo, 15));
+        if (kBigEndian) {
+            r = _mm256_shuffle_epi8(r, swap);
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(aDest + 2*i), r);
+    }
+    ApplyGain16Ssse3<kBigEndian>(aSrc + 2*i, aDest + 2*i, aGains + i, aNumSubsamples - i);
+}
+
+// (s * a) / 256 for 16-bit lanes, rounding towards zero as the scalar version does.  |s| * a is formed
+// unsigned (|-32768| fits in 16 unsigned bits) from the high and low halves of its up to 25 bit product,
+// then s's sign is applied.
+
+template <TBool kBigEndian>
+PCM_KERNELS_TARGET("ssse3")
+static void Attenuate16Ssse3(const TByte* aSrc, TByte* aDest, TUint aNumSubsamples, TUint aAttenuation)
+{
+    const __m128i swap = _mm_load_si128(reinterpret_cast<const __m128i*>(kShuffle16));
+    const __m128i atten = _mm_set1_epi16((TInt16)aAttenuation);
+    TUint i = 0;
+    for (; i + 8 <= aNumSubsamples; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aSrc + 2*i));
+        if (kBigEndian) {
+            v = _mm_shuffle_epi8(v, swap);
+        }
+        const __m128i mag = _mm_abs_epi16(v);
+        const __m128i hi = _mm_mulhi_epu16(mag, atten);
+        const __m128i lo = _mm_mullo_epi16(mag, atten);
+        __m128i r = _mm_sign_epi16(_mm_or_si128(_mm_slli_epi16(hi, 8), _mm_srli_epi16(lo, 8)), v);
+        if (kBigEndian) {
+            r = _mm_shuffle_epi8(r, swap);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(aDest + 2*i), r);
+    }
+    AttenuateSubsamples<2, kBigEndian>(aSrc + 2*i, aDest + 2*i, aNumSubsamples - i, aAttenuation);
+}
+
+template <TBool kBigEndian>
+PCM_KERNELS_TARGET("avx2")
+static void Attenuate16Avx2(const TByte* aSrc, TByte* aDest, TUint aNumSubsamples, TUint aAttenuation)
+{
+    const __m256i swap = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(kShuffle16)));
+    const __m256i atten = _mm256_set1_epi16((TInt16)aAttenuation);
+    TUint i = 0;
+    for (; i + 16 <= aNumSubsamples; i += 16) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(aSrc + 2*i));
+        if (kBigEndian) {
+            v = _mm256_shuffle_epi8(v, swap);
+        }
+        const __m256i mag = _mm256_abs_epi16(v);
+        const __m256i hi = _mm256_mulhi_epu16(mag, atten);
+        const __m256i lo = _mm256_mullo_epi16(mag, atten);
+        __m256i r = _mm256_sign_epi16(_mm256_or_si256(_mm256_slli_epi16(hi, 8), _mm256_srli_epi16(lo, 8)), v);
+        if (kBigEndian) {
+            r = _mm256_shuffle_epi8(r, swap);
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(aDest + 2*i), r);
+    }
+    Attenuate16Ssse3<kBigEndian>(aSrc + 2*i, aDest + 2*i, aNumSubsamples - i, aAttenuation);
+}
+
+// 24-bit subsamples are unpacked into the top of 32-bit lanes (so an arithmetic shift sign extends them),
+// scaled then repacked.  Each iteration converts 8 subsamples, loading 32 bytes but only storing 24.
+alignas(16) static const TByte kUnpack24Le[16] = { 0x80,0,1,2, 0x80,3,4,5, 0x80,6,7,8, 0x80,9,10,11 };
+alignas(16) static const TByte kUnpack24Be[16] = { 0x80,2,1,0, 0x80,5,4,3, 0x80,8,7,6, 0x80,11,10,9 };
+alignas(16) static const TByte kPack24Le[16] = { 0,1,2, 4,5,6, 8,9,10, 12,13,14, 0x80,0x80,0x80,0x80 };
+alignas(16) static const TByte kPack24Be[16] = { 2,1,0, 6,5,4, 10,9,8, 14,13,12, 0x80,0x80,0x80,0x80 };
+
+template <TBool kBigEndian>
+PCM_KERNELS_TARGET("avx2")
+static void Attenuate24Avx2(const TByte* aSrc, TByte* aDest, TUint aNumSubsamples, TUint aAttenuation)
+{
+    const __m256i spread = _mm256_setr_epi32(0, 1, 2, 3, 3, 4, 5, 6);  // bytes 0..15 to lane 0, 12..27 to lane 1
+    const __m256i compact = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7); // reverses spread
+    const __m256i unpack = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(kBigEndian? kUnpack24Be : kUnpack24Le)));
+    const __m256i pack = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(kBigEndian? kPack24Be : kPack24Le)));
+    const __m256i atten = _mm256_set1_epi32((TInt)aAttenuation);
+    TUint i = 0;
+    for (; 3*i + 32 <= 3*aNumSubsamples; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(aSrc + 3*i));
+        v = _mm256_shuffle_epi8(_mm256_permutevar8x32_epi32(v, spread), unpack);
+        v = _mm256_srai_epi32(v, 8);
+        v = _mm256_mullo_epi32(v, atten); // |s| <= 2^23 so product fits in 32 bits
+        v = _mm256_srai_epi32(_mm256_add_epi32(v, _mm256_srli_epi32(_mm256_srai_epi32(v, 31), 24)), 8); // +255 if negative to round towards zero
+        v = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(v, pack), compact);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(aDest + 3*i), _mm256_castsi256_si128(v));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(aDest + 3*i + 16), _mm256_extracti128_si256(v, 1));
+    }
+    AttenuateSubsamples<3, kBigEndian>(aSrc + 3*i, aDest + 3*i, aNumSubsamples - i, aAttenuation);
+}
+
+// 32-bit lanes are scaled as 64-bit products of even then odd lanes, taking bits 8..39 of each.
+// Products of negative subsamples have 255 added first so that they round towards zero.
+
+template <TBool kBigEndian>
+PCM_KERNELS_TARGET("avx2")
+static void Attenuate32Avx2(const TByte* aSrc, TByte* aDest, TUint aNumSubsamples, TUint aAttenuation)
+{
+    const __m256i swap = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(kShuffle32)));
+    const __m256i atten = _mm256_set1_epi32((TInt)aAttenuation);
+    const __m256i bias = _mm256_set1_epi64x(0xff);
+    TUint i = 0;
+    for (; i + 8 <= aNumSubsamples; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(aSrc + 4*i));
+        if (kBigEndian) {
+            v = _mm256_shuffle_epi8(v, swap);
+        }
+        const __m256i negative = _mm256_srai_epi32(v, 31);
+        const __m256i even = _mm256_add_epi64(_mm256_mul_epi32(v, atten), _mm256_and_si256(negative, bias));
+        const __m256i odd = _mm256_add_epi64(_mm256_mul_epi32(_mm256_srli_epi64(v, 32), atten),
+                                             _mm256_and_si256(_mm256_srli_epi64(negative, 32), bias));
+        __m256i r = _mm256_blend_epi32(_mm256_srli_epi64(even, 8), _mm256_slli_epi64(odd, 24), 0xAA);
+        if (kBigEndian) {
+            r = _mm256_shuffle_epi8(r, swap);
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(aDest + 4*i), r);
+    }
+    AttenuateSubsamples<4, kBigEndian>(aSrc + 4*i, aDest + 4*i, aNumSubsamples - i, aAttenuation);
+}
+
+// Planar to packed conversion handles 8 (SSE4.1) or 16 (AVX2) subsamples per iteration.
+// Mono input is loaded directly; stereo is interleaved by unpacking left and right lanes.
+// 16-bit output is clipped by the saturating pack, 24-bit by explicit min/max.  32-bit output needs no clipping.
+// Lanes are little endian so big endian output needs a byte shuffle; little endian output is stored as is.
+
+template <TUint kSubsampleBytes, TBool kBigEndian, TUint kChannels>
+PCM_KERNELS_TARGET("sse4.1")
+static void PackPlanarSse41(const TInt32* const* aChannels, TUint aNumChannels, TUint aFirstSample, TUint aNumSamples, TUint aShift, TByte* aDest)
+{
+    static_assert(kChannels == 1 || kChannels == 2, "vectorised packing only supports mono or stereo");
+    const __m128i shift = _mm_cvtsi32_si128((int)aShift);
+    const __m128i max24 = _mm_set1_epi32(0x7fffff);
+    const __m128i min24 = _mm_set1_epi32(-0x800000);
+    const __m128i swap16 = _mm_load_si128(reinterpret_cast<const __m128i*>(kShuffle16));
+    const __m128i swap32 = _mm_load_si128(reinterpret_cast<const __m128i*>(kShuffle32));
+    const __m128i pack24 = _mm_load_si128(reinterpret_cast<const __m128i*>(kBigEndian? kPack24Be : kPack24Le));
+    const TInt32* left = aChannels[0] + aFirstSample;
+    const TInt32* right = aChannels[kChannels-1] + aFirstSample;
+    const TUint samplesPerLoop = 8 / kChannels;
+    TUint i = 0;
+    for (; i + samplesPerLoop <= aNumSamples; i += samplesPerLoop) {
+        __m128i v0, v1;
+        if (kChannels == 1) {
+            v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(left + i));
+            v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(left + i + 4));
+        }
+        else {
+            const __m128i l = _mm_loadu_si128(reinterpret_cast<const __m128i*>(left + i));
+            const __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(right + i));
+            v0 = _mm_unpacklo_epi32(l, r);
+            v1 = _mm_unpackhi_epi32(l, r);
+        }
+        v0 = _mm_sra_epi32(v0, shift);
+        v1 = _mm_sra_epi32(v1, shift);
+        if (kSubsampleBytes == 2) {
+            __m128i packed = _mm_packs_epi32(v0, v1);
+            if (kBigEndian) {
+                packed = _mm_shuffle_epi8(packed, swap16);
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(aDest), packed);
+        }
+        else if (kSubsampleBytes == 3) {
+            v0 = _mm_shuffle_epi8(_mm_max_epi32(_mm_min_epi32(v0, max24), min24), pack24); // 12 bytes, then 4 zeros
+            v1 = _mm_shuffle_epi8(_mm_max_epi32(_mm_min_epi32(v1, max24), min24), pack24);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(aDest), _mm_or_si128(v0, _mm_slli_si128(v1, 12)));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(aDest + 16), _mm_srli_si128(v1, 4));
+        }
+        else {
+            if (kBigEndian) {
+                v0 = _mm_shuffle_epi8(v0, swap32);
+                v1 = _mm_shuffle_epi8(v1, swap32);
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(aDest), v0);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(aDest + 16), v1);
+        }
+        aDest += 8 * kSubsampleBytes;
+    }
+    PackPlanarSubsamples<kSubsampleBytes, kBigEndian, kChannels>(aChannels, aNumChannels, aFirstSample + i, aNumSamples - i, aShift, aDest);
+}
+
+template <TUint kSubsampleBytes, TBool kBigEndian, TUint kChannels>
+PCM_KERNELS_TARGET("avx2")
+static void PackPlanarAvx2(const TInt32* const* aChannels, TUint aNumChannels, TUint aFirstSample, TUint aNumSamples, TUint aShift, TByte* aDest)
+{
+    static_assert(kChannels == 1 || kChannels == 2, "vectorised packing only supports mono or stereo");
+    const __m128i shift = _mm_cvtsi32_si128((int)aShift);
+    const __m256i max24 = _mm256_set1_epi32(0x7fffff);
+    const __m256i min24 = _mm256_set1_epi32(-0x800000);
+    const __m256i swap16 = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(kShuffle16)));
+    const __m256i swap32 = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(kShuffle32)));
+    const __m256i pack24 = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(kBigEndian? kPack24Be : kPack24Le)));
+    const __m256i compact = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7); // 24 packed bytes to the start of the vector
+    const TInt32* left = aChannels[0] + aFirstSample;
+    const TInt32* right = aChannels[kChannels-1] + aFirstSample;
+    const TUint samplesPerLoop = 16 / kChannels;
+    TUint i = 0;
+    for (; i + samplesPerLoop <= aNumSamples; i += samplesPerLoop) {
+        __m256i v0, v1;
+        if (kChannels == 1) {
+            v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(left + i));
+            v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(left + i + 8));
+        }
+        else {
+            const __m256i l = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(left + i));
+            const __m256i r = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(right + i));
+            const __m256i lo = _mm256_unpacklo_epi32(l, r); // samples 0,1 | 4,5
+            const __m256i hi = _mm256_unpackhi_epi32(l, r); // samples 2,3 | 6,7
+            v0 = _mm256_permute2x128_si256(lo, hi, 0x20);
+            v1 = _mm256_permute2x128_si256(lo, hi, 0x31);
+        }
+        v0 = _mm256_sra_epi32(v0, shift);
+        v1 = _mm256_sra_epi32(v1, shift);
+        if (kSubsampleBytes == 2) {
+            __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(v0, v1), 0xd8); // packs works within 128-bit lanes
+            if (kBigEndian) {
+                packed = _mm256_shuffle_epi8(packed, swap16);
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(aDest), packed);
+        }
+        else if (kSubsampleBytes == 3) {
+            v0 = _mm256_shuffle_epi8(_mm256_max_epi32(_mm256_min_epi32(v0, max24), min24), pack24);
+            v1 = _mm256_shuffle_epi8(_mm256_max_epi32(_mm256_min_epi32(v1, max24), min24), pack24);
+            v0 = _mm256_permutevar8x32_epi32(v0, compact);
+            v1 = _mm256_permutevar8x32_epi32(v1, compact);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(aDest), _mm256_castsi256_si128(v0));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(aDest + 16), _mm256_extracti128_si256(v0, 1));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(aDest + 24), _mm256_castsi256_si128(v1));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(aDest + 40), _mm256_extracti128_si256(v1, 1));
+        }
+        else {
+            if (kBigEndian) {
+                v0 = _mm256_shuffle_epi8(v0, swap32);
+                v1 = _mm256_shuffle_epi8(v1, swap32);
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(aDest), v0);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(aDest + 32), v1);
+        }
+        aDest += 16 * kSubsampleBytes;
+    }
+    PackPlanarSse41<kSubsampleBytes, kBigEndian, kChannels>(aChannels, aNumChannels, aFirstSample + i, aNumSamples - i, aShift, aDest);
+}
+
+#define PCM_KERNELS_PACK_X86_ENDIAN(aIsa, aSubsampleBytes, aBigEndian) \
+    { PackPlanar##aIsa<aSubsampleBytes, aBigEndian, 1>, PackPlanar##aIsa<aSubsampleBytes, aBigEndian, 2>, \
+      PackPlanarSubsamples<aSubsampleBytes, aBigEndian, 0> }
+#define PCM_KERNELS_PACK_X86(aIsa, aSubsampleBytes) \
+    { PCM_KERNELS_PACK_X86_ENDIAN(aIsa, aSubsampleBytes, false), PCM_KERNELS_PACK_X86_ENDIAN(aIsa, aSubsampleBytes, true) }
+
+static void CpuFeatures(TBool& aSsse3, TBool& aSse41, TBool& aAvx2)
+{
+# ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+    __cpuid(info, 1);
+    aSsse3 = (info[2] & (1<<9)) != 0;
+    aSse41 = (info[2] & (1<<19)) != 0;
+    const TBool osAvx = (info[2] & (1<<27)) != 0 && (info[2] & (1<<28)) != 0 && (_xgetbv(0) & 6) == 6;
+    aAvx2 = false;
+    if (osAvx && maxLeaf >= 7) {
+        __cpuidex(info, 7, 0);
+        aAvx2 = (info[1] & (1<<5)) != 0;
+    }
+# else
+    __builtin_cpu_init();
+    aSsse3 = __builtin_cpu_supports("ssse3") != 0;
+    aSse41 = __builtin_cpu_supports("sse4.1") != 0;
+    aAvx2 = __builtin_cpu_supports("avx2") != 0;
+# endif
+}
+
+#endif // PCM_KERNELS_X86
+
+
+#ifdef PCM_KERNELS_NEON
+
+static void CopyToBigEndian16Neon(const TByte* aSrc, TByte* aDest, TUint aBytes)
+{
+    TUint i = 0;
+    for (; i + 16 <= aBytes; i += 16) {
+        vst1q_u8(aDest + i, vrev16q_u8(vld1q_u8(aSrc + i)));
+    }
+    PcmKernels::CopyToBigEndian16Scalar(aSrc + i, aDest + i, aBytes - i);
+}
+
+static void CopyToBigEndian24Neon(const TByte* aSrc, TByte* aDest, TUint aBytes)
+{
+    TUint i = 0;
+    for (; i + 48 <= aBytes; i += 48) {
+        uint8x16x3_t v = vld3q_u8(aSrc + i); // de-interleaves byte 0/1/2 of 16 subsamples
+        const uint8x16_t lsb = v.val[0];
+        v.val[0] = v.val[2];
+        v.val[2] = lsb;
+        vst3q_u8(aDest + i, v);
+    }
+    PcmKernels::CopyToBigEndian24Scalar(aSrc + i, aDest + i, aBytes - i);
+}
+
+static void CopyToBigEndian32Neon(const TByte* aSrc, TByte* aDest, TUint aBytes)
+{
+    TUint i = 0;
+    for (; i + 16 <= aBytes; i += 16) {
+        vst1q_u8(aDest + i, vrev32q_u8(vld1q_u8(aSrc + i)));
+    }
+    PcmKernels::CopyToBigEndian32Scalar(aSrc + i, aDest + i, aBytes - i);
+}
+
+template <TBool kBigEndian>
+static void ApplyGain16Neon(const TByte* aSrc, TByte* aDest, const TInt16* aGains, TUint aNumSubsamples)
+{
+    TUint i = 0;
+    for (; i + 8 <= aNumSubsamples; i += 8) {
+        uint8x16_t bytes = vld1q_u8(aSrc + 2*i);
+        if (kBigEndian) {
+            bytes = vrev16q_u8(bytes);
+        }
+        const int16x8_t r = vqdmulhq_s16(vreinterpretq_s16_u8(bytes), vld1q_s16(aGains + i)); // (2*s*g)>>16; can't saturate as g < 0x8000
+        bytes = vreinterpretq_u8_s16(r);
+        if (kBigEndian) {
+            bytes = vrev16q_u8(bytes);
+        }
+        vst1q_u8(aDest + 2*i, bytes);
+    }
+    if (kBigEndian) {
+        PcmKernels::ApplyGain16BigEndianScalar(aSrc + 2*i, aDest + 2*i, aGains + i, aNumSubsamples - i);
+    }
+    else {
+        PcmKernels::ApplyGain16LittleEndianScalar(aSrc + 2*i, aDest + 2*i, aGains + i, aNumSubsamples - i);
+    }
+}
+
+template <TBool kBigEndian>
+static void Attenuate16Neon(const TByte* aSrc, TByte* aDest, TUint aNumSubsamples, TUint aAttenuation)
+{
+    const TInt16 atten = (TInt16)aAttenuation;
+    TUint i = 0;
+    for (; i + 8 <= aNumSubsamples; i += 8) {
+        uint8x16_t bytes = vld1q_u8(aSrc + 2*i);
+        if (kBigEndian) {
+            bytes = vrev16q_u8(bytes);
+        }
+        const int16x8_t v = vreinterpretq_s16_u8(bytes);
+        int32x4_t lo = vmull_n_s16(vget_low_s16(v), atten);
+        int32x4_t hi = vmull_n_s16(vget_high_s16(v), atten);
+        // add 255 to negative products so that they round towards zero
+        lo = vaddq_s32(lo, vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(vshrq_n_s32(lo, 31)), 24)));
+        hi = vaddq_s32(hi, vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(vshrq_n_s32(hi, 31)), 24)));
+        bytes = vreinterpretq_u8_s16(vcombine_s16(vshrn_n_s32(lo, 8), vshrn_n_s32(hi, 8)));
+        if (kBigEndian) {
+            bytes = vrev16q_u8(bytes);
+        }
+        vst1q_u8(aDest + 2*i, bytes);
+    }
+    AttenuateSubsamples<2, kBigEndian>(aSrc + 2*i, aDest + 2*i, aNumSubsamples - i, aAttenuation);
+}
+
+template <TBool kBigEndian>
+static void Attenuate32Neon(const TByte* aSrc, TByte* aDest, TUint aNumSubsamples, TUint aAttenuation)
+{
+    const TInt32 atten = (TInt32)aAttenuation;
+    TUint i = 0;
+    for (; i + 4 <= aNumSubsamples; i += 4) {
+        uint8x16_t bytes = vld1q_u8(aSrc + 4*i);
+        if (kBigEndian) {
+            bytes = vrev32q_u8(bytes);
+        }
+        const int32x4_t v = vreinterpretq_s32_u8(bytes);
+        int64x2_t lo = vmull_n_s32(vget_low_s32(v), atten);
+        int64x2_t hi = vmull_n_s32(vget_high_s32(v), atten);
+        // add 255 to negative products so that they round towards zero
+        lo = vaddq_s64(lo, vreinterpretq_s64_u64(vshrq_n_u64(vreinterpretq_u64_s64(vshrq_n_s64(lo, 63)), 56)));
+        hi = vaddq_s64(hi, vreinterpretq_s64_u64(vshrq_n_u64(vreinterpretq_u64_s64(vshrq_n_s64(hi, 63)), 56)));
+        bytes = vreinterpretq_u8_s32(vcombine_s32(vshrn_n_s64(lo, 8), vshrn_n_s64(hi, 8)));
+        if (kBigEndian) {
+            bytes = vrev32q_u8(bytes);
+        }
+        vst1q_u8(aDest + 4*i, bytes);
+    }
+    AttenuateSubsamples<4, kBigEndian>(aSrc + 4*i, aDest + 4*i, aNumSubsamples - i, aAttenuation);
+}
+
+// Converts 16 subsamples per iteration.  24-bit output is assembled from byte planes, extracted by
+// unzipping the 32-bit subsamples, then written by an interleaving store.
+
+template <TUint kSubsampleBytes, TBool kBigEndian, TUint kChannels>
+static void PackPlanarNeon(const TInt32* const* aChannels, TUint aNumChannels, TUint aFirstSample, TUint aNumSamples, TUint aShift, TByte* aDest)
+{
+    static_assert(kChannels == 1 || kChannels == 2, "vectorised packing only supports mono or stereo");
+    const int32x4_t shift = vdupq_n_s32(-(TInt32)aShift); // negative left shift is an arithmetic right shift
+    const int32x4_t max24 = vdupq_n_s32(0x7fffff);
+    const int32x4_t min24 = vdupq_n_s32(-0x800000);
+    const TInt32* left = aChannels[0] + aFirstSample;
+    const TInt32* right = aChannels[kChannels-1] + aFirstSample;
+    const TUint samplesPerLoop = 16 / kChannels;
+    TUint i = 0;
+    for (; i + samplesPerLoop <= aNumSamples; i += samplesPerLoop) {
+        int32x4_t v[4];
+        if (kChannels == 1) {
+            for (TUint j=0; j<4; j++) {
+                v[j] = vld1q_s32(left + i + 4*j);
+            }
+        }
+        else {
+            for (TUint j=0; j<2; j++) {
+                const int32x4x2_t zipped = vzipq_s32(vld1q_s32(left + i + 4*j), vld1q_s32(right + i + 4*j));
+                v[2*j] = zipped.val[0];
+                v[2*j+1] = zipped.val[1];
+            }
+        }
+        for (TUint j=0; j<4; j++) {
+            v[j] = vshlq_s32(v[j], shift);
+        }
+        if (kSubsampleBytes == 2) {
+            for (TUint j=0; j<2; j++) {
+                const int16x8_t narrowed = vcombine_s16(vqmovn_s32(v[2*j]), vqmovn_s32(v[2*j+1]));
+                const uint8x16_t bytes = vreinterpretq_u8_s16(narrowed);
+                vst1q_u8(aDest + 16*j, kBigEndian? vrev16q_u8(bytes) : bytes);
+            }
+        }
+        else if (kSubsampleBytes == 3) {
+            uint8x16_t b[4];
+            for (TUint j=0; j<4; j++) {
+                b[j] = vreinterpretq_u8_s32(vmaxq_s32(vminq_s32(v[j], max24), min24));
+            }
+            const uint8x16x2_t lo = vuzpq_u8(b[0], b[1]); // bytes 0,2 | 1,3 of subsamples 0..7
+            const uint8x16x2_t hi = vuzpq_u8(b[2], b[3]); // bytes 0,2 | 1,3 of subsamples 8..15
+            const uint8x16x2_t even = vuzpq_u8(lo.val[0], hi.val[0]); // byte 0 | byte 2
+            const uint8x16x2_t odd = vuzpq_u8(lo.val[1], hi.val[1]);  // byte 1 | byte 3
+            uint8x16x3_t packed;
+            packed.val[0] = (kBigEndian? even.val[1] : even.val[0]);
+            packed.val[1] = odd.val[0];
+            packed.val[2] = (kBigEndian? even.val[0] : even.val[1]);
+            vst3q_u8(aDest, packed);
+        }
+        else {
+            for (TUint j=0; j<4; j++) {
+                const uint8x16_t bytes = vreinterpretq_u8_s32(v[j]);
+                vst1q_u8(aDest + 16*j, kBigEndian? vrev32q_u8(bytes) : bytes);
+            }
+        }
+        aDest += 16 * kSubsampleBytes;
+    }
+    PackPlanarSubsamples<kSubsampleBytes, kBigEndian, kChannels>(aChannels, aNumChannels, aFirstSample + i, aNumSamples - i, aShift, aDest);
+}
+
+#define PCM_KERNELS_PACK_NEON_ENDIAN(aSubsampleBytes, aBigEndian) \
+    { PackPlanarNeon<aSubsampleBytes, aBigEndian, 1>, PackPlanarNeon<aSubsampleBytes, aBigEndian, 2>, \
+      PackPlanarSubsamples<aSubsampleBytes, aBigEndian, 0> }
+#define PCM_KERNELS_PACK_NEON(aSubsampleBytes) \
+    { PCM_KERNELS_PACK_NEON_ENDIAN(aSubsampleBytes, false), PCM_KERNELS_PACK_NEON_ENDIAN(aSubsampleBytes, true) }
+
+#endif // PCM_KERNELS_NEON
+
+
+static PcmKernelTable SelectKernels()
+{
+#if defined(PCM_KERNELS_X86)
+    TBool ssse3, sse41, avx2;
+    CpuFeatures(ssse3, sse41, avx2);
+    if (avx2) {
+        return { "avx2", CopyToBigEndian16Avx2, CopyToBigEndian24Ssse3, CopyToBigEndian32Avx2,
+                 ApplyGain16Avx2<true>, ApplyGain16Avx2<false>,
+                 { PCM_KERNELS_ATTENUATE_SCALAR(1),
+                   { Attenuate16Avx2<false>, Attenuate16Avx2<true> },
+                   { Attenuate24Avx2<false>, Attenuate24Avx2<true> },
+                   { Attenuate32Avx2<false>, Attenuate32Avx2<true> } },
+                 { PCM_KERNELS_PACK_SCALAR(1), PCM_KERNELS_PACK_X86(Avx2, 2),
+                   PCM_KERNELS_PACK_X86(Avx2, 3), PCM_KERNELS_PACK_X86(Avx2, 4) } };
+    }
+    if (sse41) { // 24/32-bit attenuation is only vectorised for AVX2
+        return { "sse4.1", CopyToBigEndian16Ssse3, CopyToBigEndian24Ssse3, CopyToBigEndian32Ssse3,
+                 ApplyGain16Ssse3<true>, ApplyGain16Ssse3<false>,
+                 { PCM_KERNELS_ATTENUATE_SCALAR(1),
+                   { Attenuate16Ssse3<false>, Attenuate16Ssse3<true> },
+                   PCM_KERNELS_ATTENUATE_SCALAR(3),
+                   PCM_KERNELS_ATTENUATE_SCALAR(4) },
+                 { PCM_KERNELS_PACK_SCALAR(1), PCM_KERNELS_PACK_X86(Sse41, 2),
+                   PCM_KERNELS_PACK_X86(Sse41, 3), PCM_KERNELS_PACK_X86(Sse41, 4) } };
+    }
+    if (ssse3) { // 24/32-bit attenuation would need SSE4.1 multiplies so use scalar versions
+        return { "ssse3", CopyToBigEndian16Ssse3, CopyToBigEndian24Ssse3, CopyToBigEndian32Ssse3,
+                 ApplyGain16Ssse3<true>, ApplyGain16Ssse3<false>,
+                 { PCM_KERNELS_ATTENUATE_SCALAR(1),
+                   { Attenuate16Ssse3<false>, Attenuate16Ssse3<true> },
+                   PCM_KERNELS_ATTENUATE_SCALAR(3),
+                   PCM_KERNELS_ATTENUATE_SCALAR(4) },
+                 { PCM_KERNELS_PACK_SCALAR(1), PCM_KERNELS_PACK_SCALAR(2),
+                   PCM_KERNELS_PACK_SCALAR(3), PCM_KERNELS_PACK_SCALAR(4) } };
+    }
+#elif defined(PCM_KERNELS_NEON)
+    return { "neon", CopyToBigEndian16Neon, CopyToBigEndian24Neon, CopyToBigEndian32Neon,
+             ApplyGain16Neon<true>, ApplyGain16Neon<false>,
+             { PCM_KERNELS_ATTENUATE_SCALAR(1),
+               { Attenuate16Neon<false>, Attenuate16Neon<true> },
+               PCM_KERNELS_ATTENUATE_SCALAR(3),
+               { Attenuate32Neon<false>, Attenuate32Neon<true> } },
+             { PCM_KERNELS_PACK_SCALAR(1), PCM_KERNELS_PACK_NEON(2),
+               PCM_KERNELS_PACK_NEON(3), PCM_KERNELS_PACK_NEON(4) } };
+#endif
+    return { "scalar", PcmKernels::CopyToBigEndian16Scalar, PcmKernels::CopyToBigEndian24Scalar, PcmKernels::CopyToBigEndian32Scalar,
+             PcmKernels::ApplyGain16BigEndianScalar, PcmKernels::ApplyGain16LittleEndianScalar,
+             { PCM_KERNELS_ATTENUATE_SCALAR(1), PCM_KERNELS_ATTENUATE_SCALAR(2),
+               PCM_KERNELS_ATTENUATE_SCALAR(3), PCM_KERNELS_ATTENUATE_SCALAR(4) },
+             { PCM_KERNELS_PACK_SCALAR(1), PCM_KERNELS_PACK_SCALAR(2),
+               PCM_KERNELS_PACK_SCALAR(3), PCM_KERNELS_PACK_SCALAR(4) } };
+}
+
+static const PcmKernelTable& Kernels()
+{
+    static const PcmKernelTable kKernels = SelectKernels();
+    return kKernels;
+}
+
+
+// PcmKernels
+
+void PcmKernels::CopyToBigEndian16(const TByte* aSrc, TByte* aDest, TUint aBytes)
+{ // static
+    Kernels().iCopyToBigEndian16(aSrc, aDest, aBytes);
+}
+
+void PcmKernels::CopyToBigEndian24(const TByte* aSrc, TByte* aDest, TUint aBytes)
+{ // static
+    Kernels().iCopyToBigEndian24(aSrc, aDest, aBytes);
+}
+
+void PcmKernels::CopyToBigEndian32(const TByte* aSrc, TByte* aDest, TUint aBytes)
+{ // static
+    Kernels().iCopyToBigEndian32(aSrc, aDest, aBytes);
+}
+
+void PcmKernels::CopySwapped(const TByte* aSrc, TByte* aDest, TUint aBytes, TUint aSubsampleBytes)
+{ // static
+    switch (aSubsampleBytes)
+    {
+    case 1:
+        (void)memcpy(aDest, aSrc, aBytes);
+        break;
+    case 2:
+        Kernels().iCopyToBigEndian16(aSrc, aDest, aBytes);
+        break;
+    case 3:
+        Kernels().iCopyToBigEndian24(aSrc, aDest, aBytes);
+        break;
+    case 4:
+        Kernels().iCopyToBigEndian32(aSrc, aDest, aBytes);
+        break;
+    default:
+        ASSERTS();
+    }
+}
+
+void PcmKernels::ApplyGain16BigEndian(const TByte* aSrc, TByte* aDest, const TInt16* aGains, TUint aNumSubsamples)
+{ // static
+    Kernels().iApplyGain16BigEndian(aSrc, aDest, aGains, aNumSubsamples);
+}
+
+void PcmKernels::ApplyGain16LittleEndian(const TByte* aSrc, TByte* aDest, const TInt16* aGains, TUint aNumSubsamples)
+{ // static
+    Kernels().iApplyGain16LittleEndian(aSrc, aDest, aGains, aNumSubsamples);
+}
+
+void PcmKernels::Attenuate(const TByte* aSrc, TByte* aDest, TUint aBytes, TUint aSubsampleBytes, TBool aBigEndian, TUint aAttenuation)
+{ // static
+    ASSERT(aSubsampleBytes >= 1 && aSubsampleBytes <= 4);
+    ASSERT(aAttenuation <= 256);
+    Kernels().iAttenuate[aSubsampleBytes - 1][aBigEndian? 1 : 0](aSrc, aDest, aBytes / aSubsampleBytes, aAttenuation);
+}
+
+static void PackPlanar(const TInt32* const* aChannels, TUint aNumChannels, TUint aFirstSample, TUint aNumSamples,
+                       TUint aShift, TUint aSubsampleBytes, TBool aBigEndian, TByte* aDest)
+{
+    ASSERT(aSubsampleBytes >= 1 && aSubsampleBytes <= 4);
+    ASSERT(aNumChannels > 0);
+    ASSERT(aShift < 32);
+    const TUint channelsIndex = (aNumChannels < 3? aNumChannels - 1 : 2);
+    Kernels().iPackPlanar[aSubsampleBytes - 1][aBigEndian? 1 : 0][channelsIndex](aChannels, aNumChannels, aFirstSample, aNumSamples, aShift, aDest);
+}
+
+void PcmKernels::PackPlanarBigEndian(const TInt32* const* aChannels, TUint aNumChannels, TUint aFirstSample, TUint aNumSamples,
+                                     TUint aShift, TUint aSubsampleBytes, TByte* aDest)
+{ // static
+    PackPlanar(aChannels, aNumChannels, aFirstSample, aNumSamples, aShift, aSubsampleBytes, true, aDest);
+}
+
+void PcmKernels::PackPlanarLittleEndian(const TInt32* const* aChannels, TUint aNumChannels, TUint aFirstSample, TUint aNumSamples,
+                                        TUint aShift, TUint aSubsampleBytes, TByte* aDest)
+{ // static
+    PackPlanar(aChannels, aNumChannels, aFirstSample, aNumSamples, aShift, aSubsampleBytes, false, aDest);
+}
+
+const TChar* PcmKernels::Implementation()
+{ // static
+    return Kernels().iName;
+}
+
+void PcmKernels::CopyToBigEndian16Scalar(const TByte* aSrc, TByte* aDest, TUint aBytes)
+{ // static
+    for (TUint i=0; i<aBytes; i+=2) {
+        *aDest++ = aSrc[i+1];
+        *aDest++ = aSrc[i];
+    }
+}
+
+void PcmKernels::CopyToBigEndian24Scalar(const TByte* aSrc, TByte* aDest, TUint aBytes)
+{ // static
+    for (TUint i=0; i<aBytes; i+=3) {
+        *aDest++ = aSrc[i+2];
+        *aDest++ = aSrc[i+1];
+        *aDest++ = aSrc[i];
+    }
+}
+
+void PcmKernels::CopyToBigEndian32Scalar(const TByte* aSrc, TByte* aDest, TUint aBytes)
+{ // static
+    for (TUint i=0; i<aBytes; i+=4) {
+        *aDest++ = aSrc[i+3];
+        *aDest++ = aSrc[i+2];
+        *aDest++ = aSrc[i+1];
+        *aDest++ = aSrc[i];
+    }
+}
+
+void PcmKernels::ApplyGain16BigEndianScalar(const TByte* aSrc, TByte* aDest, const TInt16* aGains, TUint aNumSubsamples)
+{ // static
+    for (TUint i=0; i<aNumSubsamples; i++) {
+        const TInt subsample = (TInt16)((aSrc[0] << 8) | aSrc[1]);
+        const TInt scaled = (subsample * aGains[i]) >> 15;
+        aDest[0] = (TByte)(scaled >> 8);
+        aDest[1] = (TByte)scaled;
+        aSrc += 2;
+        aDest += 2;
+    }
+}
+
+void PcmKernels::ApplyGain16LittleEndianScalar(const TByte* aSrc, TByte* aDest, const TInt16* aGains, TUint aNumSubsamples)
+{ // static
+    for (TUint i=0; i<aNumSubsamples; i++) {
+        const TInt subsample = (TInt16)((aSrc[1] << 8) | aSrc[0]);
+        const TInt scaled = (subsample * aGains[i]) >> 15;
+        aDest[0] = (TByte)scaled;
+        aDest[1] = (TByte)(scaled >> 8);
+        aSrc += 2;
+        aDest += 2;
+    }
+}
+
+void PcmKernels::AttenuateScalar(const TByte* aSrc, TByte* aDest, TUint aBytes, TUint aSubsampleBytes, TBool aBigEndian, TUint aAttenuation)
+{ // static
+    ASSERT(aSubsampleBytes >= 1 && aSubsampleBytes <= 4);
+    static const PcmAttenuateFunc kFuncs[4][2] = {
+        PCM_KERNELS_ATTENUATE_SCALAR(1), PCM_KERNELS_ATTENUATE_SCALAR(2), PCM_KERNELS_ATTENUATE_SCALAR(3), PCM_KERNELS_ATTENUATE_SCALAR(4)
+    };
+    kFuncs[aSubsampleBytes - 1][aBigEndian? 1 : 0](aSrc, aDest, aBytes / aSubsampleBytes, aAttenuation);
+}
+
+void PcmKernels::PackPlanarBigEndianScalar(const TInt32* const* aChannels, TUint aNumChannels, TUint aFirstSample, TUint aNumSamples,
+                                           TUint aShift, TUint aSubsampleBytes, TByte* aDest)
+{ // static
+    ASSERT(aSubsampleBytes >= 1 && aSubsampleBytes <= 4);
+    ASSERT(aShift < 32);
+    static const PcmPackFunc kFuncs[4] = {
+        PackPlanarSubsamples<1, true, 0>, PackPlanarSubsamples<2, true, 0>, PackPlanarSubsamples<3, true, 0>, PackPlanarSubsamples<4, true, 0>
+    };
+    kFuncs[aSubsampleBytes - 1](aChannels, aNumChannels, aFirstSample, aNumSamples, aShift, aDest);
+}
+
+void PcmKernels::PackPlanarLittleEndianScalar(const TInt32* const* aChannels, TUint aNumChannels, TUint aFirstSample, TUint aNumSamples,
+                                              TUint aShift, TUint aSubsampleBytes, TByte* aDest)
+{ // static
+    ASSERT(aSubsampleBytes >= 1 && aSubsampleBytes <= 4);
+    ASSERT(aShift < 32);
+    static const PcmPackFunc kFuncs[4] = {
+        PackPlanarSubsamples<1, false, 0>, PackPlanarSubsamples<2, false, 0>, PackPlanarSubsamples<3, false, 0>, PackPlanarSubsamples<4, false, 0>
+    };
+    kFuncs[aSubsampleBytes - 1](aChannels, aNumChannels, aFirstSample, aNumSamples, aShift, aDest);
+}
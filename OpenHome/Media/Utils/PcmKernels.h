@@ -0,0 +1,55 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+
+namespace OpenHome {
+namespace Media {
+
+/**
+ * Bulk operations on packed PCM.
+ *
+ * Each operation has a portable scalar implementation plus vectorised versions
+ * (SSSE3/SSE4.1/AVX2 on x86, NEON on ARM).  The fastest version supported by the host CPU
+ * is selected the first time any operation is used.  NEON versions are only built if
+ * PCM_KERNELS_ENABLE_NEON is defined; ARM builds otherwise use the scalar versions.
+ */
+class PcmKernels
+{
+public:
+    // Copy aBytes of little endian subsamples from aSrc to aDest, converting to big endian.
+    // aBytes must be a multiple of the subsample size.  aSrc and aDest must not overlap.
+    static void CopyToBigEndian16(const TByte* aSrc, TByte* aDest, TUint aBytes);
+    static void CopyToBigEndian24(const TByte* aSrc, TByte* aDest, TUint aBytes);
+    static void CopyToBigEndian32(const TByte* aSrc, TByte* aDest, TUint aBytes);
+    // Reverse the byte order of each subsample (converting big <-> little endian).  aSrc and aDest must not overlap.
+    static void CopySwapped(const TByte* aSrc, TByte* aDest, TUint aBytes, TUint aSubsampleBytes);
+    // Scale aNumSubsamples 16-bit subsamples from aSrc by the Q15 multipliers in aGains
+    // (one per subsample; non-negative), writing results to aDest.  aSrc may equal aDest.
+    static void ApplyGain16BigEndian(const TByte* aSrc, TByte* aDest, const TInt16* aGains, TUint aNumSubsamples);
+    static void ApplyGain16LittleEndian(const TByte* aSrc, TByte* aDest, const TInt16* aGains, TUint aNumSubsamples);
+    // Scale aBytes of signed 8, 16, 24 or 32-bit subsamples by aAttenuation/256 (aAttenuation <= 256), rounding towards zero.
+    // aSrc may equal aDest but must not otherwise overlap it.
+    static void Attenuate(const TByte* aSrc, TByte* aDest, TUint aBytes, TUint aSubsampleBytes, TBool aBigEndian, TUint aAttenuation);
+    // Interleave aNumSamples samples, starting at index aFirstSample, from aNumChannels arrays of signed 32-bit values
+    // (one per channel, as output by decoders such as FLAC and MP3) into packed big or little endian subsamples of aSubsampleBytes.
+    // Each value is arithmetic shifted right by aShift (< 32) bits then clipped to the range of the output subsample.
+    static void PackPlanarBigEndian(const TInt32* const* aChannels, TUint aNumChannels, TUint aFirstSample, TUint aNumSamples,
+                                    TUint aShift, TUint aSubsampleBytes, TByte* aDest);
+    static void PackPlanarLittleEndian(const TInt32* const* aChannels, TUint aNumChannels, TUint aFirstSample, TUint aNumSamples,
+                                       TUint aShift, TUint aSubsampleBytes, TByte* aDest);
+    static const TChar* Implementation(); // name of the instruction set in use
+public: // reference implementations.  Exposed for use by tests
+    static void CopyToBigEndian16Scalar(const TByte* aSrc, TByte* aDest, TUint aBytes);
+    static void CopyToBigEndian24Scalar(const TByte* aSrc, TByte* aDest, TUint aBytes);
+    static void CopyToBigEndian32Scalar(const TByte* aSrc, TByte* aDest, TUint aBytes);
+    static void ApplyGain16BigEndianScalar(const TByte* aSrc, TByte* aDest, const TInt16* aGains, TUint aNumSubsamples);
+    static void ApplyGain16LittleEndianScalar(const TByte* aSrc, TByte* aDest, const TInt16* aGains, TUint aNumSubsamples);
+    static void AttenuateScalar(const TByte* aSrc, TByte* aDest, TUint aBytes, TUint aSubsampleBytes, TBool aBigEndian, TUint aAttenuation);
+    static void PackPlanarBigEndianScalar(const TInt32* const* aChannels, TUint aNumChannels, TUint aFirstSample, TUint aNumSamples,
+                                          TUint aShift, TUint aSubsampleBytes, TByte* aDest);
+    static void PackPlanarLittleEndianScalar(const TInt32* const* aChannels, TUint aNumChannels, TUint aFirstSample, TUint aNumSamples,
+                                             TUint aShift, TUint aSubsampleBytes, TByte* aDest);
+};
+
+} // namespace Media
+} // namespace OpenHome
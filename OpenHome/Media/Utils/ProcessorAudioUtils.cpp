@@ -15,8 +15,9 @@ const TByte* ProcessorPcmBufTest::Ptr() const
     return iBuf.Ptr();
 }
 
-ProcessorPcmBufTest::ProcessorPcmBufTest()
+ProcessorPcmBufTest::ProcessorPcmBufTest(AudioDataEndian aEndian)
     : iBuf(kBufferGranularity)
+    , iEndian(aEndian)
 {
 }
 
@@ -59,6 +60,11 @@ void ProcessorPcmBufTest::Flush()
 {
 }
 
+AudioDataEndian ProcessorPcmBufTest::Endian() const
+{
+    return iEndian;
+}
+
 
 // ProcessorDsdBufTest
 
@@ -13,7 +13,7 @@ class ProcessorPcmBufTest : public IPcmProcessor // Reads packed data into dynam
 {
     static const TUint kBufferGranularity = DecodedAudio::kMaxBytes;
 public:
-    ProcessorPcmBufTest();
+    ProcessorPcmBufTest(AudioDataEndian aEndian = AudioDataEndian::Big);
     Brn Buf() const;
     const TByte* Ptr() const;
 protected:
@@ -25,8 +25,11 @@ private: // from IPcmProcessor
     void ProcessSilence(const Brx& aData, TUint aNumChannels, TUint aSubsampleBytes) override;
     void EndBlock() override;
     void Flush() override;
+    AudioDataEndian Endian() const override;
 protected:
     Bwh iBuf;
+private:
+    const AudioDataEndian iEndian;
 };
 
 class ProcessorDsdBufTest : public IDsdProcessor // Reads packed data into dynamically allocated buffer.
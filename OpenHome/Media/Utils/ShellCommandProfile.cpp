@@ -0,0 +1,43 @@
+#include <OpenHome/Media/Utils/ShellCommandProfile.h>
+#include <OpenHome/Private/Shell.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Media/Pipeline/Profiler.h>
+
+using namespace OpenHome;
+using namespace OpenHome::Media;
+
+const TChar ShellCommandProfile::kShellCommand[] = "pipeline_profile";
+
+ShellCommandProfile::ShellCommandProfile(IPipelineProfile& aProfile, IShell& aShell)
+    : iProfile(aProfile)
+    , iShell(aShell)
+{
+    iShell.AddCommandHandler(kShellCommand, *this);
+}
+
+ShellCommandProfile::~ShellCommandProfile()
+{
+    iShell.RemoveCommandHandler(kShellCommand);
+}
+
+void ShellCommandProfile::HandleShellCommand(Brn /*aCommand*/, const std::vector<Brn>& aArgs, IWriter& aResponse)
+{
+    if (aArgs.size() == 0) {
+        iProfile.Report(aResponse);
+    }
+    else if (aArgs.size() == 1 && aArgs[0] == Brn("reset")) {
+        iProfile.Reset();
+        aResponse.Write(Brn("Pipeline profile reset\n"));
+    }
+    else {
+        aResponse.Write(Brn("Unexpected arguments for \'pipeline_profile\' command\n"));
+    }
+}
+
+void ShellCommandProfile::DisplayHelp(IWriter& aResponse)
+{
+    aResponse.Write(Brn("pipeline_profile [reset]\n"));
+    aResponse.Write(Brn("  report msgs, jiffies and time spent in Pull() (or Push()) for each pipeline element\n"));
+    aResponse.Write(Brn("  'total' includes elements called by this one in the same thread; 'self' excludes them\n"));
+    aResponse.Write(Brn("  [reset] clears all counters\n"));
+}
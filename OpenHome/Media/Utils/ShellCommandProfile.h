@@ -0,0 +1,26 @@
+#pragma once
+
+#include <OpenHome/Private/Shell.h>
+#include <OpenHome/Types.h>
+
+namespace OpenHome {
+namespace Media {
+
+class IPipelineProfile;
+
+class ShellCommandProfile : private IShellCommandHandler
+{
+    static const TChar kShellCommand[];
+public:
+    ShellCommandProfile(IPipelineProfile& aProfile, IShell& aShell);
+    ~ShellCommandProfile();
+private: // from IShellCommandHandler
+    void HandleShellCommand(Brn aCommand, const std::vector<Brn>& aArgs, IWriter& aResponse) override;
+    void DisplayHelp(IWriter& aResponse) override;
+private:
+    IPipelineProfile& iProfile;
+    IShell& iShell;
+};
+
+} // namespace Media
+} // namespace OpenHome
@@ -309,7 +309,7 @@ AllocatorConfigValBuf::AllocatorConfigValBuf(const TChar* aName, TUint aNumCells
     : AllocatorBase(aName, aNumCells, sizeof(ConfigValBuf), aInfoAggregator)
 {
     for (TUint i=0; i<aNumCells; i++) {
-        iFree.Write(new ConfigValBuf(*this, aBufBytes));
+        AddCell(new ConfigValBuf(*this, aBufBytes));
     }
 }
 
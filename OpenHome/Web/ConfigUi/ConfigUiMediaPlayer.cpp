@@ -46,6 +46,7 @@ ConfigAppMediaPlayer::ConfigAppMediaPlayer(IInfoAggregator& aInfoAggregator,
     AddConfigChoiceConditional(Brn("Device.AutoPlay"));
     AddConfigChoiceConditional(Brn("Sender.Enabled"));
     AddConfigChoiceConditional(Brn("Sender.Mode"));
+    AddConfigChoiceConditional(Brn("Sender.Compression"));
     AddConfigChoiceConditional(Brn("Source.NetAux.Auto"));
     AddConfigChoiceConditional(Qobuz::kConfigKeySoundQuality);
     AddConfigChoiceConditional(Brn("qobuz.com.Enabled"));
@@ -33,5 +33,7 @@ if opts.debug:
     cargs += ['--debug',]
 else:
     cargs += ['--release',]
+if opts.type != 'publish':
+    cargs += ['--pipeline-debug-elements',] # tests rely on the validators; only published builds omit them
 
 subprocess.check_call(args=[os.path.join(scrd, 'ohMediaPlayer', 'go' + ext), 'ci-build'] + cargs, cwd=cdir)
@@ -74,6 +74,7 @@ add_option("--release", action="store_const", const="Release", dest="debugmode",
 add_option("--steps", default="default", help="Steps to run, comma separated. (all,default,fetch,configure,clean,build,bundle,test,test_full,publish)")
 add_option("--publish-version", action="store", help="Specify version string.")
 add_option("--fetch-only", action="store_const", const="fetch", dest="steps", help="Fetch dependencies only.")
+add_option("--pipeline-debug-elements", action="store_true", default=False, help="Keep pipeline loggers and validators in release builds.")
 
 
 @build_step()
@@ -120,6 +121,8 @@ def setup_universal(context):
     context.configure_args = get_dependency_args(env={'debugmode': env['OH_DEBUG']})
     context.configure_args += ["--dest-platform", env["OH_PLATFORM"]]
     context.configure_args += ["--" + context.options.debugmode.lower()]
+    if context.options.pipeline_debug_elements:
+        context.configure_args += ["--pipeline-debug-elements"]
     context.integration_test_media_server = context.env.get('MEDIA_SERVER', 'N/A')
     context.integration_test_dacp_server = context.env.get('DACP_SERVER', 'N/A')
     context.integration_test_log_dir = context.env.get('LOG_DIR', 'NightlyLogs')